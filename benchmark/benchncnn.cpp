@@ -13,9 +13,11 @@
 // specific language governing permissions and limitations under the License.
 
 #include <float.h>
+#include <math.h>
 #include <stdio.h>
 #include <string.h>
 
+#include <pthread.h>
 #include <unistd.h> // sleep()
 
 #include "benchmark.h"
@@ -32,16 +34,36 @@ int DataReaderFromEmpty_scan(const void *_self, const char* format, void* p)
     return 0;
 }
 
+// the 4 byte weight flags read as zero, so every weight loads as raw float32
+// the weights get a small fixed pattern, so the outputs depend on the input
+// and the concurrency check has something to compare
 size_t DataReaderFromEmpty_read(const void *_self, void* buf, size_t size)
 {
     memset(buf, 0, size);
+
+    if (size > 4)
+    {
+        float* ptr = (float*)buf;
+        for (size_t i=0; i<size / sizeof(float); i++)
+        {
+            ptr[i] = (float)((int)(i % 17) - 8) * 0.001f;
+        }
+    }
+
     return size;
 }
 
-#define createDataReaderFromEmpty()  {  \
-    .dr_handle = NULL,                  \
-    .scan = DataReaderFromEmpty_scan,   \
-    .read = DataReaderFromEmpty_read    \
+// nothing to reference in place, the weights are always read
+size_t DataReaderFromEmpty_reference(const void *_self, size_t size, const void** buf)
+{
+    return 0;
+}
+
+#define createDataReaderFromEmpty()          {  \
+    .dr_handle = NULL,                          \
+    .scan = DataReaderFromEmpty_scan,           \
+    .read = DataReaderFromEmpty_read,           \
+    .reference = DataReaderFromEmpty_reference  \
 }
 
 static int g_warmup_loop_count = 8;
@@ -51,6 +73,93 @@ static bool g_enable_cooling_down = true;
 static UnlockedPoolAllocator g_blob_pool_allocator;
 static PoolAllocator g_workspace_pool_allocator;
 
+// parallel requests on one shared net
+static int g_concurrency = 1;
+// concurrent outputs that differ from the single threaded one, over all models
+static int g_mismatch_count = 0;
+static BucketPoolAllocator g_bucket_pool_allocator;
+
+struct benchmark_request_args
+{
+    const Net* net;
+    const Mat* in;
+    // single threaded output every request must reproduce
+    const Mat* out_ref;
+    // even threads use their own extractors, odd threads forward_request
+    bool use_forward_request;
+    int mismatch_count;
+};
+
+// outputs of different thread counts may round differently, nan and inf must match
+static bool output_matches(const Mat& out, const Mat& out_ref)
+{
+    if (out.dims != out_ref.dims || out.w != out_ref.w || out.h != out_ref.h || out.c != out_ref.c
+        || out.elemsize != out_ref.elemsize || out.elempack != out_ref.elempack)
+        return false;
+
+    const int size = out.w * out.h * out.elempack;
+
+    if (out.elemsize != out.elempack * 4u)
+    {
+        for (int q=0; q<out.c; q++)
+        {
+            if (memcmp(out.channel(q), out_ref.channel(q), size * out.elemsize / out.elempack) != 0)
+                return false;
+        }
+
+        return true;
+    }
+
+    for (int q=0; q<out.c; q++)
+    {
+        const float* ptr = out.channel(q);
+        const float* ref = out_ref.channel(q);
+
+        for (int i=0; i<size; i++)
+        {
+            if (ptr[i] == ref[i] || (ptr[i] != ptr[i] && ref[i] != ref[i]))
+                continue;
+
+            if (!(fabs(ptr[i] - ref[i]) <= 1e-3f * (1.f + fabs(ref[i]))))
+                return false;
+        }
+    }
+
+    return true;
+}
+
+static void* benchmark_request_thread(void* _args)
+{
+    benchmark_request_args* args = (benchmark_request_args*)_args;
+
+    std::vector<const char*> input_names(1, "data");
+    std::vector<const char*> output_names(1, "output");
+    std::vector<Mat> inputs(1, *args->in);
+
+    for (int i=0; i<g_loop_count; i++)
+    {
+        Mat out;
+        if (args->use_forward_request)
+        {
+            std::vector<Mat> outputs;
+            forward_request(args->net, input_names, inputs, output_names, outputs, args->net->opt);
+            if (!outputs.empty())
+                out = outputs[0];
+        }
+        else
+        {
+            Extractor ex = create_extractor(args->net);
+            ex.input("data", *args->in);
+            ex.extract("output", out);
+        }
+
+        if (!output_matches(out, *args->out_ref))
+            args->mismatch_count++;
+    }
+
+    return 0;
+}
+
 void benchmark(const char* comment, const Mat& _in, const Option& opt)
 {
     Mat in = _in;
@@ -112,6 +221,61 @@ void benchmark(const char* comment, const Mat& _in, const Option& opt)
     time_avg /= g_loop_count;
 
     fprintf(stderr, "%20s  min = %7.2f  max = %7.2f  avg = %7.2f\n", comment, time_min, time_max, time_avg);
+
+    if (g_concurrency > 1)
+    {
+        Mat out_ref;
+        {
+            Extractor ex = create_extractor(&net);
+            ex.set_num_threads(1);
+            ex.input("data", in);
+            ex.extract("output", out_ref);
+        }
+
+        // every thread runs its own requests over the same weights
+        std::vector<benchmark_request_args> args(g_concurrency);
+        for (int i=0; i<g_concurrency; i++)
+        {
+            args[i].net = &net;
+            args[i].in = &in;
+            args[i].out_ref = &out_ref;
+            args[i].use_forward_request = i % 2 == 1;
+            args[i].mismatch_count = 0;
+        }
+
+        std::vector<pthread_t> threads(g_concurrency);
+
+        double start = get_current_time();
+
+        for (int i=0; i<g_concurrency; i++)
+        {
+            pthread_create(&threads[i], 0, benchmark_request_thread, &args[i]);
+        }
+        for (int i=0; i<g_concurrency; i++)
+        {
+            pthread_join(threads[i], 0);
+        }
+
+        double end = get_current_time();
+
+        double time = end - start;
+        double request_count = (double)g_concurrency * g_loop_count;
+
+        int mismatch_count = 0;
+        for (int i=0; i<g_concurrency; i++)
+        {
+            mismatch_count += args[i].mismatch_count;
+        }
+
+        fprintf(stderr, "%20s  concurrency = %d  latency = %7.2f  throughput = %7.2f/s  mismatch = %d\n", comment, g_concurrency, time * g_concurrency / request_count, request_count * 1000 / time, mismatch_count);
+
+        if (mismatch_count > 0)
+        {
+            fprintf(stderr, "%20s  %d of %d concurrent outputs differ from the single threaded one\n", comment, mismatch_count, (int)request_count);
+        }
+
+        g_mismatch_count += mismatch_count;
+    }
 }
 
 int main(int argc, char** argv)
@@ -120,6 +284,7 @@ int main(int argc, char** argv)
     int num_threads = 1; // get_cpu_count();
     int powersave = 0;
     int cooling_down = 0;
+    int concurrency = 1;
 
     if (argc >= 2)
     {
@@ -137,11 +302,17 @@ int main(int argc, char** argv)
     {
         cooling_down = atoi(argv[4]);
     }
+    if (argc >= 6)
+    {
+        concurrency = atoi(argv[5]);
+    }
 
     g_enable_cooling_down = cooling_down != 0;
 
     g_loop_count = loop_count;
 
+    g_concurrency = max(concurrency, 1);
+
     g_blob_pool_allocator.set_size_compare_ratio(0.0f);
     g_workspace_pool_allocator.set_size_compare_ratio(0.5f);
 
@@ -161,6 +332,13 @@ int main(int argc, char** argv)
     opt.use_int8_arithmetic = true;
     opt.use_packing_layout = true;
 
+    // the unlocked blob pool cannot be shared by parallel requests
+    if (g_concurrency > 1)
+    {
+        opt.blob_allocator = &g_bucket_pool_allocator;
+        opt.workspace_allocator = &g_bucket_pool_allocator;
+    }
+
     set_cpu_powersave(powersave);
 
     set_omp_dynamic(0);
@@ -170,6 +348,7 @@ int main(int argc, char** argv)
     fprintf(stderr, "num_threads = %d\n", num_threads);
     fprintf(stderr, "powersave = %d\n", get_cpu_powersave());
     fprintf(stderr, "cooling_down = %d\n", (int)g_enable_cooling_down);
+    fprintf(stderr, "concurrency = %d\n", g_concurrency);
 
     // run
     benchmark("squeezenet", Mat(227, 227, 3), opt);
@@ -224,5 +403,5 @@ int main(int argc, char** argv)
 
     benchmark("mobilenetv2_yolov3", Mat(352, 352, 3), opt);
 
-    return 0;
+    return g_mismatch_count > 0 ? 1 : 0;
 }
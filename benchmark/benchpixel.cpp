@@ -0,0 +1,253 @@
+// Tencent is pleased to support the open source community by making ncnn available.
+//
+// Copyright (C) 2020 THL A29 Limited, a Tencent company. All rights reserved.
+//
+// Licensed under the BSD 3-Clause License (the "License"); you may not use this file except
+// in compliance with the License. You may obtain a copy of the License at
+//
+// https://opensource.org/licenses/BSD-3-Clause
+//
+// Unless required by applicable law or agreed to in writing, software distributed
+// under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+// CONDITIONS OF ANY KIND, either express or implied. See the License for the
+// specific language governing permissions and limitations under the License.
+
+#include <float.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "allocator.h"
+#include "benchmark.h"
+#include "mat.h"
+#include "platform.h"
+
+#include "cstl/utils.h"
+
+static int g_warmup_loop_count = 4;
+static int g_loop_count = 100;
+
+static int g_width = 1280;
+static int g_height = 720;
+
+// large enough for every image of g_width x g_height
+static unsigned char* g_pixels = 0;
+static unsigned char* g_pixels_out = 0;
+static Mat g_mat;
+
+// keeps the from_pixels output memory warm, so page faults do not hide the conversion time
+static PoolAllocator g_pool_allocator;
+
+// the pixel type or the rotate type the next benchmark runs with
+static int g_type = 0;
+
+typedef void (*benchmark_func)();
+
+static void benchmark(const char* comment, benchmark_func func)
+{
+    for (int i=0; i<g_warmup_loop_count; i++)
+    {
+        func();
+    }
+
+    double time_min = DBL_MAX;
+    double time_max = -DBL_MAX;
+    double time_avg = 0;
+
+    for (int i=0; i<g_loop_count; i++)
+    {
+        double start = get_current_time();
+
+        func();
+
+        double end = get_current_time();
+
+        double time = end - start;
+
+        time_min = min(time_min, time);
+        time_max = max(time_max, time);
+        time_avg += time;
+    }
+
+    time_avg /= g_loop_count;
+
+    fprintf(stderr, "%24s  min = %7.3f  max = %7.3f  avg = %7.3f\n", comment, time_min, time_max, time_avg);
+}
+
+#if NCNN_PIXEL
+static void from_pixels_func()
+{
+    Mat m = Mat::from_pixels(g_pixels, g_type, g_width, g_height, &g_pool_allocator);
+}
+
+static void to_pixels_func()
+{
+    g_mat.to_pixels(g_pixels_out, g_type);
+}
+
+static void resize_bilinear_c1_func()
+{
+    resize_bilinear_c1(g_pixels, g_width, g_height, g_pixels_out, g_width / 2, g_height / 2);
+}
+
+static void resize_bilinear_c2_func()
+{
+    resize_bilinear_c2(g_pixels, g_width, g_height, g_pixels_out, g_width / 2, g_height / 2);
+}
+
+static void resize_bilinear_c3_func()
+{
+    resize_bilinear_c3(g_pixels, g_width, g_height, g_pixels_out, g_width / 2, g_height / 2);
+}
+
+static void resize_bilinear_c4_func()
+{
+    resize_bilinear_c4(g_pixels, g_width, g_height, g_pixels_out, g_width / 2, g_height / 2);
+}
+
+static void yuv420sp2rgb_func()
+{
+    yuv420sp2rgb(g_pixels, g_width, g_height, g_pixels_out);
+}
+
+static void benchmark_from_pixels(const char* comment, int type)
+{
+    g_type = type;
+    benchmark(comment, from_pixels_func);
+}
+
+static void benchmark_to_pixels(const char* comment, int type)
+{
+    // values outside 0~255 take the saturating path too
+    int channels = (type & Mat::PIXEL_FORMAT_MASK) == Mat::PIXEL_GRAY ? 1 : (type & Mat::PIXEL_FORMAT_MASK) >= Mat::PIXEL_RGBA ? 4 : 3;
+    g_mat.create(g_width, g_height, channels);
+    for (int q=0; q<channels; q++)
+    {
+        float* ptr = g_mat.channel(q);
+        for (int i=0; i<g_width * g_height; i++)
+        {
+            ptr[i] = (float)(i % 300) - 20.5f;
+        }
+    }
+
+    g_type = type;
+    benchmark(comment, to_pixels_func);
+}
+#endif // NCNN_PIXEL
+
+#if NCNN_PIXEL_ROTATE
+static void kanna_rotate_c1_func()
+{
+    int w = g_type >= 5 ? g_height : g_width;
+    int h = g_type >= 5 ? g_width : g_height;
+    kanna_rotate_c1(g_pixels, g_width, g_height, g_pixels_out, w, h, g_type);
+}
+
+static void kanna_rotate_c2_func()
+{
+    int w = g_type >= 5 ? g_height : g_width;
+    int h = g_type >= 5 ? g_width : g_height;
+    kanna_rotate_c2(g_pixels, g_width, g_height, g_pixels_out, w, h, g_type);
+}
+
+static void kanna_rotate_c3_func()
+{
+    int w = g_type >= 5 ? g_height : g_width;
+    int h = g_type >= 5 ? g_width : g_height;
+    kanna_rotate_c3(g_pixels, g_width, g_height, g_pixels_out, w, h, g_type);
+}
+
+static void kanna_rotate_c4_func()
+{
+    int w = g_type >= 5 ? g_height : g_width;
+    int h = g_type >= 5 ? g_width : g_height;
+    kanna_rotate_c4(g_pixels, g_width, g_height, g_pixels_out, w, h, g_type);
+}
+#endif // NCNN_PIXEL_ROTATE
+
+int main(int argc, char** argv)
+{
+    if (argc >= 2)
+    {
+        g_loop_count = max(atoi(argv[1]), 1);
+    }
+    if (argc >= 3)
+    {
+        g_width = atoi(argv[2]);
+    }
+    if (argc >= 4)
+    {
+        g_height = atoi(argv[3]);
+    }
+
+    // yuv420sp wants even sizes, the resize at least 2x2 pixels
+    g_width = max(g_width / 2 * 2, 4);
+    g_height = max(g_height / 2 * 2, 4);
+
+    fprintf(stderr, "loop_count = %d\n", g_loop_count);
+    fprintf(stderr, "width = %d\n", g_width);
+    fprintf(stderr, "height = %d\n", g_height);
+
+    g_pixels = (unsigned char*)malloc(g_width * g_height * 4);
+    g_pixels_out = (unsigned char*)malloc(g_width * g_height * 4);
+
+    for (int i=0; i<g_width * g_height * 4; i++)
+    {
+        g_pixels[i] = (unsigned char)(i * 7 + (i >> 8));
+    }
+
+#if NCNN_PIXEL
+    benchmark_from_pixels("from_pixels rgb", Mat::PIXEL_RGB);
+    benchmark_from_pixels("from_pixels gray", Mat::PIXEL_GRAY);
+    benchmark_from_pixels("from_pixels rgba", Mat::PIXEL_RGBA);
+    benchmark_from_pixels("from_pixels rgb2bgr", Mat::PIXEL_RGB2BGR);
+    benchmark_from_pixels("from_pixels rgb2gray", Mat::PIXEL_RGB2GRAY);
+    benchmark_from_pixels("from_pixels gray2rgb", Mat::PIXEL_GRAY2RGB);
+    benchmark_from_pixels("from_pixels rgba2rgb", Mat::PIXEL_RGBA2RGB);
+    benchmark_from_pixels("from_pixels rgba2gray", Mat::PIXEL_RGBA2GRAY);
+    benchmark_from_pixels("from_pixels rgba2bgra", Mat::PIXEL_RGBA2BGRA);
+
+    benchmark_to_pixels("to_pixels rgb", Mat::PIXEL_RGB);
+    benchmark_to_pixels("to_pixels gray", Mat::PIXEL_GRAY);
+    benchmark_to_pixels("to_pixels rgba", Mat::PIXEL_RGBA);
+    benchmark_to_pixels("to_pixels rgb2bgr", Mat::PIXEL_RGB2BGR);
+    benchmark_to_pixels("to_pixels rgb2rgba", Mat::PIXEL_RGB2RGBA);
+    benchmark_to_pixels("to_pixels gray2rgba", Mat::PIXEL_GRAY2RGBA);
+    benchmark_to_pixels("to_pixels rgba2bgra", Mat::PIXEL_RGBA2BGRA);
+
+    benchmark("resize_bilinear_c1", resize_bilinear_c1_func);
+    benchmark("resize_bilinear_c2", resize_bilinear_c2_func);
+    benchmark("resize_bilinear_c3", resize_bilinear_c3_func);
+    benchmark("resize_bilinear_c4", resize_bilinear_c4_func);
+
+    benchmark("yuv420sp2rgb", yuv420sp2rgb_func);
+#endif // NCNN_PIXEL
+
+#if NCNN_PIXEL_ROTATE
+    static const char* rotate_comments[4][8] = {
+        {"kanna_rotate_c1 1", "kanna_rotate_c1 2", "kanna_rotate_c1 3", "kanna_rotate_c1 4", "kanna_rotate_c1 5", "kanna_rotate_c1 6", "kanna_rotate_c1 7", "kanna_rotate_c1 8"},
+        {"kanna_rotate_c2 1", "kanna_rotate_c2 2", "kanna_rotate_c2 3", "kanna_rotate_c2 4", "kanna_rotate_c2 5", "kanna_rotate_c2 6", "kanna_rotate_c2 7", "kanna_rotate_c2 8"},
+        {"kanna_rotate_c3 1", "kanna_rotate_c3 2", "kanna_rotate_c3 3", "kanna_rotate_c3 4", "kanna_rotate_c3 5", "kanna_rotate_c3 6", "kanna_rotate_c3 7", "kanna_rotate_c3 8"},
+        {"kanna_rotate_c4 1", "kanna_rotate_c4 2", "kanna_rotate_c4 3", "kanna_rotate_c4 4", "kanna_rotate_c4 5", "kanna_rotate_c4 6", "kanna_rotate_c4 7", "kanna_rotate_c4 8"},
+    };
+    static const benchmark_func rotate_funcs[4] = {
+        kanna_rotate_c1_func, kanna_rotate_c2_func, kanna_rotate_c3_func, kanna_rotate_c4_func
+    };
+
+    for (int c=0; c<4; c++)
+    {
+        for (int type=1; type<=8; type++)
+        {
+            g_type = type;
+            benchmark(rotate_comments[c][type - 1], rotate_funcs[c]);
+        }
+    }
+#endif // NCNN_PIXEL_ROTATE
+
+    g_mat.release();
+    g_pool_allocator.clear();
+
+    free(g_pixels);
+    free(g_pixels_out);
+
+    return 0;
+}
@@ -17,6 +17,8 @@
 #include <stdio.h>
 #include <algorithm>
 
+thread_local AllocationCounter* g_allocation_counter = 0;
+
 Allocator::~Allocator() 
 {
 
@@ -59,7 +61,7 @@ void PoolAllocator::clear()
     for (; it != budgets.end(); it++)
     {
         void* ptr = it->second;
-        fastFree(ptr);
+        ::fastFree(ptr);
     }
     budgets.clear();
 
@@ -109,7 +111,7 @@ void* PoolAllocator::fastMalloc(size_t size)
     pthread_mutex_unlock(&budgets_lock);
 
     // new
-    void* ptr = fastMalloc(size);
+    void* ptr = ::fastMalloc(size);
 
     pthread_mutex_lock(&payouts_lock);
 
@@ -149,7 +151,7 @@ void PoolAllocator::fastFree(void* ptr)
     pthread_mutex_unlock(&payouts_lock);
 
     fprintf(stderr, "FATAL ERROR! pool allocator get wild %p\n", ptr);
-    fastFree(ptr);
+    ::fastFree(ptr);
 }
 
 UnlockedPoolAllocator::UnlockedPoolAllocator()
@@ -179,7 +181,7 @@ void UnlockedPoolAllocator::clear()
     for (; it != budgets.end(); it++)
     {
         void* ptr = it->second;
-        fastFree(ptr);
+        ::fastFree(ptr);
     }
     budgets.clear();
 }
@@ -217,7 +219,7 @@ void* UnlockedPoolAllocator::fastMalloc(size_t size)
     }
 
     // new
-    void* ptr = fastMalloc(size);
+    void* ptr = ::fastMalloc(size);
 
     payouts.push_back(std::make_pair(size, ptr));
 
@@ -243,5 +245,650 @@ void UnlockedPoolAllocator::fastFree(void* ptr)
     }
 
     fprintf(stderr, "FATAL ERROR! unlocked pool allocator get wild %p\n", ptr);
-    fastFree(ptr);
+    ::fastFree(ptr);
+}
+
+// orders block indexes by decreasing size
+struct ArenaSizeGreater
+{
+    ArenaSizeGreater(const std::vector<size_t>& _sizes) : sizes(_sizes) {}
+    bool operator()(int a, int b) const { return sizes[a] > sizes[b]; }
+    const std::vector<size_t>& sizes;
+};
+
+// orders block indexes by increasing offset
+struct ArenaOffsetLess
+{
+    ArenaOffsetLess(const std::vector<size_t>& _offsets) : offsets(_offsets) {}
+    bool operator()(int a, int b) const { return offsets[a] < offsets[b]; }
+    const std::vector<size_t>& offsets;
+};
+
+// pointer atomics for the bucket pool free lists
+#if defined __GNUC__
+template<typename T> static inline T* atomic_load_ptr(T** addr)
+{
+    return __atomic_load_n(addr, __ATOMIC_ACQUIRE);
+}
+template<typename T> static inline T* atomic_exchange_ptr(T** addr, T* val)
+{
+    return __atomic_exchange_n(addr, val, __ATOMIC_ACQ_REL);
+}
+template<typename T> static inline bool atomic_cas_ptr(T** addr, T** expected, T* desired)
+{
+    return __atomic_compare_exchange_n(addr, expected, desired, true, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE);
+}
+#elif defined _MSC_VER && !defined RC_INVOKED
+template<typename T> static inline T* atomic_load_ptr(T** addr)
+{
+    return (T*)_InterlockedCompareExchangePointer((void* volatile*)addr, 0, 0);
+}
+template<typename T> static inline T* atomic_exchange_ptr(T** addr, T* val)
+{
+    return (T*)_InterlockedExchangePointer((void* volatile*)addr, val);
+}
+template<typename T> static inline bool atomic_cas_ptr(T** addr, T** expected, T* desired)
+{
+    T* old = (T*)_InterlockedCompareExchangePointer((void* volatile*)addr, desired, *expected);
+    bool ok = old == *expected;
+    *expected = old;
+    return ok;
+}
+#else
+// thread-unsafe branch
+template<typename T> static inline T* atomic_load_ptr(T** addr) { return *addr; }
+template<typename T> static inline T* atomic_exchange_ptr(T** addr, T* val) { T* old = *addr; *addr = val; return old; }
+template<typename T> static inline bool atomic_cas_ptr(T** addr, T** expected, T* desired) { *addr = desired; return true; }
+#endif
+
+struct BucketPoolAllocator::Block
+{
+    // size class index, -1 for blocks allocated outside the pool
+    int size_class;
+    // next free block while cached
+    Block* next;
+};
+
+struct BucketPoolAllocator::ThreadCache
+{
+    BucketPoolAllocator* allocator;
+
+    Block* heads[BUCKET_POOL_CLASS_COUNT];
+    size_t bytes[BUCKET_POOL_CLASS_COUNT];
+
+    // registry links
+    ThreadCache* prev;
+    ThreadCache* next;
+};
+
+// keep the payload as aligned as fastMalloc returns it
+#define BUCKET_POOL_HEADER_SIZE alignSize(sizeof(BucketPoolAllocator::Block), MALLOC_ALIGN)
+
+static inline int floor_log2(size_t x)
+{
+#if defined __GNUC__
+    return (int)(sizeof(unsigned long long) * 8 - 1) - __builtin_clzll((unsigned long long)x);
+#else
+    int e = 0;
+    while (x >>= 1)
+        e++;
+    return e;
+#endif
+}
+
+// class 0 holds up to 64 bytes, then every octave (2^e, 2^(e+1)] is split
+// into four classes of 2^e + k * 2^(e-2), so the waste stays below 25%
+static inline int bucket_size_class(size_t size)
+{
+    if (size <= ((size_t)1 << BUCKET_POOL_MIN_SHIFT))
+        return 0;
+
+    int e = floor_log2(size - 1);
+    if (e >= BUCKET_POOL_MAX_SHIFT)
+        return -1;
+
+    size_t k = (size - ((size_t)1 << e) + ((size_t)1 << (e - 2)) - 1) >> (e - 2);
+
+    return (e - BUCKET_POOL_MIN_SHIFT) * 4 + (int)k;
+}
+
+static inline size_t bucket_class_size(int size_class)
+{
+    if (size_class == 0)
+        return (size_t)1 << BUCKET_POOL_MIN_SHIFT;
+
+    int e = BUCKET_POOL_MIN_SHIFT + (size_class - 1) / 4;
+    int k = (size_class - 1) % 4 + 1;
+
+    return ((size_t)1 << e) + ((size_t)k << (e - 2));
+}
+
+// push the chain first..last onto a shared list
+// pops always drain the whole list with an exchange, so there is no ABA
+static inline void bucket_push_chain(BucketPoolAllocator::Block** head, BucketPoolAllocator::Block* first, BucketPoolAllocator::Block* last)
+{
+    BucketPoolAllocator::Block* old = atomic_load_ptr(head);
+    do
+    {
+        last->next = old;
+    } while (!atomic_cas_ptr(head, &old, first));
+}
+
+static void bucket_free_chain(BucketPoolAllocator::Block* b)
+{
+    while (b)
+    {
+        BucketPoolAllocator::Block* next = b->next;
+        ::fastFree(b);
+        b = next;
+    }
+}
+
+// return every cached block of the thread to the shared lists
+static void bucket_flush_thread_cache(BucketPoolAllocator::ThreadCache* cache)
+{
+    for (int i=0; i<BUCKET_POOL_CLASS_COUNT; i++)
+    {
+        BucketPoolAllocator::Block* first = cache->heads[i];
+        if (!first)
+            continue;
+
+        BucketPoolAllocator::Block* last = first;
+        while (last->next)
+            last = last->next;
+
+        bucket_push_chain(&cache->allocator->free_lists[i], first, last);
+
+        cache->heads[i] = 0;
+        cache->bytes[i] = 0;
+    }
+}
+
+static void bucket_unlink_thread_cache(BucketPoolAllocator::ThreadCache* cache)
+{
+    BucketPoolAllocator* allocator = cache->allocator;
+
+    if (cache->prev)
+        cache->prev->next = cache->next;
+    else
+        allocator->caches = cache->next;
+
+    if (cache->next)
+        cache->next->prev = cache->prev;
+}
+
+// pthread key destructor, runs on the exiting thread
+static void bucket_thread_cache_exit(void* ptr)
+{
+    BucketPoolAllocator::ThreadCache* cache = (BucketPoolAllocator::ThreadCache*)ptr;
+    BucketPoolAllocator* allocator = cache->allocator;
+
+    bucket_flush_thread_cache(cache);
+
+    pthread_mutex_lock(&allocator->caches_lock);
+    bucket_unlink_thread_cache(cache);
+    pthread_mutex_unlock(&allocator->caches_lock);
+
+    delete cache;
+}
+
+BucketPoolAllocator::BucketPoolAllocator()
+{
+    thread_cache_limit = 4 * 1024 * 1024;
+
+    for (int i=0; i<BUCKET_POOL_CLASS_COUNT; i++)
+    {
+        free_lists[i] = 0;
+    }
+
+    pthread_key_create(&cache_key, bucket_thread_cache_exit);
+
+    pthread_mutex_init(&caches_lock, 0);
+    caches = 0;
+}
+
+BucketPoolAllocator::~BucketPoolAllocator()
+{
+    // no key destructor may run on a dying allocator
+    pthread_key_delete(cache_key);
+
+    pthread_mutex_lock(&caches_lock);
+    while (caches)
+    {
+        ThreadCache* cache = caches;
+        caches = cache->next;
+
+        for (int i=0; i<BUCKET_POOL_CLASS_COUNT; i++)
+        {
+            bucket_free_chain(cache->heads[i]);
+        }
+
+        delete cache;
+    }
+    pthread_mutex_unlock(&caches_lock);
+
+    for (int i=0; i<BUCKET_POOL_CLASS_COUNT; i++)
+    {
+        bucket_free_chain(free_lists[i]);
+        free_lists[i] = 0;
+    }
+
+    pthread_mutex_destroy(&caches_lock);
+}
+
+void BucketPoolAllocator::set_thread_cache_limit(size_t limit)
+{
+    thread_cache_limit = limit;
+}
+
+void BucketPoolAllocator::clear()
+{
+    ThreadCache* cache = (ThreadCache*)pthread_getspecific(cache_key);
+    if (cache)
+    {
+        for (int i=0; i<BUCKET_POOL_CLASS_COUNT; i++)
+        {
+            bucket_free_chain(cache->heads[i]);
+            cache->heads[i] = 0;
+            cache->bytes[i] = 0;
+        }
+    }
+
+    for (int i=0; i<BUCKET_POOL_CLASS_COUNT; i++)
+    {
+        bucket_free_chain(atomic_exchange_ptr(&free_lists[i], (Block*)0));
+    }
+}
+
+BucketPoolAllocator::ThreadCache* BucketPoolAllocator::get_thread_cache()
+{
+    ThreadCache* cache = (ThreadCache*)pthread_getspecific(cache_key);
+    if (cache)
+        return cache;
+
+    cache = new ThreadCache;
+    cache->allocator = this;
+    for (int i=0; i<BUCKET_POOL_CLASS_COUNT; i++)
+    {
+        cache->heads[i] = 0;
+        cache->bytes[i] = 0;
+    }
+
+    pthread_mutex_lock(&caches_lock);
+    cache->prev = 0;
+    cache->next = caches;
+    if (caches)
+        caches->prev = cache;
+    caches = cache;
+    pthread_mutex_unlock(&caches_lock);
+
+    pthread_setspecific(cache_key, cache);
+
+    return cache;
+}
+
+void* BucketPoolAllocator::fastMalloc(size_t size)
+{
+    const size_t header_size = BUCKET_POOL_HEADER_SIZE;
+
+    int size_class = bucket_size_class(size);
+    if (size_class < 0)
+    {
+        Block* b = (Block*)::fastMalloc(header_size + size);
+        if (!b)
+            return 0;
+
+        b->size_class = -1;
+        return (unsigned char*)b + header_size;
+    }
+
+    const size_t class_size = bucket_class_size(size_class);
+
+    ThreadCache* cache = get_thread_cache();
+
+    Block* b = cache->heads[size_class];
+    if (b)
+    {
+        cache->heads[size_class] = b->next;
+        cache->bytes[size_class] -= class_size;
+        return (unsigned char*)b + header_size;
+    }
+
+    // refill from the shared list, keeping what fits in the thread cache
+    b = atomic_exchange_ptr(&free_lists[size_class], (Block*)0);
+    if (b)
+    {
+        Block* rest = b->next;
+        while (rest && cache->bytes[size_class] + class_size <= thread_cache_limit)
+        {
+            Block* next = rest->next;
+            rest->next = cache->heads[size_class];
+            cache->heads[size_class] = rest;
+            cache->bytes[size_class] += class_size;
+            rest = next;
+        }
+
+        if (rest)
+        {
+            Block* last = rest;
+            while (last->next)
+                last = last->next;
+
+            bucket_push_chain(&free_lists[size_class], rest, last);
+        }
+
+        return (unsigned char*)b + header_size;
+    }
+
+    // new
+    b = (Block*)::fastMalloc(header_size + class_size);
+    if (!b)
+        return 0;
+
+    b->size_class = size_class;
+    return (unsigned char*)b + header_size;
+}
+
+void BucketPoolAllocator::fastFree(void* ptr)
+{
+    if (!ptr)
+        return;
+
+    Block* b = (Block*)((unsigned char*)ptr - BUCKET_POOL_HEADER_SIZE);
+
+    int size_class = b->size_class;
+    if (size_class < 0)
+    {
+        ::fastFree(b);
+        return;
+    }
+
+    const size_t class_size = bucket_class_size(size_class);
+
+    ThreadCache* cache = get_thread_cache();
+
+    if (cache->bytes[size_class] + class_size <= thread_cache_limit)
+    {
+        b->next = cache->heads[size_class];
+        cache->heads[size_class] = b;
+        cache->bytes[size_class] += class_size;
+        return;
+    }
+
+    bucket_push_chain(&free_lists[size_class], b, b);
+}
+
+ArenaPlan::ArenaPlan()
+{
+    peak_size = 0;
+    from_shapes = false;
+}
+
+// arena blocks start on cache line boundaries
+#define ARENA_ALIGN 64
+
+void pack_arena_plan(ArenaPlan& p)
+{
+    const int count = (int)p.sizes.size();
+
+    // lifetime of every block in event time, unreleased blocks live to the end
+    std::vector<int> t0(count, 0);
+    std::vector<int> t1(count, (int)p.events.size());
+    for (int i=0; i<(int)p.events.size(); i++)
+    {
+        int e = p.events[i];
+        if (e >= 0)
+            t0[e] = i;
+        else
+            t1[~e] = i;
+    }
+
+    std::vector<int> order(count);
+    for (int i=0; i<count; i++)
+    {
+        order[i] = i;
+    }
+    std::stable_sort(order.begin(), order.end(), ArenaSizeGreater(p.sizes));
+
+    p.offsets.assign(count, 0);
+    p.peak_size = 0;
+
+    // placed blocks overlapping the current one in time, by offset
+    std::vector< std::pair<size_t, size_t> > busy;
+    std::vector<int> placed;
+    placed.reserve(count);
+
+    for (int k=0; k<count; k++)
+    {
+        const int i = order[k];
+        const size_t size = alignSize(p.sizes[i], ARENA_ALIGN);
+
+        busy.clear();
+        for (size_t j=0; j<placed.size(); j++)
+        {
+            const int b = placed[j];
+            if (t0[b] < t1[i] && t0[i] < t1[b])
+                busy.push_back(std::make_pair(p.offsets[b], p.offsets[b] + alignSize(p.sizes[b], ARENA_ALIGN)));
+        }
+        std::sort(busy.begin(), busy.end());
+
+        // best fit gap, or the end of the busy range
+        size_t best_offset = 0;
+        size_t best_gap = (size_t)-1;
+        size_t offset = 0;
+        for (size_t j=0; j<busy.size(); j++)
+        {
+            if (busy[j].first >= offset + size && busy[j].first - offset < best_gap)
+            {
+                best_offset = offset;
+                best_gap = busy[j].first - offset;
+            }
+            if (busy[j].second > offset)
+                offset = busy[j].second;
+        }
+        if (best_gap == (size_t)-1)
+            best_offset = offset;
+
+        p.offsets[i] = best_offset;
+        if (best_offset + size > p.peak_size)
+            p.peak_size = best_offset + size;
+
+        placed.push_back(i);
+    }
+
+    for (int i=0; i<count; i++)
+    {
+        order[i] = i;
+    }
+    std::stable_sort(order.begin(), order.end(), ArenaOffsetLess(p.offsets));
+    p.blocks_by_offset = order;
+
+    // blocks sharing bytes never live at the same time in the planned run,
+    // the allocator checks them in case a run does not follow the plan
+    p.conflict_begin.assign(count + 1, 0);
+    p.conflicts.clear();
+    for (int i=0; i<count; i++)
+    {
+        p.conflict_begin[i] = (int)p.conflicts.size();
+
+        const size_t begin = p.offsets[i];
+        const size_t end = begin + alignSize(p.sizes[i], ARENA_ALIGN);
+        for (int j=0; j<count; j++)
+        {
+            if (j != i && p.offsets[j] < end && begin < p.offsets[j] + alignSize(p.sizes[j], ARENA_ALIGN))
+                p.conflicts.push_back(j);
+        }
+    }
+    p.conflict_begin[count] = (int)p.conflicts.size();
+}
+
+ArenaAllocator::ArenaAllocator()
+{
+    plan = 0;
+    arena = 0;
+    cursor = 0;
+    misses = 0;
+    in_use = 0;
+    recording = true;
+    request_count = 0;
+}
+
+ArenaAllocator::~ArenaAllocator()
+{
+    if (in_use != 0)
+    {
+        fprintf(stderr, "FATAL ERROR! arena allocator destroyed too early, %d blocks still in use\n", in_use);
+    }
+}
+
+void ArenaAllocator::reset(const ArenaPlan* _plan, void* _arena)
+{
+    plan = _plan;
+    arena = plan && !plan->sizes.empty() ? (unsigned char*)_arena : 0;
+    cursor = 0;
+    misses = 0;
+    request_count = 0;
+
+    const size_t count = arena ? plan->sizes.size() : 0;
+    taken.assign(count, 0);
+    live.assign(count, 0);
+    block_requests.assign(count, -1);
+
+    // only a run of unknown shapes teaches the net anything
+    recording = !plan || !plan->from_shapes;
+
+    sizes.clear();
+    events.clear();
+    if (plan && recording)
+    {
+        // no reallocation while replaying the same run
+        sizes.reserve(plan->sizes.size());
+        events.reserve(plan->events.size());
+    }
+}
+
+bool ArenaAllocator::replayed() const
+{
+    return arena && misses == 0;
+}
+
+void ArenaAllocator::build_plan(ArenaPlan& p) const
+{
+    p.sizes = sizes;
+    p.events = events;
+    p.from_shapes = false;
+
+    pack_arena_plan(p);
+}
+
+void* ArenaAllocator::fastMalloc(size_t size)
+{
+    const int index = request_count++;
+
+    void* ptr = 0;
+    if (arena)
+    {
+        // the next planned block of this size, past the ones of steps this run skips
+        const size_t count = plan->sizes.size();
+        size_t k = cursor;
+        while (k < count && (taken[k] || plan->sizes[k] != size))
+            k++;
+
+        if (k < count)
+        {
+            taken[k] = 1;
+            while (cursor < count && taken[cursor])
+                cursor++;
+
+            // the plan may not hold for this run, never hand out bytes still in use
+            bool conflict = false;
+            for (int j=plan->conflict_begin[k]; j<plan->conflict_begin[k + 1]; j++)
+            {
+                if (live[plan->conflicts[j]])
+                {
+                    conflict = true;
+                    break;
+                }
+            }
+
+            if (!conflict)
+            {
+                live[k] = 1;
+                block_requests[k] = index;
+                ptr = arena + plan->offsets[k];
+            }
+        }
+    }
+
+    if (!ptr)
+    {
+        // the request index goes in front of the block for fastFree
+        unsigned char* udata = (unsigned char*)::fastMalloc(size + ARENA_ALIGN);
+        if (!udata)
+            return 0;
+
+        *(int*)udata = index;
+        ptr = udata + ARENA_ALIGN;
+        misses++;
+    }
+
+    in_use++;
+
+    if (recording)
+    {
+        sizes.push_back(size);
+        events.push_back(index);
+    }
+
+    return ptr;
+}
+
+void ArenaAllocator::fastFree(void* ptr)
+{
+    int index = -1;
+
+    if (arena && (unsigned char*)ptr >= arena && (unsigned char*)ptr < arena + plan->peak_size)
+    {
+        // the block in use among those starting at this offset
+        const size_t offset = (unsigned char*)ptr - arena;
+        const std::vector<int>& order = plan->blocks_by_offset;
+
+        int lo = 0;
+        int hi = (int)order.size();
+        while (lo < hi)
+        {
+            int mid = (lo + hi) / 2;
+            if (plan->offsets[order[mid]] < offset)
+                lo = mid + 1;
+            else
+                hi = mid;
+        }
+
+        for (int j=lo; j<(int)order.size() && plan->offsets[order[j]] == offset; j++)
+        {
+            if (live[order[j]])
+            {
+                live[order[j]] = 0;
+                index = block_requests[order[j]];
+                break;
+            }
+        }
+
+        if (index == -1)
+        {
+            fprintf(stderr, "FATAL ERROR! arena allocator get wild %p\n", ptr);
+            return;
+        }
+    }
+    else
+    {
+        unsigned char* udata = (unsigned char*)ptr - ARENA_ALIGN;
+        index = *(int*)udata;
+        ::fastFree(udata);
+    }
+
+    in_use--;
+
+    if (recording)
+        events.push_back(~index);
 }
@@ -19,6 +19,7 @@
 
 #include <stdlib.h>
 #include <list>
+#include <vector>
 #include "platform.h"
 
 // the alignment of all the allocated buffers
@@ -99,6 +100,38 @@ static inline void fastFree(void* ptr)
 static inline int NCNN_XADD(int* addr, int delta) { int tmp = *addr; *addr += delta; return tmp; }
 #endif
 
+// allocation traffic of the mats created and released on one thread
+struct AllocationCounter
+{
+    size_t malloc_bytes;
+    int malloc_count;
+    size_t free_bytes;
+    int free_count;
+};
+
+// counter of the calling thread, set by the profiler while a layer runs, null otherwise
+extern thread_local AllocationCounter* g_allocation_counter;
+
+static inline void count_malloc(size_t size)
+{
+    AllocationCounter* counter = g_allocation_counter;
+    if (counter)
+    {
+        counter->malloc_bytes += size;
+        counter->malloc_count++;
+    }
+}
+
+static inline void count_free(size_t size)
+{
+    AllocationCounter* counter = g_allocation_counter;
+    if (counter)
+    {
+        counter->free_bytes += size;
+        counter->free_count++;
+    }
+}
+
 struct Allocator
 {
     virtual ~Allocator();
@@ -148,4 +181,126 @@ struct UnlockedPoolAllocator : public Allocator
     std::list< std::pair<size_t, void*> > payouts;
 };
 
+// size classes of the bucket pool, four classes per power of two
+// from 64 bytes up to 1G, larger requests bypass the pool
+#define BUCKET_POOL_MIN_SHIFT   6
+#define BUCKET_POOL_MAX_SHIFT   30
+#define BUCKET_POOL_CLASS_COUNT ((BUCKET_POOL_MAX_SHIFT - BUCKET_POOL_MIN_SHIFT) * 4 + 1)
+
+// pool allocator for many threads sharing one instance
+// every block carries its size class in a header, so free is O(1)
+// freed blocks go to a cache private to the calling thread first,
+// overflow goes to shared per class free lists updated without locks
+struct BucketPoolAllocator : public Allocator
+{
+    BucketPoolAllocator();
+    ~BucketPoolAllocator();
+
+    // bytes one thread may keep cached per size class
+    // default 4M
+    void set_thread_cache_limit(size_t limit);
+
+    // release the blocks of the shared lists and of the calling thread cache
+    // caches of other threads are released when those threads exit
+    void clear();
+
+    virtual void* fastMalloc(size_t size);
+    virtual void fastFree(void* ptr);
+
+    struct Block;
+    struct ThreadCache;
+
+    ThreadCache* get_thread_cache();
+
+    size_t thread_cache_limit;
+
+    // shared free lists, pushed with compare-and-swap and drained with exchange
+    Block* free_lists[BUCKET_POOL_CLASS_COUNT];
+
+    // per thread cache, flushed back by the key destructor on thread exit
+    pthread_key_t cache_key;
+
+    // all live thread caches, guards only cache creation and teardown
+    pthread_mutex_t caches_lock;
+    ThreadCache* caches;
+};
+
+// offsets of an allocation sequence packed into one arena
+struct ArenaPlan
+{
+    ArenaPlan();
+
+    // the size and arena offset of every allocation, in request order
+    std::vector<size_t> sizes;
+    std::vector<size_t> offsets;
+
+    // allocation and release events in order,
+    // i for the allocation of block i and ~i for its release
+    std::vector<int> events;
+
+    // arena bytes needed
+    size_t peak_size;
+
+    // planned from the blob shapes before any run rather than recorded from one
+    bool from_shapes;
+
+    // block indexes by increasing offset, for finding a released block from its address
+    std::vector<int> blocks_by_offset;
+
+    // the blocks sharing arena bytes with block i at other times are
+    // conflicts[conflict_begin[i]] to conflicts[conflict_begin[i + 1] - 1]
+    std::vector<int> conflict_begin;
+    std::vector<int> conflicts;
+};
+
+// fill plan.offsets, plan.peak_size and the lookup tables from plan.sizes and plan.events,
+// greedy by size with best-fit gaps among the blocks living at the same time
+void pack_arena_plan(ArenaPlan& plan);
+
+// serves the allocations of a repeated run from one preallocated arena
+// a request takes the next unused planned block of its size when no block sharing its bytes is in use,
+// any other request falls back to fastMalloc
+// the requests of a run whose shapes were not known up front are recorded, to learn a plan from
+// not thread safe, it belongs to one extractor
+struct ArenaAllocator : public Allocator
+{
+    ArenaAllocator();
+    ~ArenaAllocator();
+
+    // start a new recording and replay plan from arena, with no block in use
+    // arena must hold plan.peak_size bytes and stays owned by the caller
+    // an empty plan or a null arena only records
+    void reset(const ArenaPlan* plan, void* arena);
+
+    // whether everything since reset was served from the arena
+    bool replayed() const;
+
+    // pack the blocks recorded since reset
+    void build_plan(ArenaPlan& plan) const;
+
+    virtual void* fastMalloc(size_t size);
+    virtual void fastFree(void* ptr);
+
+    const ArenaPlan* plan;
+    unsigned char* arena;
+
+    // first planned block not handed out yet, and the handed out ones
+    size_t cursor;
+    std::vector<unsigned char> taken;
+
+    // planned blocks in use, and the request index each one serves
+    std::vector<unsigned char> live;
+    std::vector<int> block_requests;
+
+    // requests served by fastMalloc since reset, and blocks of either kind still in use
+    int misses;
+    int in_use;
+
+    // recorded blocks and events since reset, unless the plan comes from the shapes
+    bool recording;
+    std::vector<size_t> sizes;
+    std::vector<int> events;
+    int request_count;
+};
+
 #endif // NCNN_ALLOCATOR_H
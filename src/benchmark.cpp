@@ -12,12 +12,13 @@
 // CONDITIONS OF ANY KIND, either express or implied. See the License for the
 // specific language governing permissions and limitations under the License.
 
-#include <sys/time.h>
+#include <time.h>
 
 #include "benchmark.h"
 
 #if NCNN_BENCHMARK
 #include <stdio.h>
+#include <string.h>
 #include "layer/convolution.h"
 #include "layer/convolutiondepthwise.h"
 #include "layer/deconvolution.h"
@@ -26,26 +27,31 @@
 
 double get_current_time()
 {
-    struct timeval tv;
-    gettimeofday(&tv, NULL);
+    return get_current_time_ns() / 1000000.0;
+}
+
+int64_t get_current_time_ns()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
 
-    return tv.tv_sec * 1000.0 + tv.tv_usec / 1000.0;
+    return ts.tv_sec * (int64_t)1000000000 + ts.tv_nsec;
 }
 
 #if NCNN_BENCHMARK
 
 void benchmark(const Layer* layer, double start, double end)
 {
-    fprintf(stderr, "%-24s %-30s %8.2lfms", layer->type.c_str(), layer->name.c_str(), end - start);
+    fprintf(stderr, "%-24s %-30s %8.2lfms", layer->type, layer->name, end - start);
     fprintf(stderr, "    |");
     fprintf(stderr, "\n");
 }
 
 void benchmark(const Layer* layer, const Mat& bottom_blob, Mat& top_blob, double start, double end)
 {
-    fprintf(stderr, "%-24s %-30s %8.2lfms", layer->type.c_str(), layer->name.c_str(), end - start);
+    fprintf(stderr, "%-24s %-30s %8.2lfms", layer->type, layer->name, end - start);
     fprintf(stderr, "    |    feature_map: %4d x %-4d    inch: %4d    outch: %4d", bottom_blob.w, bottom_blob.h, bottom_blob.c, top_blob.c);
-    if (layer->type == "Convolution")
+    if (strcmp(layer->type, "Convolution") == 0)
     {
         fprintf(stderr, "     kernel: %1d x %1d     stride: %1d x %1d",
                 ((Convolution*)layer)->kernel_w,
@@ -54,7 +60,7 @@ void benchmark(const Layer* layer, const Mat& bottom_blob, Mat& top_blob, double
                 ((Convolution*)layer)->stride_h
         );
     }
-    else if (layer->type == "ConvolutionDepthWise")
+    else if (strcmp(layer->type, "ConvolutionDepthWise") == 0)
     {
         fprintf(stderr, "     kernel: %1d x %1d     stride: %1d x %1d",
                 ((ConvolutionDepthWise*)layer)->kernel_w,
@@ -63,7 +69,7 @@ void benchmark(const Layer* layer, const Mat& bottom_blob, Mat& top_blob, double
                 ((ConvolutionDepthWise*)layer)->stride_h
         );
     }
-    else if (layer->type == "Deconvolution")
+    else if (strcmp(layer->type, "Deconvolution") == 0)
     {
         fprintf(stderr, "     kernel: %1d x %1d     stride: %1d x %1d",
                 ((Deconvolution*)layer)->kernel_w,
@@ -72,7 +78,7 @@ void benchmark(const Layer* layer, const Mat& bottom_blob, Mat& top_blob, double
                 ((Deconvolution*)layer)->stride_h
         );
     }
-    else if (layer->type == "DeconvolutionDepthWise")
+    else if (strcmp(layer->type, "DeconvolutionDepthWise") == 0)
     {
         fprintf(stderr, "     kernel: %1d x %1d     stride: %1d x %1d",
                 ((DeconvolutionDepthWise*)layer)->kernel_w,
@@ -15,6 +15,7 @@
 #ifndef NCNN_BENCHMARK_H
 #define NCNN_BENCHMARK_H
 
+#include <stdint.h>
 #include "platform.h"
 #include "mat.h"
 #include "layer.h"
@@ -22,6 +23,9 @@
 // get now timestamp in ms
 double get_current_time();
 
+// get now timestamp in ns from the monotonic clock
+int64_t get_current_time_ns();
+
 #if NCNN_BENCHMARK
 
 void benchmark(const Layer* layer, double start, double end);
@@ -15,9 +15,9 @@
 #ifndef NCNN_BLOB_H
 #define NCNN_BLOB_H
 
-#include "cstl/vector.h"
 #include "platform.h"
 #include "mat.h"
+#include "cstl/vector.h"
 
 #include "cstl/class.h"
 
@@ -12,6 +12,11 @@
 // CONDITIONS OF ANY KIND, either express or implied. See the License for the
 // specific language governing permissions and limitations under the License.
 
+#if defined(__linux__) && !defined(__ANDROID__) && !defined(_GNU_SOURCE)
+// for cpu_set_t and sched_setaffinity
+#define _GNU_SOURCE
+#endif
+
 #include "cpu.h"
 
 #include <limits.h>
@@ -22,10 +27,23 @@
 #include <omp.h>
 #endif
 
+#if defined(__i386__) || defined(__x86_64__) || defined(_M_IX86) || defined(_M_X64)
+#define NCNN_CPU_X86 1
+#ifdef _MSC_VER
+#include <intrin.h>
+#include <immintrin.h>
+#else
+#include <cpuid.h>
+#endif
+#endif
+
 #ifdef __ANDROID__
 #include <sys/syscall.h>
 #include <unistd.h>
 #include <stdint.h>
+#elif defined(__linux__)
+#include <errno.h>
+#include <sched.h>
 #endif
 
 #ifdef __ANDROID__
@@ -125,6 +143,93 @@ int cpu_support_arm_asimdhp()
 #endif
 }
 
+#if NCNN_CPU_X86
+static void x86_cpuid(int level, int subleaf, unsigned int out[4])
+{
+#ifdef _MSC_VER
+    __cpuidex((int*)out, level, subleaf);
+#else
+    __cpuid_count(level, subleaf, out[0], out[1], out[2], out[3]);
+#endif
+}
+
+static unsigned int x86_get_xcr0()
+{
+#ifdef _MSC_VER
+    return (unsigned int)_xgetbv(0);
+#else
+    unsigned int eax, edx;
+    __asm__ volatile(".byte 0x0f, 0x01, 0xd0" : "=a"(eax), "=d"(edx) : "c"(0));
+    return eax;
+#endif
+}
+
+// bit 0 = avx2 + fma + f16c
+// bit 1 = avx512f + avx512bw + avx512vl
+static int get_x86_cpu_features()
+{
+    unsigned int regs[4];
+
+    x86_cpuid(0, 0, regs);
+    if (regs[0] < 7)
+        return 0;
+
+    x86_cpuid(1, 0, regs);
+    const unsigned int ecx1 = regs[2];
+
+    // the os must save the ymm / zmm state on context switch
+    const int osxsave = (ecx1 >> 27) & 1;
+    if (!osxsave)
+        return 0;
+
+    const unsigned int xcr0 = x86_get_xcr0();
+
+    x86_cpuid(7, 0, regs);
+    const unsigned int ebx7 = regs[1];
+
+    int features = 0;
+
+    const int avx = (ecx1 >> 28) & 1;
+    const int fma = (ecx1 >> 12) & 1;
+    const int f16c = (ecx1 >> 29) & 1;
+    const int avx2 = (ebx7 >> 5) & 1;
+    if (avx && fma && f16c && avx2 && (xcr0 & 6) == 6)
+        features |= 1;
+
+    const int avx512f = (ebx7 >> 16) & 1;
+    const int avx512bw = (ebx7 >> 30) & 1;
+    const int avx512vl = (ebx7 >> 31) & 1;
+    if ((features & 1) && avx512f && avx512bw && avx512vl && (xcr0 & 0xe6) == 0xe6)
+        features |= 2;
+
+    return features;
+}
+
+static int g_x86_cpu_features = -1;
+#endif // NCNN_CPU_X86
+
+int cpu_support_x86_avx2()
+{
+#if NCNN_CPU_X86
+    if (g_x86_cpu_features == -1)
+        g_x86_cpu_features = get_x86_cpu_features();
+    return g_x86_cpu_features & 1;
+#else
+    return 0;
+#endif
+}
+
+int cpu_support_x86_avx512()
+{
+#if NCNN_CPU_X86
+    if (g_x86_cpu_features == -1)
+        g_x86_cpu_features = get_x86_cpu_features();
+    return (g_x86_cpu_features >> 1) & 1;
+#else
+    return 0;
+#endif
+}
+
 static int get_cpucount()
 {
     int count = 0;
@@ -295,6 +400,27 @@ typedef struct
 
     return 0;
 }
+#elif defined(__linux__)
+static int set_sched_affinity(size_t thread_affinity_mask)
+{
+    cpu_set_t mask;
+    CPU_ZERO(&mask);
+    for (int i=0; i<(int)sizeof(size_t) * 8 && i<CPU_SETSIZE; i++)
+    {
+        if (thread_affinity_mask & ((size_t)1 << i))
+            CPU_SET(i, &mask);
+    }
+
+    // pid 0 is the calling thread
+    int ret = sched_setaffinity(0, sizeof(mask), &mask);
+    if (ret)
+    {
+        fprintf(stderr, "sched_setaffinity error %d\n", errno);
+        return -1;
+    }
+
+    return 0;
+}
 #endif // __ANDROID__
 
 static int g_powersave = 0;
@@ -446,6 +572,17 @@ int set_cpu_thread_affinity(size_t thread_affinity_mask)
 #endif
 }
 
+int set_current_thread_affinity(size_t thread_affinity_mask)
+{
+#if defined(__ANDROID__) || defined(__linux__)
+    return set_sched_affinity(thread_affinity_mask);
+#else
+    // no per thread affinity call on this os
+    (void)thread_affinity_mask;
+    return -1;
+#endif
+}
+
 int get_omp_num_threads()
 {
 #ifdef _OPENMP
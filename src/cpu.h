@@ -28,6 +28,10 @@ int cpu_support_arm_neon();
 int cpu_support_arm_vfpv4();
 // asimdhp = aarch64 asimd half precision
 int cpu_support_arm_asimdhp();
+// avx2 = x86 avx2 + fma + f16c with os support
+int cpu_support_x86_avx2();
+// avx512 = x86 avx512 foundation + bw + vl with os support
+int cpu_support_x86_avx512();
 
 // cpu info
 int get_cpu_count();
@@ -49,6 +53,10 @@ size_t get_cpu_thread_affinity_mask(int powersave);
 // set explicit thread affinity
 int set_cpu_thread_affinity(size_t thread_affinity_mask);
 
+// set explicit thread affinity of the calling thread only
+// used by the ncnn thread pool workers, implemented on android and linux
+int set_current_thread_affinity(size_t thread_affinity_mask);
+
 // misc function wrapper for openmp routines
 int get_omp_num_threads();
 void set_omp_num_threads(int num_threads);
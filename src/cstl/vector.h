@@ -28,7 +28,6 @@
 #include "errnum.h"
 #include <string.h>
 #include <stdlib.h>
-#include <pthread.h>
 
 /* Vector struct definition */
 #define vector_def(type)                    \
@@ -37,8 +36,6 @@
         unsigned int size;                  \
         unsigned int count;                 \
         unsigned int err_num;               \
-        pthread_mutex_t mutex;              \
-        pthread_cond_t cond;                \
         type* (*get)(void *, int);          \
         void *(*ctor)(void *, va_list *);   \
         void *(*dtor)(void *);              \
@@ -71,14 +68,6 @@
     (vector).err_num = 0;                                   \
     (vector).ctor = _ctor;                                  \
     (vector).dtor = _dtor;                                  \
-    if (pthread_mutex_init(&(vector).mutex, NULL) != 0)     \
-    {                                                       \
-        (vector).err_num = ERR_INIT_FAILURE;                \
-    }                                                       \
-    if (pthread_cond_init(&(vector).cond, NULL) != 0)       \
-    {                                                       \
-        (vector).err_num = ERR_INIT_FAILURE;                \
-    }                                                       \
 } while (0)
 
 /* Uninitialize */
@@ -221,9 +210,9 @@
             (vector).size = new_size;                                       \
             if ((vector).ctor)                                              \
             {                                                               \
-                for (int i = (vector).count; i < (new_size); i++)           \
+                for (int i = (vector).count; i < (int)(new_size); i++)      \
                 {                                                           \
-                    (vector).ctor(&vector_get(vector, i));                  \
+                    (vector).ctor(&vector_get(vector, i), NULL);            \
                 }                                                           \
             }                                                               \
             (vector).err_num = ERR_OK;                                      \
@@ -237,7 +226,7 @@
     if ((vector).count >= (vector).size)                                    \
     {                                                                       \
         unsigned int n_size = (vector).size == 0? 4 : ((vector).size * 2);  \
-        vector_resize(vector, n_size);                                      \
+        vector_reserve(vector, n_size);                                     \
     }                                                                       \
     if ((vector).err_num == ERR_OK)                                         \
     {                                                                       \
@@ -273,20 +262,4 @@
     }                                                                   \
 } while (0)
 
-/* Lock the vector for multi-thread operations */
-#define vector_lock(vector) \
-    pthread_mutex_lock(&(vector).mutex);
-
-/* Unock the vector for multi-thread operations */
-#define vector_unlock(vector) \
-    pthread_mutex_unlock(&(vector).mutex);
-
-/* Sleep thread for multi-thread operations */
-#define vector_wait(vector) \
-    pthread_cond_wait(&(vector).cond, &(vector).mutex);
-
-/* Wakeup thread for multi-thread operations */
-#define vector_signal(vector) \
-    pthread_cond_signal(&(vector).cond);
-
 #endif /* __GENERIC_VECTOR_H__ */
@@ -16,6 +16,13 @@
 #include <string.h>
 #include <stdlib.h>
 
+#if NCNN_STDIO && !defined(_WIN32)
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif // NCNN_STDIO && !defined(_WIN32)
+
 #if NCNN_STDIO
 #if NCNN_STRING
 int DataReaderFromStdio_scan(const void *_self, const char* format, void* p)
@@ -30,24 +37,170 @@ size_t DataReaderFromStdio_read(const void *_self, void* buf, size_t size)
     FILE *fp = (FILE *)((struct DataReader *)_self)->dr_handle;
     return fread(buf, 1, size, fp);
 }
+
+size_t DataReaderFromStdio_reference(const void *_self, size_t size, const void** buf)
+{
+    // stream data has to be read out
+    return 0;
+}
 #endif // NCNN_STDIO
 
 #if NCNN_STRING
+static int is_scan_space(char c)
+{
+    return c == ' ' || c == '\t' || c == '\n' || c == '\r' || c == '\v' || c == '\f';
+}
+
+static int is_scan_digit(char c)
+{
+    return c >= '0' && c <= '9';
+}
+
+// the scanf subset the plain param parser uses, hand written to skip the
+// per token format string allocation and the generic scanf machinery
+// white space, literal characters, %d, %f, %s and %[ scansets with an optional width
+// the text must be null terminated
+// the input only advances when the whole format matched
 int DataReaderFromMemory_scan(const void *_self, const char* format, void* p)
 {
-    char **mem_ptr = (char **)((struct DataReader *)_self)->dr_handle;
-    size_t fmtlen = strlen(format);
+    const char **mem_ptr = (const char **)((struct DataReader *)_self)->dr_handle;
+    const char* s = *mem_ptr;
+    const char* f = format;
+    int nscan = 0;
+
+    while (*f)
+    {
+        if (is_scan_space(*f))
+        {
+            while (is_scan_space(*s))
+                s++;
+            f++;
+            continue;
+        }
+
+        if (*f != '%' || f[1] == '%')
+        {
+            if (*f == '%')
+                f++;
+            if (*s != *f)
+                return 0;
+            s++;
+            f++;
+            continue;
+        }
+
+        f++;
+
+        int width = 0;
+        while (is_scan_digit(*f))
+        {
+            width = width * 10 + (*f - '0');
+            f++;
+        }
+
+        if (*f == 'd')
+        {
+            while (is_scan_space(*s))
+                s++;
+
+            const char* q = s;
+            int negative = 0;
+            if (*q == '-' || *q == '+')
+            {
+                negative = *q == '-';
+                q++;
+            }
+            if (!is_scan_digit(*q))
+                return 0;
+
+            int v = 0;
+            while (is_scan_digit(*q))
+            {
+                v = v * 10 + (*q - '0');
+                q++;
+            }
+
+            *(int*)p = negative ? -v : v;
+            s = q;
+            f++;
+        }
+        else if (*f == 'f')
+        {
+            while (is_scan_space(*s))
+                s++;
+
+            char* end = 0;
+            float v = strtof(s, &end);
+            if (end == s)
+                return 0;
+
+            *(float*)p = v;
+            s = end;
+            f++;
+        }
+        else if (*f == 's')
+        {
+            while (is_scan_space(*s))
+                s++;
+
+            char* out = (char*)p;
+            int n = 0;
+            while (*s && !is_scan_space(*s) && (width == 0 || n < width))
+                out[n++] = *s++;
+            if (n == 0)
+                return 0;
 
-    char* format_with_n = (char *)malloc(fmtlen + 3);
-    sprintf(format_with_n, "%s%%n", format);
+            out[n] = '\0';
+            f++;
+        }
+        else if (*f == '[')
+        {
+            f++;
+            int negate = 0;
+            if (*f == '^')
+            {
+                negate = 1;
+                f++;
+            }
 
-    int nconsumed = 0;
-    int nscan = sscanf(*mem_ptr, format_with_n, p, &nconsumed);
-    *mem_ptr += nconsumed;
+            // a leading ] belongs to the set
+            const char* set_begin = f;
+            if (*f == ']')
+                f++;
+            while (*f && *f != ']')
+                f++;
+            if (!*f)
+                return 0;
+            const char* set_end = f;
+            f++;
 
-    free(format_with_n);
+            char* out = (char*)p;
+            int n = 0;
+            while (*s && (width == 0 || n < width))
+            {
+                int in_set = memchr(set_begin, *s, set_end - set_begin) != 0;
+                if (in_set == negate)
+                    break;
 
-    return nconsumed > 0 ? nscan : 0;
+                out[n++] = *s++;
+            }
+            if (n == 0)
+                return 0;
+
+            out[n] = '\0';
+        }
+        else
+        {
+            // unsupported conversion
+            return 0;
+        }
+
+        nscan++;
+    }
+
+    *mem_ptr = s;
+
+    return nscan;
 }
 #endif // NCNN_STRING
 
@@ -58,3 +211,49 @@ size_t DataReaderFromMemory_read(const void *_self, void* buf, size_t size)
     *mem_ptr += size;
     return size;
 }
+
+size_t DataReaderFromMemory_reference(const void *_self, size_t size, const void** buf)
+{
+    char **mem_ptr = (char **)((struct DataReader *)_self)->dr_handle;
+    *buf = *mem_ptr;
+    *mem_ptr += size;
+    return size;
+}
+
+#if NCNN_STDIO
+const unsigned char* DataReaderFromMmap_map(const char* path, size_t* size)
+{
+#if defined(_WIN32)
+    // not supported, the caller falls back to stdio
+    return NULL;
+#else
+    int fd = open(path, O_RDONLY);
+    if (fd < 0)
+        return NULL;
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size <= 0)
+    {
+        close(fd);
+        return NULL;
+    }
+
+    void* addr = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+
+    if (addr == MAP_FAILED)
+        return NULL;
+
+    *size = (size_t)st.st_size;
+    return (const unsigned char*)addr;
+#endif // defined(_WIN32)
+}
+
+void DataReaderFromMmap_unmap(const unsigned char* addr, size_t size)
+{
+#if !defined(_WIN32)
+    if (addr)
+        munmap((void*)addr, size);
+#endif // !defined(_WIN32)
+}
+#endif // NCNN_STDIO
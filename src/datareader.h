@@ -39,6 +39,11 @@ struct DataReader
     // read binary param and model data
     // return bytes read
     size_t (*read)(const void *self, void* buf, size_t size);
+
+    // get binary model data in place instead of copying it out
+    // the data stays valid as long as the memory behind the reader
+    // return bytes referenced, 0 if the reader can not reference
+    size_t (*reference)(const void *self, size_t size, const void** buf);
 };
 
 // the DataReaderFromStdio creator 
@@ -49,15 +54,18 @@ int DataReaderFromStdio_scan(const void *_self, const char* format, void* p);
 #endif // NCNN_STRING
 
 size_t DataReaderFromStdio_read(const void *_self, void* buf, size_t size);
+
+size_t DataReaderFromStdio_reference(const void *_self, size_t size, const void** buf);
 #endif // NCNN_STDIO
 
-#define createDataReaderFromStdio(fp) { \
-    .dr_handle = fp,                    \
-    .scan = DataReaderFromStdio_scan,   \
-    .read = DataReaderFromStdio_read    \
+#define createDataReaderFromStdio(fp) {         \
+    .dr_handle = fp,                            \
+    .scan = DataReaderFromStdio_scan,           \
+    .read = DataReaderFromStdio_read,           \
+    .reference = DataReaderFromStdio_reference  \
 }
 
-// the DataReaderFromStdio creator 
+// the DataReaderFromMemory creator 
 
 #if NCNN_STRING
 int DataReaderFromMemory_scan(const void *_self, const char* format, void* p);
@@ -65,12 +73,30 @@ int DataReaderFromMemory_scan(const void *_self, const char* format, void* p);
 
 size_t DataReaderFromMemory_read(const void *_self, void* buf, size_t size);
 
+size_t DataReaderFromMemory_reference(const void *_self, size_t size, const void** buf);
+
 #define createDataReaderFromMemory(ptr_addr) {  \
     .dr_handle = ptr_addr,                      \
-    .scan = DataReaderFromStdio_scan,           \
-    .read = DataReaderFromStdio_read            \
+    .scan = DataReaderFromMemory_scan,          \
+    .read = DataReaderFromMemory_read,          \
+    .reference = DataReaderFromMemory_reference \
 }
 
+// the DataReaderFromMmap creator
+
+#if NCNN_STDIO
+// map a whole file read only and shared
+// processes mapping the same file share one copy through the page cache
+// and pages are only faulted in when the data is first touched
+// return the mapped address, NULL if the file can not be mapped
+const unsigned char* DataReaderFromMmap_map(const char* path, size_t* size);
+
+void DataReaderFromMmap_unmap(const unsigned char* addr, size_t size);
+#endif // NCNN_STDIO
+
+// a mapped file is plain memory, read and reference it like one
+#define createDataReaderFromMmap(ptr_addr) createDataReaderFromMemory(ptr_addr)
+
 #ifdef __cplusplus 
 }
 #endif
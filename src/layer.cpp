@@ -41,6 +41,11 @@ void *Layer_ctor(void *_self, va_list *args)
     self->forward = va_arg(*args, int (*)(void*, const Mat&, Mat&, const Option&));
     self->forward_inplace_multi = va_arg(*args, int (*)(void*, std::vector<Mat>&, const Option&));
     self->forward_inplace = va_arg(*args, int (*)(void*, Mat&, const Option&));
+    self->infer_shape = va_arg(*args, int (*)(void*, const std::vector<Mat>&, std::vector<Mat>&));
+
+    self->forward_batch = 0;
+
+    self->kernel_name = 0;
 
     self->one_blob_only = false;
     self->support_inplace = false;
@@ -124,8 +129,36 @@ static const layer_registry_entry layer_registry[] =
 #include "layer_registry.h"
 };
 
+#if NCNN_RUNTIME_CPU_X86_AVX2
+static const layer_registry_entry layer_registry_avx2[] =
+{
+#include "layer_registry_avx2.h"
+};
+#endif // NCNN_RUNTIME_CPU_X86_AVX2
+
+#if NCNN_RUNTIME_CPU_X86_AVX512
+static const layer_registry_entry layer_registry_avx512[] =
+{
+#include "layer_registry_avx512.h"
+};
+#endif // NCNN_RUNTIME_CPU_X86_AVX512
+
 static const int layer_registry_entry_count = sizeof(layer_registry) / sizeof(layer_registry_entry);
 
+// pick the kernel variants built for the best instruction set this cpu supports
+static const layer_registry_entry* get_layer_registry()
+{
+#if NCNN_RUNTIME_CPU_X86_AVX512
+    if (cpu_support_x86_avx512())
+        return layer_registry_avx512;
+#endif // NCNN_RUNTIME_CPU_X86_AVX512
+#if NCNN_RUNTIME_CPU_X86_AVX2
+    if (cpu_support_x86_avx2())
+        return layer_registry_avx2;
+#endif // NCNN_RUNTIME_CPU_X86_AVX2
+    return layer_registry;
+}
+
 #if NCNN_STRING
 int layer_to_index(const char* type)
 {
@@ -153,7 +186,7 @@ Layer* create_layer(int index)
     if (index < 0 || index >= layer_registry_entry_count)
         return 0;
 
-    layer_creator_func layer_creator = layer_registry[index].creator;
+    layer_creator_func layer_creator = get_layer_registry()[index].creator;
     if (!layer_creator)
         return 0;
 
@@ -161,3 +194,23 @@ Layer* create_layer(int index)
     layer->typeindex = index;
     return layer;
 }
+
+int Layer_infer_shape(void *_self, const std::vector<Mat>& bottom_shapes, std::vector<Mat>& top_shapes)
+{
+    Layer *self = (Layer *)_self;
+
+    // shape preserving layers are exactly the inplace capable ones
+    if (!self->support_inplace)
+        return -1;
+
+    top_shapes = bottom_shapes;
+
+    return 0;
+}
+
+void Layer_add_weight_mat(void *_self, Mat* m)
+{
+    Layer *self = (Layer *)_self;
+
+    self->weight_mats.push_back(m);
+}
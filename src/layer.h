@@ -75,6 +75,21 @@ struct Layer
     int (*forward_inplace_multi)(void *_self, std::vector<Mat>& bottom_top_blobs, const Option& opt);
     int (*forward_inplace)(void *_self, Mat& bottom_top_blob, const Option& opt);
 
+    // compute output blob shapes from input blob shapes without touching data
+    // shapes are dataless mats carrying dims, w, h and c only
+    // return 0 if success
+    int (*infer_shape)(void *_self, const std::vector<Mat>& bottom_shapes, std::vector<Mat>& top_shapes);
+
+    // run a one blob layer on every sample of a batch with one pass over the weights
+    // bottom_blobs[i] and top_blobs[i] belong to sample i
+    // set by the ctor of implementations that have it, null otherwise
+    // return 0 if success
+    int (*forward_batch)(void *_self, const std::vector<Mat>& bottom_blobs, std::vector<Mat>& top_blobs, const Option& opt);
+
+    // kernel picked by create_pipeline, reported by the profiler
+    // null for layers with a single implementation
+    const char* kernel_name;
+
     // layer type index
     int typeindex;
 #if NCNN_STRING
@@ -90,6 +105,9 @@ struct Layer
     // shape hint
     std::vector<Mat> bottom_shapes;
     std::vector<Mat> top_shapes;
+    // weight mats of the layer, registered by the ctor of each implementation
+    // including the packed copies made in create_pipeline
+    std::vector<Mat*> weight_mats;
 };
 
 // layer constructor
@@ -114,6 +132,12 @@ int Layer_forward_inplace_multi(void *_self, std::vector<Mat>& /*bottom_top_blob
 
 int Layer_forward_inplace(void *_self, Mat& /*bottom_top_blob*/, const Option& /*opt*/);
 
+int Layer_infer_shape(void *_self, const std::vector<Mat>& bottom_shapes, std::vector<Mat>& top_shapes);
+
+// append to weight_mats, for the ctor of an x86 implementation
+// the runtime dispatched variants compiled from it must not instantiate the vector growth code
+void Layer_add_weight_mat(void *_self, Mat* m);
+
 // layer factory function
 typedef Layer* (*layer_creator_func)();
 
@@ -151,7 +175,8 @@ Layer* create_layer(int index);
                     name##_final_forward_multi,         \
                     name##_final_forward,               \
                     name##_final_forward_inplace_multi, \
-                    name##_final_forward_inplace        \
+                    name##_final_forward_inplace,       \
+                    name##_infer_shape                  \
         ); }
 
 #endif // NCNN_LAYER_H
@@ -36,5 +36,6 @@ int AbsVal_forward_inplace(void *_self, Mat& bottom_top_blob, const Option& opt)
 #define AbsVal_forward_multi            Layer_forward_multi
 #define AbsVal_forward                  Layer_forward
 #define AbsVal_forward_inplace_multi    Layer_forward_inplace_multi
+#define AbsVal_infer_shape              Layer_infer_shape
 
 #endif // LAYER_ABSVAL_H
@@ -15,63 +15,83 @@
 #include "batchnorm.h"
 #include <math.h>
 
-DEFINE_LAYER_CREATOR(BatchNorm)
-
-BatchNorm::BatchNorm()
+void *BatchNorm_ctor(void *_self, va_list *args)
 {
-    one_blob_only = true;
-    support_inplace = true;
+    BatchNorm *self = (BatchNorm *)_self;
+
+    self->layer.one_blob_only = true;
+    self->layer.support_inplace = true;
+
+    self->layer.weight_mats.push_back(&self->slope_data);
+    self->layer.weight_mats.push_back(&self->mean_data);
+    self->layer.weight_mats.push_back(&self->var_data);
+    self->layer.weight_mats.push_back(&self->bias_data);
+    self->layer.weight_mats.push_back(&self->a_data);
+    self->layer.weight_mats.push_back(&self->b_data);
+
+    return _self;
 }
 
-int BatchNorm::load_param(const ParamDict& pd)
+int BatchNorm_load_param(void *_self, const ParamDict& pd)
 {
-    channels = pd.get(0, 0);
-    eps = pd.get(1, 0.f);
+    BatchNorm *self = (BatchNorm *)_self;
+
+    self->channels = pd.get(0, 0);
+    self->eps = pd.get(1, 0.f);
 
     return 0;
 }
 
-int BatchNorm::load_model(const ModelBin& mb)
+int BatchNorm_load_model(void *_self, const ModelBin& mb)
 {
-    slope_data = mb.load(channels, 1);
-    if (slope_data.empty())
+    BatchNorm *self = (BatchNorm *)_self;
+
+    const int channels = self->channels;
+
+    self->slope_data = mb.load(channels, 1);
+    if (self->slope_data.empty())
         return -100;
 
-    mean_data = mb.load(channels, 1);
-    if (mean_data.empty())
+    self->mean_data = mb.load(channels, 1);
+    if (self->mean_data.empty())
         return -100;
 
-    var_data = mb.load(channels, 1);
-    if (var_data.empty())
+    self->var_data = mb.load(channels, 1);
+    if (self->var_data.empty())
         return -100;
 
-    bias_data = mb.load(channels, 1);
-    if (bias_data.empty())
+    self->bias_data = mb.load(channels, 1);
+    if (self->bias_data.empty())
         return -100;
 
-    a_data.create(channels);
-    if (a_data.empty())
+    self->a_data.create(channels);
+    if (self->a_data.empty())
         return -100;
-    b_data.create(channels);
-    if (b_data.empty())
+    self->b_data.create(channels);
+    if (self->b_data.empty())
         return -100;
 
     for (int i=0; i<channels; i++)
     {
-        float sqrt_var = static_cast<float>(sqrt(var_data[i] + eps));
-        a_data[i] = bias_data[i] - slope_data[i] * mean_data[i] / sqrt_var;
-        b_data[i] = slope_data[i] / sqrt_var;
+        float sqrt_var = static_cast<float>(sqrt(self->var_data[i] + self->eps));
+        self->a_data[i] = self->bias_data[i] - self->slope_data[i] * self->mean_data[i] / sqrt_var;
+        self->b_data[i] = self->slope_data[i] / sqrt_var;
     }
 
     return 0;
 }
 
-int BatchNorm::forward_inplace(Mat& bottom_top_blob, const Option& opt) const
+int BatchNorm_forward_inplace(void *_self, Mat& bottom_top_blob, const Option& opt)
 {
+    BatchNorm *self = (BatchNorm *)_self;
+
     // a = bias - slope * mean / sqrt(var)
     // b = slope / sqrt(var)
     // value = b * value + a
 
+    const Mat& a_data = self->a_data;
+    const Mat& b_data = self->b_data;
+
     int dims = bottom_top_blob.dims;
 
     if (dims == 1)
@@ -113,7 +133,7 @@ int BatchNorm::forward_inplace(Mat& bottom_top_blob, const Option& opt) const
         int size = w * h;
 
         #pragma omp parallel for num_threads(opt.num_threads)
-        for (int q=0; q<channels; q++)
+        for (int q=0; q<self->channels; q++)
         {
             float* ptr = bottom_top_blob.channel(q);
             float a = a_data[q];
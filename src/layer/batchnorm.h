@@ -17,16 +17,12 @@
 
 #include "layer.h"
 
-struct BatchNorm : public Layer
+struct BatchNorm
 {
-    BatchNorm();
-
-    virtual int load_param(const ParamDict& pd);
-
-    virtual int load_model(const ModelBin& mb);
-
-    virtual int forward_inplace(Mat& bottom_top_blob, const Option& opt) const;
+    // layer base
+    Layer layer;
 
+    // proprietary data
     // param
     int channels;
     float eps;
@@ -41,4 +37,21 @@ struct BatchNorm : public Layer
     Mat b_data;
 };
 
+void *BatchNorm_ctor(void *_self, va_list *args);
+
+int BatchNorm_load_param(void *_self, const ParamDict& pd);
+
+int BatchNorm_load_model(void *_self, const ModelBin& mb);
+
+int BatchNorm_forward_inplace(void *_self, Mat& bottom_top_blob, const Option& opt);
+
+// default operators
+#define BatchNorm_dtor                     Layer_dtor
+#define BatchNorm_create_pipeline          Layer_create_pipeline
+#define BatchNorm_destroy_pipeline         Layer_destroy_pipeline
+#define BatchNorm_forward_multi            Layer_forward_multi
+#define BatchNorm_forward                  Layer_forward
+#define BatchNorm_forward_inplace_multi    Layer_forward_inplace_multi
+#define BatchNorm_infer_shape              Layer_infer_shape
+
 #endif // LAYER_BATCHNORM_H
@@ -601,3 +601,38 @@ int BinaryOp_forward_inplace(void *_self, Mat& bottom_top_blob, const Option& op
 
     return 0;
 }
+
+int BinaryOp_infer_shape(void *_self, const std::vector<Mat>& bottom_shapes, std::vector<Mat>& top_shapes)
+{
+    BinaryOp *self = (BinaryOp *)_self;
+
+    if (self->with_scalar)
+        return Layer_infer_shape(_self, bottom_shapes, top_shapes);
+
+    const Mat& a = bottom_shapes[0];
+    const Mat& b = bottom_shapes[1];
+
+    // the broadcast result takes the shape of the larger operand,
+    // matching the special types dispatched in BinaryOp_forward_multi
+    bool take_b = false;
+    if (b.dims > a.dims)
+    {
+        take_b = true;
+    }
+    else if (a.dims == 3 && b.dims == 3)
+    {
+        bool type1 = b.w == 1 && b.h == 1 && b.c == a.c;
+        bool type2 = b.w == a.w && b.h == a.h && b.c == 1;
+        bool type3 = a.w == 1 && a.h == 1 && b.c == a.c;
+        bool type4 = b.w == a.w && b.h == a.h && a.c == 1;
+        take_b = !type1 && !type2 && (type3 || type4);
+    }
+    else if (a.dims == 1 && b.dims == 1)
+    {
+        take_b = a.w == 1;
+    }
+
+    top_shapes[0] = take_b ? b : a;
+
+    return 0;
+}
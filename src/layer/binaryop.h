@@ -37,6 +37,8 @@ int BinaryOp_forward_multi(void *_self, const std::vector<Mat>& bottom_blobs, st
 
 int BinaryOp_forward_inplace(void *_self, Mat& bottom_top_blob, const Option& opt);
 
+int BinaryOp_infer_shape(void *_self, const std::vector<Mat>& bottom_shapes, std::vector<Mat>& top_shapes);
+
 // default operators
 #define BinaryOp_dtor                     Layer_dtor
 #define BinaryOp_load_model               Layer_load_model
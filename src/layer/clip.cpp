@@ -24,30 +24,36 @@ static inline signed char float2int8(float v)
     return (signed char)int32;
 }
 
-DEFINE_LAYER_CREATOR(Clip)
-
-Clip::Clip()
+void *Clip_ctor(void *_self, va_list *args)
 {
-    one_blob_only = true;
-    support_inplace = true;
+    Layer *self = (Layer *)_self;
+
+    self->one_blob_only = true;
+    self->support_inplace = true;
+
+    return _self;
 }
 
-int Clip::load_param(const ParamDict& pd)
+int Clip_load_param(void *_self, const ParamDict& pd)
 {
-    min = pd.get(0, -FLT_MAX);
-    max = pd.get(1, FLT_MAX);
+    Clip *self = (Clip *)_self;
+
+    self->min = pd.get(0, -FLT_MAX);
+    self->max = pd.get(1, FLT_MAX);
 
     return 0;
 }
 
-int Clip::forward_inplace_int8(Mat& bottom_top_blob, const Option& opt) const
+int Clip_forward_inplace_int8(void *_self, Mat& bottom_top_blob, const Option& opt)
 {
+    Clip *self = (Clip *)_self;
+
     int w = bottom_top_blob.w;
     int h = bottom_top_blob.h;
     int channels = bottom_top_blob.c;
     int size = w * h;
-    signed char min_int8 = float2int8(min);
-    signed char max_int8 = float2int8(max);
+    signed char min_int8 = float2int8(self->min);
+    signed char max_int8 = float2int8(self->max);
 
     #pragma omp parallel for num_threads(opt.num_threads)
     for (int q=0; q<channels; q++)
@@ -66,12 +72,13 @@ int Clip::forward_inplace_int8(Mat& bottom_top_blob, const Option& opt) const
     return 0;
 }
 
-
-int Clip::forward_inplace(Mat& bottom_top_blob, const Option& opt) const
+int Clip_forward_inplace(void *_self, Mat& bottom_top_blob, const Option& opt)
 {
+    Clip *self = (Clip *)_self;
+
     if (bottom_top_blob.elemsize == 1u)
     {
-        return Clip::forward_inplace_int8(bottom_top_blob, opt);
+        return Clip_forward_inplace_int8(self, bottom_top_blob, opt);
     }
 
     int w = bottom_top_blob.w;
@@ -79,6 +86,9 @@ int Clip::forward_inplace(Mat& bottom_top_blob, const Option& opt) const
     int channels = bottom_top_blob.c;
     int size = w * h;
 
+    const float min = self->min;
+    const float max = self->max;
+
     #pragma omp parallel for num_threads(opt.num_threads)
     for (int q=0; q<channels; q++)
     {
@@ -1,6 +1,6 @@
 // Tencent is pleased to support the open source community by making ncnn available.
 //
-// Copyright (C) 2018 THL A29 Limited, a Tencent company. All rights reserved.
+// Copyright (C) 2017 THL A29 Limited, a Tencent company. All rights reserved.
 //
 // Licensed under the BSD 3-Clause License (the "License"); you may not use this file except
 // in compliance with the License. You may obtain a copy of the License at
@@ -17,18 +17,32 @@
 
 #include "layer.h"
 
-struct Clip : public Layer
+struct Clip
 {
-    Clip();
-
-    virtual int load_param(const ParamDict& pd);
-
-    virtual int forward_inplace(Mat& bottom_top_blob, const Option& opt) const;
-    
-    virtual int forward_inplace_int8(Mat& bottom_top_blob, const Option& opt) const;
+    // layer base
+    Layer layer;
 
+    // proprietary data
     float min;
     float max;
 };
 
+void *Clip_ctor(void *_self, va_list *args);
+
+int Clip_load_param(void *_self, const ParamDict& pd);
+
+int Clip_forward_inplace(void *_self, Mat& bottom_top_blob, const Option& opt);
+
+int Clip_forward_inplace_int8(void *_self, Mat& bottom_top_blob, const Option& opt);
+
+// default operators
+#define Clip_dtor                     Layer_dtor
+#define Clip_load_model               Layer_load_model
+#define Clip_create_pipeline          Layer_create_pipeline
+#define Clip_destroy_pipeline         Layer_destroy_pipeline
+#define Clip_forward_multi            Layer_forward_multi
+#define Clip_forward                  Layer_forward
+#define Clip_forward_inplace_multi    Layer_forward_inplace_multi
+#define Clip_infer_shape              Layer_infer_shape
+
 #endif // LAYER_CLIP_H
@@ -34,7 +34,29 @@ int Concat_load_param(void *_self, const ParamDict& pd)
     return 0;
 }
 
-int Concat_forward(void *_self, const std::vector<Mat>& bottom_blobs, std::vector<Mat>& top_blobs, const Option& opt)
+// whether the 3d bottoms follow each other in the memory of one shared buffer
+static bool channel_ranges_adjacent(const std::vector<Mat>& bottom_blobs)
+{
+    const Mat& first = bottom_blobs[0];
+    if (!first.refcount)
+        return false;
+
+    const unsigned char* next = (const unsigned char*)first.data;
+    for (size_t b=0; b<bottom_blobs.size(); b++)
+    {
+        const Mat& bottom_blob = bottom_blobs[b];
+        if (bottom_blob.refcount != first.refcount || bottom_blob.data != next
+            || bottom_blob.w != first.w || bottom_blob.h != first.h || bottom_blob.cstep != first.cstep
+            || bottom_blob.elemsize != first.elemsize || bottom_blob.elempack != first.elempack)
+            return false;
+
+        next += bottom_blob.cstep * bottom_blob.c * bottom_blob.elemsize;
+    }
+
+    return true;
+}
+
+int Concat_forward_multi(void *_self, const std::vector<Mat>& bottom_blobs, std::vector<Mat>& top_blobs, const Option& opt)
 {
     Concat *self = (Concat *)_self;
 
@@ -158,6 +180,16 @@ int Concat_forward(void *_self, const std::vector<Mat>& bottom_blobs, std::vecto
         }
 
         Mat& top_blob = top_blobs[0];
+
+        // the bottoms are adjacent channel ranges of one buffer when their producers
+        // wrote into the slots planned for Option::use_blob_views, that buffer is the result
+        if (channel_ranges_adjacent(bottom_blobs))
+        {
+            top_blob = bottom_blobs[0];
+            top_blob.c = top_channels;
+            return 0;
+        }
+
         top_blob.create(w, h, top_channels, elemsize, opt.blob_allocator);
         if (top_blob.empty())
             return -100;
@@ -263,3 +295,36 @@ int Concat_forward(void *_self, const std::vector<Mat>& bottom_blobs, std::vecto
 
     return 0;
 }
+
+int Concat_infer_shape(void *_self, const std::vector<Mat>& bottom_shapes, std::vector<Mat>& top_shapes)
+{
+    Concat *self = (Concat *)_self;
+
+    Mat top_shape = bottom_shapes[0];
+    int dims = top_shape.dims;
+
+    for (size_t b=1; b<bottom_shapes.size(); b++)
+    {
+        const Mat& bottom_shape = bottom_shapes[b];
+        if (bottom_shape.dims != dims)
+            return -1;
+
+        if (dims == 1 || (dims == 2 && self->axis == 1) || (dims == 3 && self->axis == 2))
+            top_shape.w += bottom_shape.w;
+        else if ((dims == 2 && self->axis == 0) || (dims == 3 && self->axis == 1))
+            top_shape.h += bottom_shape.h;
+        else if (dims == 3 && self->axis == 0)
+            top_shape.c += bottom_shape.c;
+        else
+            return -1;
+    }
+
+    if (dims == 1)
+        top_shapes[0] = Mat(top_shape.w, (void*)0);
+    else if (dims == 2)
+        top_shapes[0] = Mat(top_shape.w, top_shape.h, (void*)0);
+    else
+        top_shapes[0] = Mat(top_shape.w, top_shape.h, top_shape.c, (void*)0);
+
+    return 0;
+}
@@ -13,11 +13,585 @@
 // specific language governing permissions and limitations under the License.
 
 #include "convolution.h"
+#include <stdio.h>
 #include <algorithm>
+#include "cpu.h"
 #include "layer_type.h"
+#include "pipelinecache.h"
 
 #include "cstl/utils.h"
 
+// im2col sgemm blocking
+// the register tile is 4 output channels x 8 output pixels
+// a k block of the packed kernel and input panels is kept hot in cache
+#define CONV_SGEMM_MR 4
+#define CONV_SGEMM_NR 8
+#define CONV_SGEMM_KC 256
+#define CONV_SGEMM_NC_PANELS 16
+
+static inline float conv_activation_ss(float v, int activation_type, const Mat& activation_params)
+{
+    if (activation_type == 1)
+    {
+        v = max(v, 0.f);
+    }
+    else if (activation_type == 2)
+    {
+        float slope = activation_params[0];
+        v = v > 0.f ? v : v * slope;
+    }
+    else if (activation_type == 3)
+    {
+        float min = activation_params[0];
+        float max = activation_params[1];
+        if (v < min)
+            v = min;
+        if (v > max)
+            v = max;
+    }
+    else if (activation_type == 4)
+    {
+        v = static_cast<float>(1.f / (1.f + exp(-v)));
+    }
+    else if (activation_type == 6)
+    {
+        float alpha = activation_params[0];
+        float beta = activation_params[1];
+        v = v * min(max(v * alpha + beta, 0.f), 1.f);
+    }
+
+    return v;
+}
+
+// pack the kernel into panels of 4 output channels, k-major inside a panel
+// kernel_tm = Mat(4 * K, ceil(outch / 4)), the tail rows are zero padded
+static void conv_im2col_sgemm_transform_kernel(const Mat& kernel, Mat& kernel_tm, int inch, int outch, int maxk)
+{
+    const int K = inch * maxk;
+    const int npanels = (outch + CONV_SGEMM_MR - 1) / CONV_SGEMM_MR;
+
+    kernel_tm.create(CONV_SGEMM_MR * K, npanels);
+    if (kernel_tm.empty())
+        return;
+
+    for (int i=0; i<npanels; i++)
+    {
+        float* ktmp = kernel_tm.row(i);
+
+        for (int k=0; k<K; k++)
+        {
+            for (int r=0; r<CONV_SGEMM_MR; r++)
+            {
+                const int p = i * CONV_SGEMM_MR + r;
+                ktmp[k * CONV_SGEMM_MR + r] = p < outch ? ((const float*)kernel)[K * p + k] : 0.f;
+            }
+        }
+    }
+}
+
+// gather the receptive fields of 8 output pixels into one k-major panel
+static void conv_im2col_pack_panel(const Mat& bottom_blob, float* tmpptr, int col0, int N, int outw, const int* space_ofs, int maxk, int stride_w, int stride_h)
+{
+    const int inch = bottom_blob.c;
+    const int w = bottom_blob.w;
+
+    int ofs[CONV_SGEMM_NR];
+    for (int c=0; c<CONV_SGEMM_NR; c++)
+    {
+        const int col = min(col0 + c, N - 1);
+        const int i = col / outw;
+        const int j = col % outw;
+        ofs[c] = i * stride_h * w + j * stride_w;
+    }
+
+    for (int q=0; q<inch; q++)
+    {
+        const float* sptr = bottom_blob.channel(q);
+
+        for (int k=0; k<maxk; k++)
+        {
+            const float* sptr_k = sptr + space_ofs[k];
+
+            for (int c=0; c<CONV_SGEMM_NR; c++)
+            {
+                tmpptr[c] = sptr_k[ofs[c]];
+            }
+
+            tmpptr += CONV_SGEMM_NR;
+        }
+    }
+}
+
+// c[4][8] (+)= a[kc][4] * b[kc][8]
+// the inner loops have constant trip counts so the compiler keeps the tile in vector registers
+static void conv_sgemm_kernel_4x8(const float* a, const float* b, int kc, float* acc)
+{
+    float sum[CONV_SGEMM_MR][CONV_SGEMM_NR];
+    for (int r=0; r<CONV_SGEMM_MR; r++)
+    {
+        for (int c=0; c<CONV_SGEMM_NR; c++)
+        {
+            sum[r][c] = acc[r * CONV_SGEMM_NR + c];
+        }
+    }
+
+    for (int k=0; k<kc; k++)
+    {
+        for (int r=0; r<CONV_SGEMM_MR; r++)
+        {
+            const float va = a[r];
+            for (int c=0; c<CONV_SGEMM_NR; c++)
+            {
+                sum[r][c] += va * b[c];
+            }
+        }
+
+        a += CONV_SGEMM_MR;
+        b += CONV_SGEMM_NR;
+    }
+
+    for (int r=0; r<CONV_SGEMM_MR; r++)
+    {
+        for (int c=0; c<CONV_SGEMM_NR; c++)
+        {
+            acc[r * CONV_SGEMM_NR + c] = sum[r][c];
+        }
+    }
+}
+
+static int conv_im2col_sgemm(void *_self, const Mat& bottom_blob, Mat& top_blob, const Option& opt)
+{
+    Convolution *self = (Convolution *)_self;
+
+    const int w = bottom_blob.w;
+    const int inch = bottom_blob.c;
+
+    const int outw = top_blob.w;
+    const int outh = top_blob.h;
+    const int outch = top_blob.c;
+
+    const int maxk = self->kernel_w * self->kernel_h;
+    const int K = inch * maxk;
+    const int N = outw * outh;
+
+    // kernel offsets
+    std::vector<int> _space_ofs(maxk);
+    int* space_ofs = &_space_ofs[0];
+    {
+        int p1 = 0;
+        int p2 = 0;
+        int gap = w * self->dilation_h - self->kernel_w * self->dilation_w;
+        for (int i = 0; i < self->kernel_h; i++)
+        {
+            for (int j = 0; j < self->kernel_w; j++)
+            {
+                space_ofs[p1] = p2;
+                p1++;
+                p2 += self->dilation_w;
+            }
+            p2 += gap;
+        }
+    }
+
+    const int mpanels = (outch + CONV_SGEMM_MR - 1) / CONV_SGEMM_MR;
+    const int npanels = (N + CONV_SGEMM_NR - 1) / CONV_SGEMM_NR;
+
+    // split the output pixels into column blocks, one block per task
+    // keep at least as many blocks as threads for small feature maps
+    int nc_panels = (npanels + opt.num_threads - 1) / opt.num_threads;
+    nc_panels = max(1, min(nc_panels, CONV_SGEMM_NC_PANELS));
+    const int nblocks = (npanels + nc_panels - 1) / nc_panels;
+
+    // per-thread im2col buffer for one column block
+    Mat bottom_tm(CONV_SGEMM_NR * K, nc_panels, opt.num_threads, 4u, opt.workspace_allocator);
+    if (bottom_tm.empty())
+        return -100;
+
+    const float* bias = self->bias_term ? (const float*)self->bias_data : 0;
+
+    #pragma omp parallel for num_threads(opt.num_threads)
+    for (int nb=0; nb<nblocks; nb++)
+    {
+        Mat tmp = bottom_tm.channel(get_omp_thread_num());
+
+        const int panel0 = nb * nc_panels;
+        const int panel1 = min(panel0 + nc_panels, npanels);
+
+        for (int j=panel0; j<panel1; j++)
+        {
+            conv_im2col_pack_panel(bottom_blob, tmp.row(j - panel0), j * CONV_SGEMM_NR, N, outw, space_ofs, maxk, self->stride_w, self->stride_h);
+        }
+
+        // partial sums live in top_blob between k blocks,
+        // bias goes in with the first block and activation with the last one
+        for (int kk=0; kk<K; kk+=CONV_SGEMM_KC)
+        {
+            const int kc = min(CONV_SGEMM_KC, K - kk);
+            const bool first_block = kk == 0;
+            const bool last_block = kk + kc == K;
+
+            for (int i=0; i<mpanels; i++)
+            {
+                const float* kptr = (const float*)self->weight_sgemm_data.row(i) + kk * CONV_SGEMM_MR;
+                const int mr = min(CONV_SGEMM_MR, outch - i * CONV_SGEMM_MR);
+
+                for (int j=panel0; j<panel1; j++)
+                {
+                    const float* tmpptr = (const float*)tmp.row(j - panel0) + kk * CONV_SGEMM_NR;
+
+                    const int col0 = j * CONV_SGEMM_NR;
+                    const int nr = min(CONV_SGEMM_NR, N - col0);
+
+                    float acc[CONV_SGEMM_MR * CONV_SGEMM_NR] = {0.f};
+                    for (int r=0; r<mr; r++)
+                    {
+                        const int p = i * CONV_SGEMM_MR + r;
+                        const float* outptr = (const float*)top_blob.channel(p) + col0;
+                        for (int c=0; c<nr; c++)
+                        {
+                            acc[r * CONV_SGEMM_NR + c] = first_block ? (bias ? bias[p] : 0.f) : outptr[c];
+                        }
+                    }
+
+                    conv_sgemm_kernel_4x8(kptr, tmpptr, kc, acc);
+
+                    for (int r=0; r<mr; r++)
+                    {
+                        float* outptr = (float*)top_blob.channel(i * CONV_SGEMM_MR + r) + col0;
+                        for (int c=0; c<nr; c++)
+                        {
+                            float v = acc[r * CONV_SGEMM_NR + c];
+                            outptr[c] = last_block ? conv_activation_ss(v, self->activation_type, self->activation_params) : v;
+                        }
+                    }
+                }
+            }
+        }
+    }
+
+    return 0;
+}
+
+// winograd F(6,3) and F(4,3) transform matrices
+//   U = G g G^T    V = B^T d B    Y = A^T [U . V] A
+struct conv3x3s1_winograd63
+{
+    enum { tile = 6, alpha = 8 };
+    static const float ktm[8][3];
+    static const float itm[8][8];
+    static const float otm[6][8];
+};
+
+const float conv3x3s1_winograd63::ktm[8][3] = {
+    {   1.0f,     0.0f,     0.0f},
+    {-2.0f/9,  -2.0f/9,  -2.0f/9},
+    {-2.0f/9,   2.0f/9,  -2.0f/9},
+    {1.0f/90,  1.0f/45,  2.0f/45},
+    {1.0f/90, -1.0f/45,  2.0f/45},
+    {1.0f/45,  1.0f/90, 1.0f/180},
+    {1.0f/45, -1.0f/90, 1.0f/180},
+    {   0.0f,     0.0f,     1.0f}
+};
+
+const float conv3x3s1_winograd63::itm[8][8] = {
+    {1.0f,  0.0f, -5.25f,  0.00f,  5.25f,  0.00f, -1.0f, 0.0f},
+    {0.0f,  1.0f,  1.00f, -4.25f, -4.25f,  1.00f,  1.0f, 0.0f},
+    {0.0f, -1.0f,  1.00f,  4.25f, -4.25f, -1.00f,  1.0f, 0.0f},
+    {0.0f,  0.5f,  0.25f, -2.50f, -1.25f,  2.00f,  1.0f, 0.0f},
+    {0.0f, -0.5f,  0.25f,  2.50f, -1.25f, -2.00f,  1.0f, 0.0f},
+    {0.0f,  2.0f,  4.00f, -2.50f, -5.00f,  0.50f,  1.0f, 0.0f},
+    {0.0f, -2.0f,  4.00f,  2.50f, -5.00f, -0.50f,  1.0f, 0.0f},
+    {0.0f, -1.0f,  0.00f,  5.25f,  0.00f, -5.25f,  0.0f, 1.0f}
+};
+
+const float conv3x3s1_winograd63::otm[6][8] = {
+    {1.0f,  1.0f,   1.0f,   1.0f,   1.0f,  32.0f,  32.0f, 0.0f},
+    {0.0f,  1.0f,  -1.0f,   2.0f,  -2.0f,  16.0f, -16.0f, 0.0f},
+    {0.0f,  1.0f,   1.0f,   4.0f,   4.0f,   8.0f,   8.0f, 0.0f},
+    {0.0f,  1.0f,  -1.0f,   8.0f,  -8.0f,   4.0f,  -4.0f, 0.0f},
+    {0.0f,  1.0f,   1.0f,  16.0f,  16.0f,   2.0f,   2.0f, 0.0f},
+    {0.0f,  1.0f,  -1.0f,  32.0f, -32.0f,   1.0f,  -1.0f, 1.0f}
+};
+
+struct conv3x3s1_winograd43
+{
+    enum { tile = 4, alpha = 6 };
+    static const float ktm[6][3];
+    static const float itm[6][6];
+    static const float otm[4][6];
+};
+
+const float conv3x3s1_winograd43::ktm[6][3] = {
+    { 1.0f/4,     0.0f,    0.0f},
+    {-1.0f/6,  -1.0f/6, -1.0f/6},
+    {-1.0f/6,   1.0f/6, -1.0f/6},
+    {1.0f/24,  1.0f/12,  1.0f/6},
+    {1.0f/24, -1.0f/12,  1.0f/6},
+    {   0.0f,     0.0f,    1.0f}
+};
+
+const float conv3x3s1_winograd43::itm[6][6] = {
+    {4.0f,  0.0f, -5.0f,  0.0f, 1.0f, 0.0f},
+    {0.0f, -4.0f, -4.0f,  1.0f, 1.0f, 0.0f},
+    {0.0f,  4.0f, -4.0f, -1.0f, 1.0f, 0.0f},
+    {0.0f, -2.0f, -1.0f,  2.0f, 1.0f, 0.0f},
+    {0.0f,  2.0f, -1.0f, -2.0f, 1.0f, 0.0f},
+    {0.0f,  4.0f,  0.0f, -5.0f, 0.0f, 1.0f}
+};
+
+const float conv3x3s1_winograd43::otm[4][6] = {
+    {1.0f,  1.0f,  1.0f,  1.0f,  1.0f, 0.0f},
+    {0.0f,  1.0f, -1.0f,  2.0f, -2.0f, 0.0f},
+    {0.0f,  1.0f,  1.0f,  4.0f,  4.0f, 0.0f},
+    {0.0f,  1.0f, -1.0f,  8.0f, -8.0f, 1.0f}
+};
+
+// kernel_tm = Mat(4 * inch, ceil(outch / 4), alpha * alpha)
+// every transform position holds the same 4-row panels as the im2col sgemm kernel
+template<typename T>
+static void conv3x3s1_winograd_transform_kernel(const Mat& kernel, Mat& kernel_tm, int inch, int outch)
+{
+    const int alpha = T::alpha;
+    const int mpanels = (outch + CONV_SGEMM_MR - 1) / CONV_SGEMM_MR;
+
+    kernel_tm.create(CONV_SGEMM_MR * inch, mpanels, alpha * alpha);
+    if (kernel_tm.empty())
+        return;
+
+    kernel_tm.fill(0.f);
+
+    #pragma omp parallel for
+    for (int p=0; p<outch; p++)
+    {
+        for (int q=0; q<inch; q++)
+        {
+            const float* k0 = (const float*)kernel + p * inch * 9 + q * 9;
+
+            // G g
+            float tmp[alpha][3];
+            for (int i=0; i<alpha; i++)
+            {
+                for (int j=0; j<3; j++)
+                {
+                    tmp[i][j] = T::ktm[i][0] * k0[j] + T::ktm[i][1] * k0[3 + j] + T::ktm[i][2] * k0[6 + j];
+                }
+            }
+
+            // (G g) G^T
+            for (int i=0; i<alpha; i++)
+            {
+                for (int j=0; j<alpha; j++)
+                {
+                    float* ktmp = kernel_tm.channel(i * alpha + j).row(p / CONV_SGEMM_MR);
+                    ktmp[q * CONV_SGEMM_MR + p % CONV_SGEMM_MR] = tmp[i][0] * T::ktm[j][0] + tmp[i][1] * T::ktm[j][1] + tmp[i][2] * T::ktm[j][2];
+                }
+            }
+        }
+    }
+}
+
+// bottom_blob is padded to 2 + tile * n in both directions
+template<typename T>
+static int conv3x3s1_winograd(const Mat& bottom_blob, Mat& top_blob, const Mat& kernel_tm, const float* bias, int activation_type, const Mat& activation_params, const Option& opt)
+{
+    const int tile = T::tile;
+    const int alpha = T::alpha;
+    const int npos = alpha * alpha;
+
+    const int inch = bottom_blob.c;
+    const int outw = top_blob.w;
+    const int outh = top_blob.h;
+    const int outch = top_blob.c;
+
+    const int tiles_w = (outw + tile - 1) / tile;
+    const int tiles_h = (outh + tile - 1) / tile;
+    const int tiles = tiles_w * tiles_h;
+
+    const int mpanels = (outch + CONV_SGEMM_MR - 1) / CONV_SGEMM_MR;
+    const int npanels = (tiles + CONV_SGEMM_NR - 1) / CONV_SGEMM_NR;
+
+    // tiles are processed in blocks so the transformed input of one block stays in cache
+    int nc_panels = (npanels + opt.num_threads - 1) / opt.num_threads;
+    nc_panels = max(1, min(nc_panels, 4));
+    const int nblocks = (npanels + nc_panels - 1) / nc_panels;
+
+    // per-thread transformed input, [pos][panel][inch][8]
+    Mat bottom_tm(CONV_SGEMM_NR * inch * nc_panels, npos, opt.num_threads, 4u, opt.workspace_allocator);
+    if (bottom_tm.empty())
+        return -100;
+
+    // per-thread gemm result of one output channel panel, [panel][pos][4][8]
+    Mat top_tm(CONV_SGEMM_MR * CONV_SGEMM_NR * npos, nc_panels, opt.num_threads, 4u, opt.workspace_allocator);
+    if (top_tm.empty())
+        return -100;
+
+    #pragma omp parallel for num_threads(opt.num_threads)
+    for (int nb=0; nb<nblocks; nb++)
+    {
+        Mat btm = bottom_tm.channel(get_omp_thread_num());
+        Mat ttm = top_tm.channel(get_omp_thread_num());
+
+        const int panel0 = nb * nc_panels;
+        const int panel1 = min(panel0 + nc_panels, npanels);
+
+        // input transform
+        for (int j=panel0; j<panel1; j++)
+        {
+            for (int c=0; c<CONV_SGEMM_NR; c++)
+            {
+                const int t = j * CONV_SGEMM_NR + c;
+
+                for (int q=0; q<inch; q++)
+                {
+                    float d[alpha][alpha];
+                    if (t < tiles)
+                    {
+                        const Mat m = bottom_blob.channel(q);
+                        const int ti = t / tiles_w;
+                        const int tj = t % tiles_w;
+                        for (int a=0; a<alpha; a++)
+                        {
+                            const float* r0 = m.row(ti * tile + a) + tj * tile;
+                            for (int b=0; b<alpha; b++)
+                            {
+                                d[a][b] = r0[b];
+                            }
+                        }
+                    }
+                    else
+                    {
+                        for (int a=0; a<alpha; a++)
+                        {
+                            for (int b=0; b<alpha; b++)
+                            {
+                                d[a][b] = 0.f;
+                            }
+                        }
+                    }
+
+                    // B^T d
+                    float tmp[alpha][alpha];
+                    for (int a=0; a<alpha; a++)
+                    {
+                        for (int b=0; b<alpha; b++)
+                        {
+                            float v = 0.f;
+                            for (int k=0; k<alpha; k++)
+                            {
+                                v += T::itm[a][k] * d[k][b];
+                            }
+                            tmp[a][b] = v;
+                        }
+                    }
+
+                    // (B^T d) B
+                    for (int a=0; a<alpha; a++)
+                    {
+                        for (int b=0; b<alpha; b++)
+                        {
+                            float v = 0.f;
+                            for (int k=0; k<alpha; k++)
+                            {
+                                v += tmp[a][k] * T::itm[b][k];
+                            }
+
+                            float* vptr = btm.row(a * alpha + b);
+                            vptr[((j - panel0) * inch + q) * CONV_SGEMM_NR + c] = v;
+                        }
+                    }
+                }
+            }
+        }
+
+        for (int i=0; i<mpanels; i++)
+        {
+            // batched gemm, one per transform position
+            for (int j=panel0; j<panel1; j++)
+            {
+                float* accptr = ttm.row(j - panel0);
+
+                for (int pos=0; pos<npos; pos++)
+                {
+                    const float* kptr = kernel_tm.channel(pos).row(i);
+                    const float* vptr = (const float*)btm.row(pos) + (j - panel0) * inch * CONV_SGEMM_NR;
+
+                    float* acc = accptr + pos * CONV_SGEMM_MR * CONV_SGEMM_NR;
+                    for (int k=0; k<CONV_SGEMM_MR * CONV_SGEMM_NR; k++)
+                    {
+                        acc[k] = 0.f;
+                    }
+
+                    conv_sgemm_kernel_4x8(kptr, vptr, inch, acc);
+                }
+            }
+
+            // output transform with bias and activation
+            const int mr = min(CONV_SGEMM_MR, outch - i * CONV_SGEMM_MR);
+            for (int j=panel0; j<panel1; j++)
+            {
+                const float* accptr = ttm.row(j - panel0);
+
+                for (int r=0; r<mr; r++)
+                {
+                    const int p = i * CONV_SGEMM_MR + r;
+                    const float bias0 = bias ? bias[p] : 0.f;
+                    Mat out = top_blob.channel(p);
+
+                    for (int c=0; c<CONV_SGEMM_NR; c++)
+                    {
+                        const int t = j * CONV_SGEMM_NR + c;
+                        if (t >= tiles)
+                            break;
+
+                        float m[alpha][alpha];
+                        for (int a=0; a<alpha; a++)
+                        {
+                            for (int b=0; b<alpha; b++)
+                            {
+                                m[a][b] = accptr[(a * alpha + b) * CONV_SGEMM_MR * CONV_SGEMM_NR + r * CONV_SGEMM_NR + c];
+                            }
+                        }
+
+                        // A^T m
+                        float tmp[tile][alpha];
+                        for (int a=0; a<tile; a++)
+                        {
+                            for (int b=0; b<alpha; b++)
+                            {
+                                float v = 0.f;
+                                for (int k=0; k<alpha; k++)
+                                {
+                                    v += T::otm[a][k] * m[k][b];
+                                }
+                                tmp[a][b] = v;
+                            }
+                        }
+
+                        // (A^T m) A
+                        const int ti = t / tiles_w;
+                        const int tj = t % tiles_w;
+                        for (int a=0; a<tile && ti * tile + a < outh; a++)
+                        {
+                            float* outptr = out.row(ti * tile + a) + tj * tile;
+                            for (int b=0; b<tile && tj * tile + b < outw; b++)
+                            {
+                                float v = bias0;
+                                for (int k=0; k<alpha; k++)
+                                {
+                                    v += tmp[a][k] * T::otm[b][k];
+                                }
+                                outptr[b] = conv_activation_ss(v, activation_type, activation_params);
+                            }
+                        }
+                    }
+                }
+            }
+        }
+    }
+
+    return 0;
+}
+
 void *Convolution_ctor(void *_self, va_list *args)
 {
     Convolution *self = (Convolution *)_self;
@@ -27,6 +601,16 @@ void *Convolution_ctor(void *_self, va_list *args)
 
     self->use_int8_requantize = false;
 
+    self->winograd_tile_size = 0;
+
+    self->layer.weight_mats.push_back(&self->weight_data);
+    self->layer.weight_mats.push_back(&self->bias_data);
+    self->layer.weight_mats.push_back(&self->weight_data_int8_scales);
+    self->layer.weight_mats.push_back(&self->weight_sgemm_data);
+    self->layer.weight_mats.push_back(&self->weight_3x3_winograd_data);
+
+    self->layer.forward_batch = Convolution_forward_batch;
+
     return _self;
 }
 
@@ -80,6 +664,54 @@ int Convolution_load_model(void *_self, const ModelBin& mb)
     return 0;
 }
 
+// transform weight_data for the generic 3x3s1 winograd kernel if the options and the shape allow it
+// create_pipeline does it for the plain layer, an arch implementation falling back to
+// Convolution_forward calls it itself
+int Convolution_create_pipeline_winograd(void *_self, const Option& opt)
+{
+    Convolution *self = (Convolution *)_self;
+
+    self->winograd_tile_size = 0;
+
+    if (opt.use_winograd_convolution && self->weight_data.elemsize == (size_t)4u
+        && self->kernel_w == 3 && self->kernel_h == 3 && self->dilation_w == 1 && self->dilation_h == 1 && self->stride_w == 1 && self->stride_h == 1)
+    {
+        const int num_input = self->weight_data_size / 9 / self->num_output;
+
+        // F(6,3) has the lower arithmetic cost, unless the shape hint says
+        // the feature map is so small that the 6x6 tiles are mostly padding
+        self->winograd_tile_size = 6;
+
+        const Layer* layer = (const Layer*)_self;
+        if (layer->top_shapes.size() == 1 && layer->top_shapes[0].dims == 3)
+        {
+            const int outw = layer->top_shapes[0].w;
+            const int outh = layer->top_shapes[0].h;
+            const int cost63 = ((outw + 5) / 6) * ((outh + 5) / 6) * 64;
+            const int cost43 = ((outw + 3) / 4) * ((outh + 3) / 4) * 36;
+            if (cost43 < cost63)
+                self->winograd_tile_size = 4;
+        }
+
+        const int params[3] = { num_input, self->num_output, self->winograd_tile_size };
+        PipelineCacheKey key;
+        if (!pipeline_cache_lookup(opt, "Convolution_winograd", params, 3, self->weight_data, key, self->weight_3x3_winograd_data))
+        {
+            if (self->winograd_tile_size == 6)
+                conv3x3s1_winograd_transform_kernel<conv3x3s1_winograd63>(self->weight_data, self->weight_3x3_winograd_data, num_input, self->num_output);
+            else
+                conv3x3s1_winograd_transform_kernel<conv3x3s1_winograd43>(self->weight_data, self->weight_3x3_winograd_data, num_input, self->num_output);
+
+            pipeline_cache_store(opt, key, self->weight_3x3_winograd_data);
+        }
+
+        if (self->weight_3x3_winograd_data.empty())
+            return -100;
+    }
+
+    return 0;
+}
+
 int Convolution_create_pipeline(void *_self, const Option& opt)
 {
     Convolution *self = (Convolution *)_self;
@@ -106,6 +738,65 @@ int Convolution_create_pipeline(void *_self, const Option& opt)
         self->weight_data = int8_weight_data;
     }
 
+    self->winograd_tile_size = 0;
+
+    // an arch implementation packs its own layouts from weight_data after this,
+    // the generic ones would only be thrown away
+    Layer* layer = (Layer*)_self;
+    const bool arch_forward = layer->forward != Convolution_forward;
+
+    if (!arch_forward)
+    {
+        int ret = Convolution_create_pipeline_winograd(self, opt);
+        if (ret != 0)
+            return ret;
+    }
+
+    if (!arch_forward && opt.use_sgemm_convolution && self->weight_data.elemsize == (size_t)4u && self->winograd_tile_size == 0)
+    {
+        const int maxk = self->kernel_w * self->kernel_h;
+        const int num_input = self->weight_data_size / maxk / self->num_output;
+
+        const int params[3] = { num_input, self->num_output, maxk };
+        PipelineCacheKey key;
+        if (!pipeline_cache_lookup(opt, "Convolution_sgemm", params, 3, self->weight_data, key, self->weight_sgemm_data))
+        {
+            conv_im2col_sgemm_transform_kernel(self->weight_data, self->weight_sgemm_data, num_input, self->num_output, maxk);
+            pipeline_cache_store(opt, key, self->weight_sgemm_data);
+        }
+
+        if (self->weight_sgemm_data.empty())
+            return -100;
+    }
+
+    if (opt.use_int8_inference && self->weight_data.elemsize == (size_t)1u)
+        layer->kernel_name = "int8";
+    else if (self->winograd_tile_size == 6)
+        layer->kernel_name = "winograd63";
+    else if (self->winograd_tile_size == 4)
+        layer->kernel_name = "winograd43";
+    else if (!self->weight_sgemm_data.empty())
+        layer->kernel_name = "im2col_sgemm";
+    else
+        layer->kernel_name = "direct";
+
+    // an arch implementation releases it itself once its own layouts are packed
+    if (opt.lightweight && !arch_forward && (self->winograd_tile_size != 0 || !self->weight_sgemm_data.empty()))
+    {
+        self->weight_data.release();
+    }
+
+    return 0;
+}
+
+int Convolution_destroy_pipeline(void *_self, const Option& opt)
+{
+    Convolution *self = (Convolution *)_self;
+
+    self->weight_sgemm_data.release();
+    self->weight_3x3_winograd_data.release();
+    self->winograd_tile_size = 0;
+
     return 0;
 }
 
@@ -125,6 +816,28 @@ int Convolution_forward(void *_self, const Mat& bottom_blob, Mat& top_blob, cons
     if (bottom_blob.dims == 1 && self->kernel_w == 1 && self->kernel_h == 1)
     {
         int num_input = self->weight_data_size / self->num_output;
+        if (bottom_blob.w == num_input && self->weight_data.empty())
+        {
+            // the flat weights were released in lightweight mode,
+            // run the packed 1x1 kernel over a 1x1 feature map instead
+            const Layer* layer = (const Layer*)_self;
+
+            Mat bottom_blob_3d = bottom_blob.reshape(1, 1, num_input, opt.workspace_allocator);
+            if (bottom_blob_3d.empty())
+                return -100;
+
+            Mat top_blob_3d;
+            int ret = layer->forward(_self, bottom_blob_3d, top_blob_3d, opt);
+            if (ret != 0)
+                return ret;
+
+            top_blob = top_blob_3d.reshape(self->num_output, opt.blob_allocator);
+            if (top_blob.empty())
+                return -100;
+
+            return 0;
+        }
+
         if (bottom_blob.w == num_input)
         {
             // call InnerProduct
@@ -184,6 +897,38 @@ int Convolution_forward(void *_self, const Mat& bottom_blob, Mat& top_blob, cons
     int outw = (w - kernel_extent_w) / self->stride_w + 1;
     int outh = (h - kernel_extent_h) / self->stride_h + 1;
 
+    // the kernel follows what create_pipeline prepared, not the options of this forward,
+    // as the flat weights the direct loop reads may be released in lightweight mode
+    if (self->winograd_tile_size != 0 && bottom_blob.dims == 3)
+    {
+        const int tile = self->winograd_tile_size;
+
+        // pad to tile * n + 2
+        const int outw_tm = (outw + tile - 1) / tile * tile;
+        const int outh_tm = (outh + tile - 1) / tile * tile;
+
+        Mat bottom_blob_tm = bottom_blob_bordered;
+        if (outw_tm != outw || outh_tm != outh)
+        {
+            Option opt_b = opt;
+            opt_b.blob_allocator = opt.workspace_allocator;
+            copy_make_border(bottom_blob_bordered, bottom_blob_tm, 0, outh_tm - outh, 0, outw_tm - outw, BORDER_CONSTANT, 0.f, opt_b);
+            if (bottom_blob_tm.empty())
+                return -100;
+        }
+
+        top_blob.create(outw, outh, self->num_output, elemsize, opt.blob_allocator);
+        if (top_blob.empty())
+            return -100;
+
+        const float* bias = self->bias_term ? (const float*)self->bias_data : 0;
+
+        if (tile == 6)
+            return conv3x3s1_winograd<conv3x3s1_winograd63>(bottom_blob_tm, top_blob, self->weight_3x3_winograd_data, bias, self->activation_type, self->activation_params, opt);
+
+        return conv3x3s1_winograd<conv3x3s1_winograd43>(bottom_blob_tm, top_blob, self->weight_3x3_winograd_data, bias, self->activation_type, self->activation_params, opt);
+    }
+
     const int maxk = self->kernel_w * self->kernel_h;
 
     // kernel offsets
@@ -210,6 +955,17 @@ int Convolution_forward(void *_self, const Mat& bottom_blob, Mat& top_blob, cons
     if (top_blob.empty())
         return -100;
 
+    if (!self->weight_sgemm_data.empty())
+    {
+        return conv_im2col_sgemm(self, bottom_blob_bordered, top_blob, opt);
+    }
+
+    if (self->weight_data.empty())
+    {
+        fprintf(stderr, "Convolution weight data released in lightweight mode, no packed kernel for input dims %d\n", bottom_blob.dims);
+        return -1;
+    }
+
     // num_output
     #pragma omp parallel for num_threads(opt.num_threads)
     for (int p=0; p<self->num_output; p++)
@@ -243,30 +999,7 @@ int Convolution_forward(void *_self, const Mat& bottom_blob, Mat& top_blob, cons
                     kptr += maxk;
                 }
 
-                if (self->activation_type == 1)
-                {
-                    sum = max(sum, 0.f);
-                }
-                else if (self->activation_type == 2)
-                {
-                    float slope = self->activation_params[0];
-                    sum = sum > 0.f ? sum : sum * slope;
-                }
-                else if (self->activation_type == 3)
-                {
-                    float min = self->activation_params[0];
-                    float max = self->activation_params[1];
-                    if (sum < min)
-                        sum = min;
-                    if (sum > max)
-                        sum = max;
-                }
-                else if (self->activation_type == 4)
-                {
-                    sum = static_cast<float>(1.f / (1.f + exp(-sum)));
-                }
-
-                outptr[j] = sum;
+                outptr[j] = conv_activation_ss(sum, self->activation_type, self->activation_params);
             }
 
             outptr += outw;
@@ -472,3 +1205,237 @@ int Convolution_forward_int8(void *_self, const Mat& bottom_blob, Mat& top_blob,
 
     return 0;
 }
+
+int Convolution_forward_batch(void *_self, const std::vector<Mat>& bottom_blobs, std::vector<Mat>& top_blobs, const Option& opt)
+{
+    Convolution *self = (Convolution *)_self;
+    const Layer* layer = (const Layer*)_self;
+
+    const int batch = (int)bottom_blobs.size();
+
+    // the batched gemm reads the flat fp32 weights, released in lightweight mode
+    bool batchable = !self->weight_data.empty()
+                     && !(opt.use_int8_inference && self->weight_data.elemsize == (size_t)1u);
+
+    const Mat& bottom_blob0 = bottom_blobs[0];
+    for (int b=0; b<batch; b++)
+    {
+        const Mat& m = bottom_blobs[b];
+        if (m.dims != 3 || m.w != bottom_blob0.w || m.h != bottom_blob0.h || m.c != bottom_blob0.c || m.elemsize != 4u)
+            batchable = false;
+    }
+
+    const int channels = bottom_blob0.c;
+    const int maxk = self->kernel_w * self->kernel_h;
+    const int kernel_extent_w = self->dilation_w * (self->kernel_w - 1) + 1;
+    const int kernel_extent_h = self->dilation_h * (self->kernel_h - 1) + 1;
+
+    std::vector<Mat> bottom_blobs_bordered(batch);
+    if (batchable)
+    {
+        for (int b=0; b<batch; b++)
+        {
+            Convolution_make_padding(self, bottom_blobs[b], bottom_blobs_bordered[b], opt);
+            if (bottom_blobs_bordered[b].empty())
+                return -100;
+        }
+    }
+
+    const int w = bottom_blobs_bordered[0].w;
+    const int h = bottom_blobs_bordered[0].h;
+    const int outw = (w - kernel_extent_w) / self->stride_w + 1;
+    const int outh = (h - kernel_extent_h) / self->stride_h + 1;
+    const int outsize = outw * outh;
+
+    // one weight pass serves every sample, which only pays off
+    // when the weights outweigh the im2col columns of a sample
+    if (self->num_output < outsize)
+        batchable = false;
+
+    if (!batchable)
+    {
+        for (int b=0; b<batch; b++)
+        {
+            int ret = layer->forward(_self, bottom_blobs[b], top_blobs[b], opt);
+            if (ret != 0)
+                return ret;
+        }
+
+        return 0;
+    }
+
+    const int K = channels * maxk;
+
+    // a pointwise convolution reads the input channels as its columns,
+    // anything else is unfolded per sample into the workspace
+    const bool pointwise = maxk == 1 && self->stride_w == 1 && self->stride_h == 1;
+
+    Mat col_blob;
+    std::vector<Mat> cols(batch);
+    if (pointwise)
+    {
+        for (int b=0; b<batch; b++)
+        {
+            cols[b] = bottom_blobs_bordered[b];
+        }
+    }
+    else
+    {
+        col_blob.create(outsize, 1, K * batch, 4u, opt.workspace_allocator);
+        if (col_blob.empty())
+            return -100;
+
+        // kernel offsets
+        std::vector<int> _space_ofs(maxk);
+        int* space_ofs = &_space_ofs[0];
+        {
+            int p1 = 0;
+            int p2 = 0;
+            int gap = w * self->dilation_h - self->kernel_w * self->dilation_w;
+            for (int i = 0; i < self->kernel_h; i++)
+            {
+                for (int j = 0; j < self->kernel_w; j++)
+                {
+                    space_ofs[p1] = p2;
+                    p1++;
+                    p2 += self->dilation_w;
+                }
+                p2 += gap;
+            }
+        }
+
+        for (int b=0; b<batch; b++)
+        {
+            cols[b] = col_blob.channel_range(K * b, K);
+
+            const Mat& bottom_blob_bordered = bottom_blobs_bordered[b];
+            Mat& col = cols[b];
+
+            #pragma omp parallel for num_threads(opt.num_threads)
+            for (int q=0; q<channels; q++)
+            {
+                const Mat m = bottom_blob_bordered.channel(q);
+
+                for (int k = 0; k < maxk; k++)
+                {
+                    float* outptr = col.channel(q * maxk + k);
+
+                    for (int i = 0; i < outh; i++)
+                    {
+                        const float* sptr = m.row(i*self->stride_h) + space_ofs[k];
+
+                        for (int j = 0; j < outw; j++)
+                        {
+                            outptr[j] = sptr[j*self->stride_w];
+                        }
+
+                        outptr += outw;
+                    }
+                }
+            }
+        }
+    }
+
+    for (int b=0; b<batch; b++)
+    {
+        top_blobs[b].create(outw, outh, self->num_output, 4u, opt.blob_allocator);
+        if (top_blobs[b].empty())
+            return -100;
+    }
+
+    // a block of output channels keeps its weight rows in cache
+    // while they are applied to every sample in turn
+    const int nn_outch = (self->num_output + CONV_SGEMM_MR - 1) / CONV_SGEMM_MR;
+
+    #pragma omp parallel for num_threads(opt.num_threads)
+    for (int pp=0; pp<nn_outch; pp++)
+    {
+        const int p0 = pp * CONV_SGEMM_MR;
+        const int pn = min(CONV_SGEMM_MR, self->num_output - p0);
+
+        float sum[CONV_SGEMM_MR][CONV_SGEMM_NR * 2];
+
+        for (int b=0; b<batch; b++)
+        {
+            const Mat& col = cols[b];
+
+            for (int i0 = 0; i0 < outsize; i0 += CONV_SGEMM_NR * 2)
+            {
+                const int n = min(CONV_SGEMM_NR * 2, outsize - i0);
+
+                for (int r = 0; r < pn; r++)
+                {
+                    const float bias = self->bias_term ? self->bias_data[p0 + r] : 0.f;
+                    for (int j = 0; j < n; j++)
+                    {
+                        sum[r][j] = bias;
+                    }
+                }
+
+                for (int k = 0; k < K; k++)
+                {
+                    const float* sptr = (const float*)col.channel(k) + i0;
+
+                    for (int r = 0; r < pn; r++)
+                    {
+                        const float w0 = ((const float*)self->weight_data)[(p0 + r) * K + k];
+                        for (int j = 0; j < n; j++)
+                        {
+                            sum[r][j] += sptr[j] * w0;
+                        }
+                    }
+                }
+
+                for (int r = 0; r < pn; r++)
+                {
+                    float* outptr = (float*)top_blobs[b].channel(p0 + r) + i0;
+                    for (int j = 0; j < n; j++)
+                    {
+                        outptr[j] = conv_activation_ss(sum[r][j], self->activation_type, self->activation_params);
+                    }
+                }
+            }
+        }
+    }
+
+    return 0;
+}
+
+int Convolution_infer_shape(void *_self, const std::vector<Mat>& bottom_shapes, std::vector<Mat>& top_shapes)
+{
+    Convolution *self = (Convolution *)_self;
+
+    const Mat& bottom_shape = bottom_shapes[0];
+    if (bottom_shape.dims != 3)
+        return -1;
+
+    const int kernel_extent_w = self->dilation_w * (self->kernel_w - 1) + 1;
+    const int kernel_extent_h = self->dilation_h * (self->kernel_h - 1) + 1;
+
+    // same border arithmetic as Convolution_make_padding
+    int w = bottom_shape.w;
+    int h = bottom_shape.h;
+    if (self->pad_left > 0 || self->pad_right > 0 || self->pad_top > 0 || self->pad_bottom > 0)
+    {
+        w += self->pad_left + self->pad_right;
+        h += self->pad_top + self->pad_bottom;
+    }
+    else if ((self->pad_left == -233 && self->pad_right == -233 && self->pad_top == -233 && self->pad_bottom == -233)
+             || (self->pad_left == -234 && self->pad_right == -234 && self->pad_top == -234 && self->pad_bottom == -234))
+    {
+        int wpad = kernel_extent_w + (w - 1) / self->stride_w * self->stride_w - w;
+        int hpad = kernel_extent_h + (h - 1) / self->stride_h * self->stride_h - h;
+        if (wpad > 0 || hpad > 0)
+        {
+            w += wpad;
+            h += hpad;
+        }
+    }
+
+    int outw = (w - kernel_extent_w) / self->stride_w + 1;
+    int outh = (h - kernel_extent_h) / self->stride_h + 1;
+
+    top_shapes[0] = Mat(outw, outh, self->num_output, (void*)0);
+
+    return 0;
+}
@@ -42,7 +42,7 @@ struct Convolution
 
     int int8_scale_term;
 
-    // 0=none 1=relu 2=leakyrelu 3=clip 4=sigmoid
+    // 0=none 1=relu 2=leakyrelu 3=clip 4=sigmoid 6=hardswish
     int activation_type;
     Mat activation_params;
 
@@ -58,6 +58,14 @@ struct Convolution
 
     // implementation type, 0 means do not use auto pack model 
     int impl_type;
+
+    // packed weight for im2col sgemm, prepared in create_pipeline
+    Mat weight_sgemm_data;
+
+    // transformed weight for 3x3s1 winograd, prepared in create_pipeline
+    // output tile size is 6 for F(6,3), 4 for F(4,3), 0 when not used
+    int winograd_tile_size;
+    Mat weight_3x3_winograd_data;
 };
 
 void *Convolution_ctor(void *_self, va_list *args);
@@ -68,15 +76,22 @@ int Convolution_load_model(void *_self, const ModelBin& mb);
 
 int Convolution_create_pipeline(void *_self, const Option& opt);
 
+int Convolution_create_pipeline_winograd(void *_self, const Option& opt);
+
+int Convolution_destroy_pipeline(void *_self, const Option& opt);
+
 int Convolution_forward(void *_self, const Mat& bottom_blob, Mat& top_blob, const Option& opt);
 
 void Convolution_make_padding(void *_self, const Mat& bottom_blob, Mat& bottom_blob_bordered, const Option& opt);
 
 int Convolution_forward_int8(void *_self, const Mat& bottom_blob, Mat& top_blob, const Option& opt);
 
+int Convolution_forward_batch(void *_self, const std::vector<Mat>& bottom_blobs, std::vector<Mat>& top_blobs, const Option& opt);
+
+int Convolution_infer_shape(void *_self, const std::vector<Mat>& bottom_shapes, std::vector<Mat>& top_shapes);
+
 // default operators
 #define Convolution_dtor                     Layer_dtor
-#define Convolution_destroy_pipeline         Layer_destroy_pipeline
 #define Convolution_forward_multi            Layer_forward_multi
 #define Convolution_forward_inplace_multi    Layer_forward_inplace_multi
 #define Convolution_forward_inplace          Layer_forward_inplace
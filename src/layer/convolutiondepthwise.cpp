@@ -27,6 +27,13 @@ void *ConvolutionDepthWise_ctor(void *_self, va_list *args)
 
     self->use_int8_requantize = false;
 
+    self->layer.weight_mats.push_back(&self->weight_data);
+    self->layer.weight_mats.push_back(&self->bias_data);
+    self->layer.weight_mats.push_back(&self->weight_data_int8_scales);
+    self->layer.weight_mats.push_back(&self->bottom_blob_int8_scales);
+
+    self->layer.forward_batch = ConvolutionDepthWise_forward_batch;
+
     return _self;
 }
 
@@ -133,6 +140,71 @@ int ConvolutionDepthWise_create_pipeline(void *_self, const Option& opt)
     return 0;
 }
 
+// one output channel of the depth-wise case
+static void convdw_channel(const ConvolutionDepthWise* self, const Mat& bottom_blob_bordered, Mat& top_blob, int g, const int* space_ofs)
+{
+    const int outw = top_blob.w;
+    const int outh = top_blob.h;
+    const int maxk = self->kernel_w * self->kernel_h;
+
+    float* outptr = top_blob.channel(g);
+    const float* kptr = (const float*)self->weight_data + maxk * g;
+    const Mat m = bottom_blob_bordered.channel(g);
+
+    for (int i = 0; i < outh; i++)
+    {
+        for (int j = 0; j < outw; j++)
+        {
+            float sum = 0.f;
+
+            if (self->bias_term)
+                sum = self->bias_data[g];
+
+            const float* sptr = m.row(i*self->stride_h) + j*self->stride_w;
+
+            for (int k = 0; k < maxk; k++)
+            {
+                float val = sptr[ space_ofs[k] ];
+                float w = kptr[k];
+                sum += val * w;
+            }
+
+            if (self->activation_type == 1)
+            {
+                sum = max(sum, 0.f);
+            }
+            else if (self->activation_type == 2)
+            {
+                float slope = self->activation_params[0];
+                sum = sum > 0.f ? sum : sum * slope;
+            }
+            else if (self->activation_type == 3)
+            {
+                float min = self->activation_params[0];
+                float max = self->activation_params[1];
+                if (sum < min)
+                    sum = min;
+                if (sum > max)
+                    sum = max;
+            }
+            else if (self->activation_type == 4)
+            {
+                sum = static_cast<float>(1.f / (1.f + exp(-sum)));
+            }
+            else if (self->activation_type == 6)
+            {
+                float alpha = self->activation_params[0];
+                float beta = self->activation_params[1];
+                sum = sum * min(max(sum * alpha + beta, 0.f), 1.f);
+            }
+
+            outptr[j] = sum;
+        }
+
+        outptr += outw;
+    }
+}
+
 int ConvolutionDepthWise_forward(void *_self, const Mat& bottom_blob, Mat& top_blob, const Option& opt)
 {
     ConvolutionDepthWise *self = (ConvolutionDepthWise *)_self;
@@ -204,56 +276,7 @@ int ConvolutionDepthWise_forward(void *_self, const Mat& bottom_blob, Mat& top_b
         #pragma omp parallel for num_threads(opt.num_threads)
         for (int g=0; g<self->group; g++)
         {
-            float* outptr = top_blob.channel(g);
-            const float* kptr = (const float*)self->weight_data + maxk * g;
-            const Mat m = bottom_blob_bordered.channel(g);
-
-            for (int i = 0; i < outh; i++)
-            {
-                for (int j = 0; j < outw; j++)
-                {
-                    float sum = 0.f;
-
-                    if (self->bias_term)
-                        sum = self->bias_data[g];
-
-                    const float* sptr = m.row(i*self->stride_h) + j*self->stride_w;
-
-                    for (int k = 0; k < maxk; k++)
-                    {
-                        float val = sptr[ space_ofs[k] ];
-                        float w = kptr[k];
-                        sum += val * w;
-                    }
-
-                    if (self->activation_type == 1)
-                    {
-                        sum = max(sum, 0.f);
-                    }
-                    else if (self->activation_type == 2)
-                    {
-                        float slope = self->activation_params[0];
-                        sum = sum > 0.f ? sum : sum * slope;
-                    }
-                    else if (self->activation_type == 3)
-                    {
-                        float min = self->activation_params[0];
-                        float max = self->activation_params[1];
-                        if (sum < min)
-                            sum = min;
-                        if (sum > max)
-                            sum = max;
-                    }
-                    else if (self->activation_type == 4)
-                    {
-                        sum = static_cast<float>(1.f / (1.f + exp(-sum)));
-                    }
-
-                    outptr[j] = sum;
-                }
-
-                outptr += outw;
-            }
+            convdw_channel(self, bottom_blob_bordered, top_blob, g, space_ofs);
         }
     }
     else
@@ -319,6 +342,12 @@ int ConvolutionDepthWise_forward(void *_self, const Mat& bottom_blob, Mat& top_b
                         {
                             sum = static_cast<float>(1.f / (1.f + exp(-sum)));
                         }
+                        else if (self->activation_type == 6)
+                        {
+                            float alpha = self->activation_params[0];
+                            float beta = self->activation_params[1];
+                            sum = sum * min(max(sum * alpha + beta, 0.f), 1.f);
+                        }
 
                         outptr[j] = sum;
                     }
@@ -332,6 +361,96 @@ int ConvolutionDepthWise_forward(void *_self, const Mat& bottom_blob, Mat& top_b
     return 0;
 }
 
+int ConvolutionDepthWise_forward_batch(void *_self, const std::vector<Mat>& bottom_blobs, std::vector<Mat>& top_blobs, const Option& opt)
+{
+    ConvolutionDepthWise *self = (ConvolutionDepthWise *)_self;
+    const Layer* layer = (const Layer*)_self;
+
+    const int batch = (int)bottom_blobs.size();
+
+    // only the fp32 depth-wise case shares a pass over the channels
+    bool batchable = !(opt.use_int8_inference && self->weight_data.elemsize == (size_t)1u)
+                     && self->group == self->num_output;
+
+    const Mat& bottom_blob0 = bottom_blobs[0];
+    for (int b=0; b<batch; b++)
+    {
+        const Mat& m = bottom_blobs[b];
+        if (m.dims != 3 || m.w != bottom_blob0.w || m.h != bottom_blob0.h || m.c != self->group || m.c != bottom_blob0.c || m.elemsize != 4u)
+            batchable = false;
+    }
+
+    if (!batchable)
+    {
+        for (int b=0; b<batch; b++)
+        {
+            int ret = layer->forward(_self, bottom_blobs[b], top_blobs[b], opt);
+            if (ret != 0)
+                return ret;
+        }
+
+        return 0;
+    }
+
+    const int kernel_extent_w = self->dilation_w * (self->kernel_w - 1) + 1;
+    const int kernel_extent_h = self->dilation_h * (self->kernel_h - 1) + 1;
+
+    std::vector<Mat> bottom_blobs_bordered(batch);
+    for (int b=0; b<batch; b++)
+    {
+        ConvolutionDepthWise_make_padding(self, bottom_blobs[b], bottom_blobs_bordered[b], opt);
+        if (bottom_blobs_bordered[b].empty())
+            return -100;
+    }
+
+    const int w = bottom_blobs_bordered[0].w;
+    const int h = bottom_blobs_bordered[0].h;
+
+    int outw = (w - kernel_extent_w) / self->stride_w + 1;
+    int outh = (h - kernel_extent_h) / self->stride_h + 1;
+
+    const int maxk = self->kernel_w * self->kernel_h;
+
+    // kernel offsets
+    std::vector<int> _space_ofs(maxk);
+    int* space_ofs = &_space_ofs[0];
+    {
+        int p1 = 0;
+        int p2 = 0;
+        int gap = w * self->dilation_h - self->kernel_w * self->dilation_w;
+        for (int i = 0; i < self->kernel_h; i++)
+        {
+            for (int j = 0; j < self->kernel_w; j++)
+            {
+                space_ofs[p1] = p2;
+                p1++;
+                p2 += self->dilation_w;
+            }
+            p2 += gap;
+        }
+    }
+
+    for (int b=0; b<batch; b++)
+    {
+        top_blobs[b].create(outw, outh, self->num_output, 4u, opt.blob_allocator);
+        if (top_blobs[b].empty())
+            return -100;
+    }
+
+    // one parallel pass over the channels, each thread keeps its kernel
+    // and bias while it walks the samples
+    #pragma omp parallel for num_threads(opt.num_threads)
+    for (int g=0; g<self->group; g++)
+    {
+        for (int b=0; b<batch; b++)
+        {
+            convdw_channel(self, bottom_blobs_bordered[b], top_blobs[b], g, space_ofs);
+        }
+    }
+
+    return 0;
+}
+
 void ConvolutionDepthWise_make_padding(void *_self, const Mat& bottom_blob, Mat& bottom_blob_bordered, const Option& opt)
 {
     ConvolutionDepthWise *self = (ConvolutionDepthWise *)_self;
@@ -640,3 +759,42 @@ int ConvolutionDepthWise_forward_int8(void *_self, const Mat& bottom_blob, Mat&
 
     return 0;
 }
+
+int ConvolutionDepthWise_infer_shape(void *_self, const std::vector<Mat>& bottom_shapes, std::vector<Mat>& top_shapes)
+{
+    ConvolutionDepthWise *self = (ConvolutionDepthWise *)_self;
+
+    const Mat& bottom_shape = bottom_shapes[0];
+    if (bottom_shape.dims != 3)
+        return -1;
+
+    const int kernel_extent_w = self->dilation_w * (self->kernel_w - 1) + 1;
+    const int kernel_extent_h = self->dilation_h * (self->kernel_h - 1) + 1;
+
+    // same border arithmetic as ConvolutionDepthWise_make_padding
+    int w = bottom_shape.w;
+    int h = bottom_shape.h;
+    if (self->pad_left > 0 || self->pad_right > 0 || self->pad_top > 0 || self->pad_bottom > 0)
+    {
+        w += self->pad_left + self->pad_right;
+        h += self->pad_top + self->pad_bottom;
+    }
+    else if ((self->pad_left == -233 && self->pad_right == -233 && self->pad_top == -233 && self->pad_bottom == -233)
+             || (self->pad_left == -234 && self->pad_right == -234 && self->pad_top == -234 && self->pad_bottom == -234))
+    {
+        int wpad = kernel_extent_w + (w - 1) / self->stride_w * self->stride_w - w;
+        int hpad = kernel_extent_h + (h - 1) / self->stride_h * self->stride_h - h;
+        if (wpad > 0 || hpad > 0)
+        {
+            w += wpad;
+            h += hpad;
+        }
+    }
+
+    int outw = (w - kernel_extent_w) / self->stride_w + 1;
+    int outh = (h - kernel_extent_h) / self->stride_h + 1;
+
+    top_shapes[0] = Mat(outw, outh, self->num_output, (void*)0);
+
+    return 0;
+}
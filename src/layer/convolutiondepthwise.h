@@ -43,7 +43,7 @@ struct ConvolutionDepthWise
 
     int int8_scale_term;
 
-    // 0=none 1=relu 2=leakyrelu 3=clip 4=sigmoid
+    // 0=none 1=relu 2=leakyrelu 3=clip 4=sigmoid 6=hardswish
     int activation_type;
     Mat activation_params;
 
@@ -68,10 +68,14 @@ int ConvolutionDepthWise_create_pipeline(void *_self, const Option& opt);
 
 int ConvolutionDepthWise_forward(void *_self, const Mat& bottom_blob, Mat& top_blob, const Option& opt);
 
+int ConvolutionDepthWise_forward_batch(void *_self, const std::vector<Mat>& bottom_blobs, std::vector<Mat>& top_blobs, const Option& opt);
+
 void ConvolutionDepthWise_make_padding(void *_self, const Mat& bottom_blob, Mat& bottom_blob_bordered, const Option& opt);
 
 int ConvolutionDepthWise_forward_int8(void *_self, const Mat& bottom_blob, Mat& top_blob, const Option& opt);
 
+int ConvolutionDepthWise_infer_shape(void *_self, const std::vector<Mat>& bottom_shapes, std::vector<Mat>& top_shapes);
+
 // default operators
 #define ConvolutionDepthWise_dtor                     Layer_dtor
 #define ConvolutionDepthWise_destroy_pipeline         Layer_destroy_pipeline
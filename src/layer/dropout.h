@@ -40,5 +40,6 @@ int Dropout_forward_inplace(void *_self, Mat& bottom_top_blob, const Option& opt
 #define Dropout_forward_multi            Layer_forward_multi
 #define Dropout_forward                  Layer_forward
 #define Dropout_forward_inplace_multi    Layer_forward_inplace_multi
+#define Dropout_infer_shape              Layer_infer_shape
 
 #endif // LAYER_DROPOUT_H
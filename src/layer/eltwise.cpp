@@ -37,7 +37,7 @@ int Eltwise_load_param(void *_self, const ParamDict& pd)
     return 0;
 }
 
-int Eltwise_forward(void *_self, const std::vector<Mat>& bottom_blobs, std::vector<Mat>& top_blobs, const Option& opt)
+int Eltwise_forward_multi(void *_self, const std::vector<Mat>& bottom_blobs, std::vector<Mat>& top_blobs, const Option& opt)
 {
     Eltwise *self = (Eltwise *)_self;
 
@@ -194,3 +194,10 @@ int Eltwise_forward(void *_self, const std::vector<Mat>& bottom_blobs, std::vect
 
     return 0;
 }
+
+int Eltwise_infer_shape(void *_self, const std::vector<Mat>& bottom_shapes, std::vector<Mat>& top_shapes)
+{
+    top_shapes[0] = bottom_shapes[0];
+
+    return 0;
+}
@@ -34,14 +34,16 @@ void *Eltwise_ctor(void *_self, va_list *args);
 
 int Eltwise_load_param(void *_self, const ParamDict& pd);
 
-int Eltwise_forward(void *_self, const std::vector<Mat>& bottom_blobs, std::vector<Mat>& top_blobs, const Option& opt);
+int Eltwise_forward_multi(void *_self, const std::vector<Mat>& bottom_blobs, std::vector<Mat>& top_blobs, const Option& opt);
+
+int Eltwise_infer_shape(void *_self, const std::vector<Mat>& bottom_shapes, std::vector<Mat>& top_shapes);
 
 // default operators
 #define Eltwise_dtor                     Layer_dtor
 #define Eltwise_load_model               Layer_load_model
 #define Eltwise_create_pipeline          Layer_create_pipeline
 #define Eltwise_destroy_pipeline         Layer_destroy_pipeline
-#define Eltwise_forward_multi            Layer_forward_multi
+#define Eltwise_forward                  Layer_forward
 #define Eltwise_forward_inplace_multi    Layer_forward_inplace_multi
 #define Eltwise_forward_inplace          Layer_forward_inplace
 
@@ -39,5 +39,6 @@ int HardSigmoid_forward_inplace(void *_self, Mat& bottom_top_blob, const Option&
 #define HardSigmoid_forward_multi            Layer_forward_multi
 #define HardSigmoid_forward                  Layer_forward
 #define HardSigmoid_forward_inplace_multi    Layer_forward_inplace_multi
+#define HardSigmoid_infer_shape              Layer_infer_shape
 
 #endif // LAYER_HARDSIGMOID_H
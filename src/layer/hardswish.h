@@ -39,5 +39,6 @@ int HardSwish_forward_inplace(void *_self, Mat& bottom_top_blob, const Option& o
 #define HardSwish_forward_multi            Layer_forward_multi
 #define HardSwish_forward                  Layer_forward
 #define HardSwish_forward_inplace_multi    Layer_forward_inplace_multi
+#define HardSwish_infer_shape              Layer_infer_shape
 
 #endif // LAYER_HARDSWISH_H
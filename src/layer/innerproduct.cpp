@@ -18,12 +18,52 @@
 
 #include "cstl/utils.h"
 
+static inline float activation(float sum, int activation_type, const Mat& activation_params)
+{
+    if (activation_type == 1)
+    {
+        sum = max(sum, 0.f);
+    }
+    else if (activation_type == 2)
+    {
+        float slope = activation_params[0];
+        sum = sum > 0.f ? sum : sum * slope;
+    }
+    else if (activation_type == 3)
+    {
+        float min = activation_params[0];
+        float max = activation_params[1];
+        if (sum < min)
+            sum = min;
+        if (sum > max)
+            sum = max;
+    }
+    else if (activation_type == 4)
+    {
+        sum = static_cast<float>(1.f / (1.f + exp(-sum)));
+    }
+    else if (activation_type == 6)
+    {
+        float alpha = activation_params[0];
+        float beta = activation_params[1];
+        sum = sum * min(max(sum * alpha + beta, 0.f), 1.f);
+    }
+
+    return sum;
+}
+
 void *InnerProduct_ctor(void *_self, va_list *args)
 {
-    Layer *self = (Layer *)_self;
+    InnerProduct *self = (InnerProduct *)_self;
+
+    self->layer.one_blob_only = true;
+    self->layer.support_inplace = false;
 
-    self->one_blob_only = true;
-    self->support_inplace = false;
+    self->layer.weight_mats.push_back(&self->weight_data);
+    self->layer.weight_mats.push_back(&self->bias_data);
+    self->layer.weight_mats.push_back(&self->weight_data_int8_scales);
+
+    self->layer.forward_batch = InnerProduct_forward_batch;
 
     return _self;
 }
@@ -135,30 +175,78 @@ int InnerProduct_forward(void *_self, const Mat& bottom_blob, Mat& top_blob, con
             }
         }
 
-        if (self->activation_type == 1)
-        {
-            sum = max(sum, 0.f);
-        }
-        else if (self->activation_type == 2)
-        {
-            float slope = self->activation_params[0];
-            sum = sum > 0.f ? sum : sum * slope;
-        }
-        else if (self->activation_type == 3)
+        top_blob[p] = activation(sum, self->activation_type, self->activation_params);
+    }
+
+    return 0;
+}
+
+int InnerProduct_forward_batch(void *_self, const std::vector<Mat>& bottom_blobs, std::vector<Mat>& top_blobs, const Option& opt)
+{
+    InnerProduct *self = (InnerProduct *)_self;
+    const Layer* layer = (const Layer*)_self;
+
+    const int batch = (int)bottom_blobs.size();
+    const int num_input = self->weight_data_size / self->num_output;
+
+    bool batchable = !(opt.use_int8_inference && self->weight_data.elemsize == (size_t)1u);
+    for (int b=0; b<batch; b++)
+    {
+        const Mat& m = bottom_blobs[b];
+        if (m.w * m.h * m.c != num_input || m.elemsize != 4u)
+            batchable = false;
+    }
+
+    if (!batchable)
+    {
+        for (int b=0; b<batch; b++)
         {
-            float min = self->activation_params[0];
-            float max = self->activation_params[1];
-            if (sum < min)
-                sum = min;
-            if (sum > max)
-                sum = max;
+            int ret = layer->forward(_self, bottom_blobs[b], top_blobs[b], opt);
+            if (ret != 0)
+                return ret;
         }
-        else if (self->activation_type == 4)
+
+        return 0;
+    }
+
+    // weights are laid out flat, so walk the inputs flat too
+    std::vector<Mat> bottom_blobs_flattened(batch);
+    std::vector<const float*> sptrs(batch);
+    std::vector<float*> outptrs(batch);
+    for (int b=0; b<batch; b++)
+    {
+        bottom_blobs_flattened[b] = bottom_blobs[b].reshape(num_input, opt.workspace_allocator);
+        if (bottom_blobs_flattened[b].empty())
+            return -100;
+
+        top_blobs[b].create(self->num_output, 4u, opt.blob_allocator);
+        if (top_blobs[b].empty())
+            return -100;
+
+        sptrs[b] = bottom_blobs_flattened[b];
+        outptrs[b] = top_blobs[b];
+    }
+
+    // every sample is multiplied with a weight row while it is hot in cache,
+    // so the whole weight matrix is read from memory once per batch
+    #pragma omp parallel for num_threads(opt.num_threads)
+    for (int p=0; p<self->num_output; p++)
+    {
+        const float* w = (const float*)self->weight_data + num_input * p;
+        const float bias = self->bias_term ? self->bias_data[p] : 0.f;
+
+        for (int b=0; b<batch; b++)
         {
-            sum = static_cast<float>(1.f / (1.f + exp(-sum)));
-        }
+            const float* m = sptrs[b];
+
+            float sum = bias;
+            for (int i = 0; i < num_input; i++)
+            {
+                sum += m[i] * w[i];
+            }
 
-        top_blob[p] = sum;
+            outptrs[b][p] = activation(sum, self->activation_type, self->activation_params);
+        }
     }
 
     return 0;
@@ -229,3 +317,12 @@ int InnerProduct_forward_int8(void *_self, const Mat& bottom_blob, Mat& top_blob
 
     return 0;
 }
+
+int InnerProduct_infer_shape(void *_self, const std::vector<Mat>& /*bottom_shapes*/, std::vector<Mat>& top_shapes)
+{
+    InnerProduct *self = (InnerProduct *)_self;
+
+    top_shapes[0] = Mat(self->num_output, (void*)0);
+
+    return 0;
+}
@@ -31,7 +31,7 @@ struct InnerProduct
 
     int int8_scale_term;
 
-    // 0=none 1=relu 2=leakyrelu 3=clip 4=sigmoid
+    // 0=none 1=relu 2=leakyrelu 3=clip 4=sigmoid 6=hardswish
     int activation_type;
     Mat activation_params;
 
@@ -55,6 +55,10 @@ int InnerProduct_forward(void *_self, const Mat& bottom_blob, Mat& top_blob, con
 
 int InnerProduct_forward_int8(void *_self, const Mat& bottom_blob, Mat& top_blob, const Option& opt);
 
+int InnerProduct_forward_batch(void *_self, const std::vector<Mat>& bottom_blobs, std::vector<Mat>& top_blobs, const Option& opt);
+
+int InnerProduct_infer_shape(void *_self, const std::vector<Mat>& bottom_shapes, std::vector<Mat>& top_shapes);
+
 // default operators
 #define InnerProduct_dtor                     Layer_dtor
 #define InnerProduct_destroy_pipeline         Layer_destroy_pipeline
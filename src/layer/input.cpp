@@ -39,3 +39,26 @@ int Input_forward_inplace(void *_self, Mat& bottom_top_blob, const Option& opt)
 {
     return 0;
 }
+
+int Input_infer_shape(void *_self, const std::vector<Mat>& bottom_shapes, std::vector<Mat>& top_shapes)
+{
+    Input *self = (Input *)_self;
+
+    if (!bottom_shapes.empty())
+    {
+        top_shapes = bottom_shapes;
+        return 0;
+    }
+
+    // fixed size declared in the param file, zero means unknown
+    if (self->w > 0 && self->h > 0 && self->c > 0)
+        top_shapes[0] = Mat(self->w, self->h, self->c, (void*)0);
+    else if (self->w > 0 && self->h > 0)
+        top_shapes[0] = Mat(self->w, self->h, (void*)0);
+    else if (self->w > 0)
+        top_shapes[0] = Mat(self->w, (void*)0);
+    else
+        return -1;
+
+    return 0;
+}
@@ -34,6 +34,8 @@ int Input_load_param(void *_self, const ParamDict& pd);
 
 int Input_forward_inplace(void *_self, Mat& bottom_top_blob, const Option& opt);
 
+int Input_infer_shape(void *_self, const std::vector<Mat>& bottom_shapes, std::vector<Mat>& top_shapes);
+
 // default operators
 #define Input_dtor                     Layer_dtor
 #define Input_load_model               Layer_load_model
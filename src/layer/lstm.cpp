@@ -14,82 +14,78 @@
 
 #include "lstm.h"
 #include <math.h>
+#include <stdio.h>
+#include <string.h>
 
-DEFINE_LAYER_CREATOR(LSTM)
-
-LSTM::LSTM()
+void *LSTM_ctor(void *_self, va_list *args)
 {
-    one_blob_only = true;
-    support_inplace = false;
+    LSTM *self = (LSTM *)_self;
+
+    self->layer.one_blob_only = false;
+    self->layer.support_inplace = false;
+
+    self->layer.weight_mats.push_back(&self->weight_hc_data);
+    self->layer.weight_mats.push_back(&self->weight_xc_data);
+    self->layer.weight_mats.push_back(&self->bias_c_data);
+
+    return _self;
 }
 
-int LSTM::load_param(const ParamDict& pd)
+int LSTM_load_param(void *_self, const ParamDict& pd)
 {
-    num_output = pd.get(0, 0);
-    weight_data_size = pd.get(1, 0);
-    direction = pd.get(2, 0);
+    LSTM *self = (LSTM *)_self;
+
+    self->num_output = pd.get(0, 0);
+    self->weight_data_size = pd.get(1, 0);
+    self->direction = pd.get(2, 0);
 
     return 0;
 }
 
-int LSTM::load_model(const ModelBin& mb)
+int LSTM_load_model(void *_self, const ModelBin& mb)
 {
-    int num_directions = direction == 2 ? 2 : 1;
+    LSTM *self = (LSTM *)_self;
+
+    int num_output = self->num_output;
+    int num_directions = self->direction == 2 ? 2 : 1;
 
-    int size = weight_data_size / num_directions / num_output / 4;
+    int size = self->weight_data_size / num_directions / num_output / 4;
 
     // raw weight data
-    weight_xc_data = mb.load(size, num_output * 4, num_directions, 0);
-    if (weight_xc_data.empty())
+    self->weight_xc_data = mb.load(size, num_output * 4, num_directions, 0);
+    if (self->weight_xc_data.empty())
         return -100;
 
-    bias_c_data = mb.load(num_output, 4, num_directions, 0);
-    if (bias_c_data.empty())
+    self->bias_c_data = mb.load(num_output, 4, num_directions, 0);
+    if (self->bias_c_data.empty())
         return -100;
 
-    weight_hc_data = mb.load(num_output, num_output * 4, num_directions, 0);
-    if (weight_hc_data.empty())
+    self->weight_hc_data = mb.load(num_output, num_output * 4, num_directions, 0);
+    if (self->weight_hc_data.empty())
         return -100;
 
     return 0;
 }
 
-static int lstm(const Mat& bottom_blob, Mat& top_blob, int reverse, const Mat& weight_xc, const Mat& bias_c, const Mat& weight_hc, const Option& opt)
+// hidden and cell hold the initial state and receive the state after the last step
+static int lstm(const Mat& bottom_blob, Mat& top_blob, int reverse, const Mat& weight_xc, const Mat& bias_c, const Mat& weight_hc, float* hidden, float* cell, const Option& opt)
 {
     int size = bottom_blob.w;
     int T = bottom_blob.h;
 
     int num_output = top_blob.w;
 
-    // initial hidden state
-    Mat hidden(num_output, 4u, opt.workspace_allocator);
-    if (hidden.empty())
-        return -100;
-
-    // internal cell state
-    Mat cell(num_output, 4u, opt.workspace_allocator);
-    if (cell.empty())
-        return -100;
-
     // 4 x num_output
     Mat gates(4, num_output, 4u, opt.workspace_allocator);
     if (gates.empty())
         return -100;
 
-    hidden.fill(0.f);
-    cell.fill(0.f);
-
     // unroll
     for (int t=0; t<T; t++)
     {
-        // clip hidden by continuation indicator
-        // h_cont_{t-1} = cont_t * h_{t-1}
-        // h_cont_{t-1} = h_{t-1} if cont_t == 1
-        //                0       otherwise
         // calculate hidden
-        // gate_input_t := W_hc * h_conted_{t-1} + W_xc * x_t + b_c
-        int cont = t > 0;
-
+        // gate_input_t := W_hc * h_{t-1} + W_xc * x_t + b_c
+        // a zero initial state makes the first step start the sequence afresh
         int ti = reverse ? T-1-t : t;
 
         const float* x = bottom_blob.row(ti);
@@ -130,12 +126,12 @@ static int lstm(const Mat& bottom_blob, Mat& top_blob, int reverse, const Mat& w
 
             for (int i=0; i<num_output; i++)
             {
-                float h_cont = cont ? hidden[i] : 0.f;
+                float h = hidden[i];
 
-                I += weight_hc_I[i] * h_cont;
-                F += weight_hc_F[i] * h_cont;
-                O += weight_hc_O[i] * h_cont;
-                G += weight_hc_G[i] * h_cont;
+                I += weight_hc_I[i] * h;
+                F += weight_hc_F[i] * h;
+                O += weight_hc_O[i] * h;
+                G += weight_hc_G[i] * h;
             }
 
             gates_data[0] = I;
@@ -162,7 +158,7 @@ static int lstm(const Mat& bottom_blob, Mat& top_blob, int reverse, const Mat& w
             float G = gates_data[3];
 
             I = 1.f / (1.f + exp(-I));
-            F = cont ? 1.f / (1.f + exp(-F)) : 0.f;
+            F = 1.f / (1.f + exp(-F));
             O = 1.f / (1.f + exp(-O));
             G = tanh(G);
 
@@ -172,39 +168,79 @@ static int lstm(const Mat& bottom_blob, Mat& top_blob, int reverse, const Mat& w
             hidden[q] = H;
             output_data[q] = H;
         }
-
-        // no cell output here
     }
 
     return 0;
 }
 
-int LSTM::forward(const Mat& bottom_blob, Mat& top_blob, const Option& opt) const
+int LSTM_forward_multi(void *_self, const std::vector<Mat>& bottom_blobs, std::vector<Mat>& top_blobs, const Option& opt)
 {
+    LSTM *self = (LSTM *)_self;
+
+    if ((bottom_blobs.size() != 1 && bottom_blobs.size() != 3) || (top_blobs.size() != 1 && top_blobs.size() != 3))
+    {
+        fprintf(stderr, "lstm takes 1 or 3 bottoms and 1 or 3 tops, got %d and %d\n", (int)bottom_blobs.size(), (int)top_blobs.size());
+        return -1;
+    }
+
+    const Mat& bottom_blob = bottom_blobs[0];
+
+    int num_output = self->num_output;
     int T = bottom_blob.h;
 
-    int num_directions = direction == 2 ? 2 : 1;
+    int num_directions = self->direction == 2 ? 2 : 1;
+
+    // the state is updated in place, straight in the state tops if there are any
+    Mat hidden;
+    Mat cell;
+    Allocator* state_allocator = top_blobs.size() == 3 ? opt.blob_allocator : opt.workspace_allocator;
+    if (bottom_blobs.size() == 3)
+    {
+        const Mat& hidden0 = bottom_blobs[1];
+        const Mat& cell0 = bottom_blobs[2];
+        if (hidden0.w != num_output || hidden0.h != num_directions || cell0.w != num_output || cell0.h != num_directions)
+        {
+            fprintf(stderr, "lstm state blob shape mismatch, expect %d x %d\n", num_output, num_directions);
+            return -1;
+        }
 
+        hidden = hidden0.clone(state_allocator);
+        cell = cell0.clone(state_allocator);
+        if (hidden.empty() || cell.empty())
+            return -100;
+    }
+    else
+    {
+        hidden.create(num_output, num_directions, 4u, state_allocator);
+        cell.create(num_output, num_directions, 4u, state_allocator);
+        if (hidden.empty() || cell.empty())
+            return -100;
+
+        hidden.fill(0.f);
+        cell.fill(0.f);
+    }
+
+    Mat& top_blob = top_blobs[0];
     top_blob.create(num_output * num_directions, T, 4u, opt.blob_allocator);
     if (top_blob.empty())
         return -100;
 
     // forward
-    if (direction == 0)
+    if (self->direction == 0)
     {
-        int ret = lstm(bottom_blob, top_blob, 0, weight_xc_data.channel(0), bias_c_data.channel(0), weight_hc_data.channel(0), opt);
+        int ret = lstm(bottom_blob, top_blob, 0, self->weight_xc_data.channel(0), self->bias_c_data.channel(0), self->weight_hc_data.channel(0), hidden.row(0), cell.row(0), opt);
         if (ret != 0)
             return ret;
     }
 
-    if (direction == 1)
+    if (self->direction == 1)
     {
-        int ret = lstm(bottom_blob, top_blob, 1, weight_xc_data.channel(0), bias_c_data.channel(0), weight_hc_data.channel(0), opt);
+        int ret = lstm(bottom_blob, top_blob, 1, self->weight_xc_data.channel(0), self->bias_c_data.channel(0), self->weight_hc_data.channel(0), hidden.row(0), cell.row(0), opt);
         if (ret != 0)
             return ret;
     }
 
-    if (direction == 2)
+    if (self->direction == 2)
     {
         Mat top_blob_forward(num_output, T, 4u, opt.workspace_allocator);
         if (top_blob_forward.empty())
@@ -214,11 +250,15 @@ int LSTM::forward(const Mat& bottom_blob, Mat& top_blob, const Option& opt) cons
         if (top_blob_reverse.empty())
             return -100;
 
-        int ret0 = lstm(bottom_blob, top_blob_forward, 0, weight_xc_data.channel(0), bias_c_data.channel(0), weight_hc_data.channel(0), opt);
+        // the reverse pass runs from the end of this chunk, the state it left on the previous one does not continue here
+        hidden.row_range(1, 1).fill(0.f);
+        cell.row_range(1, 1).fill(0.f);
+
+        int ret0 = lstm(bottom_blob, top_blob_forward, 0, self->weight_xc_data.channel(0), self->bias_c_data.channel(0), self->weight_hc_data.channel(0), hidden.row(0), cell.row(0), opt);
         if (ret0 != 0)
             return ret0;
 
-        int ret1 = lstm(bottom_blob, top_blob_reverse, 1, weight_xc_data.channel(1), bias_c_data.channel(1), weight_hc_data.channel(1), opt);
+        int ret1 = lstm(bottom_blob, top_blob_reverse, 1, self->weight_xc_data.channel(1), self->bias_c_data.channel(1), self->weight_hc_data.channel(1), hidden.row(1), cell.row(1), opt);
         if (ret1 != 0)
             return ret1;
 
@@ -234,5 +274,40 @@ int LSTM::forward(const Mat& bottom_blob, Mat& top_blob, const Option& opt) cons
         }
     }
 
+    if (top_blobs.size() == 3)
+    {
+        top_blobs[1] = hidden;
+        top_blobs[2] = cell;
+    }
+
+    return 0;
+}
+
+int LSTM_forward(void *_self, const Mat& bottom_blob, Mat& top_blob, const Option& opt)
+{
+    std::vector<Mat> bottom_blobs(1, bottom_blob);
+    std::vector<Mat> top_blobs(1);
+
+    int ret = LSTM_forward_multi(_self, bottom_blobs, top_blobs, opt);
+    if (ret != 0)
+        return ret;
+
+    top_blob = top_blobs[0];
+
+    return 0;
+}
+
+int LSTM_infer_shape(void *_self, const std::vector<Mat>& bottom_shapes, std::vector<Mat>& top_shapes)
+{
+    LSTM *self = (LSTM *)_self;
+
+    int num_directions = self->direction == 2 ? 2 : 1;
+
+    top_shapes[0] = Mat(self->num_output * num_directions, bottom_shapes[0].h, (void*)0);
+    for (size_t i=1; i<top_shapes.size(); i++)
+    {
+        top_shapes[i] = Mat(self->num_output, num_directions, (void*)0);
+    }
+
     return 0;
 }
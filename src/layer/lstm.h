@@ -17,23 +17,46 @@
 
 #include "layer.h"
 
-struct LSTM : public Layer
+// bottoms: input [hidden cell], tops: output [hidden cell]
+// hidden and cell are num_output x num_directions, the optional state bottoms
+// replace the zero initial state and the optional state tops receive the state
+// after the last step, so a sequence may be fed chunk by chunk
+// a bidirectional one carries the forward state only, the reverse state starts
+// from zero for every chunk and the reverse state top is the one after its step 0
+struct LSTM
 {
-    LSTM();
-
-    virtual int load_param(const ParamDict& pd);
-
-    virtual int load_model(const ModelBin& mb);
-
-    virtual int forward(const Mat& bottom_blob, Mat& top_blob, const Option& opt) const;
+    // layer base
+    Layer layer;
 
+    // proprietary data
+    // param
     int num_output;
     int weight_data_size;
     int direction;// 0=forward 1=reverse 2=bidirectional
 
+    // model
     Mat weight_hc_data;
     Mat weight_xc_data;
     Mat bias_c_data;
 };
 
+void *LSTM_ctor(void *_self, va_list *args);
+
+int LSTM_load_param(void *_self, const ParamDict& pd);
+
+int LSTM_load_model(void *_self, const ModelBin& mb);
+
+int LSTM_forward_multi(void *_self, const std::vector<Mat>& bottom_blobs, std::vector<Mat>& top_blobs, const Option& opt);
+
+int LSTM_forward(void *_self, const Mat& bottom_blob, Mat& top_blob, const Option& opt);
+
+int LSTM_infer_shape(void *_self, const std::vector<Mat>& bottom_shapes, std::vector<Mat>& top_shapes);
+
+// default operators
+#define LSTM_dtor                     Layer_dtor
+#define LSTM_create_pipeline          Layer_create_pipeline
+#define LSTM_destroy_pipeline         Layer_destroy_pipeline
+#define LSTM_forward_inplace_multi    Layer_forward_inplace_multi
+#define LSTM_forward_inplace          Layer_forward_inplace
+
 #endif // LAYER_LSTM_H
@@ -14,15 +14,17 @@
 
 #include "noop.h"
 
-DEFINE_LAYER_CREATOR(Noop)
-
-Noop::Noop()
+void *Noop_ctor(void *_self, va_list *args)
 {
-    support_inplace = true;
-    support_packing = true;
+    Layer *self = (Layer *)_self;
+
+    self->support_inplace = true;
+    self->support_packing = true;
+
+    return _self;
 }
 
-int Noop::forward_inplace(std::vector<Mat>& /*bottom_top_blobs*/, const Option& /*opt*/) const
+int Noop_forward_inplace_multi(void *_self, std::vector<Mat>& /*bottom_top_blobs*/, const Option& /*opt*/)
 {
     return 0;
 }
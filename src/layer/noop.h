@@ -1,6 +1,6 @@
 // Tencent is pleased to support the open source community by making ncnn available.
 //
-// Copyright (C) 2019 THL A29 Limited, a Tencent company. All rights reserved.
+// Copyright (C) 2017 THL A29 Limited, a Tencent company. All rights reserved.
 //
 // Licensed under the BSD 3-Clause License (the "License"); you may not use this file except
 // in compliance with the License. You may obtain a copy of the License at
@@ -17,11 +17,25 @@
 
 #include "layer.h"
 
-struct Noop : public Layer
+struct Noop
 {
-    Noop();
-
-    virtual int forward_inplace(std::vector<Mat>& bottom_top_blobs, const Option& opt) const;
+    // layer base
+    Layer layer;
 };
 
+void *Noop_ctor(void *_self, va_list *args);
+
+int Noop_forward_inplace_multi(void *_self, std::vector<Mat>& bottom_top_blobs, const Option& opt);
+
+// default operators
+#define Noop_dtor                     Layer_dtor
+#define Noop_load_param               Layer_load_param
+#define Noop_load_model               Layer_load_model
+#define Noop_create_pipeline          Layer_create_pipeline
+#define Noop_destroy_pipeline         Layer_destroy_pipeline
+#define Noop_forward_multi            Layer_forward_multi
+#define Noop_forward                  Layer_forward
+#define Noop_forward_inplace          Layer_forward_inplace
+#define Noop_infer_shape              Layer_infer_shape
+
 #endif // LAYER_NOOP_H
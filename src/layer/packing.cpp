@@ -180,3 +180,11 @@ int Packing_forward(void *_self, const Mat& bottom_blob, Mat& top_blob, const Op
 
     return 0;
 }
+
+int Packing_infer_shape(void *_self, const std::vector<Mat>& bottom_shapes, std::vector<Mat>& top_shapes)
+{
+    // shapes are kept unpacked, so the dims pass through unchanged
+    top_shapes = bottom_shapes;
+
+    return 0;
+}
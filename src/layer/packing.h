@@ -33,6 +33,8 @@ int Packing_load_param(void *_self, const ParamDict& pd);
 
 int Packing_forward(void *_self, const Mat& bottom_blob, Mat& top_blob, const Option& opt);
 
+int Packing_infer_shape(void *_self, const std::vector<Mat>& bottom_shapes, std::vector<Mat>& top_shapes);
+
 // default operators
 #define Packing_dtor                     Layer_dtor
 #define Packing_load_model               Layer_load_model
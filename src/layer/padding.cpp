@@ -16,10 +16,12 @@
 
 void *Padding_ctor(void *_self, va_list *args)
 {
-    Layer *self = (Layer *)_self;
+    Padding *self = (Padding *)_self;
+
+    self->layer.one_blob_only = true;
+    self->layer.support_inplace = false;
 
-    self->one_blob_only = true;
-    self->support_inplace = false;
+    self->layer.weight_mats.push_back(&self->per_channel_pad_data);
 
     return _self;
 }
@@ -470,3 +472,28 @@ int Padding_forward_multi(void *_self, const std::vector<Mat>& bottom_blobs, std
 
     return 0;
 }
+
+int Padding_infer_shape(void *_self, const std::vector<Mat>& bottom_shapes, std::vector<Mat>& top_shapes)
+{
+    Padding *self = (Padding *)_self;
+
+    // dynamic padding depends on the reference blob content
+    if (self->top == -233 && self->bottom == -233 && self->left == -233 && self->right == -233)
+        return -1;
+
+    const Mat& bottom_shape = bottom_shapes[0];
+
+    int outw = bottom_shape.w + self->left + self->right;
+    int outh = bottom_shape.h + self->top + self->bottom;
+
+    if (bottom_shape.dims == 1)
+        top_shapes[0] = Mat(outw, (void*)0);
+    else if (bottom_shape.dims == 2)
+        top_shapes[0] = Mat(outw, outh, (void*)0);
+    else if (bottom_shape.dims == 3)
+        top_shapes[0] = Mat(outw, outh, bottom_shape.c, (void*)0);
+    else
+        return -1;
+
+    return 0;
+}
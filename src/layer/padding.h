@@ -46,6 +46,8 @@ int Padding_forward(void *_self, const Mat& bottom_blob, Mat& top_blob, const Op
 
 int Padding_forward_multi(void *_self, const std::vector<Mat>& bottom_blobs, std::vector<Mat>& top_blobs, const Option& opt);
 
+int Padding_infer_shape(void *_self, const std::vector<Mat>& bottom_shapes, std::vector<Mat>& top_shapes);
+
 // default operators
 #define Padding_dtor                     Layer_dtor
 #define Padding_create_pipeline          Layer_create_pipeline
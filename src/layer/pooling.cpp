@@ -333,3 +333,56 @@ void Pooling_make_padding(void *_self, const Mat& bottom_blob, Mat& bottom_blob_
         }
     }
 }
+
+int Pooling_infer_shape(void *_self, const std::vector<Mat>& bottom_shapes, std::vector<Mat>& top_shapes)
+{
+    Pooling *self = (Pooling *)_self;
+
+    const Mat& bottom_shape = bottom_shapes[0];
+    if (bottom_shape.dims != 3)
+        return -1;
+
+    if (self->global_pooling)
+    {
+        top_shapes[0] = Mat(bottom_shape.c, (void*)0);
+        return 0;
+    }
+
+    // same border arithmetic as Pooling_make_padding
+    int w = bottom_shape.w;
+    int h = bottom_shape.h;
+    if (self->pad_mode == 0) // full padding
+    {
+        int wtail = (w + self->pad_left + self->pad_right - self->kernel_w) % self->stride_w;
+        int htail = (h + self->pad_top + self->pad_bottom - self->kernel_h) % self->stride_h;
+
+        w += self->pad_left + self->pad_right;
+        h += self->pad_top + self->pad_bottom;
+        if (wtail != 0)
+            w += self->stride_w - wtail;
+        if (htail != 0)
+            h += self->stride_h - htail;
+    }
+    else if (self->pad_mode == 1) // valid padding
+    {
+        w += self->pad_left + self->pad_right;
+        h += self->pad_top + self->pad_bottom;
+    }
+    else if (self->pad_mode == 2 || self->pad_mode == 3) // SAME_UPPER or SAME_LOWER
+    {
+        int wpad = self->kernel_w + (w - 1) / self->stride_w * self->stride_w - w;
+        int hpad = self->kernel_h + (h - 1) / self->stride_h * self->stride_h - h;
+        if (wpad > 0 || hpad > 0)
+        {
+            w += wpad;
+            h += hpad;
+        }
+    }
+
+    int outw = (w - self->kernel_w) / self->stride_w + 1;
+    int outh = (h - self->kernel_h) / self->stride_h + 1;
+
+    top_shapes[0] = Mat(outw, outh, bottom_shape.c, (void*)0);
+
+    return 0;
+}
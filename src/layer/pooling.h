@@ -48,6 +48,8 @@ int Pooling_forward(void *_self, const Mat& bottom_blob, Mat& top_blob, const Op
 
 void Pooling_make_padding(void *_self, const Mat& bottom_blob, Mat& bottom_blob_bordered, const Option& opt);
 
+int Pooling_infer_shape(void *_self, const std::vector<Mat>& bottom_shapes, std::vector<Mat>& top_shapes);
+
 // default operators
 #define Pooling_dtor                     Layer_dtor
 #define Pooling_load_model               Layer_load_model
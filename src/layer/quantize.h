@@ -32,6 +32,8 @@ int Quantize_load_param(void *_self, const ParamDict& pd);
 
 int Quantize_forward(void *_self, const Mat& bottom_blob, Mat& top_blob, const Option& opt);
 
+int Quantize_infer_shape(void *_self, const std::vector<Mat>& bottom_shapes, std::vector<Mat>& top_shapes);
+
 // default operators
 #define Quantize_dtor                     Layer_dtor
 #define Quantize_load_model               Layer_load_model
@@ -34,7 +34,7 @@ int ReLU_load_param(void *_self, const ParamDict& pd)
     return 0;
 }
 
-int ReLU_forward_inplace(void *_self, Mat& bottom_top_blob, const Option& opt)
+int ReLU_forward_inplace_int8(void *_self, Mat& bottom_top_blob, const Option& opt)
 {
     ReLU *self = (ReLU *)_self;
 
@@ -76,7 +76,7 @@ int ReLU_forward_inplace(void *_self, Mat& bottom_top_blob, const Option& opt)
     return 0;
 }
 
-int ReLU_forward_inplace_int8(void *_self, Mat& bottom_top_blob, const Option& opt)
+int ReLU_forward_inplace(void *_self, Mat& bottom_top_blob, const Option& opt)
 {
     ReLU *self = (ReLU *)_self;
 
@@ -42,5 +42,6 @@ int ReLU_forward_inplace_int8(void *_self, Mat& bottom_top_blob, const Option& o
 #define ReLU_forward_multi            Layer_forward_multi
 #define ReLU_forward                  Layer_forward
 #define ReLU_forward_inplace_multi    Layer_forward_inplace_multi
+#define ReLU_infer_shape              Layer_infer_shape
 
 #endif // LAYER_RELU_H
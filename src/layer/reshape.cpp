@@ -131,3 +131,55 @@ int Reshape_forward(void *_self, const Mat& bottom_blob, Mat& top_blob, const Op
 
     return 0;
 }
+
+int Reshape_infer_shape(void *_self, const std::vector<Mat>& bottom_shapes, std::vector<Mat>& top_shapes)
+{
+    Reshape *self = (Reshape *)_self;
+
+    const Mat& bottom_shape = bottom_shapes[0];
+    int total = bottom_shape.w * bottom_shape.h * bottom_shape.c;
+
+    int _w = self->w == 0 ? bottom_shape.w : self->w;
+    int _h = self->h == 0 ? bottom_shape.h : self->h;
+    int _c = self->c == 0 ? bottom_shape.c : self->c;
+
+    if (self->ndim == 1)
+    {
+        if (_w == -1)
+            _w = total;
+
+        top_shapes[0] = Mat(_w, (void*)0);
+    }
+    else if (self->ndim == 2)
+    {
+        if (_w == -1)
+            _w = total / _h;
+        if (_h == -1)
+            _h = total / _w;
+
+        top_shapes[0] = Mat(_w, _h, (void*)0);
+    }
+    else if (self->ndim == 3)
+    {
+        if (_w == -1)
+            _w = total / _c / _h;
+        if (_h == -1)
+            _h = total / _c / _w;
+        if (_c == -1)
+            _c = total / _h / _w;
+
+        top_shapes[0] = Mat(_w, _h, _c, (void*)0);
+    }
+    else
+    {
+        return -1;
+    }
+
+    if (top_shapes[0].w * top_shapes[0].h * top_shapes[0].c != total)
+    {
+        fprintf(stderr, "Reshape cannot map %d elements\n", total);
+        return -1;
+    }
+
+    return 0;
+}
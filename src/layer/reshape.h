@@ -40,6 +40,8 @@ int Reshape_load_param(void *_self, const ParamDict& pd);
 
 int Reshape_forward(void *_self, const Mat& bottom_blob, Mat& top_blob, const Option& opt);
 
+int Reshape_infer_shape(void *_self, const std::vector<Mat>& bottom_shapes, std::vector<Mat>& top_shapes);
+
 // default operators
 #define Reshape_dtor                     Layer_dtor
 #define Reshape_load_model               Layer_load_model
@@ -14,53 +14,84 @@
 
 #include "rnn.h"
 #include <math.h>
+#include <stdio.h>
 
-DEFINE_LAYER_CREATOR(RNN)
-
-RNN::RNN()
+void *RNN_ctor(void *_self, va_list *args)
 {
-    one_blob_only = false;
-    support_inplace = false;
+    RNN *self = (RNN *)_self;
+
+    self->layer.one_blob_only = false;
+    self->layer.support_inplace = false;
+
+    self->layer.weight_mats.push_back(&self->weight_hh_data);
+    self->layer.weight_mats.push_back(&self->weight_xh_data);
+    self->layer.weight_mats.push_back(&self->weight_ho_data);
+    self->layer.weight_mats.push_back(&self->bias_h_data);
+    self->layer.weight_mats.push_back(&self->bias_o_data);
+
+    return _self;
 }
 
-int RNN::load_param(const ParamDict& pd)
+int RNN_load_param(void *_self, const ParamDict& pd)
 {
-    num_output = pd.get(0, 0);
-    weight_data_size = pd.get(1, 0);
+    RNN *self = (RNN *)_self;
+
+    self->num_output = pd.get(0, 0);
+    self->weight_data_size = pd.get(1, 0);
 
     return 0;
 }
 
-int RNN::load_model(const ModelBin& mb)
+int RNN_load_model(void *_self, const ModelBin& mb)
 {
-    int size = (weight_data_size - num_output * num_output) / 2 / num_output;
+    RNN *self = (RNN *)_self;
+
+    int num_output = self->num_output;
+
+    int size = (self->weight_data_size - num_output * num_output) / 2 / num_output;
 
     // raw weight data
-    weight_hh_data = mb.load(size, num_output, 1);
-    if (weight_hh_data.empty())
+    self->weight_hh_data = mb.load(size, num_output, 1);
+    if (self->weight_hh_data.empty())
         return -100;
 
-    weight_xh_data = mb.load(size, num_output, 1);
-    if (weight_xh_data.empty())
+    self->weight_xh_data = mb.load(size, num_output, 1);
+    if (self->weight_xh_data.empty())
         return -100;
 
-    weight_ho_data = mb.load(num_output, num_output, 1);
-    if (weight_ho_data.empty())
+    self->weight_ho_data = mb.load(num_output, num_output, 1);
+    if (self->weight_ho_data.empty())
         return -100;
 
-    bias_h_data = mb.load(num_output, 1);
-    if (bias_h_data.empty())
+    self->bias_h_data = mb.load(num_output, 1);
+    if (self->bias_h_data.empty())
         return -100;
 
-    bias_o_data = mb.load(num_output, 1);
-    if (bias_o_data.empty())
+    self->bias_o_data = mb.load(num_output, 1);
+    if (self->bias_o_data.empty())
         return -100;
 
     return 0;
 }
 
-int RNN::forward(const std::vector<Mat>& bottom_blobs, std::vector<Mat>& top_blobs, const Option& opt) const
+int RNN_forward_multi(void *_self, const std::vector<Mat>& bottom_blobs, std::vector<Mat>& top_blobs, const Option& opt)
 {
+    RNN *self = (RNN *)_self;
+
+    if ((bottom_blobs.size() != 2 && bottom_blobs.size() != 3) || (top_blobs.size() != 1 && top_blobs.size() != 2))
+    {
+        fprintf(stderr, "rnn takes 2 or 3 bottoms and 1 or 2 tops, got %d and %d\n", (int)bottom_blobs.size(), (int)top_blobs.size());
+        return -1;
+    }
+
+    const Mat& weight_hh_data = self->weight_hh_data;
+    const Mat& weight_xh_data = self->weight_xh_data;
+    const Mat& weight_ho_data = self->weight_ho_data;
+    const Mat& bias_h_data = self->bias_h_data;
+    const Mat& bias_o_data = self->bias_o_data;
+
+    int num_output = self->num_output;
+
     // size x 1 x T
     const Mat& input_blob = bottom_blobs[0];
     size_t elemsize = input_blob.elemsize;
@@ -71,11 +102,28 @@ int RNN::forward(const std::vector<Mat>& bottom_blobs, std::vector<Mat>& top_blo
     int T = input_blob.c;
     int size = input_blob.w;
 
-    // initial hidden state
-    Mat hidden(num_output, 4u, opt.workspace_allocator);
-    if (hidden.empty())
-        return -100;
-    hidden.fill(0.f);
+    // initial hidden state, updated in place, straight in the hidden top if there is one
+    Mat hidden;
+    Allocator* hidden_allocator = top_blobs.size() == 2 ? opt.blob_allocator : opt.workspace_allocator;
+    if (bottom_blobs.size() == 3)
+    {
+        if (bottom_blobs[2].w != num_output)
+        {
+            fprintf(stderr, "rnn hidden blob shape mismatch, expect %d\n", num_output);
+            return -1;
+        }
+
+        hidden = bottom_blobs[2].clone(hidden_allocator);
+        if (hidden.empty())
+            return -100;
+    }
+    else
+    {
+        hidden.create(num_output, 4u, hidden_allocator);
+        if (hidden.empty())
+            return -100;
+        hidden.fill(0.f);
+    }
 
     Mat& top_blob = top_blobs[0];
     top_blob.create(num_output, 1, T, elemsize, opt.blob_allocator);
@@ -127,8 +175,24 @@ int RNN::forward(const std::vector<Mat>& bottom_blobs, std::vector<Mat>& top_blo
 
             output_data[q] = tanh(s0);
         }
+    }
 
-        // no hidden output here
+    if (top_blobs.size() == 2)
+    {
+        top_blobs[1] = hidden;
+    }
+
+    return 0;
+}
+
+int RNN_infer_shape(void *_self, const std::vector<Mat>& bottom_shapes, std::vector<Mat>& top_shapes)
+{
+    RNN *self = (RNN *)_self;
+
+    top_shapes[0] = Mat(self->num_output, 1, bottom_shapes[0].c, (void*)0);
+    if (top_shapes.size() == 2)
+    {
+        top_shapes[1] = Mat(self->num_output, (void*)0);
     }
 
     return 0;
@@ -17,16 +17,16 @@
 
 #include "layer.h"
 
-struct RNN : public Layer
+// bottoms: input cont [hidden], tops: output [hidden]
+// the optional hidden bottom of num_output replaces the zero initial state and
+// the optional hidden top receives the state after the last step,
+// a cont of 0 still clears the state at that step
+struct RNN
 {
-    RNN();
-
-    virtual int load_param(const ParamDict& pd);
-
-    virtual int load_model(const ModelBin& mb);
-
-    virtual int forward(const std::vector<Mat>& bottom_blobs, std::vector<Mat>& top_blobs, const Option& opt) const;
+    // layer base
+    Layer layer;
 
+    // proprietary data
     // param
     int num_output;
     int weight_data_size;
@@ -39,4 +39,22 @@ struct RNN : public Layer
     Mat bias_o_data;
 };
 
+void *RNN_ctor(void *_self, va_list *args);
+
+int RNN_load_param(void *_self, const ParamDict& pd);
+
+int RNN_load_model(void *_self, const ModelBin& mb);
+
+int RNN_forward_multi(void *_self, const std::vector<Mat>& bottom_blobs, std::vector<Mat>& top_blobs, const Option& opt);
+
+int RNN_infer_shape(void *_self, const std::vector<Mat>& bottom_shapes, std::vector<Mat>& top_shapes);
+
+// default operators
+#define RNN_dtor                     Layer_dtor
+#define RNN_create_pipeline          Layer_create_pipeline
+#define RNN_destroy_pipeline         Layer_destroy_pipeline
+#define RNN_forward                  Layer_forward
+#define RNN_forward_inplace_multi    Layer_forward_inplace_multi
+#define RNN_forward_inplace          Layer_forward_inplace
+
 #endif // LAYER_RNN_H
@@ -14,46 +14,60 @@
 
 #include "scale.h"
 
-DEFINE_LAYER_CREATOR(Scale)
-
-Scale::Scale()
+void *Scale_ctor(void *_self, va_list *args)
 {
-    one_blob_only = true;
-    support_inplace = true;
+    Scale *self = (Scale *)_self;
+
+    self->layer.one_blob_only = true;
+    self->layer.support_inplace = true;
+
+    self->layer.weight_mats.push_back(&self->scale_data);
+    self->layer.weight_mats.push_back(&self->bias_data);
+
+    return _self;
 }
 
-int Scale::load_param(const ParamDict& pd)
+int Scale_load_param(void *_self, const ParamDict& pd)
 {
-    scale_data_size = pd.get(0, 0);
-    bias_term = pd.get(1, 0);
+    Scale *self = (Scale *)_self;
+    Layer *layer = (Layer *)_self;
+
+    self->scale_data_size = pd.get(0, 0);
+    self->bias_term = pd.get(1, 0);
 
-    if (scale_data_size == -233)
-        one_blob_only = false;
+    if (self->scale_data_size == -233)
+        layer->one_blob_only = false;
 
     return 0;
 }
 
-int Scale::load_model(const ModelBin& mb)
+int Scale_load_model(void *_self, const ModelBin& mb)
 {
-    if (scale_data_size == -233)
+    Scale *self = (Scale *)_self;
+
+    if (self->scale_data_size == -233)
         return 0;
 
-    scale_data = mb.load(scale_data_size, 1);
-    if (scale_data.empty())
+    self->scale_data = mb.load(self->scale_data_size, 1);
+    if (self->scale_data.empty())
         return -100;
 
-    if (bias_term)
+    if (self->bias_term)
     {
-        bias_data = mb.load(scale_data_size, 1);
-        if (bias_data.empty())
+        self->bias_data = mb.load(self->scale_data_size, 1);
+        if (self->bias_data.empty())
             return -100;
     }
 
     return 0;
 }
 
-int Scale::forward_inplace(std::vector<Mat>& bottom_top_blobs, const Option& opt) const
+int Scale_forward_inplace_multi(void *_self, std::vector<Mat>& bottom_top_blobs, const Option& opt)
 {
+    Scale *self = (Scale *)_self;
+
+    const Mat& bias_data = self->bias_data;
+
     Mat& bottom_top_blob = bottom_top_blobs[0];
     const Mat& scale_blob = bottom_top_blobs[1];
 
@@ -65,7 +79,7 @@ int Scale::forward_inplace(std::vector<Mat>& bottom_top_blobs, const Option& opt
 
         float* ptr = bottom_top_blob;
 
-        if (bias_term)
+        if (self->bias_term)
         {
             #pragma omp parallel for num_threads(opt.num_threads)
             for (int i=0; i<w; i++)
@@ -88,7 +102,7 @@ int Scale::forward_inplace(std::vector<Mat>& bottom_top_blobs, const Option& opt
         int w = bottom_top_blob.w;
         int h = bottom_top_blob.h;
 
-        if (bias_term)
+        if (self->bias_term)
         {
             #pragma omp parallel for num_threads(opt.num_threads)
             for (int i=0; i<h; i++)
@@ -126,7 +140,7 @@ int Scale::forward_inplace(std::vector<Mat>& bottom_top_blobs, const Option& opt
         int channels = bottom_top_blob.c;
         int size = w * h;
 
-        if (bias_term)
+        if (self->bias_term)
         {
             #pragma omp parallel for num_threads(opt.num_threads)
             for (int q=0; q<channels; q++)
@@ -162,11 +176,13 @@ int Scale::forward_inplace(std::vector<Mat>& bottom_top_blobs, const Option& opt
     return 0;
 }
 
-int Scale::forward_inplace(Mat& bottom_top_blob, const Option& opt) const
+int Scale_forward_inplace(void *_self, Mat& bottom_top_blob, const Option& opt)
 {
+    Scale *self = (Scale *)_self;
+
     std::vector<Mat> bottom_top_blobs(2);
     bottom_top_blobs[0] = bottom_top_blob;
-    bottom_top_blobs[1] = scale_data;
+    bottom_top_blobs[1] = self->scale_data;
 
-    return forward_inplace(bottom_top_blobs, opt);
+    return Scale_forward_inplace_multi(self, bottom_top_blobs, opt);
 }
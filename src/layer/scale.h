@@ -17,17 +17,12 @@
 
 #include "layer.h"
 
-struct Scale : public Layer
+struct Scale
 {
-    Scale();
-
-    virtual int load_param(const ParamDict& pd);
-
-    virtual int load_model(const ModelBin& mb);
-
-    virtual int forward_inplace(std::vector<Mat>& bottom_top_blobs, const Option& opt) const;
-    virtual int forward_inplace(Mat& bottom_top_blob, const Option& opt) const;
+    // layer base
+    Layer layer;
 
+    // proprietary data
     // param
     int scale_data_size;
     int bias_term;
@@ -37,4 +32,22 @@ struct Scale : public Layer
     Mat bias_data;
 };
 
+void *Scale_ctor(void *_self, va_list *args);
+
+int Scale_load_param(void *_self, const ParamDict& pd);
+
+int Scale_load_model(void *_self, const ModelBin& mb);
+
+int Scale_forward_inplace_multi(void *_self, std::vector<Mat>& bottom_top_blobs, const Option& opt);
+
+int Scale_forward_inplace(void *_self, Mat& bottom_top_blob, const Option& opt);
+
+// default operators
+#define Scale_dtor                     Layer_dtor
+#define Scale_create_pipeline          Layer_create_pipeline
+#define Scale_destroy_pipeline         Layer_destroy_pipeline
+#define Scale_forward_multi            Layer_forward_multi
+#define Scale_forward                  Layer_forward
+#define Scale_infer_shape              Layer_infer_shape
+
 #endif // LAYER_SCALE_H
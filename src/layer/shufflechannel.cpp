@@ -66,3 +66,11 @@ int ShuffleChannel_forward(void *_self, const Mat& bottom_blob, Mat& top_blob, c
     }
     return 0;
 }
+
+int ShuffleChannel_infer_shape(void *_self, const std::vector<Mat>& bottom_shapes, std::vector<Mat>& top_shapes)
+{
+    // shapes are kept unpacked, so the dims pass through unchanged
+    top_shapes = bottom_shapes;
+
+    return 0;
+}
@@ -32,6 +32,8 @@ int ShuffleChannel_load_param(void *_self, const ParamDict& pd);
 
 int ShuffleChannel_forward(void *_self, const Mat& bottom_blob, Mat& top_blob, const Option& opt);
 
+int ShuffleChannel_infer_shape(void *_self, const std::vector<Mat>& bottom_shapes, std::vector<Mat>& top_shapes);
+
 // default operators
 #define ShuffleChannel_dtor                     Layer_dtor
 #define ShuffleChannel_load_model               Layer_load_model
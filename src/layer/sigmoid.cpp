@@ -15,15 +15,17 @@
 #include "sigmoid.h"
 #include <math.h>
 
-DEFINE_LAYER_CREATOR(Sigmoid)
-
-Sigmoid::Sigmoid()
+void *Sigmoid_ctor(void *_self, va_list *args)
 {
-    one_blob_only = true;
-    support_inplace = true;
+    Layer *layer = (Layer *)_self;
+
+    layer->one_blob_only = true;
+    layer->support_inplace = true;
+
+    return _self;
 }
 
-int Sigmoid::forward_inplace(Mat& bottom_top_blob, const Option& opt) const
+int Sigmoid_forward_inplace(void *_self, Mat& bottom_top_blob, const Option& opt)
 {
     int w = bottom_top_blob.w;
     int h = bottom_top_blob.h;
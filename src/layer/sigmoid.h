@@ -17,11 +17,25 @@
 
 #include "layer.h"
 
-struct Sigmoid : public Layer
+struct Sigmoid
 {
-    Sigmoid();
-
-    virtual int forward_inplace(Mat& bottom_top_blob, const Option& opt) const;
+    // layer base
+    Layer layer;
 };
 
+void *Sigmoid_ctor(void *_self, va_list *args);
+
+int Sigmoid_forward_inplace(void *_self, Mat& bottom_top_blob, const Option& opt);
+
+// default operators
+#define Sigmoid_dtor                     Layer_dtor
+#define Sigmoid_load_param               Layer_load_param
+#define Sigmoid_load_model               Layer_load_model
+#define Sigmoid_create_pipeline          Layer_create_pipeline
+#define Sigmoid_destroy_pipeline         Layer_destroy_pipeline
+#define Sigmoid_forward_multi            Layer_forward_multi
+#define Sigmoid_forward                  Layer_forward
+#define Sigmoid_forward_inplace_multi    Layer_forward_inplace_multi
+#define Sigmoid_infer_shape              Layer_infer_shape
+
 #endif // LAYER_SIGMOID_H
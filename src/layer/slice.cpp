@@ -14,6 +14,16 @@
 
 #include "slice.h"
 
+void *Slice_ctor(void *_self, va_list *args)
+{
+    Layer *self = (Layer *)_self;
+
+    self->one_blob_only = false;
+    self->support_inplace = false;
+
+    return _self;
+}
+
 int Slice_load_param(void *_self, const ParamDict& pd)
 {
     Slice *self = (Slice *)_self;
@@ -33,6 +43,9 @@ int Slice_forward_multi(void *_self, const std::vector<Mat>& bottom_blobs, std::
     size_t elemsize = bottom_blob.elemsize;
     const int* slices_ptr = self->slices;
 
+    // contiguous slices of a counted buffer are handed out as ranges of it
+    const bool shared = opt.use_blob_views && bottom_blob.refcount;
+
     if (dims == 1) // self->axis == 0
     {
         int w = bottom_blob.w;
@@ -47,6 +60,13 @@ int Slice_forward_multi(void *_self, const std::vector<Mat>& bottom_blobs, std::
             }
 
             Mat& top_blob = top_blobs[i];
+            if (shared)
+            {
+                top_blob = bottom_blob.shared_range(q, slice);
+                q += slice;
+                continue;
+            }
+
             top_blob.create(slice, elemsize, opt.blob_allocator);
             if (top_blob.empty())
                 return -100;
@@ -76,6 +96,13 @@ int Slice_forward_multi(void *_self, const std::vector<Mat>& bottom_blobs, std::
             }
 
             Mat& top_blob = top_blobs[i];
+            if (shared)
+            {
+                top_blob = bottom_blob.shared_row_range(q, slice);
+                q += slice;
+                continue;
+            }
+
             top_blob.create(w, slice, elemsize, opt.blob_allocator);
             if (top_blob.empty())
                 return -100;
@@ -141,6 +168,13 @@ int Slice_forward_multi(void *_self, const std::vector<Mat>& bottom_blobs, std::
             }
 
             Mat& top_blob = top_blobs[i];
+            if (shared)
+            {
+                top_blob = bottom_blob.shared_channel_range(q, slice);
+                q += slice;
+                continue;
+            }
+
             top_blob.create(w, h, slice, elemsize, opt.blob_allocator);
             if (top_blob.empty())
                 return -100;
@@ -236,3 +270,51 @@ int Slice_forward_multi(void *_self, const std::vector<Mat>& bottom_blobs, std::
 
     return 0;
 }
+
+int Slice_infer_shape(void *_self, const std::vector<Mat>& bottom_shapes, std::vector<Mat>& top_shapes)
+{
+    Slice *self = (Slice *)_self;
+
+    const Mat& bottom_shape = bottom_shapes[0];
+    int dims = bottom_shape.dims;
+    const int* slices_ptr = self->slices;
+
+    if (dims == 0 || (int)self->slices.w < (int)top_shapes.size())
+        return -1;
+
+    // the sliced extent along axis
+    int extent = bottom_shape.w;
+    if (dims == 2 && self->axis == 0)
+        extent = bottom_shape.h;
+    if (dims == 3 && self->axis == 0)
+        extent = bottom_shape.c;
+    if (dims == 3 && self->axis == 1)
+        extent = bottom_shape.h;
+
+    int q = 0;
+    for (size_t i=0; i<top_shapes.size(); i++)
+    {
+        int slice = slices_ptr[i];
+        if (slice == -233)
+        {
+            slice = static_cast<int>((extent - q) / (top_shapes.size() - i));
+        }
+
+        if (dims == 1)
+            top_shapes[i] = Mat(slice, (void*)0);
+        else if (dims == 2 && self->axis == 0)
+            top_shapes[i] = Mat(bottom_shape.w, slice, (void*)0);
+        else if (dims == 2)
+            top_shapes[i] = Mat(slice, bottom_shape.h, (void*)0);
+        else if (self->axis == 0)
+            top_shapes[i] = Mat(bottom_shape.w, bottom_shape.h, slice, (void*)0);
+        else if (self->axis == 1)
+            top_shapes[i] = Mat(bottom_shape.w, slice, bottom_shape.c, (void*)0);
+        else
+            top_shapes[i] = Mat(slice, bottom_shape.h, bottom_shape.c, (void*)0);
+
+        q += slice;
+    }
+
+    return 0;
+}
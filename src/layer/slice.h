@@ -27,12 +27,15 @@ struct Slice
     int axis;
 };
 
+void *Slice_ctor(void *_self, va_list *args);
+
 int Slice_load_param(void *_self, const ParamDict& pd);
 
 int Slice_forward_multi(void *_self, const std::vector<Mat>& bottom_blobs, std::vector<Mat>& top_blobs, const Option& opt);
 
+int Slice_infer_shape(void *_self, const std::vector<Mat>& bottom_shapes, std::vector<Mat>& top_shapes);
+
 // default operators
-#define Slice_ctor                     Layer_ctor
 #define Slice_dtor                     Layer_dtor
 #define Slice_load_model               Layer_load_model
 #define Slice_create_pipeline          Layer_create_pipeline
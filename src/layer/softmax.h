@@ -40,5 +40,6 @@ int Softmax_forward_inplace(void *_self, Mat& bottom_top_blob, const Option& opt
 #define Softmax_forward_multi            Layer_forward_multi
 #define Softmax_forward                  Layer_forward
 #define Softmax_forward_inplace_multi    Layer_forward_inplace_multi
+#define Softmax_infer_shape              Layer_infer_shape
 
 #endif // LAYER_SOFTMAX_H
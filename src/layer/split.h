@@ -25,7 +25,9 @@ struct Split
 
 void *Split_ctor(void *_self, va_list *args);
 
-int Split_forward(void *_self, const std::vector<Mat>& bottom_blobs, std::vector<Mat>& top_blobs, const Option& opt);
+int Split_forward_multi(void *_self, const std::vector<Mat>& bottom_blobs, std::vector<Mat>& top_blobs, const Option& opt);
+
+int Split_infer_shape(void *_self, const std::vector<Mat>& bottom_shapes, std::vector<Mat>& top_shapes);
 
 // default operators
 #define Split_dtor                     Layer_dtor
@@ -33,7 +35,7 @@ int Split_forward(void *_self, const std::vector<Mat>& bottom_blobs, std::vector
 #define Split_load_model               Layer_load_model
 #define Split_create_pipeline          Layer_create_pipeline
 #define Split_destroy_pipeline         Layer_destroy_pipeline
-#define Split_forward_multi            Layer_forward_multi
+#define Split_forward                  Layer_forward
 #define Split_forward_inplace_multi    Layer_forward_inplace_multi
 #define Split_forward_inplace          Layer_forward_inplace
 
@@ -0,0 +1,102 @@
+/*
+   AVX implementation of exp
+
+   Based on "sse_mathfun.h", by Julien Pommier
+   http://gruntthepeon.free.fr/ssemath/
+
+   Copyright (C) 2012 Giovanni Garberoglio
+   Interdisciplinary Laboratory for Computational Science (LISC)
+   Fondazione Bruno Kessler and University of Trento
+   via Sommarive, 18
+   I-38123 Trento (Italy)
+
+  This software is provided 'as-is', without any express or implied
+  warranty.  In no event will the authors be held liable for any damages
+  arising from the use of this software.
+
+  Permission is granted to anyone to use this software for any purpose,
+  including commercial applications, and to alter it and redistribute it
+  freely, subject to the following restrictions:
+
+  1. The origin of this software must not be misrepresented; you must not
+     claim that you wrote the original software. If you use this software
+     in a product, an acknowledgment in the product documentation would be
+     appreciated but is not required.
+  2. Altered source versions must be plainly marked as such, and must not be
+     misrepresented as being the original software.
+  3. This notice may not be removed or altered from any source distribution.
+
+  (this is the zlib license)
+*/
+
+#ifndef AVX_MATHFUN_H
+#define AVX_MATHFUN_H
+
+#include <immintrin.h>
+
+#include "sse_mathfun.h"
+
+#if __AVX__
+/* exp() computed for 8 float at once */
+static inline __m256 exp256_ps(__m256 x)
+{
+    __m256 tmp, fx;
+
+    __m256 one = _mm256_set1_ps(1.f);
+    x = _mm256_min_ps(x, _mm256_set1_ps(c_exp_hi));
+    x = _mm256_max_ps(x, _mm256_set1_ps(c_exp_lo));
+
+    /* express exp(x) as exp(g + n*log(2)) */
+    fx = _mm256_mul_ps(x, _mm256_set1_ps(c_cephes_LOG2EF));
+    fx = _mm256_add_ps(fx, _mm256_set1_ps(0.5f));
+
+    /* perform a floorf */
+    tmp = _mm256_floor_ps(fx);
+
+    /* if greater, substract 1 */
+    __m256 mask = _mm256_cmp_ps(tmp, fx, _CMP_GT_OS);
+    mask = _mm256_and_ps(mask, one);
+    fx = _mm256_sub_ps(tmp, mask);
+
+    tmp = _mm256_mul_ps(fx, _mm256_set1_ps(c_cephes_exp_C1));
+    __m256 z = _mm256_mul_ps(fx, _mm256_set1_ps(c_cephes_exp_C2));
+    x = _mm256_sub_ps(x, tmp);
+    x = _mm256_sub_ps(x, z);
+
+    z = _mm256_mul_ps(x, x);
+
+    __m256 y = _mm256_set1_ps(c_cephes_exp_p0);
+    y = _mm256_mul_ps(y, x);
+    y = _mm256_add_ps(y, _mm256_set1_ps(c_cephes_exp_p1));
+    y = _mm256_mul_ps(y, x);
+    y = _mm256_add_ps(y, _mm256_set1_ps(c_cephes_exp_p2));
+    y = _mm256_mul_ps(y, x);
+    y = _mm256_add_ps(y, _mm256_set1_ps(c_cephes_exp_p3));
+    y = _mm256_mul_ps(y, x);
+    y = _mm256_add_ps(y, _mm256_set1_ps(c_cephes_exp_p4));
+    y = _mm256_mul_ps(y, x);
+    y = _mm256_add_ps(y, _mm256_set1_ps(c_cephes_exp_p5));
+    y = _mm256_mul_ps(y, z);
+    y = _mm256_add_ps(y, x);
+    y = _mm256_add_ps(y, one);
+
+    /* build 2^n */
+    __m256i imm0 = _mm256_cvttps_epi32(fx);
+#if __AVX2__
+    imm0 = _mm256_add_epi32(imm0, _mm256_set1_epi32(0x7f));
+    imm0 = _mm256_slli_epi32(imm0, 23);
+#else
+    __m128i imm0_lo = _mm256_castsi256_si128(imm0);
+    __m128i imm0_hi = _mm256_extractf128_si256(imm0, 1);
+    imm0_lo = _mm_slli_epi32(_mm_add_epi32(imm0_lo, _mm_set1_epi32(0x7f)), 23);
+    imm0_hi = _mm_slli_epi32(_mm_add_epi32(imm0_hi, _mm_set1_epi32(0x7f)), 23);
+    imm0 = _mm256_insertf128_si256(_mm256_castsi128_si256(imm0_lo), imm0_hi, 1);
+#endif // __AVX2__
+    __m256 pow2n = _mm256_castsi256_ps(imm0);
+
+    y = _mm256_mul_ps(y, pow2n);
+    return y;
+}
+#endif // __AVX__
+
+#endif // AVX_MATHFUN_H
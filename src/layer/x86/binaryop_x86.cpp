@@ -0,0 +1,289 @@
+// Tencent is pleased to support the open source community by making ncnn available.
+//
+// Copyright (C) 2020 THL A29 Limited, a Tencent company. All rights reserved.
+//
+// Licensed under the BSD 3-Clause License (the "License"); you may not use this file except
+// in compliance with the License. You may obtain a copy of the License at
+//
+// https://opensource.org/licenses/BSD-3-Clause
+//
+// Unless required by applicable law or agreed to in writing, software distributed
+// under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+// CONDITIONS OF ANY KIND, either express or implied. See the License for the
+// specific language governing permissions and limitations under the License.
+
+#include "binaryop_x86.h"
+
+#if __SSE2__
+#include <emmintrin.h>
+#if __AVX__
+#include <immintrin.h>
+#endif // __AVX__
+#endif // __SSE2__
+
+#include "cstl/utils.h"
+
+enum OperationType {
+    Operation_ADD   = 0,
+    Operation_SUB   = 1,
+    Operation_MUL   = 2,
+    Operation_DIV   = 3,
+    Operation_MAX   = 4,
+    Operation_MIN   = 5,
+    Operation_POW   = 6,
+    Operation_RSUB  = 7,
+    Operation_RDIV  = 8
+};
+
+void *BinaryOp_x86_ctor(void *_self, va_list *args)
+{
+    return _self;
+}
+
+struct binary_op_add_x86 {
+    float func(float x, float y) const { return x + y; }
+#if __SSE2__
+    __m128 func_pack4(__m128 x, __m128 y) const { return _mm_add_ps(x, y); }
+#if __AVX__
+    __m256 func_pack8(__m256 x, __m256 y) const { return _mm256_add_ps(x, y); }
+#if __AVX512F__
+    __m512 func_pack16(__m512 x, __m512 y) const { return _mm512_add_ps(x, y); }
+#endif // __AVX512F__
+#endif // __AVX__
+#endif // __SSE2__
+};
+
+struct binary_op_sub_x86 {
+    float func(float x, float y) const { return x - y; }
+#if __SSE2__
+    __m128 func_pack4(__m128 x, __m128 y) const { return _mm_sub_ps(x, y); }
+#if __AVX__
+    __m256 func_pack8(__m256 x, __m256 y) const { return _mm256_sub_ps(x, y); }
+#if __AVX512F__
+    __m512 func_pack16(__m512 x, __m512 y) const { return _mm512_sub_ps(x, y); }
+#endif // __AVX512F__
+#endif // __AVX__
+#endif // __SSE2__
+};
+
+struct binary_op_mul_x86 {
+    float func(float x, float y) const { return x * y; }
+#if __SSE2__
+    __m128 func_pack4(__m128 x, __m128 y) const { return _mm_mul_ps(x, y); }
+#if __AVX__
+    __m256 func_pack8(__m256 x, __m256 y) const { return _mm256_mul_ps(x, y); }
+#if __AVX512F__
+    __m512 func_pack16(__m512 x, __m512 y) const { return _mm512_mul_ps(x, y); }
+#endif // __AVX512F__
+#endif // __AVX__
+#endif // __SSE2__
+};
+
+struct binary_op_div_x86 {
+    float func(float x, float y) const { return x / y; }
+#if __SSE2__
+    __m128 func_pack4(__m128 x, __m128 y) const { return _mm_div_ps(x, y); }
+#if __AVX__
+    __m256 func_pack8(__m256 x, __m256 y) const { return _mm256_div_ps(x, y); }
+#if __AVX512F__
+    __m512 func_pack16(__m512 x, __m512 y) const { return _mm512_div_ps(x, y); }
+#endif // __AVX512F__
+#endif // __AVX__
+#endif // __SSE2__
+};
+
+struct binary_op_max_x86 {
+    float func(float x, float y) const { return max(x, y); }
+#if __SSE2__
+    __m128 func_pack4(__m128 x, __m128 y) const { return _mm_max_ps(x, y); }
+#if __AVX__
+    __m256 func_pack8(__m256 x, __m256 y) const { return _mm256_max_ps(x, y); }
+#if __AVX512F__
+    __m512 func_pack16(__m512 x, __m512 y) const { return _mm512_max_ps(x, y); }
+#endif // __AVX512F__
+#endif // __AVX__
+#endif // __SSE2__
+};
+
+struct binary_op_min_x86 {
+    float func(float x, float y) const { return min(x, y); }
+#if __SSE2__
+    __m128 func_pack4(__m128 x, __m128 y) const { return _mm_min_ps(x, y); }
+#if __AVX__
+    __m256 func_pack8(__m256 x, __m256 y) const { return _mm256_min_ps(x, y); }
+#if __AVX512F__
+    __m512 func_pack16(__m512 x, __m512 y) const { return _mm512_min_ps(x, y); }
+#endif // __AVX512F__
+#endif // __AVX__
+#endif // __SSE2__
+};
+
+// c[i] = op(a[i], b[i * b_step]), b_step is 1 for a full row and 0 for a broadcast scalar
+template<typename Op>
+static void binary_op_row_x86(const float* ptr, const float* ptr1, float* outptr, int size, int b_step)
+{
+    Op op;
+
+    int i = 0;
+#if __SSE2__
+    if (b_step == 1)
+    {
+#if __AVX__
+#if __AVX512F__
+        for (; i+15<size; i+=16)
+        {
+            _mm512_storeu_ps(outptr + i, op.func_pack16(_mm512_loadu_ps(ptr + i), _mm512_loadu_ps(ptr1 + i)));
+        }
+#endif // __AVX512F__
+        for (; i+7<size; i+=8)
+        {
+            _mm256_storeu_ps(outptr + i, op.func_pack8(_mm256_loadu_ps(ptr + i), _mm256_loadu_ps(ptr1 + i)));
+        }
+#endif // __AVX__
+        for (; i+3<size; i+=4)
+        {
+            _mm_storeu_ps(outptr + i, op.func_pack4(_mm_loadu_ps(ptr + i), _mm_loadu_ps(ptr1 + i)));
+        }
+    }
+    else
+    {
+#if __AVX__
+#if __AVX512F__
+        __m512 _b16 = _mm512_set1_ps(ptr1[0]);
+        for (; i+15<size; i+=16)
+        {
+            _mm512_storeu_ps(outptr + i, op.func_pack16(_mm512_loadu_ps(ptr + i), _b16));
+        }
+#endif // __AVX512F__
+        __m256 _b8 = _mm256_set1_ps(ptr1[0]);
+        for (; i+7<size; i+=8)
+        {
+            _mm256_storeu_ps(outptr + i, op.func_pack8(_mm256_loadu_ps(ptr + i), _b8));
+        }
+#endif // __AVX__
+        __m128 _b = _mm_set1_ps(ptr1[0]);
+        for (; i+3<size; i+=4)
+        {
+            _mm_storeu_ps(outptr + i, op.func_pack4(_mm_loadu_ps(ptr + i), _b));
+        }
+    }
+#endif // __SSE2__
+    for (; i<size; i++)
+    {
+        outptr[i] = op.func(ptr[i], ptr1[i * b_step]);
+    }
+}
+
+// only the same-shape and per-channel scalar cases are vectorized,
+// the remaining broadcast patterns go through the reference path
+template<typename Op>
+static int binary_op_x86(void *_self, const std::vector<Mat>& bottom_blobs, std::vector<Mat>& top_blobs, const Option& opt)
+{
+    const Mat& a = bottom_blobs[0];
+    const Mat& b = bottom_blobs[1];
+    Mat& c = top_blobs[0];
+
+    int w = a.w;
+    int h = a.h;
+    int channels = a.c;
+    int size = w * h;
+    size_t elemsize = a.elemsize;
+
+    const bool same_shape = a.dims == b.dims && a.w == b.w && a.h == b.h && a.c == b.c;
+    const bool channel_scalar = a.dims == 3 && b.dims == 3 && b.w == 1 && b.h == 1 && b.c == channels;
+
+    if (!same_shape && !channel_scalar)
+        return BinaryOp_forward_multi(_self, bottom_blobs, top_blobs, opt);
+
+    if (a.dims == 1)
+        c.create(w, elemsize, opt.blob_allocator);
+    else if (a.dims == 2)
+        c.create(w, h, elemsize, opt.blob_allocator);
+    else
+        c.create(w, h, channels, elemsize, opt.blob_allocator);
+    if (c.empty())
+        return -100;
+
+    const int b_step = same_shape ? 1 : 0;
+
+    #pragma omp parallel for num_threads(opt.num_threads)
+    for (int q = 0; q < channels; q++)
+    {
+        const float* ptr = a.channel(q);
+        const float* ptr1 = b.channel(q);
+        float* outptr = c.channel(q);
+
+        binary_op_row_x86<Op>(ptr, ptr1, outptr, size, b_step);
+    }
+
+    return 0;
+}
+
+template<typename Op>
+static int binary_op_scalar_inplace_x86(Mat& a, float b, const Option& opt)
+{
+    int w = a.w;
+    int h = a.h;
+    int channels = a.c;
+    int size = w * h;
+
+    #pragma omp parallel for num_threads(opt.num_threads)
+    for (int q = 0; q < channels; q++)
+    {
+        float* ptr = a.channel(q);
+
+        binary_op_row_x86<Op>(ptr, &b, ptr, size, 0);
+    }
+
+    return 0;
+}
+
+int BinaryOp_x86_forward_multi(void *_self, const std::vector<Mat>& bottom_blobs, std::vector<Mat>& top_blobs, const Option& opt)
+{
+    BinaryOp *self = (BinaryOp *)_self;
+
+    if (self->op_type == Operation_ADD)
+        return binary_op_x86<binary_op_add_x86>(self, bottom_blobs, top_blobs, opt);
+
+    if (self->op_type == Operation_SUB)
+        return binary_op_x86<binary_op_sub_x86>(self, bottom_blobs, top_blobs, opt);
+
+    if (self->op_type == Operation_MUL)
+        return binary_op_x86<binary_op_mul_x86>(self, bottom_blobs, top_blobs, opt);
+
+    if (self->op_type == Operation_DIV)
+        return binary_op_x86<binary_op_div_x86>(self, bottom_blobs, top_blobs, opt);
+
+    if (self->op_type == Operation_MAX)
+        return binary_op_x86<binary_op_max_x86>(self, bottom_blobs, top_blobs, opt);
+
+    if (self->op_type == Operation_MIN)
+        return binary_op_x86<binary_op_min_x86>(self, bottom_blobs, top_blobs, opt);
+
+    return BinaryOp_forward_multi(self, bottom_blobs, top_blobs, opt);
+}
+
+int BinaryOp_x86_forward_inplace(void *_self, Mat& bottom_top_blob, const Option& opt)
+{
+    BinaryOp *self = (BinaryOp *)_self;
+
+    if (self->op_type == Operation_ADD)
+        return binary_op_scalar_inplace_x86<binary_op_add_x86>(bottom_top_blob, self->b, opt);
+
+    if (self->op_type == Operation_SUB)
+        return binary_op_scalar_inplace_x86<binary_op_sub_x86>(bottom_top_blob, self->b, opt);
+
+    if (self->op_type == Operation_MUL)
+        return binary_op_scalar_inplace_x86<binary_op_mul_x86>(bottom_top_blob, self->b, opt);
+
+    if (self->op_type == Operation_DIV)
+        return binary_op_scalar_inplace_x86<binary_op_div_x86>(bottom_top_blob, self->b, opt);
+
+    if (self->op_type == Operation_MAX)
+        return binary_op_scalar_inplace_x86<binary_op_max_x86>(bottom_top_blob, self->b, opt);
+
+    if (self->op_type == Operation_MIN)
+        return binary_op_scalar_inplace_x86<binary_op_min_x86>(bottom_top_blob, self->b, opt);
+
+    return BinaryOp_forward_inplace(self, bottom_top_blob, opt);
+}
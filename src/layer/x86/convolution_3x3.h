@@ -0,0 +1,463 @@
+// Tencent is pleased to support the open source community by making ncnn available.
+//
+// Copyright (C) 2020 THL A29 Limited, a Tencent company. All rights reserved.
+//
+// Licensed under the BSD 3-Clause License (the "License"); you may not use this file except
+// in compliance with the License. You may obtain a copy of the License at
+//
+// https://opensource.org/licenses/BSD-3-Clause
+//
+// Unless required by applicable law or agreed to in writing, software distributed
+// under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+// CONDITIONS OF ANY KIND, either express or implied. See the License for the
+// specific language governing permissions and limitations under the License.
+
+// winograd F(6,3), the 64 transformed positions are multiplied by sgemm_x86
+// kernel_tm layout  8-inch-outch/8 + inch-outch%8 for each of the 64 positions
+
+static void conv3x3s1_winograd64_transform_kernel_x86(const Mat& kernel, Mat& kernel_tm, int inch, int outch)
+{
+    // G
+    const float ktm[8][3] = {
+        {   1.0f,     0.0f,     0.0f},
+        {-2.0f/9,  -2.0f/9,  -2.0f/9},
+        {-2.0f/9,   2.0f/9,  -2.0f/9},
+        {1.0f/90,  1.0f/45,  2.0f/45},
+        {1.0f/90, -1.0f/45,  2.0f/45},
+        {1.0f/45,  1.0f/90, 1.0f/180},
+        {1.0f/45, -1.0f/90, 1.0f/180},
+        {   0.0f,     0.0f,     1.0f}
+    };
+
+    const int nn_outch = outch >> 3;
+    const int remain_outch_start = nn_outch << 3;
+
+    kernel_tm.create(8 * inch, nn_outch + outch - remain_outch_start, 64, (size_t)4u);
+
+    #pragma omp parallel for
+    for (int p = 0; p<outch; p++)
+    {
+        const int row = p < remain_outch_start ? p / 8 : nn_outch + p - remain_outch_start;
+
+        for (int q = 0; q<inch; q++)
+        {
+            const float* kernel0 = (const float*)kernel + p*inch * 9 + q * 9;
+
+            // transform kernel
+            const float* k0 = kernel0;
+            const float* k1 = kernel0 + 3;
+            const float* k2 = kernel0 + 6;
+
+            // h
+            float tmp[8][3];
+            for (int i=0; i<8; i++)
+            {
+                tmp[i][0] = k0[0] * ktm[i][0] + k0[1] * ktm[i][1] + k0[2] * ktm[i][2];
+                tmp[i][1] = k1[0] * ktm[i][0] + k1[1] * ktm[i][1] + k1[2] * ktm[i][2];
+                tmp[i][2] = k2[0] * ktm[i][0] + k2[1] * ktm[i][1] + k2[2] * ktm[i][2];
+            }
+
+            // v
+            for (int j=0; j<8; j++)
+            {
+                float* tmpp = &tmp[j][0];
+
+                for (int i=0; i<8; i++)
+                {
+                    float* ktmp = kernel_tm.channel(j*8 + i).row(row);
+
+                    const float v = tmpp[0] * ktm[i][0] + tmpp[1] * ktm[i][1] + tmpp[2] * ktm[i][2];
+
+                    if (p < remain_outch_start)
+                        ktmp[q * 8 + p % 8] = v;
+                    else
+                        ktmp[q] = v;
+                }
+            }
+        }
+    }
+}
+
+struct Conv3x3s1Winograd64TransformOutputX86Args
+{
+    const Mat* top_tm;
+    Mat* top_blob;
+    const float* bias;
+    int w_tiles;
+    int h_tiles;
+    float act0;
+    float act1;
+};
+
+template<int activation_type>
+static void conv3x3s1_winograd64_transform_output_x86_channel(int p, void* _args)
+{
+    const Conv3x3s1Winograd64TransformOutputX86Args* args = (const Conv3x3s1Winograd64TransformOutputX86Args*)_args;
+
+    const Mat& top_tm = *args->top_tm;
+    Mat& top_blob = *args->top_blob;
+    const float* bias = args->bias;
+    const int w_tiles = args->w_tiles;
+    const int h_tiles = args->h_tiles;
+    const float act0 = args->act0;
+    const float act1 = args->act1;
+
+    const int outw = top_blob.w;
+    const int outh = top_blob.h;
+
+//         const float otm[6][8] = {
+//             {1.0f,  1.0f,   1.0f,   1.0f,   1.0f,  32.0f,  32.0f, 0.0f},
+//             {0.0f,  1.0f,  -1.0f,   2.0f,  -2.0f,  16.0f, -16.0f, 0.0f},
+//             {0.0f,  1.0f,   1.0f,   4.0f,   4.0f,   8.0f,   8.0f, 0.0f},
+//             {0.0f,  1.0f,  -1.0f,   8.0f,  -8.0f,   4.0f,  -4.0f, 0.0f},
+//             {0.0f,  1.0f,   1.0f,  16.0f,  16.0f,   2.0f,   2.0f, 0.0f},
+//             {0.0f,  1.0f,  -1.0f,  32.0f, -32.0f,   1.0f,  -1.0f, 1.0f}
+//         };
+
+    // 0 = r0 + (r1 + r2) + (r3 + r4)     + (r5 + r6) * 32
+    // 1 =      (r1 - r2) + (r3 - r4) * 2 + (r5 - r6) * 16
+    // 2 =      (r1 + r2) + (r3 + r4) * 4 + (r5 + r6) * 8
+    // 3 =      (r1 - r2) + (r3 - r4) * 8 + (r5 - r6) * 4
+    // 4 =      (r1 + r2) + (r3 + r4) * 16+ (r5 + r6) * 2
+    // 5 = r7 + (r1 - r2) + (r3 - r4) * 32+ (r5 - r6)
+
+    Mat out0 = top_blob.channel(p);
+
+    const float bias0 = bias ? bias[p] : 0.f;
+
+    float tmp[6][8];
+
+    for (int i = 0; i<h_tiles; i++)
+    {
+        for (int j = 0; j<w_tiles; j++)
+        {
+            const int t = i * w_tiles + j;
+
+            float out0_tm[64];
+            for (int r=0; r<64; r++)
+            {
+                out0_tm[r] = top_tm.channel(r).row(p)[t];
+            }
+
+            const float* r0 = out0_tm;
+
+            for (int m=0; m<8; m++)
+            {
+                float tmp024a = r0[1] + r0[2];
+                float tmp135a = r0[1] - r0[2];
+
+                float tmp024b = r0[3] + r0[4];
+                float tmp135b = r0[3] - r0[4];
+
+                float tmp024c = r0[5] + r0[6];
+                float tmp135c = r0[5] - r0[6];
+
+                tmp[0][m] = r0[0] + tmp024a + tmp024b + tmp024c * 32;
+                tmp[2][m] = tmp024a + tmp024b * 4 + tmp024c * 8;
+                tmp[4][m] = tmp024a + tmp024b * 16 + tmp024c + tmp024c;
+
+                tmp[1][m] = tmp135a + tmp135b + tmp135b + tmp135c * 16;
+                tmp[3][m] = tmp135a + tmp135b * 8 + tmp135c * 4;
+                tmp[5][m] = r0[7] + tmp135a + tmp135b * 32 + tmp135c;
+
+                r0 += 8;
+            }
+
+            for (int m=0; m<6; m++)
+            {
+                if (i * 6 + m >= outh)
+                    break;
+
+                const float* tmp0 = tmp[m];
+
+                float output0[6];
+
+                float tmp024a = tmp0[1] + tmp0[2];
+                float tmp135a = tmp0[1] - tmp0[2];
+
+                float tmp024b = tmp0[3] + tmp0[4];
+                float tmp135b = tmp0[3] - tmp0[4];
+
+                float tmp024c = tmp0[5] + tmp0[6];
+                float tmp135c = tmp0[5] - tmp0[6];
+
+                output0[0] = bias0 + tmp0[0] + tmp024a + tmp024b + tmp024c * 32;
+                output0[2] = bias0 + tmp024a + tmp024b * 4 + tmp024c * 8;
+                output0[4] = bias0 + tmp024a + tmp024b * 16 + tmp024c + tmp024c;
+
+                output0[1] = bias0 + tmp135a + tmp135b + tmp135b + tmp135c * 16;
+                output0[3] = bias0 + tmp135a + tmp135b * 8 + tmp135c * 4;
+                output0[5] = bias0 + tmp0[7] + tmp135a + tmp135b * 32 + tmp135c;
+
+                float* outptr = out0.row(i * 6 + m) + j * 6;
+
+                for (int n=0; n<6 && j * 6 + n < outw; n++)
+                {
+                    outptr[n] = epilogue_ss<activation_type>(output0[n], act0, act1);
+                }
+            }
+        }
+    }
+}
+
+// output transform with bias, activation is applied in the store step
+template<int activation_type>
+static void conv3x3s1_winograd64_transform_output_x86(const Mat& top_tm, Mat& top_blob, const float* bias, int w_tiles, int h_tiles, float act0, float act1, const Option& opt)
+{
+    Conv3x3s1Winograd64TransformOutputX86Args args;
+    args.top_tm = &top_tm;
+    args.top_blob = &top_blob;
+    args.bias = bias;
+    args.w_tiles = w_tiles;
+    args.h_tiles = h_tiles;
+    args.act0 = act0;
+    args.act1 = act1;
+
+    parallel_for(top_blob.c, conv3x3s1_winograd64_transform_output_x86_channel<activation_type>, &args, opt);
+}
+
+struct Conv3x3s1Winograd64TransformInputX86Args
+{
+    const Mat* bottom_blob_bordered;
+    Mat* bottom_tm;
+    int w_tiles;
+    int h_tiles;
+};
+
+static void conv3x3s1_winograd64_transform_input_x86_channel(int q, void* _args)
+{
+    const Conv3x3s1Winograd64TransformInputX86Args* args = (const Conv3x3s1Winograd64TransformInputX86Args*)_args;
+
+    const Mat& bottom_blob_bordered = *args->bottom_blob_bordered;
+    Mat& bottom_tm = *args->bottom_tm;
+    const int w_tiles = args->w_tiles;
+    const int h_tiles = args->h_tiles;
+
+    const int w = bottom_blob_bordered.w;
+
+    const int tiles = w_tiles * h_tiles;
+    const int nn_tiles = tiles >> 3;
+    const int remain_tiles_start = nn_tiles << 3;
+
+//         const float itm[8][8] = {
+//             {1.0f,  0.0f, -5.25f,  0.00f,  5.25f,  0.00f, -1.0f, 0.0f},
+//
+//             {0.0f,  1.0f,  1.00f, -4.25f, -4.25f,  1.00f,  1.0f, 0.0f},
+//             {0.0f, -1.0f,  1.00f,  4.25f, -4.25f, -1.00f,  1.0f, 0.0f},
+//
+//             {0.0f,  0.5f,  0.25f, -2.50f, -1.25f,  2.00f,  1.0f, 0.0f},
+//             {0.0f, -0.5f,  0.25f,  2.50f, -1.25f, -2.00f,  1.0f, 0.0f},
+//
+//             {0.0f,  2.0f,  4.00f, -2.50f, -5.00f,  0.50f,  1.0f, 0.0f},
+//             {0.0f, -2.0f,  4.00f,  2.50f, -5.00f, -0.50f,  1.0f, 0.0f},
+//
+//             {0.0f, -1.0f,  0.00f,  5.25f,  0.00f, -5.25f,  0.0f, 1.0f}
+//         };
+
+    // 0 = r00 - r06 + (r04 - r02) * 5.25
+    // 7 = r07 - r01 + (r03 - r05) * 5.25
+
+    // 1 = (r02 + r06 - r04 * 4.25) + (r01 - r03 * 4.25 + r05)
+    // 2 = (r02 + r06 - r04 * 4.25) - (r01 - r03 * 4.25 + r05)
+
+    // 3 = (r06 + r02 * 0.25 - r04 * 1.25) + (r01 * 0.5 - r03 * 2.5 + r05 * 2)
+    // 4 = (r06 + r02 * 0.25 - r04 * 1.25) - (r01 * 0.5 - r03 * 2.5 + r05 * 2)
+
+    // reuse r04 * 1.25
+    // reuse r03 * 2.5
+    // 5 = (r06 + (r02 - r04 * 1.25) * 4) + (r01 * 2 - r03 * 2.5 + r05 * 0.5)
+    // 6 = (r06 + (r02 - r04 * 1.25) * 4) - (r01 * 2 - r03 * 2.5 + r05 * 0.5)
+
+    const Mat img = bottom_blob_bordered.channel(q);
+
+    float tmp[8][8];
+
+    for (int i = 0; i<h_tiles; i++)
+    {
+        for (int j = 0; j<w_tiles; j++)
+        {
+            const float* r0 = img.row(i * 6) + j * 6;
+
+            for (int m=0; m<8; m++)
+            {
+                tmp[0][m] = r0[0] - r0[6] + (r0[4] - r0[2]) * 5.25f;
+                tmp[7][m] = r0[7] - r0[1] + (r0[3] - r0[5]) * 5.25f;
+
+                float tmp12a = (r0[2] + r0[6] - r0[4] * 4.25f);
+                float tmp12b = (r0[1] + r0[5] - r0[3] * 4.25f);
+
+                tmp[1][m] = tmp12a + tmp12b;
+                tmp[2][m] = tmp12a - tmp12b;
+
+                float tmp34a = (r0[6] + r0[2] * 0.25f - r0[4] * 1.25f);
+                float tmp34b = (r0[1] * 0.5f - r0[3] * 2.5f + r0[5] * 2.f);
+
+                tmp[3][m] = tmp34a + tmp34b;
+                tmp[4][m] = tmp34a - tmp34b;
+
+                float tmp56a = (r0[6] + (r0[2] - r0[4] * 1.25f) * 4.f);
+                float tmp56b = (r0[1] * 2.f - r0[3] * 2.5f + r0[5] * 0.5f);
+
+                tmp[5][m] = tmp56a + tmp56b;
+                tmp[6][m] = tmp56a - tmp56b;
+
+                r0 += w;
+            }
+
+            const int t = i * w_tiles + j;
+            const int row = t < remain_tiles_start ? t / 8 : nn_tiles + t - remain_tiles_start;
+            const int col = t < remain_tiles_start ? q * 8 + t % 8 : q;
+
+            for (int m=0; m<8; m++)
+            {
+                const float* tmp0 = tmp[m];
+
+                float r0_tm[8];
+
+                r0_tm[0] = tmp0[0] - tmp0[6] + (tmp0[4] - tmp0[2]) * 5.25f;
+                r0_tm[7] = tmp0[7] - tmp0[1] + (tmp0[3] - tmp0[5]) * 5.25f;
+
+                float tmp12a = (tmp0[2] + tmp0[6] - tmp0[4] * 4.25f);
+                float tmp12b = (tmp0[1] - tmp0[3] * 4.25f + tmp0[5]);
+
+                r0_tm[1] = tmp12a + tmp12b;
+                r0_tm[2] = tmp12a - tmp12b;
+
+                float tmp34a = (tmp0[6] + tmp0[2] * 0.25f - tmp0[4] * 1.25f);
+                float tmp34b = (tmp0[1] * 0.5f - tmp0[3] * 2.5f + tmp0[5] * 2.f);
+
+                r0_tm[3] = tmp34a + tmp34b;
+                r0_tm[4] = tmp34a - tmp34b;
+
+                float tmp56a = (tmp0[6] + (tmp0[2] - tmp0[4] * 1.25f) * 4.f);
+                float tmp56b = (tmp0[1] * 2.f - tmp0[3] * 2.5f + tmp0[5] * 0.5f);
+
+                r0_tm[5] = tmp56a + tmp56b;
+                r0_tm[6] = tmp56a - tmp56b;
+
+                for (int n=0; n<8; n++)
+                {
+                    float* outptr = bottom_tm.channel(m * 8 + n).row(row);
+                    outptr[col] = r0_tm[n];
+                }
+            }
+        }
+    }
+}
+
+struct Conv3x3s1Winograd64DotX86Args
+{
+    const Mat* bottom_tm;
+    const Mat* kernel_tm;
+    Mat* top_tm;
+    int inch;
+    int outch;
+    const Option* opt;
+};
+
+// one of the 64 independent gemms of the winograd domain, single threaded
+static void conv3x3s1_winograd64_dot_x86_position(int r, void* _args)
+{
+    const Conv3x3s1Winograd64DotX86Args* args = (const Conv3x3s1Winograd64DotX86Args*)_args;
+
+    const Mat& bottom_tm = *args->bottom_tm;
+    const Mat& kernel_tm = *args->kernel_tm;
+    Mat& top_tm = *args->top_tm;
+    const int inch = args->inch;
+    const int outch = args->outch;
+    const int tiles = top_tm.w;
+
+    Option opt_1 = *args->opt;
+    opt_1.num_threads = 1;
+
+    const Mat no_activation_params;
+
+    const Mat kernel_tm_r = kernel_tm.channel(r);
+    const Mat bottom_tm_r = bottom_tm.channel(r);
+    float* top_tm_r = top_tm.channel(r);
+
+    sgemm_x86(outch, tiles, inch, kernel_tm_r, bottom_tm_r, top_tm_r, tiles, 0, 0, no_activation_params, opt_1);
+}
+
+static int conv3x3s1_winograd64_x86(const Mat& bottom_blob, Mat& top_blob, const Mat& kernel_tm, const Mat& _bias, int activation_type, const Mat& activation_params, const Option& opt)
+{
+    int w = bottom_blob.w;
+    int h = bottom_blob.h;
+    int inch = bottom_blob.c;
+
+    int outw = top_blob.w;
+    int outh = top_blob.h;
+    int outch = top_blob.c;
+
+    const float* bias = _bias;
+
+    // pad to 6n+2
+    Mat bottom_blob_bordered = bottom_blob;
+
+    int outw_align = (outw + 5) / 6 * 6;
+    int outh_align = (outh + 5) / 6 * 6;
+
+    {
+        Option opt_b = opt;
+        opt_b.blob_allocator = opt.workspace_allocator;
+        copy_make_border(bottom_blob, bottom_blob_bordered, 0, outh_align + 2 - h, 0, outw_align + 2 - w, BORDER_CONSTANT, 0.f, opt_b);
+        if (bottom_blob_bordered.empty())
+            return -100;
+    }
+
+    w = bottom_blob_bordered.w;
+
+    const int w_tiles = outw_align / 6;
+    const int h_tiles = outh_align / 6;
+    const int tiles = w_tiles * h_tiles;
+
+    const int nn_tiles = tiles >> 3;
+    const int remain_tiles_start = nn_tiles << 3;
+
+    // BEGIN transform input
+    // bottom_tm layout  8-inch-tiles/8 + inch-tiles%8 for each of the 64 positions
+    Mat bottom_tm(8 * inch, nn_tiles + tiles - remain_tiles_start, 64, (size_t)4u, opt.workspace_allocator);
+    if (bottom_tm.empty())
+        return -100;
+    {
+        Conv3x3s1Winograd64TransformInputX86Args args;
+        args.bottom_blob_bordered = &bottom_blob_bordered;
+        args.bottom_tm = &bottom_tm;
+        args.w_tiles = w_tiles;
+        args.h_tiles = h_tiles;
+
+        parallel_for(inch, conv3x3s1_winograd64_transform_input_x86_channel, &args, opt);
+    }
+    bottom_blob_bordered = Mat();
+    // END transform input
+
+    // BEGIN dot
+    Mat top_tm(tiles, outch, 64, (size_t)4u, opt.workspace_allocator);
+    if (top_tm.empty())
+        return -100;
+    {
+        Conv3x3s1Winograd64DotX86Args args;
+        args.bottom_tm = &bottom_tm;
+        args.kernel_tm = &kernel_tm;
+        args.top_tm = &top_tm;
+        args.inch = inch;
+        args.outch = outch;
+        args.opt = &opt;
+
+        parallel_for(64, conv3x3s1_winograd64_dot_x86_position, &args, opt);
+    }
+    bottom_tm = Mat();
+    // END dot
+
+    // BEGIN transform output
+    {
+        float act0;
+        float act1;
+        activation_scalars(activation_type, activation_params, act0, act1);
+
+        ACTIVATION_EPILOGUE_DISPATCH(activation_type, conv3x3s1_winograd64_transform_output_x86, (top_tm, top_blob, bias, w_tiles, h_tiles, act0, act1, opt))
+    }
+    // END transform output
+
+    return 0;
+}
@@ -0,0 +1,584 @@
+// Tencent is pleased to support the open source community by making ncnn available.
+//
+// Copyright (C) 2020 THL A29 Limited, a Tencent company. All rights reserved.
+//
+// Licensed under the BSD 3-Clause License (the "License"); you may not use this file except
+// in compliance with the License. You may obtain a copy of the License at
+//
+// https://opensource.org/licenses/BSD-3-Clause
+//
+// Unless required by applicable law or agreed to in writing, software distributed
+// under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+// CONDITIONS OF ANY KIND, either express or implied. See the License for the
+// specific language governing permissions and limitations under the License.
+
+// A = outch x K row major, packed into 8-row panels
+// B = K x N, packed into 8-column panels
+// C = A * B + bias, row stride ldc
+//
+// kernel_tm layout  8-K-outch/8 + K-outch%8
+// bottom_tm layout  8-K-N/8 + K-N%8
+
+static void conv_im2col_sgemm_transform_kernel_x86(const Mat& _kernel, Mat& kernel_tm, int inch, int outch, int kernel_size)
+{
+    const float* kernel = _kernel;
+
+    const int K = inch * kernel_size;
+
+    const int nn_outch = outch >> 3;
+    const int remain_outch_start = nn_outch << 3;
+
+    kernel_tm.create(8 * K, nn_outch + outch - remain_outch_start, (size_t)4u);
+
+    for (int pp=0; pp<nn_outch; pp++)
+    {
+        const int p = pp * 8;
+
+        float* ktmp = kernel_tm.row(pp);
+
+        for (int k=0; k<K; k++)
+        {
+            for (int j=0; j<8; j++)
+            {
+                ktmp[j] = kernel[(p + j) * K + k];
+            }
+
+            ktmp += 8;
+        }
+    }
+
+    for (int p=remain_outch_start; p<outch; p++)
+    {
+        float* ktmp = kernel_tm.row(nn_outch + p - remain_outch_start);
+
+        for (int k=0; k<K; k++)
+        {
+            ktmp[k] = kernel[p * K + k];
+        }
+    }
+}
+
+struct ConvIm2colPackX86Args
+{
+    const Mat* bottom_blob;
+    Mat* bottom_tm;
+    const int* space_ofs;
+    int outw;
+    int N;
+    int maxk;
+    int stride_w;
+    int stride_h;
+};
+
+// one 8-column panel, or one leftover column past the panels
+static void conv_im2col_pack_x86_column(int ii, void* _args)
+{
+    const ConvIm2colPackX86Args* args = (const ConvIm2colPackX86Args*)_args;
+
+    const Mat& bottom_blob = *args->bottom_blob;
+    Mat& bottom_tm = *args->bottom_tm;
+    const int* space_ofs = args->space_ofs;
+    const int outw = args->outw;
+    const int maxk = args->maxk;
+    const int stride_w = args->stride_w;
+    const int stride_h = args->stride_h;
+
+    const int w = bottom_blob.w;
+    const int inch = bottom_blob.c;
+
+    const int nn_size = args->N >> 3;
+    const int remain_size_start = nn_size << 3;
+
+    if (ii < nn_size)
+    {
+        const int i = ii * 8;
+
+        int offsets[8];
+        for (int j=0; j<8; j++)
+        {
+            int y = (i + j) / outw;
+            int x = (i + j) % outw;
+            offsets[j] = y * stride_h * w + x * stride_w;
+        }
+
+        // all 8 outputs sit in one row with unit stride
+        const bool contiguous = stride_w == 1 && offsets[7] - offsets[0] == 7;
+
+        float* tmpptr = bottom_tm.row(ii);
+
+        for (int q=0; q<inch; q++)
+        {
+            const float* img = bottom_blob.channel(q);
+
+            for (int k=0; k<maxk; k++)
+            {
+                const float* sptr = img + space_ofs[k];
+
+                if (contiguous)
+                {
+                    sptr += offsets[0];
+#if __AVX__
+                    _mm256_storeu_ps(tmpptr, _mm256_loadu_ps(sptr));
+#elif __SSE2__
+                    _mm_storeu_ps(tmpptr, _mm_loadu_ps(sptr));
+                    _mm_storeu_ps(tmpptr + 4, _mm_loadu_ps(sptr + 4));
+#else
+                    for (int j=0; j<8; j++)
+                        tmpptr[j] = sptr[j];
+#endif
+                }
+                else
+                {
+                    for (int j=0; j<8; j++)
+                        tmpptr[j] = sptr[offsets[j]];
+                }
+
+                tmpptr += 8;
+            }
+        }
+    }
+    else
+    {
+        const int i = remain_size_start + ii - nn_size;
+
+        const int y = i / outw;
+        const int x = i % outw;
+        const int offset = y * stride_h * w + x * stride_w;
+
+        float* tmpptr = bottom_tm.row(nn_size + i - remain_size_start);
+
+        for (int q=0; q<inch; q++)
+        {
+            const float* img = (const float*)bottom_blob.channel(q) + offset;
+
+            for (int k=0; k<maxk; k++)
+            {
+                tmpptr[0] = img[space_ofs[k]];
+                tmpptr++;
+            }
+        }
+    }
+}
+
+// gather the sliding windows of bottom_blob into 8-column panels, no intermediate im2col matrix
+static void conv_im2col_pack_x86(const Mat& bottom_blob, Mat& bottom_tm, int outw, int outh, int kernel_w, int kernel_h, int dilation_w, int dilation_h, int stride_w, int stride_h, const Option& opt)
+{
+    const int w = bottom_blob.w;
+    const int inch = bottom_blob.c;
+
+    const int maxk = kernel_w * kernel_h;
+    const int K = inch * maxk;
+    const int N = outw * outh;
+
+    const int nn_size = N >> 3;
+    const int remain_size_start = nn_size << 3;
+
+    bottom_tm.create(8 * K, nn_size + N - remain_size_start, (size_t)4u, opt.workspace_allocator);
+    if (bottom_tm.empty())
+        return;
+
+    // kernel offsets
+    std::vector<int> _space_ofs(maxk);
+    int* space_ofs = &_space_ofs[0];
+    {
+        int p1 = 0;
+        int p2 = 0;
+        int gap = w * dilation_h - kernel_w * dilation_w;
+        for (int i = 0; i < kernel_h; i++)
+        {
+            for (int j = 0; j < kernel_w; j++)
+            {
+                space_ofs[p1] = p2;
+                p1++;
+                p2 += dilation_w;
+            }
+            p2 += gap;
+        }
+    }
+
+    ConvIm2colPackX86Args args;
+    args.bottom_blob = &bottom_blob;
+    args.bottom_tm = &bottom_tm;
+    args.space_ofs = space_ofs;
+    args.outw = outw;
+    args.N = N;
+    args.maxk = maxk;
+    args.stride_w = stride_w;
+    args.stride_h = stride_h;
+
+    parallel_for(nn_size + N - remain_size_start, conv_im2col_pack_x86_column, &args, opt);
+}
+
+struct SgemmX86Args
+{
+    int M;
+    int N;
+    int K;
+    const Mat* kernel_tm;
+    const Mat* bottom_tm;
+    float* top;
+    size_t ldc;
+    const float* bias;
+    float act0;
+    float act1;
+};
+
+// one 8-row panel of C, or one leftover row past the panels
+template<int activation_type>
+static void sgemm_x86_epilogue_rows(int pp, void* _args)
+{
+    const SgemmX86Args* args = (const SgemmX86Args*)_args;
+
+    const int N = args->N;
+    const int K = args->K;
+    const Mat& kernel_tm = *args->kernel_tm;
+    const Mat& bottom_tm = *args->bottom_tm;
+    float* top = args->top;
+    const size_t ldc = args->ldc;
+    const float* bias = args->bias;
+    const float act0 = args->act0;
+    const float act1 = args->act1;
+
+    const int nn_outch = args->M >> 3;
+    const int remain_outch_start = nn_outch << 3;
+
+    const int nn_size = N >> 3;
+    const int remain_size_start = nn_size << 3;
+
+    if (pp < nn_outch)
+    {
+        const int p = pp * 8;
+
+        float* outptr[8];
+        float biasptr[8];
+        for (int j=0; j<8; j++)
+        {
+            outptr[j] = top + (p + j) * ldc;
+            biasptr[j] = bias ? bias[p + j] : 0.f;
+        }
+
+        const float* ktmp = kernel_tm.row(pp);
+
+        int i = 0;
+        for (; i<remain_size_start; i+=8)
+        {
+            const float* tmpptr = bottom_tm.row(i / 8);
+            const float* kptr = ktmp;
+
+#if __AVX__
+            __m256 _sum0 = _mm256_set1_ps(biasptr[0]);
+            __m256 _sum1 = _mm256_set1_ps(biasptr[1]);
+            __m256 _sum2 = _mm256_set1_ps(biasptr[2]);
+            __m256 _sum3 = _mm256_set1_ps(biasptr[3]);
+            __m256 _sum4 = _mm256_set1_ps(biasptr[4]);
+            __m256 _sum5 = _mm256_set1_ps(biasptr[5]);
+            __m256 _sum6 = _mm256_set1_ps(biasptr[6]);
+            __m256 _sum7 = _mm256_set1_ps(biasptr[7]);
+
+            for (int q=0; q<K; q++)
+            {
+                __m256 _val = _mm256_loadu_ps(tmpptr);
+
+                _sum0 = _mm256_comp_fmadd_ps(_mm256_broadcast_ss(kptr), _val, _sum0);
+                _sum1 = _mm256_comp_fmadd_ps(_mm256_broadcast_ss(kptr + 1), _val, _sum1);
+                _sum2 = _mm256_comp_fmadd_ps(_mm256_broadcast_ss(kptr + 2), _val, _sum2);
+                _sum3 = _mm256_comp_fmadd_ps(_mm256_broadcast_ss(kptr + 3), _val, _sum3);
+                _sum4 = _mm256_comp_fmadd_ps(_mm256_broadcast_ss(kptr + 4), _val, _sum4);
+                _sum5 = _mm256_comp_fmadd_ps(_mm256_broadcast_ss(kptr + 5), _val, _sum5);
+                _sum6 = _mm256_comp_fmadd_ps(_mm256_broadcast_ss(kptr + 6), _val, _sum6);
+                _sum7 = _mm256_comp_fmadd_ps(_mm256_broadcast_ss(kptr + 7), _val, _sum7);
+
+                tmpptr += 8;
+                kptr += 8;
+            }
+
+            _mm256_storeu_ps(outptr[0] + i, epilogue_avx<activation_type>(_sum0, act0, act1));
+            _mm256_storeu_ps(outptr[1] + i, epilogue_avx<activation_type>(_sum1, act0, act1));
+            _mm256_storeu_ps(outptr[2] + i, epilogue_avx<activation_type>(_sum2, act0, act1));
+            _mm256_storeu_ps(outptr[3] + i, epilogue_avx<activation_type>(_sum3, act0, act1));
+            _mm256_storeu_ps(outptr[4] + i, epilogue_avx<activation_type>(_sum4, act0, act1));
+            _mm256_storeu_ps(outptr[5] + i, epilogue_avx<activation_type>(_sum5, act0, act1));
+            _mm256_storeu_ps(outptr[6] + i, epilogue_avx<activation_type>(_sum6, act0, act1));
+            _mm256_storeu_ps(outptr[7] + i, epilogue_avx<activation_type>(_sum7, act0, act1));
+#elif __SSE2__
+            // two 8x4 halves, keeps the accumulators in registers
+            for (int half=0; half<2; half++)
+            {
+                const float* tmpptr_h = tmpptr + half * 4;
+                kptr = ktmp;
+
+                __m128 _sum0 = _mm_set1_ps(biasptr[0]);
+                __m128 _sum1 = _mm_set1_ps(biasptr[1]);
+                __m128 _sum2 = _mm_set1_ps(biasptr[2]);
+                __m128 _sum3 = _mm_set1_ps(biasptr[3]);
+                __m128 _sum4 = _mm_set1_ps(biasptr[4]);
+                __m128 _sum5 = _mm_set1_ps(biasptr[5]);
+                __m128 _sum6 = _mm_set1_ps(biasptr[6]);
+                __m128 _sum7 = _mm_set1_ps(biasptr[7]);
+
+                for (int q=0; q<K; q++)
+                {
+                    __m128 _val = _mm_loadu_ps(tmpptr_h);
+
+                    _sum0 = _mm_comp_fmadd_ps(_mm_set1_ps(kptr[0]), _val, _sum0);
+                    _sum1 = _mm_comp_fmadd_ps(_mm_set1_ps(kptr[1]), _val, _sum1);
+                    _sum2 = _mm_comp_fmadd_ps(_mm_set1_ps(kptr[2]), _val, _sum2);
+                    _sum3 = _mm_comp_fmadd_ps(_mm_set1_ps(kptr[3]), _val, _sum3);
+                    _sum4 = _mm_comp_fmadd_ps(_mm_set1_ps(kptr[4]), _val, _sum4);
+                    _sum5 = _mm_comp_fmadd_ps(_mm_set1_ps(kptr[5]), _val, _sum5);
+                    _sum6 = _mm_comp_fmadd_ps(_mm_set1_ps(kptr[6]), _val, _sum6);
+                    _sum7 = _mm_comp_fmadd_ps(_mm_set1_ps(kptr[7]), _val, _sum7);
+
+                    tmpptr_h += 8;
+                    kptr += 8;
+                }
+
+                _mm_storeu_ps(outptr[0] + i + half * 4, epilogue_ps<activation_type>(_sum0, act0, act1));
+                _mm_storeu_ps(outptr[1] + i + half * 4, epilogue_ps<activation_type>(_sum1, act0, act1));
+                _mm_storeu_ps(outptr[2] + i + half * 4, epilogue_ps<activation_type>(_sum2, act0, act1));
+                _mm_storeu_ps(outptr[3] + i + half * 4, epilogue_ps<activation_type>(_sum3, act0, act1));
+                _mm_storeu_ps(outptr[4] + i + half * 4, epilogue_ps<activation_type>(_sum4, act0, act1));
+                _mm_storeu_ps(outptr[5] + i + half * 4, epilogue_ps<activation_type>(_sum5, act0, act1));
+                _mm_storeu_ps(outptr[6] + i + half * 4, epilogue_ps<activation_type>(_sum6, act0, act1));
+                _mm_storeu_ps(outptr[7] + i + half * 4, epilogue_ps<activation_type>(_sum7, act0, act1));
+            }
+#else
+            float sum[8][8];
+            for (int j=0; j<8; j++)
+            {
+                for (int n=0; n<8; n++)
+                    sum[j][n] = biasptr[j];
+            }
+
+            for (int q=0; q<K; q++)
+            {
+                for (int j=0; j<8; j++)
+                {
+                    for (int n=0; n<8; n++)
+                        sum[j][n] += kptr[j] * tmpptr[n];
+                }
+
+                tmpptr += 8;
+                kptr += 8;
+            }
+
+            for (int j=0; j<8; j++)
+            {
+                for (int n=0; n<8; n++)
+                    outptr[j][i + n] = epilogue_ss<activation_type>(sum[j][n], act0, act1);
+            }
+#endif // __AVX__
+        }
+
+        for (; i<N; i++)
+        {
+            const float* tmpptr = bottom_tm.row(nn_size + i - remain_size_start);
+            const float* kptr = ktmp;
+
+            float sum[8];
+
+#if __AVX__
+            __m256 _sum = _mm256_loadu_ps(biasptr);
+
+            for (int q=0; q<K; q++)
+            {
+                _sum = _mm256_comp_fmadd_ps(_mm256_broadcast_ss(tmpptr), _mm256_loadu_ps(kptr), _sum);
+
+                tmpptr++;
+                kptr += 8;
+            }
+
+            _mm256_storeu_ps(sum, epilogue_avx<activation_type>(_sum, act0, act1));
+#elif __SSE2__
+            __m128 _sum0 = _mm_loadu_ps(biasptr);
+            __m128 _sum1 = _mm_loadu_ps(biasptr + 4);
+
+            for (int q=0; q<K; q++)
+            {
+                __m128 _val = _mm_set1_ps(tmpptr[0]);
+                _sum0 = _mm_comp_fmadd_ps(_val, _mm_loadu_ps(kptr), _sum0);
+                _sum1 = _mm_comp_fmadd_ps(_val, _mm_loadu_ps(kptr + 4), _sum1);
+
+                tmpptr++;
+                kptr += 8;
+            }
+
+            _mm_storeu_ps(sum, epilogue_ps<activation_type>(_sum0, act0, act1));
+            _mm_storeu_ps(sum + 4, epilogue_ps<activation_type>(_sum1, act0, act1));
+#else
+            for (int j=0; j<8; j++)
+                sum[j] = biasptr[j];
+
+            for (int q=0; q<K; q++)
+            {
+                for (int j=0; j<8; j++)
+                    sum[j] += kptr[j] * tmpptr[0];
+
+                tmpptr++;
+                kptr += 8;
+            }
+
+            for (int j=0; j<8; j++)
+                sum[j] = epilogue_ss<activation_type>(sum[j], act0, act1);
+#endif // __AVX__
+
+            for (int j=0; j<8; j++)
+            {
+                outptr[j][i] = sum[j];
+            }
+        }
+    }
+    else
+    {
+        const int p = remain_outch_start + pp - nn_outch;
+
+        float* outptr = top + p * ldc;
+
+        const float bias0 = bias ? bias[p] : 0.f;
+
+        const float* ktmp = kernel_tm.row(nn_outch + p - remain_outch_start);
+
+        int i = 0;
+        for (; i<remain_size_start; i+=8)
+        {
+            const float* tmpptr = bottom_tm.row(i / 8);
+            const float* kptr = ktmp;
+
+#if __AVX__
+            __m256 _sum = _mm256_set1_ps(bias0);
+
+            for (int q=0; q<K; q++)
+            {
+                _sum = _mm256_comp_fmadd_ps(_mm256_broadcast_ss(kptr), _mm256_loadu_ps(tmpptr), _sum);
+
+                tmpptr += 8;
+                kptr++;
+            }
+
+            _mm256_storeu_ps(outptr + i, epilogue_avx<activation_type>(_sum, act0, act1));
+#elif __SSE2__
+            __m128 _sum0 = _mm_set1_ps(bias0);
+            __m128 _sum1 = _mm_set1_ps(bias0);
+
+            for (int q=0; q<K; q++)
+            {
+                __m128 _k = _mm_set1_ps(kptr[0]);
+                _sum0 = _mm_comp_fmadd_ps(_k, _mm_loadu_ps(tmpptr), _sum0);
+                _sum1 = _mm_comp_fmadd_ps(_k, _mm_loadu_ps(tmpptr + 4), _sum1);
+
+                tmpptr += 8;
+                kptr++;
+            }
+
+            _mm_storeu_ps(outptr + i, epilogue_ps<activation_type>(_sum0, act0, act1));
+            _mm_storeu_ps(outptr + i + 4, epilogue_ps<activation_type>(_sum1, act0, act1));
+#else
+            float sum[8];
+            for (int n=0; n<8; n++)
+                sum[n] = bias0;
+
+            for (int q=0; q<K; q++)
+            {
+                for (int n=0; n<8; n++)
+                    sum[n] += kptr[0] * tmpptr[n];
+
+                tmpptr += 8;
+                kptr++;
+            }
+
+            for (int n=0; n<8; n++)
+                outptr[i + n] = epilogue_ss<activation_type>(sum[n], act0, act1);
+#endif // __AVX__
+        }
+
+        for (; i<N; i++)
+        {
+            const float* tmpptr = bottom_tm.row(nn_size + i - remain_size_start);
+            const float* kptr = ktmp;
+
+            int q = 0;
+            float sum = bias0;
+#if __AVX__
+            __m256 _sum = _mm256_setzero_ps();
+            for (; q+7<K; q+=8)
+            {
+                _sum = _mm256_comp_fmadd_ps(_mm256_loadu_ps(kptr), _mm256_loadu_ps(tmpptr), _sum);
+
+                tmpptr += 8;
+                kptr += 8;
+            }
+            sum += _mm256_reduce_add_ps(_sum);
+#elif __SSE2__
+            __m128 _sum = _mm_setzero_ps();
+            for (; q+3<K; q+=4)
+            {
+                _sum = _mm_comp_fmadd_ps(_mm_loadu_ps(kptr), _mm_loadu_ps(tmpptr), _sum);
+
+                tmpptr += 4;
+                kptr += 4;
+            }
+            sum += _mm_reduce_add_ps(_sum);
+#endif // __AVX__
+            for (; q<K; q++)
+            {
+                sum += kptr[0] * tmpptr[0];
+
+                tmpptr++;
+                kptr++;
+            }
+
+            outptr[i] = epilogue_ss<activation_type>(sum, act0, act1);
+        }
+    }
+}
+
+template<int activation_type>
+static void sgemm_x86_epilogue(int M, int N, int K, const Mat& kernel_tm, const Mat& bottom_tm, float* top, size_t ldc, const float* bias, float act0, float act1, const Option& opt)
+{
+    const int nn_outch = M >> 3;
+    const int remain_outch_start = nn_outch << 3;
+
+    SgemmX86Args args;
+    args.M = M;
+    args.N = N;
+    args.K = K;
+    args.kernel_tm = &kernel_tm;
+    args.bottom_tm = &bottom_tm;
+    args.top = top;
+    args.ldc = ldc;
+    args.bias = bias;
+    args.act0 = act0;
+    args.act1 = act1;
+
+    parallel_for(nn_outch + M - remain_outch_start, sgemm_x86_epilogue_rows<activation_type>, &args, opt);
+}
+
+// activation is applied in the store step, one instantiation per activation type
+static void sgemm_x86(int M, int N, int K, const Mat& kernel_tm, const Mat& bottom_tm, float* top, size_t ldc, const float* bias, int activation_type, const Mat& activation_params, const Option& opt)
+{
+    float act0;
+    float act1;
+    activation_scalars(activation_type, activation_params, act0, act1);
+
+    ACTIVATION_EPILOGUE_DISPATCH(activation_type, sgemm_x86_epilogue, (M, N, K, kernel_tm, bottom_tm, top, ldc, bias, act0, act1, opt))
+}
+
+static int conv_im2col_sgemm_x86(const Mat& bottom_blob, Mat& top_blob, const Mat& kernel_tm, const Mat& _bias, int kernel_w, int kernel_h, int dilation_w, int dilation_h, int stride_w, int stride_h, int activation_type, const Mat& activation_params, const Option& opt)
+{
+    const int inch = bottom_blob.c;
+
+    const int outw = top_blob.w;
+    const int outh = top_blob.h;
+    const int outch = top_blob.c;
+
+    const float* bias = _bias.empty() ? 0 : (const float*)_bias;
+
+    Mat bottom_tm;
+    conv_im2col_pack_x86(bottom_blob, bottom_tm, outw, outh, kernel_w, kernel_h, dilation_w, dilation_h, stride_w, stride_h, opt);
+    if (bottom_tm.empty())
+        return -100;
+
+    sgemm_x86(outch, outw * outh, inch * kernel_w * kernel_h, kernel_tm, bottom_tm, top_blob, top_blob.cstep, bias, activation_type, activation_params, opt);
+
+    return 0;
+}
@@ -0,0 +1,174 @@
+// Tencent is pleased to support the open source community by making ncnn available.
+//
+// Copyright (C) 2020 THL A29 Limited, a Tencent company. All rights reserved.
+//
+// Licensed under the BSD 3-Clause License (the "License"); you may not use this file except
+// in compliance with the License. You may obtain a copy of the License at
+//
+// https://opensource.org/licenses/BSD-3-Clause
+//
+// Unless required by applicable law or agreed to in writing, software distributed
+// under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+// CONDITIONS OF ANY KIND, either express or implied. See the License for the
+// specific language governing permissions and limitations under the License.
+
+#include "convolution_x86.h"
+
+#include <stdio.h>
+
+#if __SSE2__
+#include <emmintrin.h>
+#if __AVX__
+#include <immintrin.h>
+#endif // __AVX__
+#endif // __SSE2__
+
+#include "x86_usability.h"
+#include "x86_activation.h"
+#include "pipelinecache.h"
+#include "threadpool.h"
+
+#include "convolution_sgemm.h"
+#include "convolution_3x3.h"
+
+void *Convolution_x86_ctor(void *_self, va_list *args)
+{
+    Convolution_x86 *self = (Convolution_x86 *)_self;
+
+    self->use_winograd3x3 = false;
+    self->use_sgemm = false;
+
+    Layer_add_weight_mat(self, &self->weight_3x3_winograd64_data);
+    Layer_add_weight_mat(self, &self->weight_sgemm_data);
+
+    return _self;
+}
+
+int Convolution_x86_create_pipeline(void *_self, const Option& opt)
+{
+    Convolution_x86 *self = (Convolution_x86 *)_self;
+    Convolution *parent = (Convolution *)_self;
+
+    self->use_winograd3x3 = false;
+    self->use_sgemm = false;
+
+    if (opt.use_int8_inference && parent->weight_data.elemsize == (size_t)1u)
+    {
+        // int8 goes the reference path
+        return 0;
+    }
+
+    const int maxk = parent->kernel_w * parent->kernel_h;
+    const int num_input = parent->weight_data_size / maxk / parent->num_output;
+
+    if (opt.use_winograd_convolution && parent->kernel_w == 3 && parent->kernel_h == 3 && parent->dilation_w == 1 && parent->dilation_h == 1 && parent->stride_w == 1 && parent->stride_h == 1)
+    {
+        // winograd is slow on small channel count
+        if (num_input >= 16 && parent->num_output >= 16)
+            self->use_winograd3x3 = true;
+
+        if (self->use_winograd3x3)
+        {
+            const int params[2] = { num_input, parent->num_output };
+            PipelineCacheKey key;
+            if (!pipeline_cache_lookup(opt, "Convolution_x86_winograd64", params, 2, parent->weight_data, key, self->weight_3x3_winograd64_data))
+            {
+                conv3x3s1_winograd64_transform_kernel_x86(parent->weight_data, self->weight_3x3_winograd64_data, num_input, parent->num_output);
+                pipeline_cache_store(opt, key, self->weight_3x3_winograd64_data);
+            }
+        }
+    }
+
+    if (opt.use_sgemm_convolution && !self->use_winograd3x3)
+    {
+        self->use_sgemm = true;
+
+        const int params[3] = { num_input, parent->num_output, maxk };
+        PipelineCacheKey key;
+        if (!pipeline_cache_lookup(opt, "Convolution_x86_sgemm", params, 3, parent->weight_data, key, self->weight_sgemm_data))
+        {
+            conv_im2col_sgemm_transform_kernel_x86(parent->weight_data, self->weight_sgemm_data, num_input, parent->num_output, maxk);
+            pipeline_cache_store(opt, key, self->weight_sgemm_data);
+        }
+    }
+
+    Layer* layer = (Layer*)_self;
+    if (self->use_winograd3x3 || self->use_sgemm)
+    {
+        layer->kernel_name = self->use_winograd3x3 ? "winograd64_x86" : "im2col_sgemm_x86";
+
+        if (opt.lightweight)
+            parent->weight_data.release();
+    }
+    else
+    {
+        // Convolution_forward runs, give it the generic winograd layout the plain layer would have,
+        // the sgemm one is never needed as use_sgemm_convolution is off to get here
+        int ret = Convolution_create_pipeline_winograd(parent, opt);
+        if (ret != 0)
+            return ret;
+
+        if (parent->winograd_tile_size != 0)
+            layer->kernel_name = parent->winograd_tile_size == 6 ? "winograd63" : "winograd43";
+    }
+
+    return 0;
+}
+
+int Convolution_x86_destroy_pipeline(void *_self, const Option& opt)
+{
+    Convolution_x86 *self = (Convolution_x86 *)_self;
+
+    self->weight_3x3_winograd64_data.release();
+    self->weight_sgemm_data.release();
+
+    return 0;
+}
+
+int Convolution_x86_forward(void *_self, const Mat& bottom_blob, Mat& top_blob, const Option& opt)
+{
+    Convolution_x86 *self = (Convolution_x86 *)_self;
+    Convolution *parent = (Convolution *)_self;
+
+    if (bottom_blob.dims != 3 || (!self->use_winograd3x3 && !self->use_sgemm))
+    {
+        // lightweight mode released the flat weights the generic kernels read,
+        // only a flattened 1x1 convolution finds its way back here as a 1x1 feature map
+        if (parent->weight_data.empty() && !(bottom_blob.dims == 1 && parent->kernel_w == 1 && parent->kernel_h == 1))
+        {
+            fprintf(stderr, "Convolution weight data released in lightweight mode, input dims %d is not supported\n", bottom_blob.dims);
+            return -1;
+        }
+
+        return Convolution_forward(self, bottom_blob, top_blob, opt);
+    }
+
+    int w = bottom_blob.w;
+    int h = bottom_blob.h;
+    size_t elemsize = bottom_blob.elemsize;
+
+    const int kernel_extent_w = parent->dilation_w * (parent->kernel_w - 1) + 1;
+    const int kernel_extent_h = parent->dilation_h * (parent->kernel_h - 1) + 1;
+
+    Mat bottom_blob_bordered;
+    Convolution_make_padding(self, bottom_blob, bottom_blob_bordered, opt);
+    if (bottom_blob_bordered.empty())
+        return -100;
+
+    w = bottom_blob_bordered.w;
+    h = bottom_blob_bordered.h;
+
+    int outw = (w - kernel_extent_w) / parent->stride_w + 1;
+    int outh = (h - kernel_extent_h) / parent->stride_h + 1;
+
+    top_blob.create(outw, outh, parent->num_output, elemsize, opt.blob_allocator);
+    if (top_blob.empty())
+        return -100;
+
+    if (self->use_winograd3x3)
+    {
+        return conv3x3s1_winograd64_x86(bottom_blob_bordered, top_blob, self->weight_3x3_winograd64_data, parent->bias_data, parent->activation_type, parent->activation_params, opt);
+    }
+
+    return conv_im2col_sgemm_x86(bottom_blob_bordered, top_blob, self->weight_sgemm_data, parent->bias_data, parent->kernel_w, parent->kernel_h, parent->dilation_w, parent->dilation_h, parent->stride_w, parent->stride_h, parent->activation_type, parent->activation_params, opt);
+}
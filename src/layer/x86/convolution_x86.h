@@ -0,0 +1,48 @@
+// Tencent is pleased to support the open source community by making ncnn available.
+//
+// Copyright (C) 2020 THL A29 Limited, a Tencent company. All rights reserved.
+//
+// Licensed under the BSD 3-Clause License (the "License"); you may not use this file except
+// in compliance with the License. You may obtain a copy of the License at
+//
+// https://opensource.org/licenses/BSD-3-Clause
+//
+// Unless required by applicable law or agreed to in writing, software distributed
+// under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+// CONDITIONS OF ANY KIND, either express or implied. See the License for the
+// specific language governing permissions and limitations under the License.
+
+#ifndef LAYER_CONVOLUTION_X86_H
+#define LAYER_CONVOLUTION_X86_H
+
+#include "convolution.h"
+
+struct Convolution_x86
+{
+    // layer base
+    Convolution layer;
+
+    // proprietary data
+    bool use_winograd3x3;
+    bool use_sgemm;
+    Mat weight_3x3_winograd64_data;
+    Mat weight_sgemm_data;
+};
+
+void *Convolution_x86_ctor(void *_self, va_list *args);
+
+int Convolution_x86_create_pipeline(void *_self, const Option& opt);
+
+int Convolution_x86_destroy_pipeline(void *_self, const Option& opt);
+
+int Convolution_x86_forward(void *_self, const Mat& bottom_blob, Mat& top_blob, const Option& opt);
+
+// default operators
+#define Convolution_x86_dtor                     Layer_dtor
+#define Convolution_x86_load_param               Layer_load_param
+#define Convolution_x86_load_model               Layer_load_model
+#define Convolution_x86_forward_multi            Layer_forward_multi
+#define Convolution_x86_forward_inplace_multi    Layer_forward_inplace_multi
+#define Convolution_x86_forward_inplace          Layer_forward_inplace
+
+#endif // LAYER_CONVOLUTION_X86_H
@@ -0,0 +1,264 @@
+// Tencent is pleased to support the open source community by making ncnn available.
+//
+// Copyright (C) 2020 THL A29 Limited, a Tencent company. All rights reserved.
+//
+// Licensed under the BSD 3-Clause License (the "License"); you may not use this file except
+// in compliance with the License. You may obtain a copy of the License at
+//
+// https://opensource.org/licenses/BSD-3-Clause
+//
+// Unless required by applicable law or agreed to in writing, software distributed
+// under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+// CONDITIONS OF ANY KIND, either express or implied. See the License for the
+// specific language governing permissions and limitations under the License.
+
+#include "convolutiondepthwise_x86.h"
+
+#if __SSE2__
+#include <emmintrin.h>
+#if __AVX__
+#include <immintrin.h>
+#endif // __AVX__
+#endif // __SSE2__
+
+#include "x86_usability.h"
+#include "x86_activation.h"
+#include "threadpool.h"
+
+void *ConvolutionDepthWise_x86_ctor(void *_self, va_list *args)
+{
+    Layer *layer = (Layer *)_self;
+    layer->forward_batch = ConvolutionDepthWise_x86_forward_batch;
+
+    return _self;
+}
+
+// out[j] += k * in[j * stride], for stride 1 and 2 the row is vectorized
+// the last tap of a row passes its activation type so the result is stored activated
+template<int activation_type>
+static void convdw_row_madd_x86(float* outptr, const float* sptr, float k, int outw, int stride, float act0, float act1)
+{
+    int j = 0;
+
+#if __SSE2__
+    if (stride == 1)
+    {
+#if __AVX__
+#if __AVX512F__
+        __m512 _k16 = _mm512_set1_ps(k);
+        for (; activation_type == 0 && j+15<outw; j+=16)
+        {
+            __m512 _out = _mm512_loadu_ps(outptr + j);
+            _out = _mm512_fmadd_ps(_mm512_loadu_ps(sptr + j), _k16, _out);
+            _mm512_storeu_ps(outptr + j, _out);
+        }
+#endif // __AVX512F__
+        __m256 _k8 = _mm256_set1_ps(k);
+        for (; j+7<outw; j+=8)
+        {
+            __m256 _out = _mm256_loadu_ps(outptr + j);
+            _out = _mm256_comp_fmadd_ps(_mm256_loadu_ps(sptr + j), _k8, _out);
+            _mm256_storeu_ps(outptr + j, epilogue_avx<activation_type>(_out, act0, act1));
+        }
+#endif // __AVX__
+        __m128 _k = _mm_set1_ps(k);
+        for (; j+3<outw; j+=4)
+        {
+            __m128 _out = _mm_loadu_ps(outptr + j);
+            _out = _mm_comp_fmadd_ps(_mm_loadu_ps(sptr + j), _k, _out);
+            _mm_storeu_ps(outptr + j, epilogue_ps<activation_type>(_out, act0, act1));
+        }
+    }
+    else if (stride == 2)
+    {
+        __m128 _k = _mm_set1_ps(k);
+        // keep the last even/odd pair inside the row
+        for (; j+4<outw; j+=4)
+        {
+            __m128 _r0 = _mm_loadu_ps(sptr + j * 2);
+            __m128 _r1 = _mm_loadu_ps(sptr + j * 2 + 4);
+            __m128 _val = _mm_shuffle_ps(_r0, _r1, _MM_SHUFFLE(2, 0, 2, 0));
+
+            __m128 _out = _mm_loadu_ps(outptr + j);
+            _out = _mm_comp_fmadd_ps(_val, _k, _out);
+            _mm_storeu_ps(outptr + j, epilogue_ps<activation_type>(_out, act0, act1));
+        }
+    }
+#endif // __SSE2__
+
+    for (; j<outw; j++)
+    {
+        outptr[j] = epilogue_ss<activation_type>(outptr[j] + sptr[j * stride] * k, act0, act1);
+    }
+}
+
+struct ConvdwX86Args
+{
+    const ConvolutionDepthWise* self;
+    const Mat* bottom_blobs_bordered;
+    Mat* top_blobs;
+    int batch;
+    float act0;
+    float act1;
+};
+
+// per channel row accumulation, bias first and activation with the last tap
+template<int activation_type>
+static void convdw_x86_epilogue_sample(const ConvolutionDepthWise* self, const Mat& bottom_blob_bordered, Mat& top_blob, int g, float act0, float act1)
+{
+    const int outw = top_blob.w;
+    const int outh = top_blob.h;
+    const int maxk = self->kernel_w * self->kernel_h;
+
+    float* outptr = top_blob.channel(g);
+    const float* kptr = (const float*)self->weight_data + maxk * g;
+    const Mat m = bottom_blob_bordered.channel(g);
+
+    const float bias0 = self->bias_term ? self->bias_data[g] : 0.f;
+
+    for (int i = 0; i < outh; i++)
+    {
+        for (int j = 0; j < outw; j++)
+        {
+            outptr[j] = bias0;
+        }
+
+        for (int u = 0; u < self->kernel_h; u++)
+        {
+            const float* sptr = m.row(i * self->stride_h + u * self->dilation_h);
+
+            for (int v = 0; v < self->kernel_w; v++)
+            {
+                const float k = kptr[u * self->kernel_w + v];
+
+                if (u == self->kernel_h - 1 && v == self->kernel_w - 1)
+                    convdw_row_madd_x86<activation_type>(outptr, sptr + v * self->dilation_w, k, outw, self->stride_w, act0, act1);
+                else
+                    convdw_row_madd_x86<0>(outptr, sptr + v * self->dilation_w, k, outw, self->stride_w, act0, act1);
+            }
+        }
+
+        outptr += outw;
+    }
+}
+
+// a channel walks every sample with its kernel and bias
+template<int activation_type>
+static void convdw_x86_epilogue_channel(int g, void* _args)
+{
+    const ConvdwX86Args* args = (const ConvdwX86Args*)_args;
+
+    for (int b=0; b<args->batch; b++)
+    {
+        convdw_x86_epilogue_sample<activation_type>(args->self, args->bottom_blobs_bordered[b], args->top_blobs[b], g, args->act0, args->act1);
+    }
+}
+
+template<int activation_type>
+static void convdw_x86_epilogue(const ConvolutionDepthWise* self, const Mat* bottom_blobs_bordered, Mat* top_blobs, int batch, float act0, float act1, const Option& opt)
+{
+    ConvdwX86Args args;
+    args.self = self;
+    args.bottom_blobs_bordered = bottom_blobs_bordered;
+    args.top_blobs = top_blobs;
+    args.batch = batch;
+    args.act0 = act0;
+    args.act1 = act1;
+
+    parallel_for(self->group, convdw_x86_epilogue_channel<activation_type>, &args, opt);
+}
+
+int ConvolutionDepthWise_x86_forward(void *_self, const Mat& bottom_blob, Mat& top_blob, const Option& opt)
+{
+    ConvolutionDepthWise *self = (ConvolutionDepthWise *)_self;
+
+    int w = bottom_blob.w;
+    int h = bottom_blob.h;
+    int channels = bottom_blob.c;
+    size_t elemsize = bottom_blob.elemsize;
+
+    // only the pure depth-wise fp32 case is vectorized here
+    if (bottom_blob.dims != 3 || (opt.use_int8_inference && self->weight_data.elemsize == (size_t)1u)
+        || channels != self->group || self->group != self->num_output)
+    {
+        return ConvolutionDepthWise_forward(self, bottom_blob, top_blob, opt);
+    }
+
+    const int kernel_extent_w = self->dilation_w * (self->kernel_w - 1) + 1;
+    const int kernel_extent_h = self->dilation_h * (self->kernel_h - 1) + 1;
+
+    Mat bottom_blob_bordered;
+    ConvolutionDepthWise_make_padding(self, bottom_blob, bottom_blob_bordered, opt);
+    if (bottom_blob_bordered.empty())
+        return -100;
+
+    w = bottom_blob_bordered.w;
+    h = bottom_blob_bordered.h;
+
+    int outw = (w - kernel_extent_w) / self->stride_w + 1;
+    int outh = (h - kernel_extent_h) / self->stride_h + 1;
+
+    top_blob.create(outw, outh, self->num_output, elemsize, opt.blob_allocator);
+    if (top_blob.empty())
+        return -100;
+
+    float act0;
+    float act1;
+    activation_scalars(self->activation_type, self->activation_params, act0, act1);
+
+    ACTIVATION_EPILOGUE_DISPATCH(self->activation_type, convdw_x86_epilogue, (self, &bottom_blob_bordered, &top_blob, 1, act0, act1, opt))
+
+    return 0;
+}
+
+int ConvolutionDepthWise_x86_forward_batch(void *_self, const std::vector<Mat>& bottom_blobs, std::vector<Mat>& top_blobs, const Option& opt)
+{
+    ConvolutionDepthWise *self = (ConvolutionDepthWise *)_self;
+
+    const int batch = (int)bottom_blobs.size();
+
+    bool batchable = !(opt.use_int8_inference && self->weight_data.elemsize == (size_t)1u)
+                     && self->group == self->num_output;
+
+    const Mat& bottom_blob0 = bottom_blobs[0];
+    for (int b=0; b<batch; b++)
+    {
+        const Mat& m = bottom_blobs[b];
+        if (m.dims != 3 || m.w != bottom_blob0.w || m.h != bottom_blob0.h || m.c != self->group || m.c != bottom_blob0.c || m.elemsize != 4u)
+            batchable = false;
+    }
+
+    if (!batchable)
+    {
+        return ConvolutionDepthWise_forward_batch(self, bottom_blobs, top_blobs, opt);
+    }
+
+    const int kernel_extent_w = self->dilation_w * (self->kernel_w - 1) + 1;
+    const int kernel_extent_h = self->dilation_h * (self->kernel_h - 1) + 1;
+
+    std::vector<Mat> bottom_blobs_bordered(batch);
+    for (int b=0; b<batch; b++)
+    {
+        ConvolutionDepthWise_make_padding(self, bottom_blobs[b], bottom_blobs_bordered[b], opt);
+        if (bottom_blobs_bordered[b].empty())
+            return -100;
+    }
+
+    int outw = (bottom_blobs_bordered[0].w - kernel_extent_w) / self->stride_w + 1;
+    int outh = (bottom_blobs_bordered[0].h - kernel_extent_h) / self->stride_h + 1;
+
+    for (int b=0; b<batch; b++)
+    {
+        top_blobs[b].create(outw, outh, self->num_output, 4u, opt.blob_allocator);
+        if (top_blobs[b].empty())
+            return -100;
+    }
+
+    float act0;
+    float act1;
+    activation_scalars(self->activation_type, self->activation_params, act0, act1);
+
+    ACTIVATION_EPILOGUE_DISPATCH(self->activation_type, convdw_x86_epilogue, (self, &bottom_blobs_bordered[0], &top_blobs[0], batch, act0, act1, opt))
+
+    return 0;
+}
@@ -0,0 +1,204 @@
+// Tencent is pleased to support the open source community by making ncnn available.
+//
+// Copyright (C) 2020 THL A29 Limited, a Tencent company. All rights reserved.
+//
+// Licensed under the BSD 3-Clause License (the "License"); you may not use this file except
+// in compliance with the License. You may obtain a copy of the License at
+//
+// https://opensource.org/licenses/BSD-3-Clause
+//
+// Unless required by applicable law or agreed to in writing, software distributed
+// under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+// CONDITIONS OF ANY KIND, either express or implied. See the License for the
+// specific language governing permissions and limitations under the License.
+
+#include "eltwise_x86.h"
+
+#if __SSE2__
+#include <emmintrin.h>
+#if __AVX__
+#include <immintrin.h>
+#endif // __AVX__
+#endif // __SSE2__
+
+#include "x86_usability.h"
+
+#include "cstl/utils.h"
+
+void *Eltwise_x86_ctor(void *_self, va_list *args)
+{
+    return _self;
+}
+
+// outptr may alias ptr when accumulating into the top blob
+static void eltwise_row_x86(int op_type, float* outptr, const float* ptr, const float* ptr1, float coeff0, float coeff1, int size)
+{
+    int i = 0;
+
+    if (op_type == Operation_PROD)
+    {
+#if __SSE2__
+#if __AVX__
+#if __AVX512F__
+        for (; i+15<size; i+=16)
+        {
+            _mm512_storeu_ps(outptr + i, _mm512_mul_ps(_mm512_loadu_ps(ptr + i), _mm512_loadu_ps(ptr1 + i)));
+        }
+#endif // __AVX512F__
+        for (; i+7<size; i+=8)
+        {
+            _mm256_storeu_ps(outptr + i, _mm256_mul_ps(_mm256_loadu_ps(ptr + i), _mm256_loadu_ps(ptr1 + i)));
+        }
+#endif // __AVX__
+        for (; i+3<size; i+=4)
+        {
+            _mm_storeu_ps(outptr + i, _mm_mul_ps(_mm_loadu_ps(ptr + i), _mm_loadu_ps(ptr1 + i)));
+        }
+#endif // __SSE2__
+        for (; i<size; i++)
+        {
+            outptr[i] = ptr[i] * ptr1[i];
+        }
+    }
+    else if (op_type == Operation_SUM)
+    {
+        if (coeff0 == 1.f && coeff1 == 1.f)
+        {
+#if __SSE2__
+#if __AVX__
+#if __AVX512F__
+            for (; i+15<size; i+=16)
+            {
+                _mm512_storeu_ps(outptr + i, _mm512_add_ps(_mm512_loadu_ps(ptr + i), _mm512_loadu_ps(ptr1 + i)));
+            }
+#endif // __AVX512F__
+            for (; i+7<size; i+=8)
+            {
+                _mm256_storeu_ps(outptr + i, _mm256_add_ps(_mm256_loadu_ps(ptr + i), _mm256_loadu_ps(ptr1 + i)));
+            }
+#endif // __AVX__
+            for (; i+3<size; i+=4)
+            {
+                _mm_storeu_ps(outptr + i, _mm_add_ps(_mm_loadu_ps(ptr + i), _mm_loadu_ps(ptr1 + i)));
+            }
+#endif // __SSE2__
+            for (; i<size; i++)
+            {
+                outptr[i] = ptr[i] + ptr1[i];
+            }
+        }
+        else
+        {
+#if __SSE2__
+#if __AVX__
+#if __AVX512F__
+            __m512 _coeff0_16 = _mm512_set1_ps(coeff0);
+            __m512 _coeff1_16 = _mm512_set1_ps(coeff1);
+            for (; i+15<size; i+=16)
+            {
+                __m512 _p = _mm512_mul_ps(_mm512_loadu_ps(ptr + i), _coeff0_16);
+                _p = _mm512_fmadd_ps(_mm512_loadu_ps(ptr1 + i), _coeff1_16, _p);
+                _mm512_storeu_ps(outptr + i, _p);
+            }
+#endif // __AVX512F__
+            __m256 _coeff0_8 = _mm256_set1_ps(coeff0);
+            __m256 _coeff1_8 = _mm256_set1_ps(coeff1);
+            for (; i+7<size; i+=8)
+            {
+                __m256 _p = _mm256_mul_ps(_mm256_loadu_ps(ptr + i), _coeff0_8);
+                _p = _mm256_comp_fmadd_ps(_mm256_loadu_ps(ptr1 + i), _coeff1_8, _p);
+                _mm256_storeu_ps(outptr + i, _p);
+            }
+#endif // __AVX__
+            __m128 _coeff0 = _mm_set1_ps(coeff0);
+            __m128 _coeff1 = _mm_set1_ps(coeff1);
+            for (; i+3<size; i+=4)
+            {
+                __m128 _p = _mm_mul_ps(_mm_loadu_ps(ptr + i), _coeff0);
+                _p = _mm_comp_fmadd_ps(_mm_loadu_ps(ptr1 + i), _coeff1, _p);
+                _mm_storeu_ps(outptr + i, _p);
+            }
+#endif // __SSE2__
+            for (; i<size; i++)
+            {
+                outptr[i] = ptr[i] * coeff0 + ptr1[i] * coeff1;
+            }
+        }
+    }
+    else if (op_type == Operation_MAX)
+    {
+#if __SSE2__
+#if __AVX__
+#if __AVX512F__
+        for (; i+15<size; i+=16)
+        {
+            _mm512_storeu_ps(outptr + i, _mm512_max_ps(_mm512_loadu_ps(ptr + i), _mm512_loadu_ps(ptr1 + i)));
+        }
+#endif // __AVX512F__
+        for (; i+7<size; i+=8)
+        {
+            _mm256_storeu_ps(outptr + i, _mm256_max_ps(_mm256_loadu_ps(ptr + i), _mm256_loadu_ps(ptr1 + i)));
+        }
+#endif // __AVX__
+        for (; i+3<size; i+=4)
+        {
+            _mm_storeu_ps(outptr + i, _mm_max_ps(_mm_loadu_ps(ptr + i), _mm_loadu_ps(ptr1 + i)));
+        }
+#endif // __SSE2__
+        for (; i<size; i++)
+        {
+            outptr[i] = max(ptr[i], ptr1[i]);
+        }
+    }
+}
+
+int Eltwise_x86_forward_multi(void *_self, const std::vector<Mat>& bottom_blobs, std::vector<Mat>& top_blobs, const Option& opt)
+{
+    Eltwise *self = (Eltwise *)_self;
+
+    const Mat& bottom_blob = bottom_blobs[0];
+    int w = bottom_blob.w;
+    int h = bottom_blob.h;
+    int channels = bottom_blob.c;
+    size_t elemsize = bottom_blob.elemsize;
+    int size = w * h;
+
+    Mat& top_blob = top_blobs[0];
+    top_blob.create(w, h, channels, elemsize, opt.blob_allocator);
+    if (top_blob.empty())
+        return -100;
+
+    const bool has_coeffs = self->op_type == Operation_SUM && self->coeffs.w != 0;
+
+    // first blob
+    {
+        const Mat& bottom_blob1 = bottom_blobs[1];
+        float coeff0 = has_coeffs ? self->coeffs[0] : 1.f;
+        float coeff1 = has_coeffs ? self->coeffs[1] : 1.f;
+        #pragma omp parallel for num_threads(opt.num_threads)
+        for (int q=0; q<channels; q++)
+        {
+            const float* ptr = bottom_blob.channel(q);
+            const float* ptr1 = bottom_blob1.channel(q);
+            float* outptr = top_blob.channel(q);
+
+            eltwise_row_x86(self->op_type, outptr, ptr, ptr1, coeff0, coeff1, size);
+        }
+    }
+
+    for (size_t b=2; b<bottom_blobs.size(); b++)
+    {
+        const Mat& bottom_blob1 = bottom_blobs[b];
+        float coeff = has_coeffs ? self->coeffs[b] : 1.f;
+        #pragma omp parallel for num_threads(opt.num_threads)
+        for (int q=0; q<channels; q++)
+        {
+            const float* ptr = bottom_blob1.channel(q);
+            float* outptr = top_blob.channel(q);
+
+            eltwise_row_x86(self->op_type, outptr, outptr, ptr, 1.f, coeff, size);
+        }
+    }
+
+    return 0;
+}
@@ -0,0 +1,35 @@
+// Tencent is pleased to support the open source community by making ncnn available.
+//
+// Copyright (C) 2020 THL A29 Limited, a Tencent company. All rights reserved.
+//
+// Licensed under the BSD 3-Clause License (the "License"); you may not use this file except
+// in compliance with the License. You may obtain a copy of the License at
+//
+// https://opensource.org/licenses/BSD-3-Clause
+//
+// Unless required by applicable law or agreed to in writing, software distributed
+// under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+// CONDITIONS OF ANY KIND, either express or implied. See the License for the
+// specific language governing permissions and limitations under the License.
+
+#ifndef LAYER_ELTWISE_X86_H
+#define LAYER_ELTWISE_X86_H
+
+#include "eltwise.h"
+
+void *Eltwise_x86_ctor(void *_self, va_list *args);
+
+int Eltwise_x86_forward_multi(void *_self, const std::vector<Mat>& bottom_blobs, std::vector<Mat>& top_blobs, const Option& opt);
+
+// default operators
+#define Eltwise_x86                          Eltwise
+#define Eltwise_x86_dtor                     Layer_dtor
+#define Eltwise_x86_load_param               Layer_load_param
+#define Eltwise_x86_load_model               Layer_load_model
+#define Eltwise_x86_create_pipeline          Layer_create_pipeline
+#define Eltwise_x86_destroy_pipeline         Layer_destroy_pipeline
+#define Eltwise_x86_forward                  Layer_forward
+#define Eltwise_x86_forward_inplace_multi    Layer_forward_inplace_multi
+#define Eltwise_x86_forward_inplace          Layer_forward_inplace
+
+#endif // LAYER_ELTWISE_X86_H
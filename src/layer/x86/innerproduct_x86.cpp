@@ -0,0 +1,430 @@
+// Tencent is pleased to support the open source community by making ncnn available.
+//
+// Copyright (C) 2020 THL A29 Limited, a Tencent company. All rights reserved.
+//
+// Licensed under the BSD 3-Clause License (the "License"); you may not use this file except
+// in compliance with the License. You may obtain a copy of the License at
+//
+// https://opensource.org/licenses/BSD-3-Clause
+//
+// Unless required by applicable law or agreed to in writing, software distributed
+// under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+// CONDITIONS OF ANY KIND, either express or implied. See the License for the
+// specific language governing permissions and limitations under the License.
+
+#include "innerproduct_x86.h"
+
+#if __SSE2__
+#include <emmintrin.h>
+#if __AVX__
+#include <immintrin.h>
+#endif // __AVX__
+#endif // __SSE2__
+
+#include "x86_usability.h"
+#include "x86_activation.h"
+#include "threadpool.h"
+
+struct InnerProductX86Args
+{
+    const InnerProduct* self;
+    const float* sptr0;
+    float* outptr;
+    int num_input;
+};
+
+// four outputs, or one leftover output past the groups of four
+// four outputs share every input load
+static void innerproduct_x86_outputs(int pp, void* _args)
+{
+    const InnerProductX86Args* args = (const InnerProductX86Args*)_args;
+
+    const InnerProduct* self = args->self;
+    const float* sptr0 = args->sptr0;
+    const float* weight_data_ptr = self->weight_data;
+    const int num_input = args->num_input;
+
+    const int nn_num_output = self->num_output >> 2;
+    const int remain_num_output_start = nn_num_output << 2;
+
+    if (pp < nn_num_output)
+    {
+        const int p = pp * 4;
+
+        const float* w0 = weight_data_ptr + num_input * p;
+        const float* w1 = weight_data_ptr + num_input * (p + 1);
+        const float* w2 = weight_data_ptr + num_input * (p + 2);
+        const float* w3 = weight_data_ptr + num_input * (p + 3);
+        const float* m = sptr0;
+
+        float sum0 = 0.f;
+        float sum1 = 0.f;
+        float sum2 = 0.f;
+        float sum3 = 0.f;
+
+        int i = 0;
+#if __SSE2__
+#if __AVX__
+#if __AVX512F__
+        __m512 _sum0x = _mm512_setzero_ps();
+        __m512 _sum1x = _mm512_setzero_ps();
+        __m512 _sum2x = _mm512_setzero_ps();
+        __m512 _sum3x = _mm512_setzero_ps();
+        for (; i+15<num_input; i+=16)
+        {
+            __m512 _m = _mm512_loadu_ps(m + i);
+            _sum0x = _mm512_fmadd_ps(_m, _mm512_loadu_ps(w0 + i), _sum0x);
+            _sum1x = _mm512_fmadd_ps(_m, _mm512_loadu_ps(w1 + i), _sum1x);
+            _sum2x = _mm512_fmadd_ps(_m, _mm512_loadu_ps(w2 + i), _sum2x);
+            _sum3x = _mm512_fmadd_ps(_m, _mm512_loadu_ps(w3 + i), _sum3x);
+        }
+        sum0 += _mm512_reduce_add_ps(_sum0x);
+        sum1 += _mm512_reduce_add_ps(_sum1x);
+        sum2 += _mm512_reduce_add_ps(_sum2x);
+        sum3 += _mm512_reduce_add_ps(_sum3x);
+#endif // __AVX512F__
+        __m256 _sum0 = _mm256_setzero_ps();
+        __m256 _sum1 = _mm256_setzero_ps();
+        __m256 _sum2 = _mm256_setzero_ps();
+        __m256 _sum3 = _mm256_setzero_ps();
+        for (; i+7<num_input; i+=8)
+        {
+            __m256 _m = _mm256_loadu_ps(m + i);
+            _sum0 = _mm256_comp_fmadd_ps(_m, _mm256_loadu_ps(w0 + i), _sum0);
+            _sum1 = _mm256_comp_fmadd_ps(_m, _mm256_loadu_ps(w1 + i), _sum1);
+            _sum2 = _mm256_comp_fmadd_ps(_m, _mm256_loadu_ps(w2 + i), _sum2);
+            _sum3 = _mm256_comp_fmadd_ps(_m, _mm256_loadu_ps(w3 + i), _sum3);
+        }
+        sum0 += _mm256_reduce_add_ps(_sum0);
+        sum1 += _mm256_reduce_add_ps(_sum1);
+        sum2 += _mm256_reduce_add_ps(_sum2);
+        sum3 += _mm256_reduce_add_ps(_sum3);
+#endif // __AVX__
+        __m128 _sum0q = _mm_setzero_ps();
+        __m128 _sum1q = _mm_setzero_ps();
+        __m128 _sum2q = _mm_setzero_ps();
+        __m128 _sum3q = _mm_setzero_ps();
+        for (; i+3<num_input; i+=4)
+        {
+            __m128 _m = _mm_loadu_ps(m + i);
+            _sum0q = _mm_comp_fmadd_ps(_m, _mm_loadu_ps(w0 + i), _sum0q);
+            _sum1q = _mm_comp_fmadd_ps(_m, _mm_loadu_ps(w1 + i), _sum1q);
+            _sum2q = _mm_comp_fmadd_ps(_m, _mm_loadu_ps(w2 + i), _sum2q);
+            _sum3q = _mm_comp_fmadd_ps(_m, _mm_loadu_ps(w3 + i), _sum3q);
+        }
+        sum0 += _mm_reduce_add_ps(_sum0q);
+        sum1 += _mm_reduce_add_ps(_sum1q);
+        sum2 += _mm_reduce_add_ps(_sum2q);
+        sum3 += _mm_reduce_add_ps(_sum3q);
+#endif // __SSE2__
+        for (; i<num_input; i++)
+        {
+            sum0 += m[i] * w0[i];
+            sum1 += m[i] * w1[i];
+            sum2 += m[i] * w2[i];
+            sum3 += m[i] * w3[i];
+        }
+
+        if (self->bias_term)
+        {
+            sum0 += self->bias_data[p];
+            sum1 += self->bias_data[p + 1];
+            sum2 += self->bias_data[p + 2];
+            sum3 += self->bias_data[p + 3];
+        }
+
+        float* outptr = args->outptr;
+        outptr[p] = activation_ss(sum0, self->activation_type, self->activation_params);
+        outptr[p + 1] = activation_ss(sum1, self->activation_type, self->activation_params);
+        outptr[p + 2] = activation_ss(sum2, self->activation_type, self->activation_params);
+        outptr[p + 3] = activation_ss(sum3, self->activation_type, self->activation_params);
+    }
+    else
+    {
+        const int p = remain_num_output_start + pp - nn_num_output;
+
+        const float* w0 = weight_data_ptr + num_input * p;
+        const float* m = sptr0;
+
+        float sum = 0.f;
+
+        int i = 0;
+#if __SSE2__
+#if __AVX__
+#if __AVX512F__
+        __m512 _sumx = _mm512_setzero_ps();
+        for (; i+15<num_input; i+=16)
+        {
+            _sumx = _mm512_fmadd_ps(_mm512_loadu_ps(m + i), _mm512_loadu_ps(w0 + i), _sumx);
+        }
+        sum += _mm512_reduce_add_ps(_sumx);
+#endif // __AVX512F__
+        __m256 _sum = _mm256_setzero_ps();
+        for (; i+7<num_input; i+=8)
+        {
+            _sum = _mm256_comp_fmadd_ps(_mm256_loadu_ps(m + i), _mm256_loadu_ps(w0 + i), _sum);
+        }
+        sum += _mm256_reduce_add_ps(_sum);
+#endif // __AVX__
+        __m128 _sumq = _mm_setzero_ps();
+        for (; i+3<num_input; i+=4)
+        {
+            _sumq = _mm_comp_fmadd_ps(_mm_loadu_ps(m + i), _mm_loadu_ps(w0 + i), _sumq);
+        }
+        sum += _mm_reduce_add_ps(_sumq);
+#endif // __SSE2__
+        for (; i<num_input; i++)
+        {
+            sum += m[i] * w0[i];
+        }
+
+        if (self->bias_term)
+            sum += self->bias_data[p];
+
+        float* outptr = args->outptr;
+        outptr[p] = activation_ss(sum, self->activation_type, self->activation_params);
+    }
+}
+
+struct InnerProductX86BatchArgs
+{
+    const InnerProduct* self;
+    const float* const* sptrs;
+    float* const* outptrs;
+    int batch;
+    int num_input;
+};
+
+// one output of every sample in the batch
+static void innerproduct_x86_batch_output(int p, void* _args)
+{
+    const InnerProductX86BatchArgs* args = (const InnerProductX86BatchArgs*)_args;
+
+    const InnerProduct* self = args->self;
+    const float* const* sptrs = args->sptrs;
+    float* const* outptrs = args->outptrs;
+    const float* weight_data_ptr = self->weight_data;
+    const int batch = args->batch;
+    const int num_input = args->num_input;
+
+    const int nn_batch = batch >> 2;
+    const int remain_batch_start = nn_batch << 2;
+
+    const float* w0 = weight_data_ptr + num_input * p;
+    const float bias = self->bias_term ? self->bias_data[p] : 0.f;
+
+    // four samples share every weight load
+    for (int bb=0; bb<nn_batch; bb++)
+    {
+        const int b = bb * 4;
+
+        const float* m0 = sptrs[b];
+        const float* m1 = sptrs[b + 1];
+        const float* m2 = sptrs[b + 2];
+        const float* m3 = sptrs[b + 3];
+
+        float sum0 = bias;
+        float sum1 = bias;
+        float sum2 = bias;
+        float sum3 = bias;
+
+        int i = 0;
+#if __SSE2__
+#if __AVX__
+        __m256 _sum0 = _mm256_setzero_ps();
+        __m256 _sum1 = _mm256_setzero_ps();
+        __m256 _sum2 = _mm256_setzero_ps();
+        __m256 _sum3 = _mm256_setzero_ps();
+        for (; i+7<num_input; i+=8)
+        {
+            __m256 _w = _mm256_loadu_ps(w0 + i);
+            _sum0 = _mm256_comp_fmadd_ps(_mm256_loadu_ps(m0 + i), _w, _sum0);
+            _sum1 = _mm256_comp_fmadd_ps(_mm256_loadu_ps(m1 + i), _w, _sum1);
+            _sum2 = _mm256_comp_fmadd_ps(_mm256_loadu_ps(m2 + i), _w, _sum2);
+            _sum3 = _mm256_comp_fmadd_ps(_mm256_loadu_ps(m3 + i), _w, _sum3);
+        }
+        sum0 += _mm256_reduce_add_ps(_sum0);
+        sum1 += _mm256_reduce_add_ps(_sum1);
+        sum2 += _mm256_reduce_add_ps(_sum2);
+        sum3 += _mm256_reduce_add_ps(_sum3);
+#endif // __AVX__
+        __m128 _sum0q = _mm_setzero_ps();
+        __m128 _sum1q = _mm_setzero_ps();
+        __m128 _sum2q = _mm_setzero_ps();
+        __m128 _sum3q = _mm_setzero_ps();
+        for (; i+3<num_input; i+=4)
+        {
+            __m128 _w = _mm_loadu_ps(w0 + i);
+            _sum0q = _mm_comp_fmadd_ps(_mm_loadu_ps(m0 + i), _w, _sum0q);
+            _sum1q = _mm_comp_fmadd_ps(_mm_loadu_ps(m1 + i), _w, _sum1q);
+            _sum2q = _mm_comp_fmadd_ps(_mm_loadu_ps(m2 + i), _w, _sum2q);
+            _sum3q = _mm_comp_fmadd_ps(_mm_loadu_ps(m3 + i), _w, _sum3q);
+        }
+        sum0 += _mm_reduce_add_ps(_sum0q);
+        sum1 += _mm_reduce_add_ps(_sum1q);
+        sum2 += _mm_reduce_add_ps(_sum2q);
+        sum3 += _mm_reduce_add_ps(_sum3q);
+#endif // __SSE2__
+        for (; i<num_input; i++)
+        {
+            sum0 += m0[i] * w0[i];
+            sum1 += m1[i] * w0[i];
+            sum2 += m2[i] * w0[i];
+            sum3 += m3[i] * w0[i];
+        }
+
+        outptrs[b][p] = activation_ss(sum0, self->activation_type, self->activation_params);
+        outptrs[b + 1][p] = activation_ss(sum1, self->activation_type, self->activation_params);
+        outptrs[b + 2][p] = activation_ss(sum2, self->activation_type, self->activation_params);
+        outptrs[b + 3][p] = activation_ss(sum3, self->activation_type, self->activation_params);
+    }
+
+    for (int b=remain_batch_start; b<batch; b++)
+    {
+        const float* m = sptrs[b];
+
+        float sum = bias;
+
+        int i = 0;
+#if __SSE2__
+#if __AVX__
+        __m256 _sum = _mm256_setzero_ps();
+        for (; i+7<num_input; i+=8)
+        {
+            _sum = _mm256_comp_fmadd_ps(_mm256_loadu_ps(m + i), _mm256_loadu_ps(w0 + i), _sum);
+        }
+        sum += _mm256_reduce_add_ps(_sum);
+#endif // __AVX__
+        __m128 _sumq = _mm_setzero_ps();
+        for (; i+3<num_input; i+=4)
+        {
+            _sumq = _mm_comp_fmadd_ps(_mm_loadu_ps(m + i), _mm_loadu_ps(w0 + i), _sumq);
+        }
+        sum += _mm_reduce_add_ps(_sumq);
+#endif // __SSE2__
+        for (; i<num_input; i++)
+        {
+            sum += m[i] * w0[i];
+        }
+
+        outptrs[b][p] = activation_ss(sum, self->activation_type, self->activation_params);
+    }
+}
+
+void *InnerProduct_x86_ctor(void *_self, va_list *args)
+{
+    Layer *layer = (Layer *)_self;
+    layer->forward_batch = InnerProduct_x86_forward_batch;
+
+    return _self;
+}
+
+int InnerProduct_x86_forward(void *_self, const Mat& bottom_blob, Mat& top_blob, const Option& opt)
+{
+    InnerProduct *self = (InnerProduct *)_self;
+
+    if (opt.use_int8_inference && self->weight_data.elemsize == (size_t)1u)
+    {
+        return InnerProduct_forward(self, bottom_blob, top_blob, opt);
+    }
+
+    size_t elemsize = bottom_blob.elemsize;
+    const int num_input = bottom_blob.w * bottom_blob.h * bottom_blob.c;
+
+    // weights are laid out flat, so walk the input flat too
+    Mat bottom_blob_flattened = bottom_blob;
+    if (bottom_blob.dims == 3 && bottom_blob.cstep != (size_t)bottom_blob.w * bottom_blob.h)
+    {
+        Option opt_flatten = opt;
+        opt_flatten.blob_allocator = opt.workspace_allocator;
+
+        bottom_blob_flattened = bottom_blob.reshape(num_input, opt_flatten.blob_allocator);
+        if (bottom_blob_flattened.empty())
+            return -100;
+    }
+
+    top_blob.create(self->num_output, elemsize, opt.blob_allocator);
+    if (top_blob.empty())
+        return -100;
+
+    const int nn_num_output = self->num_output >> 2;
+    const int remain_num_output_start = nn_num_output << 2;
+
+    InnerProductX86Args args;
+    args.self = self;
+    args.sptr0 = bottom_blob_flattened;
+    args.outptr = top_blob;
+    args.num_input = num_input;
+
+    parallel_for(nn_num_output + self->num_output - remain_num_output_start, innerproduct_x86_outputs, &args, opt);
+
+    return 0;
+}
+
+int InnerProduct_x86_forward_batch(void *_self, const std::vector<Mat>& bottom_blobs, std::vector<Mat>& top_blobs, const Option& opt)
+{
+    InnerProduct *self = (InnerProduct *)_self;
+
+    const int batch = (int)bottom_blobs.size();
+    const int num_input = self->weight_data_size / self->num_output;
+
+    bool batchable = !(opt.use_int8_inference && self->weight_data.elemsize == (size_t)1u);
+    for (int b=0; b<batch; b++)
+    {
+        const Mat& m = bottom_blobs[b];
+        if (m.w * m.h * m.c != num_input || m.elemsize != 4u)
+            batchable = false;
+    }
+
+    if (!batchable)
+    {
+        return InnerProduct_forward_batch(self, bottom_blobs, top_blobs, opt);
+    }
+
+    // inputs with gaps between the channels are packed into the rows of one workspace mat
+    Mat bottom_blobs_flattened;
+    std::vector<const float*> sptrs(batch);
+    std::vector<float*> outptrs(batch);
+    for (int b=0; b<batch; b++)
+    {
+        const Mat& bottom_blob = bottom_blobs[b];
+
+        sptrs[b] = bottom_blob;
+        if (bottom_blob.dims == 3 && bottom_blob.cstep != (size_t)bottom_blob.w * bottom_blob.h)
+        {
+            if (bottom_blobs_flattened.empty())
+            {
+                bottom_blobs_flattened.create(num_input, batch, 4u, opt.workspace_allocator);
+                if (bottom_blobs_flattened.empty())
+                    return -100;
+            }
+
+            const int size = bottom_blob.w * bottom_blob.h;
+            float* outptr = bottom_blobs_flattened.row(b);
+            for (int q=0; q<bottom_blob.c; q++)
+            {
+                memcpy(outptr + size * q, bottom_blob.channel(q), size * sizeof(float));
+            }
+
+            sptrs[b] = outptr;
+        }
+
+        top_blobs[b].create(self->num_output, 4u, opt.blob_allocator);
+        if (top_blobs[b].empty())
+            return -100;
+
+        outptrs[b] = top_blobs[b];
+    }
+
+    // the weight matrix is streamed once for the whole batch
+    InnerProductX86BatchArgs args;
+    args.self = self;
+    args.sptrs = &sptrs[0];
+    args.outptrs = &outptrs[0];
+    args.batch = batch;
+    args.num_input = num_input;
+
+    parallel_for(self->num_output, innerproduct_x86_batch_output, &args, opt);
+
+    return 0;
+}
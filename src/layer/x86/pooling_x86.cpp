@@ -0,0 +1,229 @@
+// Tencent is pleased to support the open source community by making ncnn available.
+//
+// Copyright (C) 2020 THL A29 Limited, a Tencent company. All rights reserved.
+//
+// Licensed under the BSD 3-Clause License (the "License"); you may not use this file except
+// in compliance with the License. You may obtain a copy of the License at
+//
+// https://opensource.org/licenses/BSD-3-Clause
+//
+// Unless required by applicable law or agreed to in writing, software distributed
+// under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+// CONDITIONS OF ANY KIND, either express or implied. See the License for the
+// specific language governing permissions and limitations under the License.
+
+#include "pooling_x86.h"
+#include <float.h>
+
+#if __SSE2__
+#include <emmintrin.h>
+#if __AVX__
+#include <immintrin.h>
+#endif // __AVX__
+#endif // __SSE2__
+
+#include "x86_usability.h"
+
+#include "cstl/utils.h"
+
+void *Pooling_x86_ctor(void *_self, va_list *args)
+{
+    return _self;
+}
+
+// out[j] = max(out[j], in[j * stride]), for stride 1 and 2 the row is vectorized
+static void pooling_row_max_x86(float* outptr, const float* sptr, int outw, int stride)
+{
+    int j = 0;
+
+#if __SSE2__
+    if (stride == 1)
+    {
+#if __AVX__
+#if __AVX512F__
+        for (; j+15<outw; j+=16)
+        {
+            __m512 _out = _mm512_max_ps(_mm512_loadu_ps(outptr + j), _mm512_loadu_ps(sptr + j));
+            _mm512_storeu_ps(outptr + j, _out);
+        }
+#endif // __AVX512F__
+        for (; j+7<outw; j+=8)
+        {
+            __m256 _out = _mm256_max_ps(_mm256_loadu_ps(outptr + j), _mm256_loadu_ps(sptr + j));
+            _mm256_storeu_ps(outptr + j, _out);
+        }
+#endif // __AVX__
+        for (; j+3<outw; j+=4)
+        {
+            __m128 _out = _mm_max_ps(_mm_loadu_ps(outptr + j), _mm_loadu_ps(sptr + j));
+            _mm_storeu_ps(outptr + j, _out);
+        }
+    }
+    else if (stride == 2)
+    {
+        // keep the last even/odd pair inside the row
+        for (; j+4<outw; j+=4)
+        {
+            __m128 _r0 = _mm_loadu_ps(sptr + j * 2);
+            __m128 _r1 = _mm_loadu_ps(sptr + j * 2 + 4);
+            __m128 _val = _mm_shuffle_ps(_r0, _r1, _MM_SHUFFLE(2, 0, 2, 0));
+
+            _mm_storeu_ps(outptr + j, _mm_max_ps(_mm_loadu_ps(outptr + j), _val));
+        }
+    }
+#endif // __SSE2__
+
+    for (; j<outw; j++)
+    {
+        outptr[j] = max(outptr[j], sptr[j * stride]);
+    }
+}
+
+int Pooling_x86_forward(void *_self, const Mat& bottom_blob, Mat& top_blob, const Option& opt)
+{
+    Pooling *self = (Pooling *)_self;
+
+    // max value in NxN window
+    // avg value in NxN window
+
+    int w = bottom_blob.w;
+    int h = bottom_blob.h;
+    int channels = bottom_blob.c;
+    size_t elemsize = bottom_blob.elemsize;
+
+    if (self->global_pooling)
+    {
+        top_blob.create(channels, elemsize, opt.blob_allocator);
+        if (top_blob.empty())
+            return -100;
+
+        int size = w * h;
+
+        if (self->pooling_type == PoolMethod_MAX)
+        {
+            #pragma omp parallel for num_threads(opt.num_threads)
+            for (int q=0; q<channels; q++)
+            {
+                const float* ptr = bottom_blob.channel(q);
+
+                float max = ptr[0];
+
+                int i = 0;
+#if __SSE2__
+#if __AVX__
+                if (size >= 8)
+                {
+                    __m256 _max = _mm256_loadu_ps(ptr);
+                    for (; i+7<size; i+=8)
+                    {
+                        _max = _mm256_max_ps(_max, _mm256_loadu_ps(ptr + i));
+                    }
+                    max = max(max, _mm256_reduce_max_ps(_max));
+                }
+#endif // __AVX__
+                if (i+3<size)
+                {
+                    __m128 _max = _mm_loadu_ps(ptr + i);
+                    for (; i+3<size; i+=4)
+                    {
+                        _max = _mm_max_ps(_max, _mm_loadu_ps(ptr + i));
+                    }
+                    max = max(max, _mm_reduce_max_ps(_max));
+                }
+#endif // __SSE2__
+                for (; i<size; i++)
+                {
+                    max = max(max, ptr[i]);
+                }
+
+                top_blob[q] = max;
+            }
+        }
+        else if (self->pooling_type == PoolMethod_AVE)
+        {
+            #pragma omp parallel for num_threads(opt.num_threads)
+            for (int q=0; q<channels; q++)
+            {
+                const float* ptr = bottom_blob.channel(q);
+
+                float sum = 0.f;
+
+                int i = 0;
+#if __SSE2__
+#if __AVX__
+                __m256 _sum = _mm256_setzero_ps();
+                for (; i+7<size; i+=8)
+                {
+                    _sum = _mm256_add_ps(_sum, _mm256_loadu_ps(ptr + i));
+                }
+                sum += _mm256_reduce_add_ps(_sum);
+#endif // __AVX__
+                __m128 _sumq = _mm_setzero_ps();
+                for (; i+3<size; i+=4)
+                {
+                    _sumq = _mm_add_ps(_sumq, _mm_loadu_ps(ptr + i));
+                }
+                sum += _mm_reduce_add_ps(_sumq);
+#endif // __SSE2__
+                for (; i<size; i++)
+                {
+                    sum += ptr[i];
+                }
+
+                top_blob[q] = sum / size;
+            }
+        }
+
+        return 0;
+    }
+
+    // windowed average pooling needs the area bookkeeping of the reference
+    if (self->pooling_type != PoolMethod_MAX || self->stride_w > 2)
+    {
+        return Pooling_forward(self, bottom_blob, top_blob, opt);
+    }
+
+    Mat bottom_blob_bordered;
+    Pooling_make_padding(self, bottom_blob, bottom_blob_bordered, opt);
+    if (bottom_blob_bordered.empty())
+        return -100;
+
+    w = bottom_blob_bordered.w;
+    h = bottom_blob_bordered.h;
+
+    int outw = (w - self->kernel_w) / self->stride_w + 1;
+    int outh = (h - self->kernel_h) / self->stride_h + 1;
+
+    top_blob.create(outw, outh, channels, elemsize, opt.blob_allocator);
+    if (top_blob.empty())
+        return -100;
+
+    #pragma omp parallel for num_threads(opt.num_threads)
+    for (int q=0; q<channels; q++)
+    {
+        const Mat m = bottom_blob_bordered.channel(q);
+        float* outptr = top_blob.channel(q);
+
+        for (int i = 0; i < outh; i++)
+        {
+            for (int j = 0; j < outw; j++)
+            {
+                outptr[j] = -FLT_MAX;
+            }
+
+            for (int u = 0; u < self->kernel_h; u++)
+            {
+                const float* sptr = m.row(i * self->stride_h + u);
+
+                for (int v = 0; v < self->kernel_w; v++)
+                {
+                    pooling_row_max_x86(outptr, sptr + v, outw, self->stride_w);
+                }
+            }
+
+            outptr += outw;
+        }
+    }
+
+    return 0;
+}
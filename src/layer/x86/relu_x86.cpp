@@ -0,0 +1,107 @@
+// Tencent is pleased to support the open source community by making ncnn available.
+//
+// Copyright (C) 2020 THL A29 Limited, a Tencent company. All rights reserved.
+//
+// Licensed under the BSD 3-Clause License (the "License"); you may not use this file except
+// in compliance with the License. You may obtain a copy of the License at
+//
+// https://opensource.org/licenses/BSD-3-Clause
+//
+// Unless required by applicable law or agreed to in writing, software distributed
+// under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+// CONDITIONS OF ANY KIND, either express or implied. See the License for the
+// specific language governing permissions and limitations under the License.
+
+#include "relu_x86.h"
+
+#if __SSE2__
+#include <emmintrin.h>
+#if __AVX__
+#include <immintrin.h>
+#endif // __AVX__
+#endif // __SSE2__
+
+void *ReLU_x86_ctor(void *_self, va_list *args)
+{
+    return _self;
+}
+
+int ReLU_x86_forward_inplace(void *_self, Mat& bottom_top_blob, const Option& opt)
+{
+    ReLU *self = (ReLU *)_self;
+
+    if (bottom_top_blob.elemsize == 1u)
+        return ReLU_forward_inplace(self, bottom_top_blob, opt);
+
+    int w = bottom_top_blob.w;
+    int h = bottom_top_blob.h;
+    int channels = bottom_top_blob.c;
+    int size = w * h;
+
+    const float slope = self->slope;
+
+    #pragma omp parallel for num_threads(opt.num_threads)
+    for (int q=0; q<channels; q++)
+    {
+        float* ptr = bottom_top_blob.channel(q);
+
+        int i = 0;
+#if __SSE2__
+#if __AVX__
+#if __AVX512F__
+        __m512 _zero16 = _mm512_setzero_ps();
+        __m512 _slope16 = _mm512_set1_ps(slope);
+        for (; i+15<size; i+=16)
+        {
+            __m512 _p = _mm512_loadu_ps(ptr + i);
+            __m512 _pos = _mm512_max_ps(_p, _zero16);
+            __m512 _neg = _mm512_min_ps(_p, _zero16);
+            _p = _mm512_fmadd_ps(_neg, _slope16, _pos);
+            _mm512_storeu_ps(ptr + i, _p);
+        }
+#endif // __AVX512F__
+        __m256 _zero8 = _mm256_setzero_ps();
+        __m256 _slope8 = _mm256_set1_ps(slope);
+        for (; i+7<size; i+=8)
+        {
+            __m256 _p = _mm256_loadu_ps(ptr + i);
+            if (slope == 0.f)
+            {
+                _p = _mm256_max_ps(_p, _zero8);
+            }
+            else
+            {
+                __m256 _pos = _mm256_max_ps(_p, _zero8);
+                __m256 _neg = _mm256_min_ps(_p, _zero8);
+                _p = _mm256_add_ps(_pos, _mm256_mul_ps(_neg, _slope8));
+            }
+            _mm256_storeu_ps(ptr + i, _p);
+        }
+#endif // __AVX__
+        __m128 _zero = _mm_setzero_ps();
+        __m128 _slope = _mm_set1_ps(slope);
+        for (; i+3<size; i+=4)
+        {
+            __m128 _p = _mm_loadu_ps(ptr + i);
+            if (slope == 0.f)
+            {
+                _p = _mm_max_ps(_p, _zero);
+            }
+            else
+            {
+                __m128 _pos = _mm_max_ps(_p, _zero);
+                __m128 _neg = _mm_min_ps(_p, _zero);
+                _p = _mm_add_ps(_pos, _mm_mul_ps(_neg, _slope));
+            }
+            _mm_storeu_ps(ptr + i, _p);
+        }
+#endif // __SSE2__
+        for (; i<size; i++)
+        {
+            if (ptr[i] < 0)
+                ptr[i] = slope == 0.f ? 0.f : ptr[i] * slope;
+        }
+    }
+
+    return 0;
+}
@@ -0,0 +1,72 @@
+// Tencent is pleased to support the open source community by making ncnn available.
+//
+// Copyright (C) 2020 THL A29 Limited, a Tencent company. All rights reserved.
+//
+// Licensed under the BSD 3-Clause License (the "License"); you may not use this file except
+// in compliance with the License. You may obtain a copy of the License at
+//
+// https://opensource.org/licenses/BSD-3-Clause
+//
+// Unless required by applicable law or agreed to in writing, software distributed
+// under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+// CONDITIONS OF ANY KIND, either express or implied. See the License for the
+// specific language governing permissions and limitations under the License.
+
+#include "sigmoid_x86.h"
+#include <math.h>
+
+#if __SSE2__
+#include <emmintrin.h>
+#include "sse_mathfun.h"
+#if __AVX__
+#include <immintrin.h>
+#include "avx_mathfun.h"
+#endif // __AVX__
+#endif // __SSE2__
+
+void *Sigmoid_x86_ctor(void *_self, va_list *args)
+{
+    return _self;
+}
+
+int Sigmoid_x86_forward_inplace(void *_self, Mat& bottom_top_blob, const Option& opt)
+{
+    int w = bottom_top_blob.w;
+    int h = bottom_top_blob.h;
+    int channels = bottom_top_blob.c;
+    int size = w * h;
+
+    #pragma omp parallel for num_threads(opt.num_threads)
+    for (int q=0; q<channels; q++)
+    {
+        float* ptr = bottom_top_blob.channel(q);
+
+        int i = 0;
+#if __SSE2__
+#if __AVX__
+        __m256 _one8 = _mm256_set1_ps(1.f);
+        for (; i+7<size; i+=8)
+        {
+            __m256 _p = _mm256_loadu_ps(ptr + i);
+            _p = exp256_ps(_mm256_sub_ps(_mm256_setzero_ps(), _p));
+            _p = _mm256_div_ps(_one8, _mm256_add_ps(_one8, _p));
+            _mm256_storeu_ps(ptr + i, _p);
+        }
+#endif // __AVX__
+        __m128 _one = _mm_set1_ps(1.f);
+        for (; i+3<size; i+=4)
+        {
+            __m128 _p = _mm_loadu_ps(ptr + i);
+            _p = exp_ps(_mm_sub_ps(_mm_setzero_ps(), _p));
+            _p = _mm_div_ps(_one, _mm_add_ps(_one, _p));
+            _mm_storeu_ps(ptr + i, _p);
+        }
+#endif // __SSE2__
+        for (; i<size; i++)
+        {
+            ptr[i] = 1.f / (1.f + exp(-ptr[i]));
+        }
+    }
+
+    return 0;
+}
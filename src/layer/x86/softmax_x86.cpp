@@ -0,0 +1,269 @@
+// Tencent is pleased to support the open source community by making ncnn available.
+//
+// Copyright (C) 2020 THL A29 Limited, a Tencent company. All rights reserved.
+//
+// Licensed under the BSD 3-Clause License (the "License"); you may not use this file except
+// in compliance with the License. You may obtain a copy of the License at
+//
+// https://opensource.org/licenses/BSD-3-Clause
+//
+// Unless required by applicable law or agreed to in writing, software distributed
+// under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+// CONDITIONS OF ANY KIND, either express or implied. See the License for the
+// specific language governing permissions and limitations under the License.
+
+#include "softmax_x86.h"
+#include <float.h>
+#include <math.h>
+
+#if __SSE2__
+#include <emmintrin.h>
+#include "sse_mathfun.h"
+#if __AVX__
+#include <immintrin.h>
+#include "avx_mathfun.h"
+#endif // __AVX__
+#endif // __SSE2__
+
+#include "x86_usability.h"
+
+#include "cstl/utils.h"
+
+void *Softmax_x86_ctor(void *_self, va_list *args)
+{
+    return _self;
+}
+
+// softmax over one contiguous run of values
+static void softmax_row_x86(float* ptr, int size)
+{
+    float m = -FLT_MAX;
+    {
+        int i = 0;
+#if __SSE2__
+#if __AVX__
+        __m256 _max8 = _mm256_set1_ps(-FLT_MAX);
+        for (; i+7<size; i+=8)
+        {
+            _max8 = _mm256_max_ps(_max8, _mm256_loadu_ps(ptr + i));
+        }
+        m = max(m, _mm256_reduce_max_ps(_max8));
+#endif // __AVX__
+        __m128 _max = _mm_set1_ps(-FLT_MAX);
+        for (; i+3<size; i+=4)
+        {
+            _max = _mm_max_ps(_max, _mm_loadu_ps(ptr + i));
+        }
+        m = max(m, _mm_reduce_max_ps(_max));
+#endif // __SSE2__
+        for (; i<size; i++)
+        {
+            m = max(m, ptr[i]);
+        }
+    }
+
+    float s = 0.f;
+    {
+        int i = 0;
+#if __SSE2__
+#if __AVX__
+        __m256 _m8 = _mm256_set1_ps(m);
+        __m256 _sum8 = _mm256_setzero_ps();
+        for (; i+7<size; i+=8)
+        {
+            __m256 _p = exp256_ps(_mm256_sub_ps(_mm256_loadu_ps(ptr + i), _m8));
+            _mm256_storeu_ps(ptr + i, _p);
+            _sum8 = _mm256_add_ps(_sum8, _p);
+        }
+        s += _mm256_reduce_add_ps(_sum8);
+#endif // __AVX__
+        __m128 _m = _mm_set1_ps(m);
+        __m128 _sum = _mm_setzero_ps();
+        for (; i+3<size; i+=4)
+        {
+            __m128 _p = exp_ps(_mm_sub_ps(_mm_loadu_ps(ptr + i), _m));
+            _mm_storeu_ps(ptr + i, _p);
+            _sum = _mm_add_ps(_sum, _p);
+        }
+        s += _mm_reduce_add_ps(_sum);
+#endif // __SSE2__
+        for (; i<size; i++)
+        {
+            ptr[i] = static_cast<float>(exp(ptr[i] - m));
+            s += ptr[i];
+        }
+    }
+
+    {
+        int i = 0;
+#if __SSE2__
+#if __AVX__
+        __m256 _s8 = _mm256_set1_ps(s);
+        for (; i+7<size; i+=8)
+        {
+            _mm256_storeu_ps(ptr + i, _mm256_div_ps(_mm256_loadu_ps(ptr + i), _s8));
+        }
+#endif // __AVX__
+        __m128 _s = _mm_set1_ps(s);
+        for (; i+3<size; i+=4)
+        {
+            _mm_storeu_ps(ptr + i, _mm_div_ps(_mm_loadu_ps(ptr + i), _s));
+        }
+#endif // __SSE2__
+        for (; i<size; i++)
+        {
+            ptr[i] /= s;
+        }
+    }
+}
+
+int Softmax_x86_forward_inplace(void *_self, Mat& bottom_top_blob, const Option& opt)
+{
+    Softmax *self = (Softmax *)_self;
+
+    int dims = bottom_top_blob.dims;
+    size_t elemsize = bottom_top_blob.elemsize;
+
+    if (dims == 1) // axis == 0
+    {
+        softmax_row_x86(bottom_top_blob, bottom_top_blob.w);
+
+        return 0;
+    }
+
+    if (dims == 2 && self->axis == 1)
+    {
+        int w = bottom_top_blob.w;
+        int h = bottom_top_blob.h;
+
+        #pragma omp parallel for num_threads(opt.num_threads)
+        for (int i=0; i<h; i++)
+        {
+            softmax_row_x86(bottom_top_blob.row(i), w);
+        }
+
+        return 0;
+    }
+
+    if (dims == 3 && self->axis == 2)
+    {
+        int w = bottom_top_blob.w;
+        int h = bottom_top_blob.h;
+        int channels = bottom_top_blob.c;
+
+        #pragma omp parallel for num_threads(opt.num_threads)
+        for (int q=0; q<channels; q++)
+        {
+            float* ptr = bottom_top_blob.channel(q);
+
+            for (int i=0; i<h; i++)
+            {
+                softmax_row_x86(ptr, w);
+                ptr += w;
+            }
+        }
+
+        return 0;
+    }
+
+    if (dims == 3 && self->axis == 0)
+    {
+        int w = bottom_top_blob.w;
+        int h = bottom_top_blob.h;
+        int channels = bottom_top_blob.c;
+        int size = w * h;
+
+        Mat max;
+        max.create(w, h, elemsize, opt.workspace_allocator);
+        if (max.empty())
+            return -100;
+        max.fill(-FLT_MAX);
+        for (int q=0; q<channels; q++)
+        {
+            const float* ptr = bottom_top_blob.channel(q);
+            float* maxptr = max;
+
+            int i = 0;
+#if __SSE2__
+#if __AVX__
+            for (; i+7<size; i+=8)
+            {
+                _mm256_storeu_ps(maxptr + i, _mm256_max_ps(_mm256_loadu_ps(maxptr + i), _mm256_loadu_ps(ptr + i)));
+            }
+#endif // __AVX__
+            for (; i+3<size; i+=4)
+            {
+                _mm_storeu_ps(maxptr + i, _mm_max_ps(_mm_loadu_ps(maxptr + i), _mm_loadu_ps(ptr + i)));
+            }
+#endif // __SSE2__
+            for (; i<size; i++)
+            {
+                maxptr[i] = max(maxptr[i], ptr[i]);
+            }
+        }
+
+        Mat sum;
+        sum.create(w, h, elemsize, opt.workspace_allocator);
+        if (sum.empty())
+            return -100;
+        sum.fill(0.f);
+        for (int q=0; q<channels; q++)
+        {
+            float* ptr = bottom_top_blob.channel(q);
+            const float* maxptr = max;
+            float* sumptr = sum;
+
+            int i = 0;
+#if __SSE2__
+#if __AVX__
+            for (; i+7<size; i+=8)
+            {
+                __m256 _p = exp256_ps(_mm256_sub_ps(_mm256_loadu_ps(ptr + i), _mm256_loadu_ps(maxptr + i)));
+                _mm256_storeu_ps(ptr + i, _p);
+                _mm256_storeu_ps(sumptr + i, _mm256_add_ps(_mm256_loadu_ps(sumptr + i), _p));
+            }
+#endif // __AVX__
+            for (; i+3<size; i+=4)
+            {
+                __m128 _p = exp_ps(_mm_sub_ps(_mm_loadu_ps(ptr + i), _mm_loadu_ps(maxptr + i)));
+                _mm_storeu_ps(ptr + i, _p);
+                _mm_storeu_ps(sumptr + i, _mm_add_ps(_mm_loadu_ps(sumptr + i), _p));
+            }
+#endif // __SSE2__
+            for (; i<size; i++)
+            {
+                ptr[i] = static_cast<float>(exp(ptr[i] - maxptr[i]));
+                sumptr[i] += ptr[i];
+            }
+        }
+
+        #pragma omp parallel for num_threads(opt.num_threads)
+        for (int q=0; q<channels; q++)
+        {
+            float* ptr = bottom_top_blob.channel(q);
+            const float* sumptr = sum;
+
+            int i = 0;
+#if __SSE2__
+#if __AVX__
+            for (; i+7<size; i+=8)
+            {
+                _mm256_storeu_ps(ptr + i, _mm256_div_ps(_mm256_loadu_ps(ptr + i), _mm256_loadu_ps(sumptr + i)));
+            }
+#endif // __AVX__
+            for (; i+3<size; i+=4)
+            {
+                _mm_storeu_ps(ptr + i, _mm_div_ps(_mm_loadu_ps(ptr + i), _mm_loadu_ps(sumptr + i)));
+            }
+#endif // __SSE2__
+            for (; i<size; i++)
+            {
+                ptr[i] /= sumptr[i];
+            }
+        }
+
+        return 0;
+    }
+
+    return Softmax_forward_inplace(self, bottom_top_blob, opt);
+}
@@ -0,0 +1,101 @@
+/* SSE2 implementation of exp
+
+   Inspired by Intel Approximate Math library, and based on the
+   corresponding algorithms of the cephes math library
+*/
+
+/* Copyright (C) 2007  Julien Pommier
+
+  This software is provided 'as-is', without any express or implied
+  warranty.  In no event will the authors be held liable for any damages
+  arising from the use of this software.
+
+  Permission is granted to anyone to use this software for any purpose,
+  including commercial applications, and to alter it and redistribute it
+  freely, subject to the following restrictions:
+
+  1. The origin of this software must not be misrepresented; you must not
+     claim that you wrote the original software. If you use this software
+     in a product, an acknowledgment in the product documentation would be
+     appreciated but is not required.
+  2. Altered source versions must be plainly marked as such, and must not be
+     misrepresented as being the original software.
+  3. This notice may not be removed or altered from any source distribution.
+
+  (this is the zlib license)
+*/
+
+#ifndef SSE_MATHFUN_H
+#define SSE_MATHFUN_H
+
+#include <emmintrin.h>
+
+#define c_exp_hi 88.3762626647949f
+#define c_exp_lo -88.3762626647949f
+
+#define c_cephes_LOG2EF 1.44269504088896341f
+#define c_cephes_exp_C1 0.693359375f
+#define c_cephes_exp_C2 -2.12194440e-4f
+
+#define c_cephes_exp_p0 1.9875691500E-4f
+#define c_cephes_exp_p1 1.3981999507E-3f
+#define c_cephes_exp_p2 8.3334519073E-3f
+#define c_cephes_exp_p3 4.1665795894E-2f
+#define c_cephes_exp_p4 1.6666665459E-1f
+#define c_cephes_exp_p5 5.0000001201E-1f
+
+/* exp() computed for 4 float at once */
+static inline __m128 exp_ps(__m128 x)
+{
+    __m128 tmp, fx;
+
+    __m128 one = _mm_set1_ps(1.f);
+    x = _mm_min_ps(x, _mm_set1_ps(c_exp_hi));
+    x = _mm_max_ps(x, _mm_set1_ps(c_exp_lo));
+
+    /* express exp(x) as exp(g + n*log(2)) */
+    fx = _mm_mul_ps(x, _mm_set1_ps(c_cephes_LOG2EF));
+    fx = _mm_add_ps(fx, _mm_set1_ps(0.5f));
+
+    /* perform a floorf */
+    __m128i emm0 = _mm_cvttps_epi32(fx);
+    tmp = _mm_cvtepi32_ps(emm0);
+
+    /* if greater, substract 1 */
+    __m128 mask = _mm_cmpgt_ps(tmp, fx);
+    mask = _mm_and_ps(mask, one);
+    fx = _mm_sub_ps(tmp, mask);
+
+    tmp = _mm_mul_ps(fx, _mm_set1_ps(c_cephes_exp_C1));
+    __m128 z = _mm_mul_ps(fx, _mm_set1_ps(c_cephes_exp_C2));
+    x = _mm_sub_ps(x, tmp);
+    x = _mm_sub_ps(x, z);
+
+    z = _mm_mul_ps(x, x);
+
+    __m128 y = _mm_set1_ps(c_cephes_exp_p0);
+    y = _mm_mul_ps(y, x);
+    y = _mm_add_ps(y, _mm_set1_ps(c_cephes_exp_p1));
+    y = _mm_mul_ps(y, x);
+    y = _mm_add_ps(y, _mm_set1_ps(c_cephes_exp_p2));
+    y = _mm_mul_ps(y, x);
+    y = _mm_add_ps(y, _mm_set1_ps(c_cephes_exp_p3));
+    y = _mm_mul_ps(y, x);
+    y = _mm_add_ps(y, _mm_set1_ps(c_cephes_exp_p4));
+    y = _mm_mul_ps(y, x);
+    y = _mm_add_ps(y, _mm_set1_ps(c_cephes_exp_p5));
+    y = _mm_mul_ps(y, z);
+    y = _mm_add_ps(y, x);
+    y = _mm_add_ps(y, one);
+
+    /* build 2^n */
+    emm0 = _mm_cvttps_epi32(fx);
+    emm0 = _mm_add_epi32(emm0, _mm_set1_epi32(0x7f));
+    emm0 = _mm_slli_epi32(emm0, 23);
+    __m128 pow2n = _mm_castsi128_ps(emm0);
+
+    y = _mm_mul_ps(y, pow2n);
+    return y;
+}
+
+#endif // SSE_MATHFUN_H
@@ -0,0 +1,157 @@
+// Tencent is pleased to support the open source community by making ncnn available.
+//
+// Copyright (C) 2019 THL A29 Limited, a Tencent company. All rights reserved.
+//
+// Licensed under the BSD 3-Clause License (the "License"); you may not use this file except
+// in compliance with the License. You may obtain a copy of the License at
+//
+// https://opensource.org/licenses/BSD-3-Clause
+//
+// Unless required by applicable law or agreed to in writing, software distributed
+// under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+// CONDITIONS OF ANY KIND, either express or implied. See the License for the
+// specific language governing permissions and limitations under the License.
+
+#ifndef X86_ACTIVATION_H
+#define X86_ACTIVATION_H
+
+#include <math.h>
+
+#if __SSE2__
+#include <emmintrin.h>
+#include "sse_mathfun.h"
+#if __AVX__
+#include <immintrin.h>
+#include "avx_mathfun.h"
+#endif // __AVX__
+#endif // __SSE2__
+
+#include "x86_usability.h"
+
+#include "cstl/utils.h"
+
+// fused epilogues, kernels are instantiated per activation type so the store
+// step carries no branch, and the two params travel as plain scalars that
+// stay in registers instead of being reloaded through the Mat on every store
+// 0=none 1=relu 2=leakyrelu 3=clip 4=sigmoid 6=hardswish
+static inline void activation_scalars(int activation_type, const Mat& activation_params, float& p0, float& p1)
+{
+    p0 = 0.f;
+    p1 = 0.f;
+    if (activation_type == 2)
+    {
+        p0 = activation_params[0];
+    }
+    else if (activation_type == 3 || activation_type == 6)
+    {
+        p0 = activation_params[0];
+        p1 = activation_params[1];
+    }
+}
+
+template<int activation_type> static inline float epilogue_ss(float v, float p0, float p1)
+{
+    if (activation_type == 1)
+        return max(v, 0.f);
+    if (activation_type == 2)
+        return v > 0.f ? v : v * p0;
+    if (activation_type == 3)
+        return min(max(v, p0), p1);
+    if (activation_type == 4)
+        return 1.f / (1.f + exp(-v));
+    if (activation_type == 6)
+        return v * min(max(v * p0 + p1, 0.f), 1.f);
+
+    return v;
+}
+
+#if __SSE2__
+template<int activation_type> static inline __m128 epilogue_ps(__m128 _v, float p0, float p1)
+{
+    if (activation_type == 1)
+        return _mm_max_ps(_v, _mm_setzero_ps());
+    if (activation_type == 2)
+        return _mm_add_ps(_mm_max_ps(_v, _mm_setzero_ps()), _mm_mul_ps(_mm_min_ps(_v, _mm_setzero_ps()), _mm_set1_ps(p0)));
+    if (activation_type == 3)
+        return _mm_min_ps(_mm_max_ps(_v, _mm_set1_ps(p0)), _mm_set1_ps(p1));
+    if (activation_type == 4)
+        return _mm_div_ps(_mm_set1_ps(1.f), _mm_add_ps(_mm_set1_ps(1.f), exp_ps(_mm_sub_ps(_mm_setzero_ps(), _v))));
+    if (activation_type == 6)
+    {
+        __m128 _gate = _mm_comp_fmadd_ps(_v, _mm_set1_ps(p0), _mm_set1_ps(p1));
+        return _mm_mul_ps(_v, _mm_min_ps(_mm_max_ps(_gate, _mm_setzero_ps()), _mm_set1_ps(1.f)));
+    }
+
+    return _v;
+}
+
+#if __AVX__
+template<int activation_type> static inline __m256 epilogue_avx(__m256 _v, float p0, float p1)
+{
+    if (activation_type == 1)
+        return _mm256_max_ps(_v, _mm256_setzero_ps());
+    if (activation_type == 2)
+        return _mm256_add_ps(_mm256_max_ps(_v, _mm256_setzero_ps()), _mm256_mul_ps(_mm256_min_ps(_v, _mm256_setzero_ps()), _mm256_set1_ps(p0)));
+    if (activation_type == 3)
+        return _mm256_min_ps(_mm256_max_ps(_v, _mm256_set1_ps(p0)), _mm256_set1_ps(p1));
+    if (activation_type == 4)
+        return _mm256_div_ps(_mm256_set1_ps(1.f), _mm256_add_ps(_mm256_set1_ps(1.f), exp256_ps(_mm256_sub_ps(_mm256_setzero_ps(), _v))));
+    if (activation_type == 6)
+    {
+        __m256 _gate = _mm256_comp_fmadd_ps(_v, _mm256_set1_ps(p0), _mm256_set1_ps(p1));
+        return _mm256_mul_ps(_v, _mm256_min_ps(_mm256_max_ps(_gate, _mm256_setzero_ps()), _mm256_set1_ps(1.f)));
+    }
+
+    return _v;
+}
+#endif // __AVX__
+#endif // __SSE2__
+
+// call kernel<activation_type> args, one instantiation per supported type
+#define ACTIVATION_EPILOGUE_DISPATCH(activation_type, kernel, args) \
+    switch (activation_type)                                        \
+    {                                                               \
+    case 1: kernel<1> args; break;                                  \
+    case 2: kernel<2> args; break;                                  \
+    case 3: kernel<3> args; break;                                  \
+    case 4: kernel<4> args; break;                                  \
+    case 6: kernel<6> args; break;                                  \
+    default: kernel<0> args; break;                                 \
+    }
+
+// the same activations with the type known at run time only
+static inline float activation_ss(float v, int activation_type, const Mat& activation_params)
+{
+    float p0, p1;
+    activation_scalars(activation_type, activation_params, p0, p1);
+
+    switch (activation_type)
+    {
+    case 1: return epilogue_ss<1>(v, p0, p1);
+    case 2: return epilogue_ss<2>(v, p0, p1);
+    case 3: return epilogue_ss<3>(v, p0, p1);
+    case 4: return epilogue_ss<4>(v, p0, p1);
+    case 6: return epilogue_ss<6>(v, p0, p1);
+    default: return v;
+    }
+}
+
+#if __SSE2__
+static inline __m128 activation_ps(__m128 _v, int activation_type, const Mat& activation_params)
+{
+    float p0, p1;
+    activation_scalars(activation_type, activation_params, p0, p1);
+
+    switch (activation_type)
+    {
+    case 1: return epilogue_ps<1>(_v, p0, p1);
+    case 2: return epilogue_ps<2>(_v, p0, p1);
+    case 3: return epilogue_ps<3>(_v, p0, p1);
+    case 4: return epilogue_ps<4>(_v, p0, p1);
+    case 6: return epilogue_ps<6>(_v, p0, p1);
+    default: return _v;
+    }
+}
+#endif // __SSE2__
+
+#endif // X86_ACTIVATION_H
@@ -0,0 +1,77 @@
+// Tencent is pleased to support the open source community by making ncnn available.
+//
+// Copyright (C) 2020 THL A29 Limited, a Tencent company. All rights reserved.
+//
+// Licensed under the BSD 3-Clause License (the "License"); you may not use this file except
+// in compliance with the License. You may obtain a copy of the License at
+//
+// https://opensource.org/licenses/BSD-3-Clause
+//
+// Unless required by applicable law or agreed to in writing, software distributed
+// under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+// CONDITIONS OF ANY KIND, either express or implied. See the License for the
+// specific language governing permissions and limitations under the License.
+
+#ifndef X86_USABILITY_H
+#define X86_USABILITY_H
+
+#if __SSE2__
+#include <emmintrin.h>
+#if __AVX__
+#include <immintrin.h>
+#endif // __AVX__
+#endif // __SSE2__
+
+#if __SSE2__
+// a * b + c
+static inline __m128 _mm_comp_fmadd_ps(__m128 a, __m128 b, __m128 c)
+{
+#if __FMA__
+    return _mm_fmadd_ps(a, b, c);
+#else
+    return _mm_add_ps(_mm_mul_ps(a, b), c);
+#endif
+}
+
+static inline float _mm_reduce_add_ps(__m128 x)
+{
+    // x0+x2 x1+x3 ..
+    __m128 x64 = _mm_add_ps(x, _mm_movehl_ps(x, x));
+    // x0+x2+x1+x3 ..
+    __m128 x32 = _mm_add_ss(x64, _mm_shuffle_ps(x64, x64, _MM_SHUFFLE(1, 1, 1, 1)));
+    return _mm_cvtss_f32(x32);
+}
+
+static inline float _mm_reduce_max_ps(__m128 x)
+{
+    __m128 x64 = _mm_max_ps(x, _mm_movehl_ps(x, x));
+    __m128 x32 = _mm_max_ss(x64, _mm_shuffle_ps(x64, x64, _MM_SHUFFLE(1, 1, 1, 1)));
+    return _mm_cvtss_f32(x32);
+}
+
+#if __AVX__
+// a * b + c
+static inline __m256 _mm256_comp_fmadd_ps(__m256 a, __m256 b, __m256 c)
+{
+#if __FMA__
+    return _mm256_fmadd_ps(a, b, c);
+#else
+    return _mm256_add_ps(_mm256_mul_ps(a, b), c);
+#endif
+}
+
+static inline float _mm256_reduce_add_ps(__m256 x)
+{
+    __m128 x128 = _mm_add_ps(_mm256_extractf128_ps(x, 1), _mm256_castps256_ps128(x));
+    return _mm_reduce_add_ps(x128);
+}
+
+static inline float _mm256_reduce_max_ps(__m256 x)
+{
+    __m128 x128 = _mm_max_ps(_mm256_extractf128_ps(x, 1), _mm256_castps256_ps128(x));
+    return _mm_reduce_max_ps(x128);
+}
+#endif // __AVX__
+#endif // __SSE2__
+
+#endif // X86_USABILITY_H
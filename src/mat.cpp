@@ -26,83 +26,79 @@
 
 void Mat::substract_mean_normalize(const float* mean_vals, const float* norm_vals)
 {
-    Layer* op;
+    if (!mean_vals && !norm_vals)
+        return;
 
-    if (mean_vals && !norm_vals)
-    {
-        // substract mean only
-        op = create_layer(LayerBias);
+    int size = w * h;
 
-        ParamDict pd;
-        pd.set(0, c);
+    for (int q=0; q<c; q++)
+    {
+        float* ptr = channel(q);
 
-        op->load_param(op, pd);
+        const float mean = mean_vals ? mean_vals[q] : 0.f;
+        const float norm = norm_vals ? norm_vals[q] : 1.f;
 
-        Mat weights[1];
-        weights[0] = Mat(c);
-        for (int q=0; q<c; q++)
+        if (!norm_vals)
         {
-            weights[0][q] = -mean_vals[q];
+            // substract mean only
+            for (int i=0; i<size; i++)
+            {
+                ptr[i] = ptr[i] - mean;
+            }
         }
-
-        op->load_model(op, ModelBinFromMatArray(weights));
-    }
-    else if (!mean_vals && norm_vals)
-    {
-        // normalize only
-        op = create_layer(LayerScale);
-
-        ParamDict pd;
-        pd.set(0, c);
-
-        op->load_param(op, pd);
-
-        Mat weights[1];
-        weights[0] = Mat(c);
-        for (int q=0; q<c; q++)
+        else
         {
-            weights[0][q] = norm_vals[q];
+            // normalize, with mean substracted when given
+            const float bias = - mean * norm;
+            for (int i=0; i<size; i++)
+            {
+                ptr[i] = ptr[i] * norm + bias;
+            }
         }
-
-        op->load_model(op, ModelBinFromMatArray(weights));
     }
-    else if (mean_vals && norm_vals)
-    {
-        // substract mean and normalize
-        op = create_layer(LayerScale);
-
-        ParamDict pd;
-        pd.set(0, c);
-        pd.set(1, 1);
+}
 
-        op->load_param(op, pd);
+// out of line as it calls itself, the other reshape overloads are inline in mat.h
+Mat Mat::reshape(int _w, int _h, int _c, Allocator* _allocator) const
+{
+    if (w * h * c != _w * _h * _c)
+        return Mat();
 
-        Mat weights[2];
-        weights[0] = Mat(c);
-        weights[1] = Mat(c);
-        for (int q=0; q<c; q++)
+    if (dims < 3)
+    {
+        if ((size_t)_w * _h != alignSize(_w * _h * elemsize, 16) / elemsize)
         {
-            weights[0][q] = norm_vals[q];
-            weights[1][q] = - mean_vals[q] * norm_vals[q];
-        }
+            Mat m;
+            m.create(_w, _h, _c, elemsize, elempack, _allocator);
 
-        op->load_model(op, ModelBinFromMatArray(weights));
+            // align channel
+            for (int i=0; i<_c; i++)
+            {
+                const void* ptr = (unsigned char*)data + i * _w * _h * elemsize;
+                void* mptr = (unsigned char*)m.data + i * m.cstep * m.elemsize;
+                memcpy(mptr, ptr, _w * _h * elemsize);
+            }
+
+            return m;
+        }
     }
-    else // if (!mean_vals && !norm_vals)
+    else if (c != _c)
     {
-        return;
+        // flatten and then align
+        Mat tmp = reshape(_w * _h * _c, _allocator);
+        return tmp.reshape(_w, _h, _c, _allocator);
     }
 
-    Option opt;
-    opt.num_threads = 1;// TODO
-
-    op->create_pipeline(op, opt);
+    Mat m = *this;
 
-    op->forward_inplace(op, *this, opt);
+    m.dims = 3;
+    m.w = _w;
+    m.h = _h;
+    m.c = _c;
 
-    op->destroy_pipeline(op, opt);
+    m.cstep = alignSize(_w * _h * elemsize, 16) / elemsize;
 
-    cdelete(op);
+    return m;
 }
 
 Mat Mat::from_float16(const unsigned short* data, int size)
@@ -287,50 +283,200 @@ float float16_to_float32(unsigned short value)
     return tmp.f;
 }
 
+// the mat process helpers below run their kernels directly,
+// they are called per layer per inference and must cost only the memory traffic
+
+template<typename T>
+static void copy_make_border_image(const Mat& src, Mat& dst, int top, int left, int type, T v)
+{
+    const int w = dst.w;
+    const int h = dst.h;
+    const int right = w - left - src.w;
+
+    T* outptr = dst;
+
+    for (int y=0; y<h; y++)
+    {
+        int sy = y - top;
+        if (sy < 0 || sy >= src.h)
+        {
+            if (type == BORDER_CONSTANT)
+            {
+                for (int x=0; x<w; x++)
+                {
+                    outptr[x] = v;
+                }
+                outptr += w;
+                continue;
+            }
+
+            if (type == BORDER_REPLICATE)
+                sy = sy < 0 ? 0 : src.h - 1;
+            else // reflect
+                sy = sy < 0 ? -sy : 2 * (src.h - 1) - sy;
+        }
+
+        const T* ptr = (const T*)src.data + sy * src.w;
+
+        for (int x=0; x<left; x++)
+        {
+            if (type == BORDER_CONSTANT)
+                outptr[x] = v;
+            else if (type == BORDER_REPLICATE)
+                outptr[x] = ptr[0];
+            else
+                outptr[x] = ptr[left - x];
+        }
+
+        memcpy(outptr + left, ptr, src.w * sizeof(T));
+
+        T* rptr = outptr + left + src.w;
+        for (int x=0; x<right; x++)
+        {
+            if (type == BORDER_CONSTANT)
+                rptr[x] = v;
+            else if (type == BORDER_REPLICATE)
+                rptr[x] = ptr[src.w - 1];
+            else
+                rptr[x] = ptr[src.w - x - 2];
+        }
+
+        outptr += w;
+    }
+}
+
+static void copy_make_border_image(const Mat& src, Mat& dst, int top, int left, int type, float v, size_t elemsize)
+{
+    if (elemsize == 1)
+        copy_make_border_image<signed char>(src, dst, top, left, type, static_cast<signed char>(v));
+    if (elemsize == 2)
+        copy_make_border_image<unsigned short>(src, dst, top, left, type, float32_to_bfloat16(v));
+    if (elemsize == 4)
+        copy_make_border_image<float>(src, dst, top, left, type, v);
+}
+
 void copy_make_border(const Mat& src, Mat& dst, int top, int bottom, int left, int right, int type, float v, const Option& opt)
 {
-    Layer* padding = create_layer(LayerPadding);
+    if (top == 0 && bottom == 0 && left == 0 && right == 0)
+    {
+        dst = src;
+        return;
+    }
 
-    ParamDict pd;
-    pd.set(0, top);
-    pd.set(1, bottom);
-    pd.set(2, left);
-    pd.set(3, right);
-    pd.set(4, type);
-    pd.set(5, v);
+    int w = src.w;
+    int h = src.h;
+    int channels = src.c;
+    int dims = src.dims;
+    size_t elemsize = src.elemsize;
+
+    int outw = w + left + right;
+
+    if (dims == 1)
+    {
+        dst.create(outw, elemsize, opt.blob_allocator);
+        if (dst.empty())
+            return;
 
-    padding->load_param(padding, pd);
+        copy_make_border_image(src, dst, 0, left, type, v, elemsize);
+        return;
+    }
 
-    padding->create_pipeline(padding, opt);
+    int outh = h + top + bottom;
 
-    padding->forward(padding, src, dst, opt);
+    if (dims == 2)
+    {
+        dst.create(outw, outh, elemsize, opt.blob_allocator);
+        if (dst.empty())
+            return;
 
-    padding->destroy_pipeline(padding, opt);
+        copy_make_border_image(src, dst, top, left, type, v, elemsize);
+        return;
+    }
 
-    cdelete(padding);
+    if (dims == 3)
+    {
+        dst.create(outw, outh, channels, elemsize, opt.blob_allocator);
+        if (dst.empty())
+            return;
+
+        #pragma omp parallel for num_threads(opt.num_threads)
+        for (int q=0; q<channels; q++)
+        {
+            const Mat m = src.channel(q);
+            Mat borderm = dst.channel(q);
+
+            copy_make_border_image(m, borderm, top, left, type, v, elemsize);
+        }
+    }
+}
+
+static void copy_cut_border_image(const Mat& src, Mat& dst, int top, int left, size_t elemsize)
+{
+    const unsigned char* ptr = (const unsigned char*)src.data + (top * src.w + left) * elemsize;
+    unsigned char* outptr = dst;
+
+    for (int y=0; y<dst.h; y++)
+    {
+        memcpy(outptr, ptr, dst.w * elemsize);
+
+        outptr += dst.w * elemsize;
+        ptr += src.w * elemsize;
+    }
 }
 
 void copy_cut_border(const Mat& src, Mat& dst, int top, int bottom, int left, int right, const Option& opt)
 {
-    Layer* crop = create_layer(LayerCrop);
+    if (top == 0 && bottom == 0 && left == 0 && right == 0)
+    {
+        dst = src;
+        return;
+    }
 
-    ParamDict pd;
-    pd.set(0, left);
-    pd.set(1, top);
-    pd.set(2, 0);
-    pd.set(3, src.w - left - right);
-    pd.set(4, src.h - top - bottom);
-    pd.set(5, -233);
+    int w = src.w;
+    int h = src.h;
+    int channels = src.c;
+    int dims = src.dims;
+    size_t elemsize = src.elemsize;
+
+    int outw = w - left - right;
+
+    if (dims == 1)
+    {
+        dst.create(outw, elemsize, opt.blob_allocator);
+        if (dst.empty())
+            return;
+
+        copy_cut_border_image(src, dst, 0, left, elemsize);
+        return;
+    }
 
-    crop->load_param(crop, pd);
+    int outh = h - top - bottom;
 
-    crop->create_pipeline(crop, opt);
+    if (dims == 2)
+    {
+        dst.create(outw, outh, elemsize, opt.blob_allocator);
+        if (dst.empty())
+            return;
 
-    crop->forward(crop, src, dst, opt);
+        copy_cut_border_image(src, dst, top, left, elemsize);
+        return;
+    }
 
-    crop->destroy_pipeline(crop, opt);
+    if (dims == 3)
+    {
+        dst.create(outw, outh, channels, elemsize, opt.blob_allocator);
+        if (dst.empty())
+            return;
 
-    cdelete(crop);
+        #pragma omp parallel for num_threads(opt.num_threads)
+        for (int q=0; q<channels; q++)
+        {
+            const Mat m = src.channel(q);
+            Mat cutm = dst.channel(q);
+
+            copy_cut_border_image(m, cutm, top, left, elemsize);
+        }
+    }
 }
 
 void resize_bilinear(const Mat& src, Mat& dst, int w, int h, const Option& opt)
@@ -373,185 +519,349 @@ void resize_bicubic(const Mat& src, Mat& dst, int w, int h, const Option& opt)
     cdelete(interp);
 }
 
-void convert_packing(const Mat& src, Mat& dst, int _elempack, const Option& opt)
+void convert_packing(const Mat& src, Mat& dst, int out_elempack, const Option& opt)
 {
-    Layer* packing = create_layer(LayerPacking);
+    int elempack = src.elempack;
 
-    ParamDict pd;
-    pd.set(0, _elempack);
-
-    packing->load_param(packing, pd);
+    if (elempack == out_elempack)
+    {
+        dst = src;
+        return;
+    }
 
-    packing->create_pipeline(packing, opt);
+    int w = src.w;
+    int h = src.h;
+    int channels = src.c;
+    int dims = src.dims;
+    size_t elemsize = src.elemsize;
 
-    packing->forward(packing, src, dst, opt);
+    // identity if the packed axis does not divide evenly
+    if (dims == 1 && w * elempack % out_elempack != 0)
+    {
+        dst = src;
+        return;
+    }
+    if (dims == 2 && h * elempack % out_elempack != 0)
+    {
+        dst = src;
+        return;
+    }
+    if (dims == 3 && channels * elempack % out_elempack != 0)
+    {
+        dst = src;
+        return;
+    }
 
-    packing->destroy_pipeline(packing, opt);
+    size_t out_elemsize = elemsize / elempack * out_elempack;
+    size_t lane_size = elemsize / elempack;
 
-    cdelete(packing);
-}
+    if (dims == 1)
+    {
+        if (out_elempack == 1)
+        {
+            dst = src;
+            dst.w = w * elempack;
+            dst.cstep = w * elempack;
+            dst.elemsize = elemsize / elempack;
+            dst.elempack = out_elempack;
+            return;
+        }
 
-void cast_float32_to_float16(const Mat& src, Mat& dst, const Option& opt)
-{
-    Layer* cast = create_layer(LayerCast);
+        int outw = w * elempack / out_elempack;
 
-    ParamDict pd;
-    pd.set(0, 1);
-    pd.set(1, 2);
+        dst.create(outw, out_elemsize, out_elempack, opt.blob_allocator);
+        if (dst.empty())
+            return;
 
-    cast->load_param(cast, pd);
+        memcpy(dst.data, src.data, w * elemsize);
+        return;
+    }
 
-    cast->create_pipeline(cast, opt);
+    if (dims == 2)
+    {
+        int outh = h * elempack / out_elempack;
 
-    cast->forward(cast, src, dst, opt);
+        dst.create(w, outh, out_elemsize, out_elempack, opt.blob_allocator);
+        if (dst.empty())
+            return;
 
-    cast->destroy_pipeline(cast, opt);
+        #pragma omp parallel for num_threads(opt.num_threads)
+        for (int i=0; i<outh; i++)
+        {
+            unsigned char* outptr = (unsigned char*)dst + i * w * out_elemsize;
 
-    cdelete(cast);
-}
+            for (int k=0; k<out_elempack; k++)
+            {
+                int srcy = (i * out_elempack + k) / elempack;
+                int srck = (i * out_elempack + k) % elempack;
 
-void cast_float16_to_float32(const Mat& src, Mat& dst, const Option& opt)
-{
-    Layer* cast = create_layer(LayerCast);
+                const unsigned char* ptr = (const unsigned char*)src + srcy * w * elemsize + srck * lane_size;
 
-    ParamDict pd;
-    pd.set(0, 2);
-    pd.set(1, 1);
+                for (int j=0; j<w; j++)
+                {
+                    memcpy(outptr + j * out_elemsize + k * lane_size, ptr + j * elemsize, lane_size);
+                }
+            }
+        }
 
-    cast->load_param(cast, pd);
+        return;
+    }
 
-    cast->create_pipeline(cast, opt);
+    if (dims == 3)
+    {
+        int outc = channels * elempack / out_elempack;
+        int size = w * h;
 
-    cast->forward(cast, src, dst, opt);
+        dst.create(w, h, outc, out_elemsize, out_elempack, opt.blob_allocator);
+        if (dst.empty())
+            return;
 
-    cast->destroy_pipeline(cast, opt);
+        #pragma omp parallel for num_threads(opt.num_threads)
+        for (int q=0; q<outc; q++)
+        {
+            unsigned char* outptr = dst.channel(q);
 
-    cdelete(cast);
+            for (int k=0; k<out_elempack; k++)
+            {
+                int srcq = (q * out_elempack + k) / elempack;
+                int srck = (q * out_elempack + k) % elempack;
+
+                const unsigned char* ptr = (const unsigned char*)src.channel(srcq).data + srck * lane_size;
+
+                if (lane_size == 4)
+                {
+                    // fp32 lanes, the common case
+                    const float* fptr = (const float*)ptr;
+                    float* foutptr = (float*)outptr + k;
+
+                    for (int i=0; i<size; i++)
+                    {
+                        foutptr[i * out_elempack] = fptr[i * elempack];
+                    }
+                }
+                else
+                {
+                    for (int i=0; i<size; i++)
+                    {
+                        memcpy(outptr + i * out_elemsize + k * lane_size, ptr + i * elemsize, lane_size);
+                    }
+                }
+            }
+        }
+    }
 }
 
-void cast_int8_to_float32(const Mat& src, Mat& dst, const Option& opt)
+// allocate dst with the shape of src and a new element size
+static void create_like(const Mat& src, Mat& dst, size_t out_elemsize, int elempack, Allocator* allocator)
 {
-    Layer* cast = create_layer(LayerCast);
-
-    ParamDict pd;
-    pd.set(0, 3);
-    pd.set(1, 1);
+    if (src.dims == 1)
+        dst.create(src.w, out_elemsize, elempack, allocator);
+    else if (src.dims == 2)
+        dst.create(src.w, src.h, out_elemsize, elempack, allocator);
+    else if (src.dims == 3)
+        dst.create(src.w, src.h, src.c, out_elemsize, elempack, allocator);
+}
 
-    cast->load_param(cast, pd);
+void cast_float32_to_float16(const Mat& src, Mat& dst, const Option& opt)
+{
+    int elempack = src.elempack;
 
-    cast->create_pipeline(cast, opt);
+    create_like(src, dst, 2 * elempack, elempack, opt.blob_allocator);
+    if (dst.empty())
+        return;
 
-    cast->forward(cast, src, dst, opt);
+    int channels = src.dims == 3 ? src.c : 1;
+    int size = src.dims == 3 ? src.w * src.h * elempack : (int)src.total() * elempack;
 
-    cast->destroy_pipeline(cast, opt);
+    #pragma omp parallel for num_threads(opt.num_threads)
+    for (int q=0; q<channels; q++)
+    {
+        const float* ptr = src.channel(q);
+        unsigned short* outptr = dst.channel(q);
 
-    cdelete(cast);
+        for (int i=0; i<size; i++)
+        {
+            outptr[i] = float32_to_float16(ptr[i]);
+        }
+    }
 }
 
-void cast_float32_to_bfloat16(const Mat& src, Mat& dst, const Option& opt)
+void cast_float16_to_float32(const Mat& src, Mat& dst, const Option& opt)
 {
-    Layer* cast = create_layer(LayerCast);
-
-    ParamDict pd;
-    pd.set(0, 1);
-    pd.set(1, 4);
-
-    cast->load_param(cast, pd);
+    int elempack = src.elempack;
 
-    cast->create_pipeline(cast, opt);
+    create_like(src, dst, 4 * elempack, elempack, opt.blob_allocator);
+    if (dst.empty())
+        return;
 
-    cast->forward(cast, src, dst, opt);
+    int channels = src.dims == 3 ? src.c : 1;
+    int size = src.dims == 3 ? src.w * src.h * elempack : (int)src.total() * elempack;
 
-    cast->destroy_pipeline(cast, opt);
+    #pragma omp parallel for num_threads(opt.num_threads)
+    for (int q=0; q<channels; q++)
+    {
+        const unsigned short* ptr = src.channel(q);
+        float* outptr = dst.channel(q);
 
-    cdelete(cast);
+        for (int i=0; i<size; i++)
+        {
+            outptr[i] = float16_to_float32(ptr[i]);
+        }
+    }
 }
 
-void cast_bfloat16_to_float32(const Mat& src, Mat& dst, const Option& opt)
+void cast_int8_to_float32(const Mat& src, Mat& dst, const Option& opt)
 {
-    Layer* cast = create_layer(LayerCast);
+    int elempack = src.elempack;
 
-    ParamDict pd;
-    pd.set(0, 4);
-    pd.set(1, 1);
+    create_like(src, dst, 4 * elempack, elempack, opt.blob_allocator);
+    if (dst.empty())
+        return;
+
+    int channels = src.dims == 3 ? src.c : 1;
+    int size = src.dims == 3 ? src.w * src.h * elempack : (int)src.total() * elempack;
 
-    cast->load_param(cast, pd);
+    #pragma omp parallel for num_threads(opt.num_threads)
+    for (int q=0; q<channels; q++)
+    {
+        const signed char* ptr = src.channel(q);
+        float* outptr = dst.channel(q);
+
+        for (int i=0; i<size; i++)
+        {
+            outptr[i] = (float)ptr[i];
+        }
+    }
+}
 
-    cast->create_pipeline(cast, opt);
+void cast_float32_to_bfloat16(const Mat& src, Mat& dst, const Option& opt)
+{
+    int elempack = src.elempack;
 
-    cast->forward(cast, src, dst, opt);
+    create_like(src, dst, 2 * elempack, elempack, opt.blob_allocator);
+    if (dst.empty())
+        return;
 
-    cast->destroy_pipeline(cast, opt);
+    int channels = src.dims == 3 ? src.c : 1;
+    int size = src.dims == 3 ? src.w * src.h * elempack : (int)src.total() * elempack;
 
-    cdelete(cast);
+    #pragma omp parallel for num_threads(opt.num_threads)
+    for (int q=0; q<channels; q++)
+    {
+        const float* ptr = src.channel(q);
+        unsigned short* outptr = dst.channel(q);
+
+        for (int i=0; i<size; i++)
+        {
+            outptr[i] = float32_to_bfloat16(ptr[i]);
+        }
+    }
 }
 
-void quantize_float32_to_int8(const Mat& src, Mat& dst, float scale, const Option& opt)
+void cast_bfloat16_to_float32(const Mat& src, Mat& dst, const Option& opt)
 {
-    Layer* quantize = create_layer(LayerQuantize);
+    int elempack = src.elempack;
 
-    ParamDict pd;
-    pd.set(0, scale);
-
-    quantize->load_param(quantize, pd);
+    create_like(src, dst, 4 * elempack, elempack, opt.blob_allocator);
+    if (dst.empty())
+        return;
 
-    quantize->create_pipeline(quantize, opt);
+    int channels = src.dims == 3 ? src.c : 1;
+    int size = src.dims == 3 ? src.w * src.h * elempack : (int)src.total() * elempack;
 
-    quantize->forward(quantize, src, dst, opt);
+    #pragma omp parallel for num_threads(opt.num_threads)
+    for (int q=0; q<channels; q++)
+    {
+        const unsigned short* ptr = src.channel(q);
+        float* outptr = dst.channel(q);
 
-    quantize->destroy_pipeline(quantize, opt);
+        for (int i=0; i<size; i++)
+        {
+            outptr[i] = bfloat16_to_float32(ptr[i]);
+        }
+    }
+}
 
-    cdelete(quantize);
+static inline signed char float2int8(float v)
+{
+    int int32 = static_cast<int>(round(v));
+    if (int32 > 127) return 127;
+    if (int32 < -127) return -127;
+    return (signed char)int32;
 }
 
-void dequantize_int32_to_float32(Mat& m, float scale, const float* bias, int bias_data_size, const Option& opt)
+void quantize_float32_to_int8(const Mat& src, Mat& dst, float scale, const Option& opt)
 {
-    Layer* dequantize = create_layer(LayerDequantize);
+    create_like(src, dst, 1u, 1, opt.blob_allocator);
+    if (dst.empty())
+        return;
 
-    ParamDict pd;
-    pd.set(0, scale);
-    pd.set(1, bias ? 1 : 0);
-    pd.set(2, bias_data_size);
+    int channels = src.dims == 3 ? src.c : 1;
+    int size = src.dims == 3 ? src.w * src.h : (int)src.total();
 
-    dequantize->load_param(dequantize, pd);
+    #pragma omp parallel for num_threads(opt.num_threads)
+    for (int q=0; q<channels; q++)
+    {
+        const float* ptr = src.channel(q);
+        signed char* outptr = dst.channel(q);
 
-    Mat weights[1];
-    weights[0] = Mat(bias_data_size, (void*)bias);
+        for (int i=0; i<size; i++)
+        {
+            outptr[i] = float2int8(ptr[i] * scale);
+        }
+    }
+}
 
-    dequantize->load_model(dequantize, ModelBinFromMatArray(weights));
+// bias is per element for 1d, per row for 2d and per channel for 3d, or a single value
+void dequantize_int32_to_float32(Mat& m, float scale, const float* bias, int bias_data_size, const Option& opt)
+{
+    int dims = m.dims;
 
-    dequantize->create_pipeline(dequantize, opt);
+    int outer = dims == 1 ? m.w : dims == 2 ? m.h : m.c;
+    int size = dims == 1 ? 1 : dims == 2 ? m.w : m.w * m.h;
+    size_t step = dims == 3 ? m.cstep : (size_t)size;
 
-    dequantize->forward_inplace(dequantize, m, opt);
+    #pragma omp parallel for num_threads(opt.num_threads)
+    for (int q=0; q<outer; q++)
+    {
+        const int* intptr = (const int*)m.data + q * step;
+        float* ptr = (float*)m.data + q * step;
 
-    dequantize->destroy_pipeline(dequantize, opt);
+        const float b = bias ? (bias_data_size > 1 ? bias[q] : bias[0]) : 0.f;
 
-    cdelete(dequantize);
+        for (int i=0; i<size; i++)
+        {
+            ptr[i] = intptr[i] * scale + b;
+        }
+    }
 }
 
 void requantize_int8_to_int8(const Mat& src, Mat& dst, float scale_in, float scale_out, const float* bias, int bias_data_size, int fusion_relu, const Option& opt)
 {
-    Layer* requantize = create_layer(LayerRequantize);
-
-    ParamDict pd;
-    pd.set(0, scale_in);
-    pd.set(1, scale_out);
-    pd.set(2, bias ? 1 : 0);
-    pd.set(3, bias_data_size);
-    pd.set(4, fusion_relu);
-
-    requantize->load_param(requantize, pd);
-
-    Mat weights[1];
-    weights[0] = Mat(bias_data_size, (void*)bias);
+    create_like(src, dst, 1u, 1, opt.blob_allocator);
+    if (dst.empty())
+        return;
 
-    requantize->load_model(requantize, ModelBinFromMatArray(weights));
+    int dims = src.dims;
 
-    requantize->create_pipeline(requantize, opt);
+    int outer = dims == 1 ? src.w : dims == 2 ? src.h : src.c;
+    int size = dims == 1 ? 1 : dims == 2 ? src.w : src.w * src.h;
+    size_t step = dims == 3 ? src.cstep : (size_t)size;
+    size_t outstep = dims == 3 ? dst.cstep : (size_t)size;
 
-    requantize->forward(requantize, src, dst, opt);
+    #pragma omp parallel for num_threads(opt.num_threads)
+    for (int q=0; q<outer; q++)
+    {
+        const int* intptr = (const int*)src.data + q * step;
+        signed char* ptr = (signed char*)dst.data + q * outstep;
 
-    requantize->destroy_pipeline(requantize, opt);
+        const float b = bias ? (bias_data_size > 1 ? bias[q] : bias[0]) : 0.f;
 
-    cdelete(requantize);
+        for (int i=0; i<size; i++)
+        {
+            ptr[i] = float2int8((intptr[i] * scale_in + b) * scale_out);
+            if (fusion_relu && ptr[i] < 0)
+                ptr[i] = 0;
+        }
+    }
 }
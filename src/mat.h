@@ -116,6 +116,15 @@ struct Mat
     Mat range(int x, int n);
     const Mat range(int x, int n) const;
 
+    // range reference sharing the reference counter, keeps the whole mat alive
+    // same as the plain range reference when the data is not owned
+    Mat shared_channel_range(int c, int channels);
+    const Mat shared_channel_range(int c, int channels) const;
+    Mat shared_row_range(int y, int rows);
+    const Mat shared_row_range(int y, int rows) const;
+    Mat shared_range(int x, int n);
+    const Mat shared_range(int x, int n) const;
+
     // access raw data
     template<typename T> operator T*();
     template<typename T> operator const T*() const;
@@ -170,6 +179,27 @@ struct Mat
     static Mat from_pixels_resize(const unsigned char* pixels, int type, int w, int h, int target_width, int target_height, Allocator* allocator = 0);
     // convenient construct from pixel data and resize to specific size with stride(bytes-per-row) parameter
     static Mat from_pixels_resize(const unsigned char* pixels, int type, int w, int h, int stride, int target_width, int target_height, Allocator* allocator = 0);
+    // convenient construct from pixel data, resize to specific size, then substract channel-wise mean values
+    // and multiply by normalize values, pass 0 to skip, all in one pass over the pixels
+    // the result equals from_pixels_resize followed by substract_mean_normalize
+    // elempack 4 packs the channels, which needs a four channel output type
+    static Mat from_pixels_resize_normalize(const unsigned char* pixels, int type, int w, int h, int target_width, int target_height, const float* mean_vals, const float* norm_vals, int elempack = 1, Allocator* allocator = 0);
+    // convenient construct from pixel data, resize and normalize with stride(bytes-per-row) parameter
+    static Mat from_pixels_resize_normalize(const unsigned char* pixels, int type, int w, int h, int stride, int target_width, int target_height, const float* mean_vals, const float* norm_vals, int elempack = 1, Allocator* allocator = 0);
+
+    enum Yuv420Format
+    {
+        YUV420_NV21 = 1,// y plane, then interleaved v u
+        YUV420_NV12 = 2,// y plane, then interleaved u v
+        YUV420_I420 = 3,// y plane, u plane, v plane
+    };
+    // convenient construct from a yuv420 frame, crop the roi, rotate it by the kanna rotate type, resize to specific size
+    // and convert to the pixel type, then substract channel-wise mean values and multiply by normalize values, pass 0 to skip
+    // all in one pass sampling the frame, with no full resolution intermediate
+    // w h and the roi are in luma pixels, orientation 1 keeps the roi upright, type is one of rgb bgr gray rgba bgra
+    // luma and chroma are interpolated bilinearly and converted with the yuv420sp2rgb coefficients
+    // elempack 4 packs the channels, which needs a four channel pixel type
+    static Mat from_yuv420_roi_resize_normalize(const unsigned char* yuv, int format, int w, int h, int roix, int roiy, int roiw, int roih, int orientation, int type, int target_width, int target_height, const float* mean_vals, const float* norm_vals, int elempack = 1, Allocator* allocator = 0);
 
     // convenient export to pixel data
     void to_pixels(unsigned char* pixels, int type) const;
@@ -269,7 +299,7 @@ unsigned short float32_to_float16(float value);
 // convert half precision floating point to float
 float float16_to_float32(unsigned short value);
 // convert float to brain half
-inline unsigned short float32_to_bfloat16(float value)
+NCNN_FORCEINLINE unsigned short float32_to_bfloat16(float value)
 {
     // 16 : 16
     union { unsigned int u; float f; } tmp;
@@ -277,7 +307,7 @@ inline unsigned short float32_to_bfloat16(float value)
     return tmp.u >> 16;
 }
 // convert brain half to float
-inline float bfloat16_to_float32(unsigned short value)
+NCNN_FORCEINLINE float bfloat16_to_float32(unsigned short value)
 {
     // 16 : 16
     union { unsigned int u; float f; } tmp;
@@ -305,96 +335,96 @@ void quantize_float32_to_int8(const Mat& src, Mat& dst, float scale, const Optio
 void dequantize_int32_to_float32(Mat& m, float scale, const float* bias, int bias_data_size, const Option& opt = Option());
 void requantize_int8_to_int8(const Mat& src, Mat& dst, float scale_in, float scale_out, const float* bias, int bias_data_size, int fusion_relu, const Option& opt = Option());
 
-inline Mat::Mat()
+NCNN_FORCEINLINE Mat::Mat()
     : data(0), refcount(0), elemsize(0), elempack(0), allocator(0), dims(0), w(0), h(0), c(0), cstep(0)
 {
 }
 
-inline Mat::Mat(int _w, size_t _elemsize, Allocator* _allocator)
+NCNN_FORCEINLINE Mat::Mat(int _w, size_t _elemsize, Allocator* _allocator)
     : data(0), refcount(0), elemsize(0), elempack(0), allocator(0), dims(0), w(0), h(0), c(0), cstep(0)
 {
     create(_w, _elemsize, _allocator);
 }
 
-inline Mat::Mat(int _w, int _h, size_t _elemsize, Allocator* _allocator)
+NCNN_FORCEINLINE Mat::Mat(int _w, int _h, size_t _elemsize, Allocator* _allocator)
     : data(0), refcount(0), elemsize(0), elempack(0), allocator(0), dims(0), w(0), h(0), c(0), cstep(0)
 {
     create(_w, _h, _elemsize, _allocator);
 }
 
-inline Mat::Mat(int _w, int _h, int _c, size_t _elemsize, Allocator* _allocator)
+NCNN_FORCEINLINE Mat::Mat(int _w, int _h, int _c, size_t _elemsize, Allocator* _allocator)
     : data(0), refcount(0), elemsize(0), elempack(0), allocator(0), dims(0), w(0), h(0), c(0), cstep(0)
 {
     create(_w, _h, _c, _elemsize, _allocator);
 }
 
-inline Mat::Mat(int _w, size_t _elemsize, int _elempack, Allocator* _allocator)
+NCNN_FORCEINLINE Mat::Mat(int _w, size_t _elemsize, int _elempack, Allocator* _allocator)
     : data(0), refcount(0), elemsize(0), elempack(0), allocator(0), dims(0), w(0), h(0), c(0), cstep(0)
 {
     create(_w, _elemsize, _elempack, _allocator);
 }
 
-inline Mat::Mat(int _w, int _h, size_t _elemsize, int _elempack, Allocator* _allocator)
+NCNN_FORCEINLINE Mat::Mat(int _w, int _h, size_t _elemsize, int _elempack, Allocator* _allocator)
     : data(0), refcount(0), elemsize(0), elempack(0), allocator(0), dims(0), w(0), h(0), c(0), cstep(0)
 {
     create(_w, _h, _elemsize, _elempack, _allocator);
 }
 
-inline Mat::Mat(int _w, int _h, int _c, size_t _elemsize, int _elempack, Allocator* _allocator)
+NCNN_FORCEINLINE Mat::Mat(int _w, int _h, int _c, size_t _elemsize, int _elempack, Allocator* _allocator)
     : data(0), refcount(0), elemsize(0), elempack(0), allocator(0), dims(0), w(0), h(0), c(0), cstep(0)
 {
     create(_w, _h, _c, _elemsize, _elempack, _allocator);
 }
 
-inline Mat::Mat(const Mat& m)
+NCNN_FORCEINLINE Mat::Mat(const Mat& m)
     : data(m.data), refcount(m.refcount), elemsize(m.elemsize), elempack(m.elempack), allocator(m.allocator), dims(m.dims), w(m.w), h(m.h), c(m.c), cstep(m.cstep)
 {
     if (refcount)
         NCNN_XADD(refcount, 1);
 }
 
-inline Mat::Mat(int _w, void* _data, size_t _elemsize, Allocator* _allocator)
+NCNN_FORCEINLINE Mat::Mat(int _w, void* _data, size_t _elemsize, Allocator* _allocator)
     : data(_data), refcount(0), elemsize(_elemsize), elempack(1), allocator(_allocator), dims(1), w(_w), h(1), c(1)
 {
     cstep = w;
 }
 
-inline Mat::Mat(int _w, int _h, void* _data, size_t _elemsize, Allocator* _allocator)
+NCNN_FORCEINLINE Mat::Mat(int _w, int _h, void* _data, size_t _elemsize, Allocator* _allocator)
     : data(_data), refcount(0), elemsize(_elemsize), elempack(1), allocator(_allocator), dims(2), w(_w), h(_h), c(1)
 {
     cstep = w * h;
 }
 
-inline Mat::Mat(int _w, int _h, int _c, void* _data, size_t _elemsize, Allocator* _allocator)
+NCNN_FORCEINLINE Mat::Mat(int _w, int _h, int _c, void* _data, size_t _elemsize, Allocator* _allocator)
     : data(_data), refcount(0), elemsize(_elemsize), elempack(1), allocator(_allocator), dims(3), w(_w), h(_h), c(_c)
 {
     cstep = alignSize(w * h * elemsize, 16) / elemsize;
 }
 
-inline Mat::Mat(int _w, void* _data, size_t _elemsize, int _elempack, Allocator* _allocator)
+NCNN_FORCEINLINE Mat::Mat(int _w, void* _data, size_t _elemsize, int _elempack, Allocator* _allocator)
     : data(_data), refcount(0), elemsize(_elemsize), elempack(_elempack), allocator(_allocator), dims(1), w(_w), h(1), c(1)
 {
     cstep = w;
 }
 
-inline Mat::Mat(int _w, int _h, void* _data, size_t _elemsize, int _elempack, Allocator* _allocator)
+NCNN_FORCEINLINE Mat::Mat(int _w, int _h, void* _data, size_t _elemsize, int _elempack, Allocator* _allocator)
     : data(_data), refcount(0), elemsize(_elemsize), elempack(_elempack), allocator(_allocator), dims(2), w(_w), h(_h), c(1)
 {
     cstep = w * h;
 }
 
-inline Mat::Mat(int _w, int _h, int _c, void* _data, size_t _elemsize, int _elempack, Allocator* _allocator)
+NCNN_FORCEINLINE Mat::Mat(int _w, int _h, int _c, void* _data, size_t _elemsize, int _elempack, Allocator* _allocator)
     : data(_data), refcount(0), elemsize(_elemsize), elempack(_elempack), allocator(_allocator), dims(3), w(_w), h(_h), c(_c)
 {
     cstep = alignSize(w * h * elemsize, 16) / elemsize;
 }
 
-inline Mat::~Mat()
+NCNN_FORCEINLINE Mat::~Mat()
 {
     release();
 }
 
-inline Mat& Mat::operator=(const Mat& m)
+NCNN_FORCEINLINE Mat& Mat::operator=(const Mat& m)
 {
     if (this == &m)
         return *this;
@@ -420,7 +450,7 @@ inline Mat& Mat::operator=(const Mat& m)
     return *this;
 }
 
-inline void Mat::fill(float _v)
+NCNN_FORCEINLINE void Mat::fill(float _v)
 {
     int size = (int)total();
     float* ptr = (float*)data;
@@ -474,7 +504,7 @@ inline void Mat::fill(float _v)
     }
 }
 
-inline void Mat::fill(int _v)
+NCNN_FORCEINLINE void Mat::fill(int _v)
 {
     int size = (int)total();
     int* ptr = (int*)data;
@@ -529,7 +559,7 @@ inline void Mat::fill(int _v)
 }
 
 #if __ARM_NEON
-inline void Mat::fill(float32x4_t _v)
+NCNN_FORCEINLINE void Mat::fill(float32x4_t _v)
 {
     int size = total();
     float* ptr = (float*)data;
@@ -542,7 +572,7 @@ inline void Mat::fill(float32x4_t _v)
 #endif // __ARM_NEON
 
 template <typename T>
-inline void Mat::fill(T _v)
+NCNN_FORCEINLINE void Mat::fill(T _v)
 {
     int size = total();
     T* ptr = (T*)data;
@@ -552,7 +582,7 @@ inline void Mat::fill(T _v)
     }
 }
 
-inline Mat Mat::clone(Allocator* allocator) const
+NCNN_FORCEINLINE Mat Mat::clone(Allocator* allocator) const
 {
     if (empty())
         return Mat();
@@ -573,7 +603,7 @@ inline Mat Mat::clone(Allocator* allocator) const
     return m;
 }
 
-inline Mat Mat::reshape(int _w, Allocator* _allocator) const
+NCNN_FORCEINLINE Mat Mat::reshape(int _w, Allocator* _allocator) const
 {
     if (w * h * c != _w)
         return Mat();
@@ -606,7 +636,7 @@ inline Mat Mat::reshape(int _w, Allocator* _allocator) const
     return m;
 }
 
-inline Mat Mat::reshape(int _w, int _h, Allocator* _allocator) const
+NCNN_FORCEINLINE Mat Mat::reshape(int _w, int _h, Allocator* _allocator) const
 {
     if (w * h * c != _w * _h)
         return Mat();
@@ -639,49 +669,45 @@ inline Mat Mat::reshape(int _w, int _h, Allocator* _allocator) const
     return m;
 }
 
-inline Mat Mat::reshape(int _w, int _h, int _c, Allocator* _allocator) const
+// bytes mat_data_alloc asks the allocator for, totalsize bytes of data and the trailer
+static inline size_t mat_data_alloc_size(size_t totalsize)
 {
-    if (w * h * c != _w * _h * _c)
-        return Mat();
+    return alignSize(totalsize, sizeof(void*)) + sizeof(void*) * 3;
+}
 
-    if (dims < 3)
-    {
-        if ((size_t)_w * _h != alignSize(_w * _h * elemsize, 16) / elemsize)
-        {
-            Mat m;
-            m.create(_w, _h, _c, elemsize, elempack, _allocator);
-
-            // align channel
-            for (int i=0; i<_c; i++)
-            {
-                const void* ptr = (unsigned char*)data + i * _w * _h * elemsize;
-                void* mptr = (unsigned char*)m.data + i * m.cstep * m.elemsize;
-                memcpy(mptr, ptr, _w * _h * elemsize);
-            }
-
-            return m;
-        }
-    }
-    else if (c != _c)
-    {
-        // flatten and then align
-        Mat tmp = reshape(_w * _h * _c, _allocator);
-        return tmp.reshape(_w, _h, _c, _allocator);
-    }
+// allocate totalsize bytes of mat data with the reference counter behind them
+// the counter is followed by the start of the allocation and by totalsize,
+// so a range reference sharing the counter frees and counts the whole buffer
+// when it is the last holder
+static inline void* mat_data_alloc(size_t totalsize, Allocator* allocator, int*& refcount)
+{
+    size_t refcount_offset = alignSize(totalsize, sizeof(void*));
+    size_t size = mat_data_alloc_size(totalsize);
 
-    Mat m = *this;
+    unsigned char* data = (unsigned char*)(allocator ? allocator->fastMalloc(size) : fastMalloc(size));
+    refcount = (int*)(data + refcount_offset);
+    *refcount = 1;
+    ((void**)refcount)[1] = data;
+    *(size_t*)((unsigned char*)refcount + sizeof(void*) * 2) = totalsize;
 
-    m.dims = 3;
-    m.w = _w;
-    m.h = _h;
-    m.c = _c;
+    count_malloc(totalsize);
 
-    m.cstep = alignSize(_w * _h * elemsize, 16) / elemsize;
+    return data;
+}
 
-    return m;
+static inline void mat_data_free(int* refcount, Allocator* allocator)
+{
+    void* data = ((void**)refcount)[1];
+
+    count_free(*(const size_t*)((const unsigned char*)refcount + sizeof(void*) * 2));
+
+    if (allocator)
+        allocator->fastFree(data);
+    else
+        fastFree(data);
 }
 
-inline void Mat::create(int _w, size_t _elemsize, Allocator* _allocator)
+NCNN_FORCEINLINE void Mat::create(int _w, size_t _elemsize, Allocator* _allocator)
 {
     if (dims == 1 && w == _w && elemsize == _elemsize && elempack == 1 && allocator == _allocator)
         return;
@@ -702,16 +728,11 @@ inline void Mat::create(int _w, size_t _elemsize, Allocator* _allocator)
     if (total() > 0)
     {
         size_t totalsize = alignSize(total() * elemsize, 4);
-        if (allocator)
-            data = allocator->fastMalloc(totalsize + (int)sizeof(*refcount));
-        else
-            data = fastMalloc(totalsize + (int)sizeof(*refcount));
-        refcount = (int*)(((unsigned char*)data) + totalsize);
-        *refcount = 1;
+        data = mat_data_alloc(totalsize, allocator, refcount);
     }
 }
 
-inline void Mat::create(int _w, int _h, size_t _elemsize, Allocator* _allocator)
+NCNN_FORCEINLINE void Mat::create(int _w, int _h, size_t _elemsize, Allocator* _allocator)
 {
     if (dims == 2 && w == _w && h == _h && elemsize == _elemsize && elempack == 1 && allocator == _allocator)
         return;
@@ -732,16 +753,11 @@ inline void Mat::create(int _w, int _h, size_t _elemsize, Allocator* _allocator)
     if (total() > 0)
     {
         size_t totalsize = alignSize(total() * elemsize, 4);
-        if (allocator)
-            data = allocator->fastMalloc(totalsize + (int)sizeof(*refcount));
-        else
-            data = fastMalloc(totalsize + (int)sizeof(*refcount));
-        refcount = (int*)(((unsigned char*)data) + totalsize);
-        *refcount = 1;
+        data = mat_data_alloc(totalsize, allocator, refcount);
     }
 }
 
-inline void Mat::create(int _w, int _h, int _c, size_t _elemsize, Allocator* _allocator)
+NCNN_FORCEINLINE void Mat::create(int _w, int _h, int _c, size_t _elemsize, Allocator* _allocator)
 {
     if (dims == 3 && w == _w && h == _h && c == _c && elemsize == _elemsize && elempack == 1 && allocator == _allocator)
         return;
@@ -762,16 +778,11 @@ inline void Mat::create(int _w, int _h, int _c, size_t _elemsize, Allocator* _al
     if (total() > 0)
     {
         size_t totalsize = alignSize(total() * elemsize, 4);
-        if (allocator)
-            data = allocator->fastMalloc(totalsize + (int)sizeof(*refcount));
-        else
-            data = fastMalloc(totalsize + (int)sizeof(*refcount));
-        refcount = (int*)(((unsigned char*)data) + totalsize);
-        *refcount = 1;
+        data = mat_data_alloc(totalsize, allocator, refcount);
     }
 }
 
-inline void Mat::create(int _w, size_t _elemsize, int _elempack, Allocator* _allocator)
+NCNN_FORCEINLINE void Mat::create(int _w, size_t _elemsize, int _elempack, Allocator* _allocator)
 {
     if (dims == 1 && w == _w && elemsize == _elemsize && elempack == _elempack && allocator == _allocator)
         return;
@@ -792,16 +803,11 @@ inline void Mat::create(int _w, size_t _elemsize, int _elempack, Allocator* _all
     if (total() > 0)
     {
         size_t totalsize = alignSize(total() * elemsize, 4);
-        if (allocator)
-            data = allocator->fastMalloc(totalsize + (int)sizeof(*refcount));
-        else
-            data = fastMalloc(totalsize + (int)sizeof(*refcount));
-        refcount = (int*)(((unsigned char*)data) + totalsize);
-        *refcount = 1;
+        data = mat_data_alloc(totalsize, allocator, refcount);
     }
 }
 
-inline void Mat::create(int _w, int _h, size_t _elemsize, int _elempack, Allocator* _allocator)
+NCNN_FORCEINLINE void Mat::create(int _w, int _h, size_t _elemsize, int _elempack, Allocator* _allocator)
 {
     if (dims == 2 && w == _w && h == _h && elemsize == _elemsize && elempack == _elempack && allocator == _allocator)
         return;
@@ -822,16 +828,11 @@ inline void Mat::create(int _w, int _h, size_t _elemsize, int _elempack, Allocat
     if (total() > 0)
     {
         size_t totalsize = alignSize(total() * elemsize, 4);
-        if (allocator)
-            data = allocator->fastMalloc(totalsize + (int)sizeof(*refcount));
-        else
-            data = fastMalloc(totalsize + (int)sizeof(*refcount));
-        refcount = (int*)(((unsigned char*)data) + totalsize);
-        *refcount = 1;
+        data = mat_data_alloc(totalsize, allocator, refcount);
     }
 }
 
-inline void Mat::create(int _w, int _h, int _c, size_t _elemsize, int _elempack, Allocator* _allocator)
+NCNN_FORCEINLINE void Mat::create(int _w, int _h, int _c, size_t _elemsize, int _elempack, Allocator* _allocator)
 {
     if (dims == 3 && w == _w && h == _h && c == _c && elemsize == _elemsize && elempack == _elempack && allocator == _allocator)
         return;
@@ -852,16 +853,11 @@ inline void Mat::create(int _w, int _h, int _c, size_t _elemsize, int _elempack,
     if (total() > 0)
     {
         size_t totalsize = alignSize(total() * elemsize, 4);
-        if (allocator)
-            data = allocator->fastMalloc(totalsize + (int)sizeof(*refcount));
-        else
-            data = fastMalloc(totalsize + (int)sizeof(*refcount));
-        refcount = (int*)(((unsigned char*)data) + totalsize);
-        *refcount = 1;
+        data = mat_data_alloc(totalsize, allocator, refcount);
     }
 }
 
-inline void Mat::create_like(const Mat& m, Allocator* _allocator)
+NCNN_FORCEINLINE void Mat::create_like(const Mat& m, Allocator* _allocator)
 {
     int _dims = m.dims;
     if (_dims == 1)
@@ -872,20 +868,17 @@ inline void Mat::create_like(const Mat& m, Allocator* _allocator)
         create(m.w, m.h, m.c, m.elemsize, m.elempack, _allocator);
 }
 
-inline void Mat::addref()
+NCNN_FORCEINLINE void Mat::addref()
 {
     if (refcount)
         NCNN_XADD(refcount, 1);
 }
 
-inline void Mat::release()
+NCNN_FORCEINLINE void Mat::release()
 {
     if (refcount && NCNN_XADD(refcount, -1) == 1)
     {
-        if (allocator)
-            allocator->fastFree(data);
-        else
-            fastFree(data);
+        mat_data_free(refcount, allocator);
     }
 
     data = 0;
@@ -903,17 +896,17 @@ inline void Mat::release()
     refcount = 0;
 }
 
-inline bool Mat::empty() const
+NCNN_FORCEINLINE bool Mat::empty() const
 {
     return data == 0 || total() == 0;
 }
 
-inline size_t Mat::total() const
+NCNN_FORCEINLINE size_t Mat::total() const
 {
     return cstep * c;
 }
 
-inline Mat Mat::shape() const
+NCNN_FORCEINLINE Mat Mat::shape() const
 {
     if (dims == 1)
         return Mat(w * elempack, (void*)0);
@@ -925,86 +918,134 @@ inline Mat Mat::shape() const
     return Mat();
 }
 
-inline Mat Mat::channel(int _c)
+NCNN_FORCEINLINE Mat Mat::channel(int _c)
 {
     return Mat(w, h, (unsigned char*)data + cstep * _c * elemsize, elemsize, elempack, allocator);
 }
 
-inline const Mat Mat::channel(int _c) const
+NCNN_FORCEINLINE const Mat Mat::channel(int _c) const
 {
     return Mat(w, h, (unsigned char*)data + cstep * _c * elemsize, elemsize, elempack, allocator);
 }
 
-inline float* Mat::row(int y)
+NCNN_FORCEINLINE float* Mat::row(int y)
 {
     return (float*)((unsigned char*)data + w * y * elemsize);
 }
 
-inline const float* Mat::row(int y) const
+NCNN_FORCEINLINE const float* Mat::row(int y) const
 {
     return (const float*)((unsigned char*)data + w * y * elemsize);
 }
 
 template <typename T>
-inline T* Mat::row(int y)
+NCNN_FORCEINLINE T* Mat::row(int y)
 {
     return (T*)((unsigned char*)data + w * y * elemsize);
 }
 
 template <typename T>
-inline const T* Mat::row(int y) const
+NCNN_FORCEINLINE const T* Mat::row(int y) const
 {
     return (const T*)((unsigned char*)data + w * y * elemsize);
 }
 
-inline Mat Mat::channel_range(int _c, int channels)
+NCNN_FORCEINLINE Mat Mat::channel_range(int _c, int channels)
 {
     return Mat(w, h, channels, (unsigned char*)data + cstep * _c * elemsize, elemsize, elempack, allocator);
 }
 
-inline const Mat Mat::channel_range(int _c, int channels) const
+NCNN_FORCEINLINE const Mat Mat::channel_range(int _c, int channels) const
 {
     return Mat(w, h, channels, (unsigned char*)data + cstep * _c * elemsize, elemsize, elempack, allocator);
 }
 
-inline Mat Mat::row_range(int y, int rows)
+NCNN_FORCEINLINE Mat Mat::row_range(int y, int rows)
 {
     return Mat(w, rows, (unsigned char*)data + w * y * elemsize, elemsize, elempack, allocator);
 }
 
-inline const Mat Mat::row_range(int y, int rows) const
+NCNN_FORCEINLINE const Mat Mat::row_range(int y, int rows) const
 {
     return Mat(w, rows, (unsigned char*)data + w * y * elemsize, elemsize, elempack, allocator);
 }
 
-inline Mat Mat::range(int x, int n)
+NCNN_FORCEINLINE Mat Mat::range(int x, int n)
 {
     return Mat(n, (unsigned char*)data + x * elemsize, elemsize, elempack, allocator);
 }
 
-inline const Mat Mat::range(int x, int n) const
+NCNN_FORCEINLINE const Mat Mat::range(int x, int n) const
 {
     return Mat(n, (unsigned char*)data + x * elemsize, elemsize, elempack, allocator);
 }
 
+NCNN_FORCEINLINE Mat Mat::shared_channel_range(int _c, int channels)
+{
+    Mat m = channel_range(_c, channels);
+    m.refcount = refcount;
+    m.addref();
+    return m;
+}
+
+NCNN_FORCEINLINE const Mat Mat::shared_channel_range(int _c, int channels) const
+{
+    Mat m = channel_range(_c, channels);
+    m.refcount = refcount;
+    m.addref();
+    return m;
+}
+
+NCNN_FORCEINLINE Mat Mat::shared_row_range(int y, int rows)
+{
+    Mat m = row_range(y, rows);
+    m.refcount = refcount;
+    m.addref();
+    return m;
+}
+
+NCNN_FORCEINLINE const Mat Mat::shared_row_range(int y, int rows) const
+{
+    Mat m = row_range(y, rows);
+    m.refcount = refcount;
+    m.addref();
+    return m;
+}
+
+NCNN_FORCEINLINE Mat Mat::shared_range(int x, int n)
+{
+    Mat m = range(x, n);
+    m.refcount = refcount;
+    m.addref();
+    return m;
+}
+
+NCNN_FORCEINLINE const Mat Mat::shared_range(int x, int n) const
+{
+    Mat m = range(x, n);
+    m.refcount = refcount;
+    m.addref();
+    return m;
+}
+
 template <typename T>
-inline Mat::operator T*()
+NCNN_FORCEINLINE Mat::operator T*()
 {
     return (T*)data;
 }
 
 template <typename T>
-inline Mat::operator const T*() const
+NCNN_FORCEINLINE Mat::operator const T*() const
 {
     return (const T*)data;
 }
 
-inline float& Mat::operator[](size_t i)
+NCNN_FORCEINLINE float& Mat::operator[](size_t i)
 {
     return ((float*)data)[i];
 }
 
-inline const float& Mat::operator[](size_t i) const
+NCNN_FORCEINLINE const float& Mat::operator[](size_t i) const
 {
     return ((const float*)data)[i];
 }
@@ -15,15 +15,237 @@
 #include "mat.h"
 #include <limits.h>
 #include <math.h>
+#include <string.h>
 #include <algorithm>
 #if __ARM_NEON
 #include <arm_neon.h>
 #endif // __ARM_NEON
+#if __SSE2__
+#include <emmintrin.h>
+#if __SSSE3__
+#include <tmmintrin.h>
+#endif // __SSSE3__
+#if __AVX__
+#include <immintrin.h>
+#endif // __AVX__
+#endif // __SSE2__
 #include "platform.h"
 
 #include "cstl/utils.h"
 
 #if NCNN_PIXEL
+#if __SSE2__
+// widen 16 bytes to floats
+static inline void store_u8_as_ps(float* ptr, __m128i _v)
+{
+#if __AVX2__
+    _mm256_storeu_ps(ptr, _mm256_cvtepi32_ps(_mm256_cvtepu8_epi32(_v)));
+    _mm256_storeu_ps(ptr+8, _mm256_cvtepi32_ps(_mm256_cvtepu8_epi32(_mm_unpackhi_epi64(_v, _v))));
+#else
+    __m128i _zero = _mm_setzero_si128();
+    __m128i _v16_0 = _mm_unpacklo_epi8(_v, _zero);
+    __m128i _v16_1 = _mm_unpackhi_epi8(_v, _zero);
+    _mm_storeu_ps(ptr, _mm_cvtepi32_ps(_mm_unpacklo_epi16(_v16_0, _zero)));
+    _mm_storeu_ps(ptr+4, _mm_cvtepi32_ps(_mm_unpackhi_epi16(_v16_0, _zero)));
+    _mm_storeu_ps(ptr+8, _mm_cvtepi32_ps(_mm_unpacklo_epi16(_v16_1, _zero)));
+    _mm_storeu_ps(ptr+12, _mm_cvtepi32_ps(_mm_unpackhi_epi16(_v16_1, _zero)));
+#endif // __AVX2__
+}
+
+// widen 8 unsigned shorts to floats
+static inline void store_u16_as_ps(float* ptr, __m128i _v)
+{
+    __m128i _zero = _mm_setzero_si128();
+    _mm_storeu_ps(ptr, _mm_cvtepi32_ps(_mm_unpacklo_epi16(_v, _zero)));
+    _mm_storeu_ps(ptr+4, _mm_cvtepi32_ps(_mm_unpackhi_epi16(_v, _zero)));
+}
+
+// 16 floats to bytes, truncated and saturated like SATURATE_CAST_UCHAR
+static inline __m128i load_ps_as_u8(const float* ptr)
+{
+#if __AVX__
+    __m256i _v01 = _mm256_cvttps_epi32(_mm256_loadu_ps(ptr));
+    __m256i _v23 = _mm256_cvttps_epi32(_mm256_loadu_ps(ptr+8));
+    __m128i _v0 = _mm256_castsi256_si128(_v01);
+    __m128i _v1 = _mm256_extractf128_si256(_v01, 1);
+    __m128i _v2 = _mm256_castsi256_si128(_v23);
+    __m128i _v3 = _mm256_extractf128_si256(_v23, 1);
+#else
+    __m128i _v0 = _mm_cvttps_epi32(_mm_loadu_ps(ptr));
+    __m128i _v1 = _mm_cvttps_epi32(_mm_loadu_ps(ptr+4));
+    __m128i _v2 = _mm_cvttps_epi32(_mm_loadu_ps(ptr+8));
+    __m128i _v3 = _mm_cvttps_epi32(_mm_loadu_ps(ptr+12));
+#endif // __AVX__
+    return _mm_packus_epi16(_mm_packs_epi32(_v0, _v1), _mm_packs_epi32(_v2, _v3));
+}
+
+// (byte0 * W0 + byte1 * W1 + byte2 * W2) >> Y_shift of 8 pixels of 4 bytes, widened to floats
+// bytes 0 2 and bytes 1 3 make pairs of shorts, madd weighs and sums each pair
+static inline void store_c4_u8_gray_as_ps(float* ptr, const unsigned char* p, int W0, int W1, int W2, int Y_shift)
+{
+#if __AVX2__
+    __m256i _mask = _mm256_set1_epi32(0x00ff00ff);
+    __m256i _v = _mm256_loadu_si256((const __m256i*)p);
+    __m256i _v02 = _mm256_and_si256(_v, _mask);
+    __m256i _v13 = _mm256_and_si256(_mm256_srli_epi32(_v, 8), _mask);
+    __m256i _y = _mm256_add_epi32(_mm256_madd_epi16(_v02, _mm256_set1_epi32((W2 << 16) | W0)), _mm256_madd_epi16(_v13, _mm256_set1_epi32(W1)));
+    _mm256_storeu_ps(ptr, _mm256_cvtepi32_ps(_mm256_srli_epi32(_y, Y_shift)));
+#else
+    __m128i _mask = _mm_set1_epi32(0x00ff00ff);
+    __m128i _W02 = _mm_set1_epi32((W2 << 16) | W0);
+    __m128i _W13 = _mm_set1_epi32(W1);
+    for (int i=0; i<2; i++)
+    {
+        __m128i _v = _mm_loadu_si128((const __m128i*)(p + i*16));
+        __m128i _v02 = _mm_and_si128(_v, _mask);
+        __m128i _v13 = _mm_and_si128(_mm_srli_epi32(_v, 8), _mask);
+        __m128i _y = _mm_add_epi32(_mm_madd_epi16(_v02, _W02), _mm_madd_epi16(_v13, _W13));
+        _mm_storeu_ps(ptr + i*4, _mm_cvtepi32_ps(_mm_srli_epi32(_y, Y_shift)));
+    }
+#endif // __AVX2__
+}
+
+#if !__SSSE3__
+// one round of the byte transpose network, interleaves register j with register j+n/2
+// repeating it gathers every cn-th byte together
+static inline void unpack_round_u8(__m128i* _v, int n)
+{
+    __m128i _t[6];
+    for (int j=0; j<n/2; j++)
+    {
+        _t[j*2] = _mm_unpacklo_epi8(_v[j], _v[j+n/2]);
+        _t[j*2+1] = _mm_unpackhi_epi8(_v[j], _v[j+n/2]);
+    }
+    for (int j=0; j<n; j++)
+    {
+        _v[j] = _t[j];
+    }
+}
+#endif // !__SSSE3__
+
+// 32 pixels of 3 bytes, _v[0] _v[1] get channel 0, _v[2] _v[3] channel 1, _v[4] _v[5] channel 2
+static inline void load_deinterleave_c3_u8(const unsigned char* p, __m128i* _v)
+{
+#if __SSSE3__
+    for (int i=0; i<2; i++)
+    {
+        __m128i _a = _mm_loadu_si128((const __m128i*)(p + i*48));
+        __m128i _b = _mm_loadu_si128((const __m128i*)(p + i*48 + 16));
+        __m128i _c = _mm_loadu_si128((const __m128i*)(p + i*48 + 32));
+
+        __m128i _c0 = _mm_shuffle_epi8(_a, _mm_setr_epi8(0, 3, 6, 9, 12, 15, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1));
+        _c0 = _mm_or_si128(_c0, _mm_shuffle_epi8(_b, _mm_setr_epi8(-1, -1, -1, -1, -1, -1, 2, 5, 8, 11, 14, -1, -1, -1, -1, -1)));
+        _c0 = _mm_or_si128(_c0, _mm_shuffle_epi8(_c, _mm_setr_epi8(-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, 1, 4, 7, 10, 13)));
+
+        __m128i _c1 = _mm_shuffle_epi8(_a, _mm_setr_epi8(1, 4, 7, 10, 13, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1));
+        _c1 = _mm_or_si128(_c1, _mm_shuffle_epi8(_b, _mm_setr_epi8(-1, -1, -1, -1, -1, 0, 3, 6, 9, 12, 15, -1, -1, -1, -1, -1)));
+        _c1 = _mm_or_si128(_c1, _mm_shuffle_epi8(_c, _mm_setr_epi8(-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, 2, 5, 8, 11, 14)));
+
+        __m128i _c2 = _mm_shuffle_epi8(_a, _mm_setr_epi8(2, 5, 8, 11, 14, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1));
+        _c2 = _mm_or_si128(_c2, _mm_shuffle_epi8(_b, _mm_setr_epi8(-1, -1, -1, -1, -1, 1, 4, 7, 10, 13, -1, -1, -1, -1, -1, -1)));
+        _c2 = _mm_or_si128(_c2, _mm_shuffle_epi8(_c, _mm_setr_epi8(-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, 0, 3, 6, 9, 12, 15)));
+
+        _v[i] = _c0;
+        _v[2 + i] = _c1;
+        _v[4 + i] = _c2;
+    }
+#else
+    for (int j=0; j<6; j++)
+    {
+        _v[j] = _mm_loadu_si128((const __m128i*)(p + j*16));
+    }
+    for (int k=0; k<5; k++)
+    {
+        unpack_round_u8(_v, 6);
+    }
+#endif // __SSSE3__
+}
+
+static inline void store_interleave_c4_u8(unsigned char* p, __m128i _c0, __m128i _c1, __m128i _c2, __m128i _c3)
+{
+    __m128i _c01_0 = _mm_unpacklo_epi8(_c0, _c1);
+    __m128i _c01_1 = _mm_unpackhi_epi8(_c0, _c1);
+    __m128i _c23_0 = _mm_unpacklo_epi8(_c2, _c3);
+    __m128i _c23_1 = _mm_unpackhi_epi8(_c2, _c3);
+    _mm_storeu_si128((__m128i*)p, _mm_unpacklo_epi16(_c01_0, _c23_0));
+    _mm_storeu_si128((__m128i*)(p + 16), _mm_unpackhi_epi16(_c01_0, _c23_0));
+    _mm_storeu_si128((__m128i*)(p + 32), _mm_unpacklo_epi16(_c01_1, _c23_1));
+    _mm_storeu_si128((__m128i*)(p + 48), _mm_unpackhi_epi16(_c01_1, _c23_1));
+}
+
+#if __SSSE3__
+static inline void store_interleave_c3_u8(unsigned char* p, __m128i _c0, __m128i _c1, __m128i _c2)
+{
+    __m128i _a = _mm_shuffle_epi8(_c0, _mm_setr_epi8(0, -1, -1, 1, -1, -1, 2, -1, -1, 3, -1, -1, 4, -1, -1, 5));
+    _a = _mm_or_si128(_a, _mm_shuffle_epi8(_c1, _mm_setr_epi8(-1, 0, -1, -1, 1, -1, -1, 2, -1, -1, 3, -1, -1, 4, -1, -1)));
+    _a = _mm_or_si128(_a, _mm_shuffle_epi8(_c2, _mm_setr_epi8(-1, -1, 0, -1, -1, 1, -1, -1, 2, -1, -1, 3, -1, -1, 4, -1)));
+
+    __m128i _b = _mm_shuffle_epi8(_c0, _mm_setr_epi8(-1, -1, 6, -1, -1, 7, -1, -1, 8, -1, -1, 9, -1, -1, 10, -1));
+    _b = _mm_or_si128(_b, _mm_shuffle_epi8(_c1, _mm_setr_epi8(5, -1, -1, 6, -1, -1, 7, -1, -1, 8, -1, -1, 9, -1, -1, 10)));
+    _b = _mm_or_si128(_b, _mm_shuffle_epi8(_c2, _mm_setr_epi8(-1, 5, -1, -1, 6, -1, -1, 7, -1, -1, 8, -1, -1, 9, -1, -1)));
+
+    __m128i _c = _mm_shuffle_epi8(_c0, _mm_setr_epi8(-1, 11, -1, -1, 12, -1, -1, 13, -1, -1, 14, -1, -1, 15, -1, -1));
+    _c = _mm_or_si128(_c, _mm_shuffle_epi8(_c1, _mm_setr_epi8(-1, -1, 11, -1, -1, 12, -1, -1, 13, -1, -1, 14, -1, -1, 15, -1)));
+    _c = _mm_or_si128(_c, _mm_shuffle_epi8(_c2, _mm_setr_epi8(10, -1, -1, 11, -1, -1, 12, -1, -1, 13, -1, -1, 14, -1, -1, 15)));
+
+    _mm_storeu_si128((__m128i*)p, _a);
+    _mm_storeu_si128((__m128i*)(p + 16), _b);
+    _mm_storeu_si128((__m128i*)(p + 32), _c);
+}
+#else
+// drop the 4th byte of 4 pixels and store the 12 bytes left
+static inline void store_c4_as_c3_u8(unsigned char* p, __m128i _v)
+{
+    // 6 bytes at the bottom of each 64bit half
+    __m128i _lo = _mm_and_si128(_v, _mm_set_epi32(0, 0x00ffffff, 0, 0x00ffffff));
+    __m128i _hi = _mm_and_si128(_mm_srli_epi64(_v, 8), _mm_set_epi32(0x0000ffff, 0xff000000, 0x0000ffff, 0xff000000));
+    __m128i _t = _mm_or_si128(_lo, _hi);
+
+    // close the gap between the halves
+    __m128i _t0 = _mm_and_si128(_t, _mm_set_epi32(0, 0, 0x0000ffff, 0xffffffff));
+    __m128i _t1 = _mm_and_si128(_mm_srli_si128(_t, 2), _mm_set_epi32(0, 0xffffffff, 0xffff0000, 0));
+    _t = _mm_or_si128(_t0, _t1);
+
+    _mm_storel_epi64((__m128i*)p, _t);
+    int _t2 = _mm_cvtsi128_si32(_mm_srli_si128(_t, 8));
+    memcpy(p + 8, &_t2, 4);
+}
+
+static inline void store_interleave_c3_u8(unsigned char* p, __m128i _c0, __m128i _c1, __m128i _c2)
+{
+    __m128i _zero = _mm_setzero_si128();
+    __m128i _c01_0 = _mm_unpacklo_epi8(_c0, _c1);
+    __m128i _c01_1 = _mm_unpackhi_epi8(_c0, _c1);
+    __m128i _c2x_0 = _mm_unpacklo_epi8(_c2, _zero);
+    __m128i _c2x_1 = _mm_unpackhi_epi8(_c2, _zero);
+    store_c4_as_c3_u8(p, _mm_unpacklo_epi16(_c01_0, _c2x_0));
+    store_c4_as_c3_u8(p + 12, _mm_unpackhi_epi16(_c01_0, _c2x_0));
+    store_c4_as_c3_u8(p + 24, _mm_unpacklo_epi16(_c01_1, _c2x_1));
+    store_c4_as_c3_u8(p + 36, _mm_unpackhi_epi16(_c01_1, _c2x_1));
+}
+#endif // __SSSE3__
+
+// gray = (r * R2Y + g * G2Y + b * B2Y) >> Y_shift of 16 pixels, widened to floats
+static inline void store_rgb2gray_as_ps(float* ptr, __m128i _r, __m128i _g, __m128i _b, int R2Y, int G2Y, int B2Y, int Y_shift)
+{
+    __m128i _zero = _mm_setzero_si128();
+    __m128i _R2Y = _mm_set1_epi16(R2Y);
+    __m128i _G2Y = _mm_set1_epi16(G2Y);
+    __m128i _B2Y = _mm_set1_epi16(B2Y);
+
+    // the weights sum to 1 << Y_shift, so the sums fit unsigned shorts
+    __m128i _y16_0 = _mm_mullo_epi16(_mm_unpacklo_epi8(_r, _zero), _R2Y);
+    __m128i _y16_1 = _mm_mullo_epi16(_mm_unpackhi_epi8(_r, _zero), _R2Y);
+    _y16_0 = _mm_add_epi16(_y16_0, _mm_mullo_epi16(_mm_unpacklo_epi8(_g, _zero), _G2Y));
+    _y16_1 = _mm_add_epi16(_y16_1, _mm_mullo_epi16(_mm_unpackhi_epi8(_g, _zero), _G2Y));
+    _y16_0 = _mm_add_epi16(_y16_0, _mm_mullo_epi16(_mm_unpacklo_epi8(_b, _zero), _B2Y));
+    _y16_1 = _mm_add_epi16(_y16_1, _mm_mullo_epi16(_mm_unpackhi_epi8(_b, _zero), _B2Y));
+
+    store_u16_as_ps(ptr, _mm_srli_epi16(_y16_0, Y_shift));
+    store_u16_as_ps(ptr+8, _mm_srli_epi16(_y16_1, Y_shift));
+}
+#endif // __SSE2__
+
 static int from_rgb(const unsigned char* rgb, int w, int h, int stride, Mat& m, Allocator* allocator)
 {
     m.create(w, h, 3, 4u, allocator);
@@ -46,6 +268,9 @@ static int from_rgb(const unsigned char* rgb, int w, int h, int stride, Mat& m,
 #if __ARM_NEON
         int nn = w >> 3;
         int remain = w - (nn << 3);
+#elif __SSE2__
+        int nn = w >> 5;
+        int remain = w - (nn << 5);
 #else
         int remain = w;
 #endif // __ARM_NEON
@@ -119,6 +344,24 @@ static int from_rgb(const unsigned char* rgb, int w, int h, int stride, Mat& m,
         );
         }
 #endif // __aarch64__
+#elif __SSE2__
+        for (; nn>0; nn--)
+        {
+            __m128i _rgb[6];
+            load_deinterleave_c3_u8(rgb, _rgb);
+
+            store_u8_as_ps(ptr0, _rgb[0]);
+            store_u8_as_ps(ptr0+16, _rgb[1]);
+            store_u8_as_ps(ptr1, _rgb[2]);
+            store_u8_as_ps(ptr1+16, _rgb[3]);
+            store_u8_as_ps(ptr2, _rgb[4]);
+            store_u8_as_ps(ptr2+16, _rgb[5]);
+
+            rgb += 3*32;
+            ptr0 += 32;
+            ptr1 += 32;
+            ptr2 += 32;
+        }
 #endif // __ARM_NEON
         for (; remain>0; remain--)
         {
@@ -161,6 +404,9 @@ static void to_rgb(const Mat& m, unsigned char* rgb, int stride)
 #if __ARM_NEON
         int nn = w >> 3;
         int remain = w - (nn << 3);
+#elif __SSE2__
+        int nn = w >> 4;
+        int remain = w - (nn << 4);
 #else
         int remain = w;
 #endif // __ARM_NEON
@@ -191,6 +437,20 @@ static void to_rgb(const Mat& m, unsigned char* rgb, int stride)
             ptr1 += 8;
             ptr2 += 8;
         }
+#elif __SSE2__
+        for (; nn>0; nn--)
+        {
+            __m128i _p0 = load_ps_as_u8(ptr0);
+            __m128i _p1 = load_ps_as_u8(ptr1);
+            __m128i _p2 = load_ps_as_u8(ptr2);
+
+            store_interleave_c3_u8(rgb, _p0, _p1, _p2);
+
+            rgb += 3*16;
+            ptr0 += 16;
+            ptr1 += 16;
+            ptr2 += 16;
+        }
 #endif // __ARM_NEON
         for (; remain>0; remain--)
         {
@@ -229,6 +489,9 @@ static int from_gray(const unsigned char* gray, int w, int h, int stride, Mat& m
 #if __ARM_NEON
         int nn = w >> 4;
         int remain = w - (nn << 4);
+#elif __SSE2__
+        int nn = w >> 4;
+        int remain = w - (nn << 4);
 #else
         int remain = w;
 #endif // __ARM_NEON
@@ -285,6 +548,14 @@ static int from_gray(const unsigned char* gray, int w, int h, int stride, Mat& m
         );
         }
 #endif // __aarch64__
+#elif __SSE2__
+        for (; nn>0; nn--)
+        {
+            store_u8_as_ps(ptr, _mm_loadu_si128((const __m128i*)gray));
+
+            gray += 16;
+            ptr += 16;
+        }
 #endif // __ARM_NEON
         for (; remain>0; remain--)
         {
@@ -321,6 +592,9 @@ static void to_gray(const Mat& m, unsigned char* gray, int stride)
 #if __ARM_NEON
         int nn = w >> 3;
         int remain = w - (nn << 3);
+#elif __SSE2__
+        int nn = w >> 4;
+        int remain = w - (nn << 4);
 #else
         int remain = w;
 #endif // __ARM_NEON
@@ -340,6 +614,14 @@ static void to_gray(const Mat& m, unsigned char* gray, int stride)
             gray += 8;
             ptr += 8;
         }
+#elif __SSE2__
+        for (; nn>0; nn--)
+        {
+            _mm_storeu_si128((__m128i*)gray, load_ps_as_u8(ptr));
+
+            gray += 16;
+            ptr += 16;
+        }
 #endif // __ARM_NEON
         for (; remain>0; remain--)
         {
@@ -509,6 +791,9 @@ static void to_rgba(const Mat& m, unsigned char* rgba, int stride)
 #if __ARM_NEON
         int nn = w >> 3;
         int remain = w - (nn << 3);
+#elif __SSE2__
+        int nn = w >> 4;
+        int remain = w - (nn << 4);
 #else
         int remain = w;
 #endif // __ARM_NEON
@@ -544,6 +829,22 @@ static void to_rgba(const Mat& m, unsigned char* rgba, int stride)
             ptr2 += 8;
             ptr3 += 8;
         }
+#elif __SSE2__
+        for (; nn>0; nn--)
+        {
+            __m128i _p0 = load_ps_as_u8(ptr0);
+            __m128i _p1 = load_ps_as_u8(ptr1);
+            __m128i _p2 = load_ps_as_u8(ptr2);
+            __m128i _p3 = load_ps_as_u8(ptr3);
+
+            store_interleave_c4_u8(rgba, _p0, _p1, _p2, _p3);
+
+            rgba += 4*16;
+            ptr0 += 16;
+            ptr1 += 16;
+            ptr2 += 16;
+            ptr3 += 16;
+        }
 #endif // __ARM_NEON
         for (; remain>0; remain--)
         {
@@ -586,6 +887,9 @@ static int from_rgb2bgr(const unsigned char* rgb, int w, int h, int stride, Mat&
 #if __ARM_NEON
         int nn = w >> 3;
         int remain = w - (nn << 3);
+#elif __SSE2__
+        int nn = w >> 5;
+        int remain = w - (nn << 5);
 #else
         int remain = w;
 #endif // __ARM_NEON
@@ -659,6 +963,24 @@ static int from_rgb2bgr(const unsigned char* rgb, int w, int h, int stride, Mat&
         );
         }
 #endif // __aarch64__
+#elif __SSE2__
+        for (; nn>0; nn--)
+        {
+            __m128i _rgb[6];
+            load_deinterleave_c3_u8(rgb, _rgb);
+
+            store_u8_as_ps(ptr0, _rgb[4]);
+            store_u8_as_ps(ptr0+16, _rgb[5]);
+            store_u8_as_ps(ptr1, _rgb[2]);
+            store_u8_as_ps(ptr1+16, _rgb[3]);
+            store_u8_as_ps(ptr2, _rgb[0]);
+            store_u8_as_ps(ptr2+16, _rgb[1]);
+
+            rgb += 3*32;
+            ptr0 += 32;
+            ptr1 += 32;
+            ptr2 += 32;
+        }
 #endif // __ARM_NEON
         for (; remain>0; remain--)
         {
@@ -701,6 +1023,9 @@ static void to_bgr2rgb(const Mat& m, unsigned char* rgb, int stride)
 #if __ARM_NEON
         int nn = w >> 3;
         int remain = w - (nn << 3);
+#elif __SSE2__
+        int nn = w >> 4;
+        int remain = w - (nn << 4);
 #else
         int remain = w;
 #endif // __ARM_NEON
@@ -731,6 +1056,20 @@ static void to_bgr2rgb(const Mat& m, unsigned char* rgb, int stride)
             ptr1 += 8;
             ptr2 += 8;
         }
+#elif __SSE2__
+        for (; nn>0; nn--)
+        {
+            __m128i _p0 = load_ps_as_u8(ptr0);
+            __m128i _p1 = load_ps_as_u8(ptr1);
+            __m128i _p2 = load_ps_as_u8(ptr2);
+
+            store_interleave_c3_u8(rgb, _p2, _p1, _p0);
+
+            rgb += 3*16;
+            ptr0 += 16;
+            ptr1 += 16;
+            ptr2 += 16;
+        }
 #endif // __ARM_NEON
         for (; remain>0; remain--)
         {
@@ -775,6 +1114,10 @@ static int from_rgb2gray(const unsigned char* rgb, int w, int h, int stride, Mat
 #if __ARM_NEON
         int nn = w >> 3;
         int remain = w - (nn << 3);
+#elif __SSE2__ && !__AVX2__
+        // the compiler vectorizes the plain loop better with avx2
+        int nn = w >> 5;
+        int remain = w - (nn << 5);
 #else
         int remain = w;
 #endif // __ARM_NEON
@@ -836,6 +1179,18 @@ static int from_rgb2gray(const unsigned char* rgb, int w, int h, int stride, Mat
         );
         }
 #endif // __aarch64__
+#elif __SSE2__ && !__AVX2__
+        for (; nn>0; nn--)
+        {
+            __m128i _rgb[6];
+            load_deinterleave_c3_u8(rgb, _rgb);
+
+            store_rgb2gray_as_ps(ptr, _rgb[0], _rgb[2], _rgb[4], R2Y, G2Y, B2Y, Y_shift);
+            store_rgb2gray_as_ps(ptr+16, _rgb[1], _rgb[3], _rgb[5], R2Y, G2Y, B2Y, Y_shift);
+
+            rgb += 3*32;
+            ptr += 32;
+        }
 #endif // __ARM_NEON
         for (; remain>0; remain--)
         {
@@ -889,6 +1244,9 @@ static void to_rgb2rgba(const Mat& m, unsigned char* rgba, int stride)
 #if __ARM_NEON
         int nn = w >> 3;
         int remain = w - (nn << 3);
+#elif __SSE2__
+        int nn = w >> 4;
+        int remain = w - (nn << 4);
 #else
         int remain = w;
 #endif // __ARM_NEON
@@ -921,6 +1279,21 @@ static void to_rgb2rgba(const Mat& m, unsigned char* rgba, int stride)
             ptr1 += 8;
             ptr2 += 8;
         }
+#elif __SSE2__
+        for (; nn>0; nn--)
+        {
+            __m128i _p0 = load_ps_as_u8(ptr0);
+            __m128i _p1 = load_ps_as_u8(ptr1);
+            __m128i _p2 = load_ps_as_u8(ptr2);
+            __m128i _v255 = _mm_set1_epi8((char)255);
+
+            store_interleave_c4_u8(rgba, _p0, _p1, _p2, _v255);
+
+            rgba += 4*16;
+            ptr0 += 16;
+            ptr1 += 16;
+            ptr2 += 16;
+        }
 #endif // __ARM_NEON
         for (; remain>0; remain--)
         {
@@ -966,6 +1339,10 @@ static int from_bgr2gray(const unsigned char* bgr, int w, int h, int stride, Mat
 #if __ARM_NEON
         int nn = w >> 3;
         int remain = w - (nn << 3);
+#elif __SSE2__ && !__AVX2__
+        // the compiler vectorizes the plain loop better with avx2
+        int nn = w >> 5;
+        int remain = w - (nn << 5);
 #else
         int remain = w;
 #endif // __ARM_NEON
@@ -1027,6 +1404,18 @@ static int from_bgr2gray(const unsigned char* bgr, int w, int h, int stride, Mat
         );
         }
 #endif // __aarch64__
+#elif __SSE2__ && !__AVX2__
+        for (; nn>0; nn--)
+        {
+            __m128i _bgr[6];
+            load_deinterleave_c3_u8(bgr, _bgr);
+
+            store_rgb2gray_as_ps(ptr, _bgr[4], _bgr[2], _bgr[0], R2Y, G2Y, B2Y, Y_shift);
+            store_rgb2gray_as_ps(ptr+16, _bgr[5], _bgr[3], _bgr[1], R2Y, G2Y, B2Y, Y_shift);
+
+            bgr += 3*32;
+            ptr += 32;
+        }
 #endif // __ARM_NEON
         for (; remain>0; remain--)
         {
@@ -1080,6 +1469,9 @@ static void to_bgr2rgba(const Mat& m, unsigned char* rgba, int stride)
 #if __ARM_NEON
         int nn = w >> 3;
         int remain = w - (nn << 3);
+#elif __SSE2__
+        int nn = w >> 4;
+        int remain = w - (nn << 4);
 #else
         int remain = w;
 #endif // __ARM_NEON
@@ -1112,6 +1504,21 @@ static void to_bgr2rgba(const Mat& m, unsigned char* rgba, int stride)
             ptr1 += 8;
             ptr2 += 8;
         }
+#elif __SSE2__
+        for (; nn>0; nn--)
+        {
+            __m128i _p0 = load_ps_as_u8(ptr0);
+            __m128i _p1 = load_ps_as_u8(ptr1);
+            __m128i _p2 = load_ps_as_u8(ptr2);
+            __m128i _v255 = _mm_set1_epi8((char)255);
+
+            store_interleave_c4_u8(rgba, _p2, _p1, _p0, _v255);
+
+            rgba += 4*16;
+            ptr0 += 16;
+            ptr1 += 16;
+            ptr2 += 16;
+        }
 #endif // __ARM_NEON
         for (; remain>0; remain--)
         {
@@ -1153,6 +1560,9 @@ static int from_gray2rgb(const unsigned char* gray, int w, int h, int stride, Ma
 #if __ARM_NEON
         int nn = w >> 4;
         int remain = w - (nn << 4);
+#elif __SSE2__
+        int nn = w >> 4;
+        int remain = w - (nn << 4);
 #else
         int remain = w;
 #endif // __ARM_NEON
@@ -1229,6 +1639,23 @@ static int from_gray2rgb(const unsigned char* gray, int w, int h, int stride, Ma
         );
         }
 #endif // __aarch64__
+#elif __SSE2__
+        for (; nn>0; nn--)
+        {
+            store_u8_as_ps(ptr0, _mm_loadu_si128((const __m128i*)gray));
+
+            for (int i=0; i<16; i+=4)
+            {
+                __m128 _gray = _mm_loadu_ps(ptr0 + i);
+                _mm_storeu_ps(ptr1 + i, _gray);
+                _mm_storeu_ps(ptr2 + i, _gray);
+            }
+
+            gray += 16;
+            ptr0 += 16;
+            ptr1 += 16;
+            ptr2 += 16;
+        }
 #endif // __ARM_NEON
         for (; remain>0; remain--)
         {
@@ -1284,6 +1711,9 @@ static void to_gray2rgba(const Mat& m, unsigned char* rgba, int stride)
 #if __ARM_NEON
         int nn = w >> 3;
         int remain = w - (nn << 3);
+#elif __SSE2__
+        int nn = w >> 4;
+        int remain = w - (nn << 4);
 #else
         int remain = w;
 #endif // __ARM_NEON
@@ -1310,6 +1740,17 @@ static void to_gray2rgba(const Mat& m, unsigned char* rgba, int stride)
             rgba += 4*8;
             ptr += 8;
         }
+#elif __SSE2__
+        for (; nn>0; nn--)
+        {
+            __m128i _gray = load_ps_as_u8(ptr);
+            __m128i _v255 = _mm_set1_epi8((char)255);
+
+            store_interleave_c4_u8(rgba, _gray, _gray, _gray, _v255);
+
+            rgba += 4*16;
+            ptr += 16;
+        }
 #endif // __ARM_NEON
         for (; remain>0; remain--)
         {
@@ -1582,6 +2023,9 @@ static int from_rgba2gray(const unsigned char* rgba, int w, int h, int stride, M
 #if __ARM_NEON
         int nn = w >> 3;
         int remain = w - (nn << 3);
+#elif __SSE2__
+        int nn = w >> 3;
+        int remain = w - (nn << 3);
 #else
         int remain = w;
 #endif // __ARM_NEON
@@ -1643,6 +2087,14 @@ static int from_rgba2gray(const unsigned char* rgba, int w, int h, int stride, M
         );
         }
 #endif // __aarch64__
+#elif __SSE2__
+        for (; nn>0; nn--)
+        {
+            store_c4_u8_gray_as_ps(ptr, rgba, R2Y, G2Y, B2Y, Y_shift);
+
+            rgba += 4*8;
+            ptr += 8;
+        }
 #endif // __ARM_NEON
         for (; remain>0; remain--)
         {
@@ -1813,6 +2265,9 @@ static void to_rgba2bgra(const Mat& m, unsigned char* bgra, int stride)
 #if __ARM_NEON
         int nn = w >> 3;
         int remain = w - (nn << 3);
+#elif __SSE2__
+        int nn = w >> 4;
+        int remain = w - (nn << 4);
 #else
         int remain = w;
 #endif // __ARM_NEON
@@ -1848,6 +2303,22 @@ static void to_rgba2bgra(const Mat& m, unsigned char* bgra, int stride)
             ptr2 += 8;
             ptr3 += 8;
         }
+#elif __SSE2__
+        for (; nn>0; nn--)
+        {
+            __m128i _p0 = load_ps_as_u8(ptr0);
+            __m128i _p1 = load_ps_as_u8(ptr1);
+            __m128i _p2 = load_ps_as_u8(ptr2);
+            __m128i _p3 = load_ps_as_u8(ptr3);
+
+            store_interleave_c4_u8(bgra, _p2, _p1, _p0, _p3);
+
+            bgra += 4*16;
+            ptr0 += 16;
+            ptr1 += 16;
+            ptr2 += 16;
+            ptr3 += 16;
+        }
 #endif // __ARM_NEON
         for (; remain>0; remain--)
         {
@@ -1894,6 +2365,9 @@ static int from_bgra2gray(const unsigned char* bgra, int w, int h, int stride, M
 #if __ARM_NEON
         int nn = w >> 3;
         int remain = w - (nn << 3);
+#elif __SSE2__
+        int nn = w >> 3;
+        int remain = w - (nn << 3);
 #else
         int remain = w;
 #endif // __ARM_NEON
@@ -1955,6 +2429,14 @@ static int from_bgra2gray(const unsigned char* bgra, int w, int h, int stride, M
         );
         }
 #endif // __aarch64__
+#elif __SSE2__
+        for (; nn>0; nn--)
+        {
+            store_c4_u8_gray_as_ps(ptr, bgra, B2Y, G2Y, R2Y, Y_shift);
+
+            bgra += 4*8;
+            ptr += 8;
+        }
 #endif // __ARM_NEON
         for (; remain>0; remain--)
         {
@@ -1981,6 +2463,12 @@ void yuv420sp2rgb(const unsigned char* yuv420sp, int w, int h, unsigned char* rg
     int8x8_t _v46 = vdup_n_s8(46);
     int8x8_t _v22 = vdup_n_s8(22);
     int8x8_t _v113 = vdup_n_s8(113);
+#elif __SSE2__
+    __m128i _v128 = _mm_set1_epi16(128);
+    __m128i _v90 = _mm_set1_epi16(90);
+    __m128i _v46 = _mm_set1_epi16(-46);
+    __m128i _v22 = _mm_set1_epi16(-22);
+    __m128i _v113 = _mm_set1_epi16(113);
 #endif // __ARM_NEON
 
     for (int y=0; y<h; y+=2)
@@ -1993,6 +2481,9 @@ void yuv420sp2rgb(const unsigned char* yuv420sp, int w, int h, unsigned char* rg
 #if __ARM_NEON
         int nn = w >> 3;
         int remain = w - (nn << 3);
+#elif __SSE2__
+        int nn = w >> 4;
+        int remain = w - (nn << 4);
 #else
         int remain = w;
 #endif // __ARM_NEON
@@ -2101,6 +2592,52 @@ void yuv420sp2rgb(const unsigned char* yuv420sp, int w, int h, unsigned char* rg
         );
         }
 #endif // __aarch64__
+#elif __SSE2__
+        for (; nn>0; nn--)
+        {
+            // 8 vu pairs shared by 16 pixels of both rows, all sums fit shorts
+            __m128i _zero = _mm_setzero_si128();
+            __m128i _vu = _mm_loadu_si128((const __m128i*)vuptr);
+            __m128i _vv = _mm_sub_epi16(_mm_and_si128(_vu, _mm_set1_epi16(0xff)), _v128);
+            __m128i _uu = _mm_sub_epi16(_mm_srli_epi16(_vu, 8), _v128);
+
+            __m128i _ruv = _mm_mullo_epi16(_vv, _v90);
+            __m128i _guv = _mm_add_epi16(_mm_mullo_epi16(_vv, _v46), _mm_mullo_epi16(_uu, _v22));
+            __m128i _buv = _mm_mullo_epi16(_uu, _v113);
+
+            __m128i _ruv0 = _mm_unpacklo_epi16(_ruv, _ruv);
+            __m128i _ruv1 = _mm_unpackhi_epi16(_ruv, _ruv);
+            __m128i _guv0 = _mm_unpacklo_epi16(_guv, _guv);
+            __m128i _guv1 = _mm_unpackhi_epi16(_guv, _guv);
+            __m128i _buv0 = _mm_unpacklo_epi16(_buv, _buv);
+            __m128i _buv1 = _mm_unpackhi_epi16(_buv, _buv);
+
+            __m128i _y0 = _mm_loadu_si128((const __m128i*)yptr0);
+            __m128i _yy00 = _mm_slli_epi16(_mm_unpacklo_epi8(_y0, _zero), 6);
+            __m128i _yy01 = _mm_slli_epi16(_mm_unpackhi_epi8(_y0, _zero), 6);
+
+            __m128i _r0 = _mm_packus_epi16(_mm_srai_epi16(_mm_add_epi16(_yy00, _ruv0), 6), _mm_srai_epi16(_mm_add_epi16(_yy01, _ruv1), 6));
+            __m128i _g0 = _mm_packus_epi16(_mm_srai_epi16(_mm_add_epi16(_yy00, _guv0), 6), _mm_srai_epi16(_mm_add_epi16(_yy01, _guv1), 6));
+            __m128i _b0 = _mm_packus_epi16(_mm_srai_epi16(_mm_add_epi16(_yy00, _buv0), 6), _mm_srai_epi16(_mm_add_epi16(_yy01, _buv1), 6));
+
+            store_interleave_c3_u8(rgb0, _r0, _g0, _b0);
+
+            __m128i _y1 = _mm_loadu_si128((const __m128i*)yptr1);
+            __m128i _yy10 = _mm_slli_epi16(_mm_unpacklo_epi8(_y1, _zero), 6);
+            __m128i _yy11 = _mm_slli_epi16(_mm_unpackhi_epi8(_y1, _zero), 6);
+
+            __m128i _r1 = _mm_packus_epi16(_mm_srai_epi16(_mm_add_epi16(_yy10, _ruv0), 6), _mm_srai_epi16(_mm_add_epi16(_yy11, _ruv1), 6));
+            __m128i _g1 = _mm_packus_epi16(_mm_srai_epi16(_mm_add_epi16(_yy10, _guv0), 6), _mm_srai_epi16(_mm_add_epi16(_yy11, _guv1), 6));
+            __m128i _b1 = _mm_packus_epi16(_mm_srai_epi16(_mm_add_epi16(_yy10, _buv0), 6), _mm_srai_epi16(_mm_add_epi16(_yy11, _buv1), 6));
+
+            store_interleave_c3_u8(rgb1, _r1, _g1, _b1);
+
+            yptr0 += 16;
+            yptr1 += 16;
+            vuptr += 16;
+            rgb0 += 3*16;
+            rgb1 += 3*16;
+        }
 #endif // __ARM_NEON
 
 #define SATURATE_CAST_UCHAR(X) (unsigned char)min(max((int)(X), 0), 255);
@@ -2313,6 +2850,733 @@ Mat Mat::from_pixels_resize(const unsigned char* pixels, int type, int w, int h,
     return Mat();
 }
 
+// channel letters of a pixel format, Y for gray
+static const char* pixel_channel_names(int format)
+{
+    switch (format)
+    {
+    case Mat::PIXEL_RGB:
+        return "RGB";
+    case Mat::PIXEL_BGR:
+        return "BGR";
+    case Mat::PIXEL_GRAY:
+        return "Y";
+    case Mat::PIXEL_RGBA:
+        return "RGBA";
+    case Mat::PIXEL_BGRA:
+        return "BGRA";
+    default:
+        return 0;
+    }
+}
+
+// bilinear coefficients in the fixed point format of resize_bilinear_c1..c4
+static void resize_bilinear_coeffs(int srcw, int w, int cn, int* xofs, short* ialpha)
+{
+    const int INTER_RESIZE_COEF_BITS=11;
+    const int INTER_RESIZE_COEF_SCALE=1 << INTER_RESIZE_COEF_BITS;
+
+    double scale_x = (double)srcw / w;
+
+#define SATURATE_CAST_SHORT(X) (short)min(max((int)(X + (X >= 0.f ? 0.5f : -0.5f)), SHRT_MIN), SHRT_MAX);
+
+    for (int dx = 0; dx < w; dx++)
+    {
+        float fx = (float)((dx + 0.5) * scale_x - 0.5);
+        int sx = static_cast<int>(floor(fx));
+        fx -= sx;
+
+        if (sx < 0)
+        {
+            sx = 0;
+            fx = 0.f;
+        }
+        if (sx >= srcw - 1)
+        {
+            sx = srcw - 2;
+            fx = 1.f;
+        }
+
+        xofs[dx] = sx*cn;
+
+        float a0 = (1.f - fx) * INTER_RESIZE_COEF_SCALE;
+        float a1 =        fx  * INTER_RESIZE_COEF_SCALE;
+
+        ialpha[dx*2    ] = SATURATE_CAST_SHORT(a0);
+        ialpha[dx*2 + 1] = SATURATE_CAST_SHORT(a1);
+    }
+
+#undef SATURATE_CAST_SHORT
+}
+
+static inline void resize_bilinear_hresize_cn(const unsigned char* S, const int cn, const int* xofs, const short* ialpha, short* rows, int w)
+{
+    for (int dx = 0; dx < w; dx++)
+    {
+        const unsigned char* Sp = S + xofs[dx];
+        short a0 = ialpha[dx*2];
+        short a1 = ialpha[dx*2 + 1];
+
+        for (int k=0; k<cn; k++)
+        {
+            rows[k] = (Sp[k]*a0 + Sp[k+cn]*a1) >> 4;
+        }
+
+        rows += cn;
+    }
+}
+
+static void resize_bilinear_hresize(const unsigned char* S, int cn, const int* xofs, const short* ialpha, short* rows, int w)
+{
+    // constant channel counts let the compiler unroll the pixel
+    if (cn == 1)
+        resize_bilinear_hresize_cn(S, 1, xofs, ialpha, rows, w);
+    else if (cn == 3)
+        resize_bilinear_hresize_cn(S, 3, xofs, ialpha, rows, w);
+    else
+        resize_bilinear_hresize_cn(S, 4, xofs, ialpha, rows, w);
+}
+
+static inline void resize_bilinear_hresize2_cn(const unsigned char* S0, const unsigned char* S1, const int cn, const int* xofs, const short* ialpha, short* rows0, short* rows1, int w)
+{
+    for (int dx = 0; dx < w; dx++)
+    {
+        const unsigned char* S0p = S0 + xofs[dx];
+        const unsigned char* S1p = S1 + xofs[dx];
+        short a0 = ialpha[dx*2];
+        short a1 = ialpha[dx*2 + 1];
+
+        for (int k=0; k<cn; k++)
+        {
+            rows0[k] = (S0p[k]*a0 + S0p[k+cn]*a1) >> 4;
+            rows1[k] = (S1p[k]*a0 + S1p[k+cn]*a1) >> 4;
+        }
+
+        rows0 += cn;
+        rows1 += cn;
+    }
+}
+
+// hresize two rows sharing the coefficient loads
+static void resize_bilinear_hresize2(const unsigned char* S0, const unsigned char* S1, int cn, const int* xofs, const short* ialpha, short* rows0, short* rows1, int w)
+{
+    if (cn == 1)
+        resize_bilinear_hresize2_cn(S0, S1, 1, xofs, ialpha, rows0, rows1, w);
+    else if (cn == 3)
+        resize_bilinear_hresize2_cn(S0, S1, 3, xofs, ialpha, rows0, rows1, w);
+    else
+        resize_bilinear_hresize2_cn(S0, S1, 4, xofs, ialpha, rows0, rows1, w);
+}
+
+// v * norm + bias of one channel of a float pixel row, every outstep floats
+static inline void normalize_pixel_row_cn(const float* rowp, const int cn, int s, float norm, float bias, float* ptr, const int outstep, int x0, int w)
+{
+    for (int x=x0; x<w; x++)
+    {
+        ptr[x*outstep] = rowp[x*cn + s] * norm + bias;
+    }
+}
+
+static void normalize_pixel_row(const float* rowp, int cn, int s, float norm, float bias, float* ptr, int outstep, int x0, int w)
+{
+    // constant channel counts and steps let the compiler vectorize the strided loads
+    if (outstep == 1)
+    {
+        if (cn == 1)
+            normalize_pixel_row_cn(rowp, 1, s, norm, bias, ptr, 1, x0, w);
+        else if (cn == 3)
+            normalize_pixel_row_cn(rowp, 3, s, norm, bias, ptr, 1, x0, w);
+        else
+            normalize_pixel_row_cn(rowp, 4, s, norm, bias, ptr, 1, x0, w);
+    }
+    else
+    {
+        normalize_pixel_row_cn(rowp, cn, s, norm, bias, ptr, 4, x0, w);
+    }
+}
+
+static void resize_bilinear_vresize(const short* rows0p, const short* rows1p, short b0, short b1, unsigned char* Dp, int n)
+{
+#if __ARM_NEON || __SSE2__
+    int nn = n >> 3;
+#else
+    int nn = 0;
+#endif
+    int remain = n - (nn << 3);
+
+#if __ARM_NEON
+    int16x4_t _b0 = vdup_n_s16(b0);
+    int16x4_t _b1 = vdup_n_s16(b1);
+    int32x4_t _v2 = vdupq_n_s32(2);
+    for (; nn>0; nn--)
+    {
+        int32x4_t _acc = _v2;
+        _acc = vsraq_n_s32(_acc, vmull_s16(vld1_s16(rows0p), _b0), 16);
+        _acc = vsraq_n_s32(_acc, vmull_s16(vld1_s16(rows1p), _b1), 16);
+
+        int32x4_t _acc_1 = _v2;
+        _acc_1 = vsraq_n_s32(_acc_1, vmull_s16(vld1_s16(rows0p+4), _b0), 16);
+        _acc_1 = vsraq_n_s32(_acc_1, vmull_s16(vld1_s16(rows1p+4), _b1), 16);
+
+        uint8x8_t _D = vqmovun_s16(vcombine_s16(vshrn_n_s32(_acc, 2), vshrn_n_s32(_acc_1, 2)));
+        vst1_u8(Dp, _D);
+
+        Dp += 8;
+        rows0p += 8;
+        rows1p += 8;
+    }
+#elif __SSE2__
+    // the high half of the 16 bit products, the sum stays far below the short range
+    __m128i _b0 = _mm_set1_epi16(b0);
+    __m128i _b1 = _mm_set1_epi16(b1);
+    __m128i _v2 = _mm_set1_epi16(2);
+    for (; nn>0; nn--)
+    {
+        __m128i _rows0 = _mm_loadu_si128((const __m128i*)rows0p);
+        __m128i _rows1 = _mm_loadu_si128((const __m128i*)rows1p);
+
+        __m128i _acc = _mm_add_epi16(_mm_mulhi_epi16(_rows0, _b0), _mm_mulhi_epi16(_rows1, _b1));
+        _acc = _mm_srai_epi16(_mm_add_epi16(_acc, _v2), 2);
+
+        _mm_storel_epi64((__m128i*)Dp, _mm_packus_epi16(_acc, _acc));
+
+        Dp += 8;
+        rows0p += 8;
+        rows1p += 8;
+    }
+#endif // __ARM_NEON
+    for ( ; remain; --remain )
+    {
+        *Dp++ = (unsigned char)(( (short)((b0 * (short)(*rows0p++)) >> 16) + (short)((b1 * (short)(*rows1p++)) >> 16) + 2)>>2);
+    }
+}
+
+Mat Mat::from_pixels_resize_normalize(const unsigned char* pixels, int type, int w, int h, int target_width, int target_height, const float* mean_vals, const float* norm_vals, int elempack, Allocator* allocator)
+{
+    int type_from = type & PIXEL_FORMAT_MASK;
+
+    if (type_from == PIXEL_RGB || type_from == PIXEL_BGR)
+    {
+        return Mat::from_pixels_resize_normalize(pixels, type, w, h, w * 3, target_width, target_height, mean_vals, norm_vals, elempack, allocator);
+    }
+    else if (type_from == PIXEL_GRAY)
+    {
+        return Mat::from_pixels_resize_normalize(pixels, type, w, h, w * 1, target_width, target_height, mean_vals, norm_vals, elempack, allocator);
+    }
+    else if (type_from == PIXEL_RGBA || type_from == PIXEL_BGRA)
+    {
+        return Mat::from_pixels_resize_normalize(pixels, type, w, h, w * 4, target_width, target_height, mean_vals, norm_vals, elempack, allocator);
+    }
+
+    // unknown convert type
+    return Mat();
+}
+
+Mat Mat::from_pixels_resize_normalize(const unsigned char* pixels, int type, int w, int h, int stride, int target_width, int target_height, const float* mean_vals, const float* norm_vals, int elempack, Allocator* allocator)
+{
+    int type_from = type & PIXEL_FORMAT_MASK;
+    int type_to = (type & PIXEL_CONVERT_MASK) ? (type >> PIXEL_CONVERT_SHIFT) : type_from;
+
+    const char* names_from = pixel_channel_names(type_from);
+    const char* names_to = pixel_channel_names(type_to);
+    if (!names_from || !names_to)
+    {
+        // unknown convert type
+        return Mat();
+    }
+
+    const int cn = (int)strlen(names_from);
+    const int channels = (int)strlen(names_to);
+
+    if (elempack != 1 && !(elempack == 4 && channels == 4))
+        return Mat();
+
+    // the source channel of every output channel,
+    // -1 for the opaque alpha of a source without one, -2 for gray from r g b
+    int source[4];
+    // source channels of r g b for gray
+    int gray_source[3] = { 0, 0, 0 };
+    for (int k=0; k<channels; k++)
+    {
+        const char name = names_to[k];
+        const char* p = strchr(names_from, name);
+
+        if (p)
+            source[k] = (int)(p - names_from);
+        else if (name == 'A')
+            source[k] = -1;
+        else if (name == 'Y')
+            source[k] = -2;
+        else
+            source[k] = 0;// gray to r g b
+    }
+    for (int k=0; k<3 && cn >= 3; k++)
+    {
+        gray_source[k] = (int)(strchr(names_from, "RGB"[k]) - names_from);
+    }
+
+    // v * norm + bias, the same arithmetic as substract_mean_normalize
+    float norm[4];
+    float bias[4];
+    for (int k=0; k<channels; k++)
+    {
+        const float mean = mean_vals ? mean_vals[k] : 0.f;
+        norm[k] = norm_vals ? norm_vals[k] : 1.f;
+        bias[k] = - mean * norm[k];
+    }
+
+    Mat m;
+    m.create(target_width, target_height, channels / elempack, (size_t)4u * elempack, elempack, allocator);
+    if (m.empty())
+        return m;
+
+    const bool resize = w != target_width || h != target_height;
+
+    // horizontally resized source rows and one resized pixel row, the whole working set of a row
+    int* xofs = 0;
+    short* ialpha = 0;
+    Mat rowsbuf0;
+    Mat rowsbuf1;
+    Mat rowbuf;
+    if (resize)
+    {
+        xofs = new int[target_width + target_width];
+        ialpha = (short*)(xofs + target_width);
+        resize_bilinear_coeffs(w, target_width, cn, xofs, ialpha);
+
+        rowsbuf0.create(target_width*cn+1, (size_t)2u);
+        rowsbuf1.create(target_width*cn+1, (size_t)2u);
+        rowbuf.create(target_width*cn, (size_t)1u);
+    }
+    // the pixel row as float, converted once for all output channels
+    Mat rowfbuf(target_width*cn, (size_t)4u);
+
+    short* rows0 = (short*)rowsbuf0.data;
+    short* rows1 = (short*)rowsbuf1.data;
+    int prev_sy1 = -2;
+
+    // coeffs for r g b = 0.299f, 0.587f, 0.114f
+    const unsigned char Y_shift = 8;//14
+    const unsigned char R2Y = 77;
+    const unsigned char G2Y = 150;
+    const unsigned char B2Y = 29;
+
+    const int outw = target_width;
+    const int outstep = elempack;
+
+    double scale_y = (double)h / target_height;
+
+    for (int dy = 0; dy < target_height; dy++)
+    {
+        const unsigned char* rowp = pixels + stride * dy;
+
+        if (resize)
+        {
+            const int INTER_RESIZE_COEF_BITS=11;
+            const int INTER_RESIZE_COEF_SCALE=1 << INTER_RESIZE_COEF_BITS;
+
+            float fy = (float)((dy + 0.5) * scale_y - 0.5);
+            int sy = static_cast<int>(floor(fy));
+            fy -= sy;
+
+            if (sy < 0)
+            {
+                sy = 0;
+                fy = 0.f;
+            }
+            if (sy >= h - 1)
+            {
+                sy = h - 2;
+                fy = 1.f;
+            }
+
+            float fb0 = (1.f - fy) * INTER_RESIZE_COEF_SCALE;
+            float fb1 =        fy  * INTER_RESIZE_COEF_SCALE;
+            short b0 = (short)min(max((int)(fb0 + (fb0 >= 0.f ? 0.5f : -0.5f)), SHRT_MIN), SHRT_MAX);
+            short b1 = (short)min(max((int)(fb1 + (fb1 >= 0.f ? 0.5f : -0.5f)), SHRT_MIN), SHRT_MAX);
+
+            if (sy == prev_sy1)
+            {
+                // reuse all rows
+            }
+            else if (sy == prev_sy1 + 1)
+            {
+                // hresize one row
+                short* rows0_old = rows0;
+                rows0 = rows1;
+                rows1 = rows0_old;
+                resize_bilinear_hresize(pixels + stride * (sy+1), cn, xofs, ialpha, rows1, target_width);
+            }
+            else
+            {
+                // hresize two rows
+                resize_bilinear_hresize2(pixels + stride * (sy), pixels + stride * (sy+1), cn, xofs, ialpha, rows0, rows1, target_width);
+            }
+
+            prev_sy1 = sy;
+
+            // vresize
+            resize_bilinear_vresize(rows0, rows1, b0, b1, rowbuf, target_width*cn);
+            rowp = rowbuf;
+        }
+
+        // swizzle, normalize and pack the pixel row into the output row
+        float* outptr[4];
+        for (int k=0; k<channels; k++)
+        {
+            outptr[k] = elempack == 4 ? m.channel(0).row(dy) + k : m.channel(k).row(dy);
+        }
+
+        int x = 0;
+#if __ARM_NEON
+        if (source[0] != -2 && (cn == 1 || cn == 3 || cn == 4))
+        {
+            for (; x+7<outw; x+=8)
+            {
+                uint8x8_t _p[4];
+                if (cn == 1)
+                {
+                    _p[0] = vld1_u8(rowp + x);
+                }
+                else if (cn == 3)
+                {
+                    uint8x8x3_t _p3 = vld3_u8(rowp + x*3);
+                    _p[0] = _p3.val[0];
+                    _p[1] = _p3.val[1];
+                    _p[2] = _p3.val[2];
+                }
+                else
+                {
+                    uint8x8x4_t _p4 = vld4_u8(rowp + x*4);
+                    _p[0] = _p4.val[0];
+                    _p[1] = _p4.val[1];
+                    _p[2] = _p4.val[2];
+                    _p[3] = _p4.val[3];
+                }
+
+                float32x4x4_t _outlow;
+                float32x4x4_t _outhigh;
+                for (int k=0; k<channels; k++)
+                {
+                    uint16x8_t _p16 = vmovl_u8(source[k] == -1 ? vdup_n_u8(255) : _p[source[k]]);
+                    float32x4_t _plow = vcvtq_f32_u32(vmovl_u16(vget_low_u16(_p16)));
+                    float32x4_t _phigh = vcvtq_f32_u32(vmovl_u16(vget_high_u16(_p16)));
+
+                    float32x4_t _norm = vdupq_n_f32(norm[k]);
+                    float32x4_t _bias = vdupq_n_f32(bias[k]);
+                    _outlow.val[k] = vmlaq_f32(_bias, _plow, _norm);
+                    _outhigh.val[k] = vmlaq_f32(_bias, _phigh, _norm);
+                }
+
+                if (elempack == 4)
+                {
+                    vst4q_f32(outptr[0] + x*4, _outlow);
+                    vst4q_f32(outptr[0] + x*4 + 16, _outhigh);
+                }
+                else
+                {
+                    for (int k=0; k<channels; k++)
+                    {
+                        vst1q_f32(outptr[k] + x, _outlow.val[k]);
+                        vst1q_f32(outptr[k] + x + 4, _outhigh.val[k]);
+                    }
+                }
+            }
+        }
+#endif // __ARM_NEON
+        const int x0 = x;
+
+        float* rowf = rowfbuf;
+        for (int i=x0*cn; i<outw*cn; i++)
+        {
+            rowf[i] = rowp[i];
+        }
+
+        for (int k=0; k<channels; k++)
+        {
+            const int s = source[k];
+            const float nk = norm[k];
+            const float bk = bias[k];
+            float* ptr = outptr[k];
+
+            if (s >= 0)
+            {
+                normalize_pixel_row(rowf, cn, s, nk, bk, ptr, outstep, x0, outw);
+            }
+            else if (s == -1)
+            {
+                const float alpha = 255.f * nk + bk;
+                for (x=x0; x<outw; x++)
+                {
+                    ptr[x*outstep] = alpha;
+                }
+            }
+            else
+            {
+                const int r = gray_source[0];
+                const int g = gray_source[1];
+                const int b = gray_source[2];
+                for (x=x0; x<outw; x++)
+                {
+                    const unsigned char* p = rowp + x*cn;
+                    ptr[x*outstep] = static_cast<float>((p[r] * R2Y + p[g] * G2Y + p[b] * B2Y) >> Y_shift) * nk + bk;
+                }
+            }
+        }
+    }
+
+    delete[] xofs;
+
+    return m;
+}
+
+// bilinear taps along one source axis for every output position along one output axis
+// the positions run over roi_size pixels from roi_offset, mirrored when flip,
+// the taps are byte offsets of luma and chroma samples with their second sample weights
+static void yuv420_axis_taps(int roi_offset, int roi_size, int out_size, bool flip, int luma_step, int chroma_step, int* luma_ofs, float* luma_alpha, int* chroma_ofs, float* chroma_alpha)
+{
+    const float scale = (float)roi_size / out_size;
+
+    // the chroma samples covering the roi
+    const int chroma_first = roi_offset / 2;
+    const int chroma_last = (roi_offset + roi_size - 1) / 2;
+
+    for (int d=0; d<out_size; d++)
+    {
+        float f = (d + 0.5f) * scale - 0.5f;
+        if (flip)
+            f = roi_size - 1 - f;
+
+        f = min(max(f, 0.f), (float)(roi_size - 1));
+
+        int i0 = static_cast<int>(f);
+        int i1 = min(i0 + 1, roi_size - 1);
+        luma_ofs[d*2] = (roi_offset + i0) * luma_step;
+        luma_ofs[d*2 + 1] = (roi_offset + i1) * luma_step;
+        luma_alpha[d] = f - i0;
+
+        // chroma sits at the center of its 2x2 luma block
+        float fc = (roi_offset + f) * 0.5f - 0.25f;
+        fc = min(max(fc, (float)chroma_first), (float)chroma_last);
+
+        int c0 = static_cast<int>(fc);
+        int c1 = min(c0 + 1, chroma_last);
+        chroma_ofs[d*2] = c0 * chroma_step;
+        chroma_ofs[d*2 + 1] = c1 * chroma_step;
+        chroma_alpha[d] = fc - c0;
+    }
+}
+
+Mat Mat::from_yuv420_roi_resize_normalize(const unsigned char* yuv, int format, int w, int h, int roix, int roiy, int roiw, int roih, int orientation, int type, int target_width, int target_height, const float* mean_vals, const float* norm_vals, int elempack, Allocator* allocator)
+{
+    const char* names_to = pixel_channel_names(type);
+    if (!names_to || (type & PIXEL_CONVERT_MASK))
+    {
+        // unknown pixel type
+        return Mat();
+    }
+
+    if (format != YUV420_NV21 && format != YUV420_NV12 && format != YUV420_I420)
+        return Mat();
+
+    if (roix < 0 || roiy < 0 || roiw <= 0 || roih <= 0 || roix + roiw > w || roiy + roih > h)
+        return Mat();
+
+    if (orientation < 1 || orientation > 8)
+        return Mat();
+
+    const int channels = (int)strlen(names_to);
+
+    if (elempack != 1 && !(elempack == 4 && channels == 4))
+        return Mat();
+
+    // r g b computed, 3 for the opaque alpha, 4 for luma as gray
+    int source[4];
+    for (int k=0; k<channels; k++)
+    {
+        const char name = names_to[k];
+
+        if (name == 'A')
+            source[k] = 3;
+        else if (name == 'Y')
+            source[k] = 4;
+        else
+            source[k] = (int)(strchr("RGB", name) - "RGB");
+    }
+    const bool gray = channels == 1;
+
+    // v * norm + bias, the same arithmetic as substract_mean_normalize
+    float norm[4];
+    float bias[4];
+    for (int k=0; k<channels; k++)
+    {
+        const float mean = mean_vals ? mean_vals[k] : 0.f;
+        norm[k] = norm_vals ? norm_vals[k] : 1.f;
+        bias[k] = - mean * norm[k];
+    }
+
+    Mat m;
+    m.create(target_width, target_height, channels / elempack, (size_t)4u * elempack, elempack, allocator);
+    if (m.empty())
+        return m;
+
+    // chroma planes, u and v samples chroma_step bytes apart along a chroma row
+    const int cw = (w + 1) / 2;
+    const int ch = (h + 1) / 2;
+    const unsigned char* yptr = yuv;
+    const unsigned char* uptr;
+    const unsigned char* vptr;
+    int chroma_step;
+    int chroma_stride;
+    if (format == YUV420_NV21)
+    {
+        vptr = yuv + w * h;
+        uptr = vptr + 1;
+        chroma_step = 2;
+        chroma_stride = cw * 2;
+    }
+    else if (format == YUV420_NV12)
+    {
+        uptr = yuv + w * h;
+        vptr = uptr + 1;
+        chroma_step = 2;
+        chroma_stride = cw * 2;
+    }
+    else
+    {
+        uptr = yuv + w * h;
+        vptr = uptr + cw * ch;
+        chroma_step = 1;
+        chroma_stride = cw;
+    }
+
+    // kanna rotate type 5 to 8 swap the axes, the output columns then walk the source rows
+    // output x runs backwards on the source for type 2 3 6 7, output y for type 3 4 7 8
+    const bool transpose = orientation >= 5;
+    const bool flipx = orientation == 2 || orientation == 3 || orientation == 6 || orientation == 7;
+    const bool flipy = orientation == 3 || orientation == 4 || orientation == 7 || orientation == 8;
+
+    int* xofs = new int[target_width * 4 + target_height * 4];
+    int* yofs = xofs + target_width * 4;
+    float* alphas = new float[target_width * 2 + target_height * 2];
+
+    int* xofs_luma = xofs;
+    int* xofs_chroma = xofs + target_width * 2;
+    float* xalpha_luma = alphas;
+    float* xalpha_chroma = alphas + target_width;
+    int* yofs_luma = yofs;
+    int* yofs_chroma = yofs + target_height * 2;
+    float* yalpha_luma = alphas + target_width * 2;
+    float* yalpha_chroma = yalpha_luma + target_height;
+
+    if (!transpose)
+    {
+        yuv420_axis_taps(roix, roiw, target_width, flipx, 1, chroma_step, xofs_luma, xalpha_luma, xofs_chroma, xalpha_chroma);
+        yuv420_axis_taps(roiy, roih, target_height, flipy, w, chroma_stride, yofs_luma, yalpha_luma, yofs_chroma, yalpha_chroma);
+    }
+    else
+    {
+        yuv420_axis_taps(roiy, roih, target_width, flipx, w, chroma_stride, xofs_luma, xalpha_luma, xofs_chroma, xalpha_chroma);
+        yuv420_axis_taps(roix, roiw, target_height, flipy, 1, chroma_step, yofs_luma, yalpha_luma, yofs_chroma, yalpha_chroma);
+    }
+
+    // interpolated luma and chroma of one output row, then the r g b planes of the row
+    Mat rowbuf(target_width, 6, (size_t)4u);
+    float* yrow = rowbuf.row(0);
+    float* urow = rowbuf.row(1);
+    float* vrow = rowbuf.row(2);
+    float* rgbrows[5] = { rowbuf.row(3), rowbuf.row(4), rowbuf.row(5), 0, yrow };
+
+    const int outw = target_width;
+    const int outstep = elempack;
+
+    for (int dy = 0; dy < target_height; dy++)
+    {
+        const float by = yalpha_luma[dy];
+        const unsigned char* Y0 = yptr + yofs_luma[dy*2];
+        const unsigned char* Y1 = yptr + yofs_luma[dy*2 + 1];
+
+        for (int dx = 0; dx < outw; dx++)
+        {
+            const int x0 = xofs_luma[dx*2];
+            const int x1 = xofs_luma[dx*2 + 1];
+            const float ax = xalpha_luma[dx];
+
+            float y0 = Y0[x0] + (Y0[x1] - Y0[x0]) * ax;
+            float y1 = Y1[x0] + (Y1[x1] - Y1[x0]) * ax;
+            yrow[dx] = y0 + (y1 - y0) * by;
+        }
+
+        if (!gray)
+        {
+            const float cy = yalpha_chroma[dy];
+            const int c0ofs = yofs_chroma[dy*2];
+            const int c1ofs = yofs_chroma[dy*2 + 1];
+            const unsigned char* U0 = uptr + c0ofs;
+            const unsigned char* U1 = uptr + c1ofs;
+            const unsigned char* V0 = vptr + c0ofs;
+            const unsigned char* V1 = vptr + c1ofs;
+
+            for (int dx = 0; dx < outw; dx++)
+            {
+                const int x0 = xofs_chroma[dx*2];
+                const int x1 = xofs_chroma[dx*2 + 1];
+                const float cx = xalpha_chroma[dx];
+
+                float u0 = U0[x0] + (U0[x1] - U0[x0]) * cx;
+                float u1 = U1[x0] + (U1[x1] - U1[x0]) * cx;
+                float v0 = V0[x0] + (V0[x1] - V0[x0]) * cx;
+                float v1 = V1[x0] + (V1[x1] - V1[x0]) * cx;
+                urow[dx] = u0 + (u1 - u0) * cy - 128.f;
+                vrow[dx] = v0 + (v1 - v0) * cy - 128.f;
+            }
+
+            // the coefficients of yuv420sp2rgb
+            // R = Y + 90/64 * V
+            // G = Y - 46/64 * V - 22/64 * U
+            // B = Y + 113/64 * U
+            float* rrow = rgbrows[0];
+            float* grow = rgbrows[1];
+            float* brow = rgbrows[2];
+            for (int dx = 0; dx < outw; dx++)
+            {
+                const float yy = yrow[dx];
+                const float uu = urow[dx];
+                const float vv = vrow[dx];
+
+                rrow[dx] = min(max(yy + 1.40625f * vv, 0.f), 255.f);
+                grow[dx] = min(max(yy - 0.71875f * vv - 0.34375f * uu, 0.f), 255.f);
+                brow[dx] = min(max(yy + 1.765625f * uu, 0.f), 255.f);
+            }
+        }
+
+        for (int k=0; k<channels; k++)
+        {
+            const float nk = norm[k];
+            const float bk = bias[k];
+            float* ptr = elempack == 4 ? m.channel(0).row(dy) + k : m.channel(k).row(dy);
+
+            if (source[k] == 3)
+            {
+                const float alpha = 255.f * nk + bk;
+                for (int dx = 0; dx < outw; dx++)
+                {
+                    ptr[dx*outstep] = alpha;
+                }
+            }
+            else
+            {
+                normalize_pixel_row(rgbrows[source[k]], 1, 0, nk, bk, ptr, outstep, 0, outw);
+            }
+        }
+    }
+
+    delete[] xofs;
+    delete[] alphas;
+
+    return m;
+}
+
 void Mat::to_pixels(unsigned char* pixels, int type) const
 {
     int type_to = (type & PIXEL_CONVERT_MASK) ? (type >> PIXEL_CONVERT_SHIFT) : (type & PIXEL_FORMAT_MASK);
@@ -19,6 +19,12 @@
 #if __ARM_NEON
 #include <arm_neon.h>
 #endif // __ARM_NEON
+#if __SSE2__
+#include <emmintrin.h>
+#if __AVX2__
+#include <immintrin.h>
+#endif // __AVX2__
+#endif // __SSE2__
 #include "platform.h"
 
 #include "cstl/utils.h"
@@ -196,6 +202,8 @@ void resize_bilinear_c1(const unsigned char* src, int srcw, int srch, int srcstr
 
 #if __ARM_NEON
         int nn = w >> 3;
+#elif __SSE2__
+        int nn = w >> 3;
 #else
         int nn = 0;
 #endif
@@ -286,6 +294,46 @@ void resize_bilinear_c1(const unsigned char* src, int srcw, int srch, int srcstr
         );
         }
 #endif // __aarch64__
+#elif __SSE2__
+        __m128i _b0 = _mm_set1_epi16(b0);
+        __m128i _b1 = _mm_set1_epi16(b1);
+        __m128i _v2 = _mm_set1_epi16(2);
+#if __AVX2__
+        __m256i _b0_256 = _mm256_set1_epi16(b0);
+        __m256i _b1_256 = _mm256_set1_epi16(b1);
+        __m256i _v2_256 = _mm256_set1_epi16(2);
+        for (; nn>1; nn-=2)
+        {
+            __m256i _rows0 = _mm256_loadu_si256((const __m256i*)rows0p);
+            __m256i _rows1 = _mm256_loadu_si256((const __m256i*)rows1p);
+
+            __m256i _acc = _mm256_add_epi16(_mm256_mulhi_epi16(_rows0, _b0_256), _mm256_mulhi_epi16(_rows1, _b1_256));
+            _acc = _mm256_srai_epi16(_mm256_add_epi16(_acc, _v2_256), 2);
+
+            // packus works within 128bit lanes, gather the low halves
+            __m256i _D = _mm256_permute4x64_epi64(_mm256_packus_epi16(_acc, _acc), _MM_SHUFFLE(3, 1, 2, 0));
+            _mm_storeu_si128((__m128i*)Dp, _mm256_castsi256_si128(_D));
+
+            Dp += 16;
+            rows0p += 16;
+            rows1p += 16;
+        }
+#endif // __AVX2__
+        for (; nn>0; nn--)
+        {
+            __m128i _rows0 = _mm_loadu_si128((const __m128i*)rows0p);
+            __m128i _rows1 = _mm_loadu_si128((const __m128i*)rows1p);
+
+            // mulhi is the (short)((b * rows) >> 16) of the scalar loop
+            __m128i _acc = _mm_add_epi16(_mm_mulhi_epi16(_rows0, _b0), _mm_mulhi_epi16(_rows1, _b1));
+            _acc = _mm_srai_epi16(_mm_add_epi16(_acc, _v2), 2);
+
+            _mm_storel_epi64((__m128i*)Dp, _mm_packus_epi16(_acc, _acc));
+
+            Dp += 8;
+            rows0p += 8;
+            rows1p += 8;
+        }
 #endif // __ARM_NEON
         for ( ; remain; --remain )
         {
@@ -506,6 +554,8 @@ void resize_bilinear_c2(const unsigned char* src, int srcw, int srch, int srcstr
 
 #if __ARM_NEON
         int nn = (w * 2) >> 3;
+#elif __SSE2__
+        int nn = (w * 2) >> 3;
 #else
         int nn = 0;
 #endif
@@ -596,6 +646,46 @@ void resize_bilinear_c2(const unsigned char* src, int srcw, int srch, int srcstr
         );
         }
 #endif // __aarch64__
+#elif __SSE2__
+        __m128i _b0 = _mm_set1_epi16(b0);
+        __m128i _b1 = _mm_set1_epi16(b1);
+        __m128i _v2 = _mm_set1_epi16(2);
+#if __AVX2__
+        __m256i _b0_256 = _mm256_set1_epi16(b0);
+        __m256i _b1_256 = _mm256_set1_epi16(b1);
+        __m256i _v2_256 = _mm256_set1_epi16(2);
+        for (; nn>1; nn-=2)
+        {
+            __m256i _rows0 = _mm256_loadu_si256((const __m256i*)rows0p);
+            __m256i _rows1 = _mm256_loadu_si256((const __m256i*)rows1p);
+
+            __m256i _acc = _mm256_add_epi16(_mm256_mulhi_epi16(_rows0, _b0_256), _mm256_mulhi_epi16(_rows1, _b1_256));
+            _acc = _mm256_srai_epi16(_mm256_add_epi16(_acc, _v2_256), 2);
+
+            // packus works within 128bit lanes, gather the low halves
+            __m256i _D = _mm256_permute4x64_epi64(_mm256_packus_epi16(_acc, _acc), _MM_SHUFFLE(3, 1, 2, 0));
+            _mm_storeu_si128((__m128i*)Dp, _mm256_castsi256_si128(_D));
+
+            Dp += 16;
+            rows0p += 16;
+            rows1p += 16;
+        }
+#endif // __AVX2__
+        for (; nn>0; nn--)
+        {
+            __m128i _rows0 = _mm_loadu_si128((const __m128i*)rows0p);
+            __m128i _rows1 = _mm_loadu_si128((const __m128i*)rows1p);
+
+            // mulhi is the (short)((b * rows) >> 16) of the scalar loop
+            __m128i _acc = _mm_add_epi16(_mm_mulhi_epi16(_rows0, _b0), _mm_mulhi_epi16(_rows1, _b1));
+            _acc = _mm_srai_epi16(_mm_add_epi16(_acc, _v2), 2);
+
+            _mm_storel_epi64((__m128i*)Dp, _mm_packus_epi16(_acc, _acc));
+
+            Dp += 8;
+            rows0p += 8;
+            rows1p += 8;
+        }
 #endif // __ARM_NEON
         for ( ; remain; --remain )
         {
@@ -827,6 +917,8 @@ void resize_bilinear_c3(const unsigned char* src, int srcw, int srch, int srcstr
 
 #if __ARM_NEON
         int nn = (w * 3) >> 3;
+#elif __SSE2__
+        int nn = (w * 3) >> 3;
 #else
         int nn = 0;
 #endif
@@ -917,6 +1009,46 @@ void resize_bilinear_c3(const unsigned char* src, int srcw, int srch, int srcstr
         );
         }
 #endif // __aarch64__
+#elif __SSE2__
+        __m128i _b0 = _mm_set1_epi16(b0);
+        __m128i _b1 = _mm_set1_epi16(b1);
+        __m128i _v2 = _mm_set1_epi16(2);
+#if __AVX2__
+        __m256i _b0_256 = _mm256_set1_epi16(b0);
+        __m256i _b1_256 = _mm256_set1_epi16(b1);
+        __m256i _v2_256 = _mm256_set1_epi16(2);
+        for (; nn>1; nn-=2)
+        {
+            __m256i _rows0 = _mm256_loadu_si256((const __m256i*)rows0p);
+            __m256i _rows1 = _mm256_loadu_si256((const __m256i*)rows1p);
+
+            __m256i _acc = _mm256_add_epi16(_mm256_mulhi_epi16(_rows0, _b0_256), _mm256_mulhi_epi16(_rows1, _b1_256));
+            _acc = _mm256_srai_epi16(_mm256_add_epi16(_acc, _v2_256), 2);
+
+            // packus works within 128bit lanes, gather the low halves
+            __m256i _D = _mm256_permute4x64_epi64(_mm256_packus_epi16(_acc, _acc), _MM_SHUFFLE(3, 1, 2, 0));
+            _mm_storeu_si128((__m128i*)Dp, _mm256_castsi256_si128(_D));
+
+            Dp += 16;
+            rows0p += 16;
+            rows1p += 16;
+        }
+#endif // __AVX2__
+        for (; nn>0; nn--)
+        {
+            __m128i _rows0 = _mm_loadu_si128((const __m128i*)rows0p);
+            __m128i _rows1 = _mm_loadu_si128((const __m128i*)rows1p);
+
+            // mulhi is the (short)((b * rows) >> 16) of the scalar loop
+            __m128i _acc = _mm_add_epi16(_mm_mulhi_epi16(_rows0, _b0), _mm_mulhi_epi16(_rows1, _b1));
+            _acc = _mm_srai_epi16(_mm_add_epi16(_acc, _v2), 2);
+
+            _mm_storel_epi64((__m128i*)Dp, _mm_packus_epi16(_acc, _acc));
+
+            Dp += 8;
+            rows0p += 8;
+            rows1p += 8;
+        }
 #endif // __ARM_NEON
         for ( ; remain; --remain )
         {
@@ -1052,6 +1184,13 @@ void resize_bilinear_c4(const unsigned char* src, int srcw, int srch, int srcstr
                 _rows1 = vmlal_s16(_rows1, _S1high, _a1);
                 int16x4_t _rows1_sr4 = vshrn_n_s32(_rows1, 4);
                 vst1_s16(rows1p, _rows1_sr4);
+#elif __SSE2__
+                // pair each channel with its right neighbour, madd weighs them with a0 a1
+                __m128i _a0a1 = _mm_set1_epi32((a1 << 16) | (unsigned short)a0);
+                __m128i _S116 = _mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i*)S1p), _mm_setzero_si128());
+                __m128i _S1pair = _mm_unpacklo_epi16(_S116, _mm_unpackhi_epi64(_S116, _S116));
+                __m128i _rows1 = _mm_srai_epi32(_mm_madd_epi16(_S1pair, _a0a1), 4);
+                _mm_storel_epi64((__m128i*)rows1p, _mm_packs_epi32(_rows1, _rows1));
 #else
                 rows1p[0] = (S1p[0]*a0 + S1p[4]*a1) >> 4;
                 rows1p[1] = (S1p[1]*a0 + S1p[5]*a1) >> 4;
@@ -1099,6 +1238,16 @@ void resize_bilinear_c4(const unsigned char* src, int srcw, int srch, int srcstr
                 int16x4_t _rows1_sr4 = vshrn_n_s32(_rows1, 4);
                 vst1_s16(rows0p, _rows0_sr4);
                 vst1_s16(rows1p, _rows1_sr4);
+#elif __SSE2__
+                __m128i _a0a1 = _mm_set1_epi32((a1 << 16) | (unsigned short)a0);
+                __m128i _S016 = _mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i*)S0p), _mm_setzero_si128());
+                __m128i _S116 = _mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i*)S1p), _mm_setzero_si128());
+                __m128i _S0pair = _mm_unpacklo_epi16(_S016, _mm_unpackhi_epi64(_S016, _S016));
+                __m128i _S1pair = _mm_unpacklo_epi16(_S116, _mm_unpackhi_epi64(_S116, _S116));
+                __m128i _rows0 = _mm_srai_epi32(_mm_madd_epi16(_S0pair, _a0a1), 4);
+                __m128i _rows1 = _mm_srai_epi32(_mm_madd_epi16(_S1pair, _a0a1), 4);
+                _mm_storel_epi64((__m128i*)rows0p, _mm_packs_epi32(_rows0, _rows0));
+                _mm_storel_epi64((__m128i*)rows1p, _mm_packs_epi32(_rows1, _rows1));
 #else
                 rows0p[0] = (S0p[0]*a0 + S0p[4]*a1) >> 4;
                 rows0p[1] = (S0p[1]*a0 + S0p[5]*a1) >> 4;
@@ -1128,6 +1277,8 @@ void resize_bilinear_c4(const unsigned char* src, int srcw, int srch, int srcstr
 
 #if __ARM_NEON
         int nn = (w * 4) >> 3;
+#elif __SSE2__
+        int nn = (w * 4) >> 3;
 #else
         int nn = 0;
 #endif
@@ -1218,6 +1369,46 @@ void resize_bilinear_c4(const unsigned char* src, int srcw, int srch, int srcstr
         );
         }
 #endif // __aarch64__
+#elif __SSE2__
+        __m128i _b0 = _mm_set1_epi16(b0);
+        __m128i _b1 = _mm_set1_epi16(b1);
+        __m128i _v2 = _mm_set1_epi16(2);
+#if __AVX2__
+        __m256i _b0_256 = _mm256_set1_epi16(b0);
+        __m256i _b1_256 = _mm256_set1_epi16(b1);
+        __m256i _v2_256 = _mm256_set1_epi16(2);
+        for (; nn>1; nn-=2)
+        {
+            __m256i _rows0 = _mm256_loadu_si256((const __m256i*)rows0p);
+            __m256i _rows1 = _mm256_loadu_si256((const __m256i*)rows1p);
+
+            __m256i _acc = _mm256_add_epi16(_mm256_mulhi_epi16(_rows0, _b0_256), _mm256_mulhi_epi16(_rows1, _b1_256));
+            _acc = _mm256_srai_epi16(_mm256_add_epi16(_acc, _v2_256), 2);
+
+            // packus works within 128bit lanes, gather the low halves
+            __m256i _D = _mm256_permute4x64_epi64(_mm256_packus_epi16(_acc, _acc), _MM_SHUFFLE(3, 1, 2, 0));
+            _mm_storeu_si128((__m128i*)Dp, _mm256_castsi256_si128(_D));
+
+            Dp += 16;
+            rows0p += 16;
+            rows1p += 16;
+        }
+#endif // __AVX2__
+        for (; nn>0; nn--)
+        {
+            __m128i _rows0 = _mm_loadu_si128((const __m128i*)rows0p);
+            __m128i _rows1 = _mm_loadu_si128((const __m128i*)rows1p);
+
+            // mulhi is the (short)((b * rows) >> 16) of the scalar loop
+            __m128i _acc = _mm_add_epi16(_mm_mulhi_epi16(_rows0, _b0), _mm_mulhi_epi16(_rows1, _b1));
+            _acc = _mm_srai_epi16(_mm_add_epi16(_acc, _v2), 2);
+
+            _mm_storel_epi64((__m128i*)Dp, _mm_packus_epi16(_acc, _acc));
+
+            Dp += 8;
+            rows0p += 8;
+            rows1p += 8;
+        }
 #endif // __ARM_NEON
         for ( ; remain; --remain )
         {
@@ -16,6 +16,12 @@
 #if __ARM_NEON
 #include <arm_neon.h>
 #endif // __ARM_NEON
+#if __SSE2__
+#include <emmintrin.h>
+#if __SSSE3__
+#include <tmmintrin.h>
+#endif // __SSSE3__
+#endif // __SSE2__
 #include "platform.h"
 
 #if NCNN_PIXEL_ROTATE
@@ -23,6 +29,124 @@
 // but we shall ask the original art author for permission first ...
 // https://www.reddit.com/r/anime/comments/5uxjn4/i_recreated_the_kanna_ascii_art_from_kobayashisan/
 
+#if __SSE2__
+static inline __m128i reverse_u8(__m128i _v)
+{
+#if __SSSE3__
+    return _mm_shuffle_epi8(_v, _mm_setr_epi8(15, 14, 13, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1, 0));
+#else
+    _v = _mm_shuffle_epi32(_v, _MM_SHUFFLE(0, 1, 2, 3));
+    _v = _mm_shufflelo_epi16(_mm_shufflehi_epi16(_v, _MM_SHUFFLE(2, 3, 0, 1)), _MM_SHUFFLE(2, 3, 0, 1));
+    return _mm_or_si128(_mm_slli_epi16(_v, 8), _mm_srli_epi16(_v, 8));
+#endif // __SSSE3__
+}
+
+static inline __m128i reverse_u16(__m128i _v)
+{
+    _v = _mm_shuffle_epi32(_v, _MM_SHUFFLE(0, 1, 2, 3));
+    return _mm_shufflelo_epi16(_mm_shufflehi_epi16(_v, _MM_SHUFFLE(2, 3, 0, 1)), _MM_SHUFFLE(2, 3, 0, 1));
+}
+
+static inline __m128i reverse_u32(__m128i _v)
+{
+    return _mm_shuffle_epi32(_v, _MM_SHUFFLE(0, 1, 2, 3));
+}
+
+// the transposes read 8 (4) rows srcstride apart and write 8 (4) rows stride apart,
+// a negative srcstride flips the rows and a negative stride flips the columns of the result
+static inline void transpose_u8_8x8(const unsigned char* src, int srcstride, unsigned char* dst, int stride)
+{
+    __m128i _r01 = _mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i*)src), _mm_loadl_epi64((const __m128i*)(src + srcstride)));
+    __m128i _r23 = _mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i*)(src + 2*srcstride)), _mm_loadl_epi64((const __m128i*)(src + 3*srcstride)));
+    __m128i _r45 = _mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i*)(src + 4*srcstride)), _mm_loadl_epi64((const __m128i*)(src + 5*srcstride)));
+    __m128i _r67 = _mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i*)(src + 6*srcstride)), _mm_loadl_epi64((const __m128i*)(src + 7*srcstride)));
+
+    __m128i _r0123_0 = _mm_unpacklo_epi16(_r01, _r23);
+    __m128i _r0123_1 = _mm_unpackhi_epi16(_r01, _r23);
+    __m128i _r4567_0 = _mm_unpacklo_epi16(_r45, _r67);
+    __m128i _r4567_1 = _mm_unpackhi_epi16(_r45, _r67);
+
+    __m128i _c01 = _mm_unpacklo_epi32(_r0123_0, _r4567_0);
+    __m128i _c23 = _mm_unpackhi_epi32(_r0123_0, _r4567_0);
+    __m128i _c45 = _mm_unpacklo_epi32(_r0123_1, _r4567_1);
+    __m128i _c67 = _mm_unpackhi_epi32(_r0123_1, _r4567_1);
+
+    _mm_storel_epi64((__m128i*)dst, _c01);
+    _mm_storel_epi64((__m128i*)(dst + stride), _mm_unpackhi_epi64(_c01, _c01));
+    _mm_storel_epi64((__m128i*)(dst + 2*stride), _c23);
+    _mm_storel_epi64((__m128i*)(dst + 3*stride), _mm_unpackhi_epi64(_c23, _c23));
+    _mm_storel_epi64((__m128i*)(dst + 4*stride), _c45);
+    _mm_storel_epi64((__m128i*)(dst + 5*stride), _mm_unpackhi_epi64(_c45, _c45));
+    _mm_storel_epi64((__m128i*)(dst + 6*stride), _c67);
+    _mm_storel_epi64((__m128i*)(dst + 7*stride), _mm_unpackhi_epi64(_c67, _c67));
+}
+
+static inline void transpose_u16_8x8(const unsigned char* src, int srcstride, unsigned char* dst, int stride)
+{
+    __m128i _r0 = _mm_loadu_si128((const __m128i*)src);
+    __m128i _r1 = _mm_loadu_si128((const __m128i*)(src + srcstride));
+    __m128i _r2 = _mm_loadu_si128((const __m128i*)(src + 2*srcstride));
+    __m128i _r3 = _mm_loadu_si128((const __m128i*)(src + 3*srcstride));
+    __m128i _r4 = _mm_loadu_si128((const __m128i*)(src + 4*srcstride));
+    __m128i _r5 = _mm_loadu_si128((const __m128i*)(src + 5*srcstride));
+    __m128i _r6 = _mm_loadu_si128((const __m128i*)(src + 6*srcstride));
+    __m128i _r7 = _mm_loadu_si128((const __m128i*)(src + 7*srcstride));
+
+    __m128i _r01_0 = _mm_unpacklo_epi16(_r0, _r1);
+    __m128i _r01_1 = _mm_unpackhi_epi16(_r0, _r1);
+    __m128i _r23_0 = _mm_unpacklo_epi16(_r2, _r3);
+    __m128i _r23_1 = _mm_unpackhi_epi16(_r2, _r3);
+    __m128i _r45_0 = _mm_unpacklo_epi16(_r4, _r5);
+    __m128i _r45_1 = _mm_unpackhi_epi16(_r4, _r5);
+    __m128i _r67_0 = _mm_unpacklo_epi16(_r6, _r7);
+    __m128i _r67_1 = _mm_unpackhi_epi16(_r6, _r7);
+
+    __m128i _r0123_0 = _mm_unpacklo_epi32(_r01_0, _r23_0);
+    __m128i _r0123_1 = _mm_unpackhi_epi32(_r01_0, _r23_0);
+    __m128i _r0123_2 = _mm_unpacklo_epi32(_r01_1, _r23_1);
+    __m128i _r0123_3 = _mm_unpackhi_epi32(_r01_1, _r23_1);
+    __m128i _r4567_0 = _mm_unpacklo_epi32(_r45_0, _r67_0);
+    __m128i _r4567_1 = _mm_unpackhi_epi32(_r45_0, _r67_0);
+    __m128i _r4567_2 = _mm_unpacklo_epi32(_r45_1, _r67_1);
+    __m128i _r4567_3 = _mm_unpackhi_epi32(_r45_1, _r67_1);
+
+    _mm_storeu_si128((__m128i*)dst, _mm_unpacklo_epi64(_r0123_0, _r4567_0));
+    _mm_storeu_si128((__m128i*)(dst + stride), _mm_unpackhi_epi64(_r0123_0, _r4567_0));
+    _mm_storeu_si128((__m128i*)(dst + 2*stride), _mm_unpacklo_epi64(_r0123_1, _r4567_1));
+    _mm_storeu_si128((__m128i*)(dst + 3*stride), _mm_unpackhi_epi64(_r0123_1, _r4567_1));
+    _mm_storeu_si128((__m128i*)(dst + 4*stride), _mm_unpacklo_epi64(_r0123_2, _r4567_2));
+    _mm_storeu_si128((__m128i*)(dst + 5*stride), _mm_unpackhi_epi64(_r0123_2, _r4567_2));
+    _mm_storeu_si128((__m128i*)(dst + 6*stride), _mm_unpacklo_epi64(_r0123_3, _r4567_3));
+    _mm_storeu_si128((__m128i*)(dst + 7*stride), _mm_unpackhi_epi64(_r0123_3, _r4567_3));
+}
+
+static inline void transpose_u32_4x4(const unsigned char* src, int srcstride, unsigned char* dst, int stride)
+{
+    __m128i _r0 = _mm_loadu_si128((const __m128i*)src);
+    __m128i _r1 = _mm_loadu_si128((const __m128i*)(src + srcstride));
+    __m128i _r2 = _mm_loadu_si128((const __m128i*)(src + 2*srcstride));
+    __m128i _r3 = _mm_loadu_si128((const __m128i*)(src + 3*srcstride));
+
+    __m128i _r01_0 = _mm_unpacklo_epi32(_r0, _r1);
+    __m128i _r01_1 = _mm_unpackhi_epi32(_r0, _r1);
+    __m128i _r23_0 = _mm_unpacklo_epi32(_r2, _r3);
+    __m128i _r23_1 = _mm_unpackhi_epi32(_r2, _r3);
+
+    _mm_storeu_si128((__m128i*)dst, _mm_unpacklo_epi64(_r01_0, _r23_0));
+    _mm_storeu_si128((__m128i*)(dst + stride), _mm_unpackhi_epi64(_r01_0, _r23_0));
+    _mm_storeu_si128((__m128i*)(dst + 2*stride), _mm_unpacklo_epi64(_r01_1, _r23_1));
+    _mm_storeu_si128((__m128i*)(dst + 3*stride), _mm_unpackhi_epi64(_r01_1, _r23_1));
+}
+
+static inline void transpose_u32_8x8(const unsigned char* src, int srcstride, unsigned char* dst, int stride)
+{
+    transpose_u32_4x4(src, srcstride, dst, stride);
+    transpose_u32_4x4(src + 4*srcstride, srcstride, dst + 16, stride);
+    transpose_u32_4x4(src + 16, srcstride, dst + 4*stride, stride);
+    transpose_u32_4x4(src + 4*srcstride + 16, srcstride, dst + 4*stride + 16, stride);
+}
+#endif // __SSE2__
+
 static void kanna_rotate_1_c1(const unsigned char* src, int srcw, int srch, int srcstride, unsigned char* dst, int w, int /*h*/, int stride)
 {
     const int srcwgap = srcstride - srcw;
@@ -84,6 +208,26 @@ static void kanna_rotate_1_c1(const unsigned char* src, int srcw, int srch, int
         );
         }
 #endif // __aarch64__
+#elif __SSE2__
+        int nn = srcw >> 5;
+        int remain = srcw - (nn << 5);
+        for (; nn>0; nn--)
+        {
+            __m128i _src0 = _mm_loadu_si128((const __m128i*)src0);
+            __m128i _src0n = _mm_loadu_si128((const __m128i*)(src0 + 16));
+            _mm_storeu_si128((__m128i*)dst0, _src0);
+            _mm_storeu_si128((__m128i*)(dst0 + 16), _src0n);
+
+            __m128i _src1 = _mm_loadu_si128((const __m128i*)src1);
+            __m128i _src1n = _mm_loadu_si128((const __m128i*)(src1 + 16));
+            _mm_storeu_si128((__m128i*)dst1, _src1);
+            _mm_storeu_si128((__m128i*)(dst1 + 16), _src1n);
+
+            src0 += 32;
+            src1 += 32;
+            dst0 += 32;
+            dst1 += 32;
+        }
 #else
         int remain = srcw;
 #endif // __ARM_NEON
@@ -136,6 +280,19 @@ static void kanna_rotate_1_c1(const unsigned char* src, int srcw, int srch, int
         );
         }
 #endif // __aarch64__
+#elif __SSE2__
+        int nn = srcw >> 5;
+        int remain = srcw - (nn << 5);
+        for (; nn>0; nn--)
+        {
+            __m128i _src = _mm_loadu_si128((const __m128i*)src0);
+            __m128i _src2 = _mm_loadu_si128((const __m128i*)(src0 + 16));
+            _mm_storeu_si128((__m128i*)dst0, _src);
+            _mm_storeu_si128((__m128i*)(dst0 + 16), _src2);
+
+            src0 += 32;
+            dst0 += 32;
+        }
 #else
         int remain = srcw;
 #endif // __ARM_NEON
@@ -213,6 +370,26 @@ static void kanna_rotate_1_c2(const unsigned char* src, int srcw, int srch, int
         );
         }
 #endif // __aarch64__
+#elif __SSE2__
+        int nn = size >> 5;
+        int remain = size - (nn << 5);
+        for (; nn>0; nn--)
+        {
+            __m128i _src0 = _mm_loadu_si128((const __m128i*)src0);
+            __m128i _src0n = _mm_loadu_si128((const __m128i*)(src0 + 16));
+            _mm_storeu_si128((__m128i*)dst0, _src0);
+            _mm_storeu_si128((__m128i*)(dst0 + 16), _src0n);
+
+            __m128i _src1 = _mm_loadu_si128((const __m128i*)src1);
+            __m128i _src1n = _mm_loadu_si128((const __m128i*)(src1 + 16));
+            _mm_storeu_si128((__m128i*)dst1, _src1);
+            _mm_storeu_si128((__m128i*)(dst1 + 16), _src1n);
+
+            src0 += 32;
+            src1 += 32;
+            dst0 += 32;
+            dst1 += 32;
+        }
 #else
         int remain = size;
 #endif // __ARM_NEON
@@ -265,6 +442,19 @@ static void kanna_rotate_1_c2(const unsigned char* src, int srcw, int srch, int
         );
         }
 #endif // __aarch64__
+#elif __SSE2__
+        int nn = size >> 5;
+        int remain = size - (nn << 5);
+        for (; nn>0; nn--)
+        {
+            __m128i _src = _mm_loadu_si128((const __m128i*)src0);
+            __m128i _src2 = _mm_loadu_si128((const __m128i*)(src0 + 16));
+            _mm_storeu_si128((__m128i*)dst0, _src);
+            _mm_storeu_si128((__m128i*)(dst0 + 16), _src2);
+
+            src0 += 32;
+            dst0 += 32;
+        }
 #else
         int remain = size;
 #endif // __ARM_NEON
@@ -342,6 +532,26 @@ static void kanna_rotate_1_c3(const unsigned char* src, int srcw, int srch, int
         );
         }
 #endif // __aarch64__
+#elif __SSE2__
+        int nn = size >> 5;
+        int remain = size - (nn << 5);
+        for (; nn>0; nn--)
+        {
+            __m128i _src0 = _mm_loadu_si128((const __m128i*)src0);
+            __m128i _src0n = _mm_loadu_si128((const __m128i*)(src0 + 16));
+            _mm_storeu_si128((__m128i*)dst0, _src0);
+            _mm_storeu_si128((__m128i*)(dst0 + 16), _src0n);
+
+            __m128i _src1 = _mm_loadu_si128((const __m128i*)src1);
+            __m128i _src1n = _mm_loadu_si128((const __m128i*)(src1 + 16));
+            _mm_storeu_si128((__m128i*)dst1, _src1);
+            _mm_storeu_si128((__m128i*)(dst1 + 16), _src1n);
+
+            src0 += 32;
+            src1 += 32;
+            dst0 += 32;
+            dst1 += 32;
+        }
 #else
         int remain = size;
 #endif // __ARM_NEON
@@ -394,6 +604,19 @@ static void kanna_rotate_1_c3(const unsigned char* src, int srcw, int srch, int
         );
         }
 #endif // __aarch64__
+#elif __SSE2__
+        int nn = size >> 5;
+        int remain = size - (nn << 5);
+        for (; nn>0; nn--)
+        {
+            __m128i _src = _mm_loadu_si128((const __m128i*)src0);
+            __m128i _src2 = _mm_loadu_si128((const __m128i*)(src0 + 16));
+            _mm_storeu_si128((__m128i*)dst0, _src);
+            _mm_storeu_si128((__m128i*)(dst0 + 16), _src2);
+
+            src0 += 32;
+            dst0 += 32;
+        }
 #else
         int remain = size;
 #endif // __ARM_NEON
@@ -471,6 +694,26 @@ static void kanna_rotate_1_c4(const unsigned char* src, int srcw, int srch, int
         );
         }
 #endif // __aarch64__
+#elif __SSE2__
+        int nn = size >> 5;
+        int remain = size - (nn << 5);
+        for (; nn>0; nn--)
+        {
+            __m128i _src0 = _mm_loadu_si128((const __m128i*)src0);
+            __m128i _src0n = _mm_loadu_si128((const __m128i*)(src0 + 16));
+            _mm_storeu_si128((__m128i*)dst0, _src0);
+            _mm_storeu_si128((__m128i*)(dst0 + 16), _src0n);
+
+            __m128i _src1 = _mm_loadu_si128((const __m128i*)src1);
+            __m128i _src1n = _mm_loadu_si128((const __m128i*)(src1 + 16));
+            _mm_storeu_si128((__m128i*)dst1, _src1);
+            _mm_storeu_si128((__m128i*)(dst1 + 16), _src1n);
+
+            src0 += 32;
+            src1 += 32;
+            dst0 += 32;
+            dst1 += 32;
+        }
 #else
         int remain = size;
 #endif // __ARM_NEON
@@ -523,6 +766,19 @@ static void kanna_rotate_1_c4(const unsigned char* src, int srcw, int srch, int
         );
         }
 #endif // __aarch64__
+#elif __SSE2__
+        int nn = size >> 5;
+        int remain = size - (nn << 5);
+        for (; nn>0; nn--)
+        {
+            __m128i _src = _mm_loadu_si128((const __m128i*)src0);
+            __m128i _src2 = _mm_loadu_si128((const __m128i*)(src0 + 16));
+            _mm_storeu_si128((__m128i*)dst0, _src);
+            _mm_storeu_si128((__m128i*)(dst0 + 16), _src2);
+
+            src0 += 32;
+            dst0 += 32;
+        }
 #else
         int remain = size;
 #endif // __ARM_NEON
@@ -593,6 +849,22 @@ static void kanna_rotate_2_c1(const unsigned char* src, int srcw, int srch, int
         }
 #endif // __aarch64__
 
+        dst0 += 15;
+#elif __SSE2__
+        dst0 -= 15;
+
+        int nn = srcw >> 4;
+        int remain = srcw - (nn << 4);
+
+        for (; nn>0; nn--)
+        {
+            __m128i _src = _mm_loadu_si128((const __m128i*)src0);
+            _mm_storeu_si128((__m128i*)dst0, reverse_u8(_src));
+
+            src0 += 16;
+            dst0 -= 16;
+        }
+
         dst0 += 15;
 #else
         int remain = srcw;
@@ -675,6 +947,22 @@ static void kanna_rotate_2_c2(const unsigned char* src, int srcw, int srch, int
         }
 #endif // __aarch64__
 
+        dst0 += 7*2;
+#elif __SSE2__
+        dst0 -= 7*2;
+
+        int nn = srcw >> 3;
+        int remain = srcw - (nn << 3);
+
+        for (; nn>0; nn--)
+        {
+            __m128i _src = _mm_loadu_si128((const __m128i*)src0);
+            _mm_storeu_si128((__m128i*)dst0, reverse_u16(_src));
+
+            src0 += 8*2;
+            dst0 -= 8*2;
+        }
+
         dst0 += 7*2;
 #else
         int remain = srcw;
@@ -855,6 +1143,22 @@ static void kanna_rotate_2_c4(const unsigned char* src, int srcw, int srch, int
 #endif // __aarch64__
 
         dst0 += 7*4;
+#elif __SSE2__
+        dst0 -= 3*4;
+
+        int nn = srcw >> 2;
+        int remain = srcw - (nn << 2);
+
+        for (; nn>0; nn--)
+        {
+            __m128i _src = _mm_loadu_si128((const __m128i*)src0);
+            _mm_storeu_si128((__m128i*)dst0, reverse_u32(_src));
+
+            src0 += 4*4;
+            dst0 -= 4*4;
+        }
+
+        dst0 += 3*4;
 #else
         int remain = srcw;
 #endif // __ARM_NEON
@@ -934,6 +1238,22 @@ static void kanna_rotate_3_c1(const unsigned char* src, int srcw, int srch, int
         }
 #endif // __aarch64__
 
+        dst0 += 15;
+#elif __SSE2__
+        dst0 -= 15;
+
+        int nn = srcw >> 4;
+        int remain = srcw - (nn << 4);
+
+        for (; nn>0; nn--)
+        {
+            __m128i _src = _mm_loadu_si128((const __m128i*)src0);
+            _mm_storeu_si128((__m128i*)dst0, reverse_u8(_src));
+
+            src0 += 16;
+            dst0 -= 16;
+        }
+
         dst0 += 15;
 #else
         int remain = srcw;
@@ -1019,6 +1339,22 @@ static void kanna_rotate_3_c2(const unsigned char* src, int srcw, int srch, int
         }
 #endif // __aarch64__
 
+        dst0 += 7*2;
+#elif __SSE2__
+        dst0 -= 7*2;
+
+        int nn = srcw >> 3;
+        int remain = srcw - (nn << 3);
+
+        for (; nn>0; nn--)
+        {
+            __m128i _src = _mm_loadu_si128((const __m128i*)src0);
+            _mm_storeu_si128((__m128i*)dst0, reverse_u16(_src));
+
+            src0 += 8*2;
+            dst0 -= 8*2;
+        }
+
         dst0 += 7*2;
 #else
         int remain = srcw;
@@ -1205,6 +1541,22 @@ static void kanna_rotate_3_c4(const unsigned char* src, int srcw, int srch, int
 #endif // __aarch64__
 
         dst0 += 7*4;
+#elif __SSE2__
+        dst0 -= 3*4;
+
+        int nn = srcw >> 2;
+        int remain = srcw - (nn << 2);
+
+        for (; nn>0; nn--)
+        {
+            __m128i _src = _mm_loadu_si128((const __m128i*)src0);
+            _mm_storeu_si128((__m128i*)dst0, reverse_u32(_src));
+
+            src0 += 4*4;
+            dst0 -= 4*4;
+        }
+
+        dst0 += 3*4;
 #else
         int remain = srcw;
 #endif // __ARM_NEON
@@ -1289,6 +1641,26 @@ static void kanna_rotate_4_c1(const unsigned char* src, int srcw, int srch, int
         );
         }
 #endif // __aarch64__
+#elif __SSE2__
+        int nn = srcw >> 5;
+        int remain = srcw - (nn << 5);
+        for (; nn>0; nn--)
+        {
+            __m128i _src0 = _mm_loadu_si128((const __m128i*)src0);
+            __m128i _src0n = _mm_loadu_si128((const __m128i*)(src0 + 16));
+            _mm_storeu_si128((__m128i*)dst0, _src0);
+            _mm_storeu_si128((__m128i*)(dst0 + 16), _src0n);
+
+            __m128i _src1 = _mm_loadu_si128((const __m128i*)src1);
+            __m128i _src1n = _mm_loadu_si128((const __m128i*)(src1 + 16));
+            _mm_storeu_si128((__m128i*)dst1, _src1);
+            _mm_storeu_si128((__m128i*)(dst1 + 16), _src1n);
+
+            src0 += 32;
+            src1 += 32;
+            dst0 += 32;
+            dst1 += 32;
+        }
 #else
         int remain = srcw;
 #endif // __ARM_NEON
@@ -1341,6 +1713,19 @@ static void kanna_rotate_4_c1(const unsigned char* src, int srcw, int srch, int
         );
         }
 #endif // __aarch64__
+#elif __SSE2__
+        int nn = srcw >> 5;
+        int remain = srcw - (nn << 5);
+        for (; nn>0; nn--)
+        {
+            __m128i _src = _mm_loadu_si128((const __m128i*)src0);
+            __m128i _src2 = _mm_loadu_si128((const __m128i*)(src0 + 16));
+            _mm_storeu_si128((__m128i*)dst0, _src);
+            _mm_storeu_si128((__m128i*)(dst0 + 16), _src2);
+
+            src0 += 32;
+            dst0 += 32;
+        }
 #else
         int remain = srcw;
 #endif // __ARM_NEON
@@ -1421,6 +1806,26 @@ static void kanna_rotate_4_c2(const unsigned char* src, int srcw, int srch, int
         );
         }
 #endif // __aarch64__
+#elif __SSE2__
+        int nn = size >> 5;
+        int remain = size - (nn << 5);
+        for (; nn>0; nn--)
+        {
+            __m128i _src0 = _mm_loadu_si128((const __m128i*)src0);
+            __m128i _src0n = _mm_loadu_si128((const __m128i*)(src0 + 16));
+            _mm_storeu_si128((__m128i*)dst0, _src0);
+            _mm_storeu_si128((__m128i*)(dst0 + 16), _src0n);
+
+            __m128i _src1 = _mm_loadu_si128((const __m128i*)src1);
+            __m128i _src1n = _mm_loadu_si128((const __m128i*)(src1 + 16));
+            _mm_storeu_si128((__m128i*)dst1, _src1);
+            _mm_storeu_si128((__m128i*)(dst1 + 16), _src1n);
+
+            src0 += 32;
+            src1 += 32;
+            dst0 += 32;
+            dst1 += 32;
+        }
 #else
         int remain = size;
 #endif // __ARM_NEON
@@ -1473,6 +1878,19 @@ static void kanna_rotate_4_c2(const unsigned char* src, int srcw, int srch, int
         );
         }
 #endif // __aarch64__
+#elif __SSE2__
+        int nn = size >> 5;
+        int remain = size - (nn << 5);
+        for (; nn>0; nn--)
+        {
+            __m128i _src = _mm_loadu_si128((const __m128i*)src0);
+            __m128i _src2 = _mm_loadu_si128((const __m128i*)(src0 + 16));
+            _mm_storeu_si128((__m128i*)dst0, _src);
+            _mm_storeu_si128((__m128i*)(dst0 + 16), _src2);
+
+            src0 += 32;
+            dst0 += 32;
+        }
 #else
         int remain = size;
 #endif // __ARM_NEON
@@ -1553,6 +1971,26 @@ static void kanna_rotate_4_c3(const unsigned char* src, int srcw, int srch, int
         );
         }
 #endif // __aarch64__
+#elif __SSE2__
+        int nn = size >> 5;
+        int remain = size - (nn << 5);
+        for (; nn>0; nn--)
+        {
+            __m128i _src0 = _mm_loadu_si128((const __m128i*)src0);
+            __m128i _src0n = _mm_loadu_si128((const __m128i*)(src0 + 16));
+            _mm_storeu_si128((__m128i*)dst0, _src0);
+            _mm_storeu_si128((__m128i*)(dst0 + 16), _src0n);
+
+            __m128i _src1 = _mm_loadu_si128((const __m128i*)src1);
+            __m128i _src1n = _mm_loadu_si128((const __m128i*)(src1 + 16));
+            _mm_storeu_si128((__m128i*)dst1, _src1);
+            _mm_storeu_si128((__m128i*)(dst1 + 16), _src1n);
+
+            src0 += 32;
+            src1 += 32;
+            dst0 += 32;
+            dst1 += 32;
+        }
 #else
         int remain = size;
 #endif // __ARM_NEON
@@ -1605,6 +2043,19 @@ static void kanna_rotate_4_c3(const unsigned char* src, int srcw, int srch, int
         );
         }
 #endif // __aarch64__
+#elif __SSE2__
+        int nn = size >> 5;
+        int remain = size - (nn << 5);
+        for (; nn>0; nn--)
+        {
+            __m128i _src = _mm_loadu_si128((const __m128i*)src0);
+            __m128i _src2 = _mm_loadu_si128((const __m128i*)(src0 + 16));
+            _mm_storeu_si128((__m128i*)dst0, _src);
+            _mm_storeu_si128((__m128i*)(dst0 + 16), _src2);
+
+            src0 += 32;
+            dst0 += 32;
+        }
 #else
         int remain = size;
 #endif // __ARM_NEON
@@ -1685,6 +2136,26 @@ static void kanna_rotate_4_c4(const unsigned char* src, int srcw, int srch, int
         );
         }
 #endif // __aarch64__
+#elif __SSE2__
+        int nn = size >> 5;
+        int remain = size - (nn << 5);
+        for (; nn>0; nn--)
+        {
+            __m128i _src0 = _mm_loadu_si128((const __m128i*)src0);
+            __m128i _src0n = _mm_loadu_si128((const __m128i*)(src0 + 16));
+            _mm_storeu_si128((__m128i*)dst0, _src0);
+            _mm_storeu_si128((__m128i*)(dst0 + 16), _src0n);
+
+            __m128i _src1 = _mm_loadu_si128((const __m128i*)src1);
+            __m128i _src1n = _mm_loadu_si128((const __m128i*)(src1 + 16));
+            _mm_storeu_si128((__m128i*)dst1, _src1);
+            _mm_storeu_si128((__m128i*)(dst1 + 16), _src1n);
+
+            src0 += 32;
+            src1 += 32;
+            dst0 += 32;
+            dst1 += 32;
+        }
 #else
         int remain = size;
 #endif // __ARM_NEON
@@ -1737,6 +2208,19 @@ static void kanna_rotate_4_c4(const unsigned char* src, int srcw, int srch, int
         );
         }
 #endif // __aarch64__
+#elif __SSE2__
+        int nn = size >> 5;
+        int remain = size - (nn << 5);
+        for (; nn>0; nn--)
+        {
+            __m128i _src = _mm_loadu_si128((const __m128i*)src0);
+            __m128i _src2 = _mm_loadu_si128((const __m128i*)(src0 + 16));
+            _mm_storeu_si128((__m128i*)dst0, _src);
+            _mm_storeu_si128((__m128i*)(dst0 + 16), _src2);
+
+            src0 += 32;
+            dst0 += 32;
+        }
 #else
         int remain = size;
 #endif // __ARM_NEON
@@ -1758,7 +2242,7 @@ static void kanna_rotate_5_c1(const unsigned char* src, int srcw, int srch, int
     const unsigned char* src0 = src;
 
     int y = 0;
-#if __ARM_NEON
+#if __ARM_NEON || __SSE2__
     for (; y+7<srch; y+=8)
     {
         const unsigned char* src1 = src0 + srcstride;
@@ -1772,6 +2256,7 @@ static void kanna_rotate_5_c1(const unsigned char* src, int srcw, int srch, int
         int nn = srcw >> 3;
         int remain = srcw - (nn << 3);
 
+#if __ARM_NEON
 #if __aarch64__
         for (; nn>0; nn--)
         {
@@ -1907,6 +2392,18 @@ static void kanna_rotate_5_c1(const unsigned char* src, int srcw, int srch, int
         );
         }
 #endif // __aarch64__
+#else
+        for (; nn>0; nn--)
+        {
+            transpose_u8_8x8(src0, srcstride, dst0, stride);
+
+            src0 += 8;
+            src1 += 8;
+
+            dst0 += 4*dst_step;
+            dst1 += 4*dst_step;
+        }
+#endif // __ARM_NEON
         for (; remain>0; remain--)
         {
             dst0[0] = src0[0];
@@ -1926,7 +2423,7 @@ static void kanna_rotate_5_c1(const unsigned char* src, int srcw, int srch, int
 
         src0 += srcwgap + 7*srcstride;
     }
-#endif // __ARM_NEON
+#endif // __ARM_NEON || __SSE2__
     for (; y<srch; y++)
     {
         unsigned char* dst0 = dst + y;
@@ -1951,7 +2448,7 @@ static void kanna_rotate_5_c2(const unsigned char* src, int srcw, int srch, int
     const unsigned char* src0 = src;
 
     int y = 0;
-#if __ARM_NEON
+#if __ARM_NEON || __SSE2__
     for (; y+7<srch; y+=8)
     {
         const unsigned char* src1 = src0 + srcstride;
@@ -1965,6 +2462,7 @@ static void kanna_rotate_5_c2(const unsigned char* src, int srcw, int srch, int
         int nn = srcw >> 3;
         int remain = srcw - (nn << 3);
 
+#if __ARM_NEON
 #if __aarch64__
         for (; nn>0; nn--)
         {
@@ -2141,6 +2639,18 @@ static void kanna_rotate_5_c2(const unsigned char* src, int srcw, int srch, int
         );
         }
 #endif // __aarch64__
+#else
+        for (; nn>0; nn--)
+        {
+            transpose_u16_8x8(src0, srcstride, dst0, stride);
+
+            src0 += 2*8;
+            src1 += 2*8;
+
+            dst0 += 4*dst_step;
+            dst1 += 4*dst_step;
+        }
+#endif // __ARM_NEON
         for (; remain>0; remain--)
         {
             dst0[0] = src0[0];
@@ -2168,7 +2678,7 @@ static void kanna_rotate_5_c2(const unsigned char* src, int srcw, int srch, int
 
         src0 += srcwgap + 7*srcstride;
     }
-#endif // __ARM_NEON
+#endif // __ARM_NEON || __SSE2__
     for (; y<srch; y++)
     {
         unsigned char* dst0 = dst + y*2;
@@ -2482,7 +2992,7 @@ static void kanna_rotate_5_c4(const unsigned char* src, int srcw, int srch, int
     const unsigned char* src0 = src;
 
     int y = 0;
-#if __ARM_NEON
+#if __ARM_NEON || __SSE2__
     for (; y+7<srch; y+=8)
     {
         const unsigned char* src1 = src0 + srcstride;
@@ -2496,6 +3006,7 @@ static void kanna_rotate_5_c4(const unsigned char* src, int srcw, int srch, int
         int nn = srcw >> 3;
         int remain = srcw - (nn << 3);
 
+#if __ARM_NEON
 #if __aarch64__
         for (; nn>0; nn--)
         {
@@ -2732,6 +3243,18 @@ static void kanna_rotate_5_c4(const unsigned char* src, int srcw, int srch, int
         );
         }
 #endif // __aarch64__
+#else
+        for (; nn>0; nn--)
+        {
+            transpose_u32_8x8(src0, srcstride, dst0, stride);
+
+            src0 += 4*8;
+            src1 += 4*8;
+
+            dst0 += 4*dst_step;
+            dst1 += 4*dst_step;
+        }
+#endif // __ARM_NEON
         for (; remain>0; remain--)
         {
             dst0[0] = src0[0];
@@ -2775,7 +3298,7 @@ static void kanna_rotate_5_c4(const unsigned char* src, int srcw, int srch, int
 
         src0 += srcwgap + 7*srcstride;
     }
-#endif // __ARM_NEON
+#endif // __ARM_NEON || __SSE2__
     for (; y<srch; y++)
     {
         unsigned char* dst0 = dst + y*4;
@@ -2806,7 +3329,7 @@ static void kanna_rotate_6_c1(const unsigned char* src, int srcw, int srch, int
     const unsigned char* src0 = src;
 
     int y = 0;
-#if __ARM_NEON
+#if __ARM_NEON || __SSE2__
     for (; y+7<srch; y+=8)
     {
         const unsigned char* src1 = src0 + srcstride;
@@ -2820,6 +3343,7 @@ static void kanna_rotate_6_c1(const unsigned char* src, int srcw, int srch, int
         int nn = srcw >> 3;
         int remain = srcw - (nn << 3);
 
+#if __ARM_NEON
 #if __aarch64__
         for (; nn>0; nn--)
         {
@@ -2955,6 +3479,18 @@ static void kanna_rotate_6_c1(const unsigned char* src, int srcw, int srch, int
         );
         }
 #endif // __aarch64__
+#else
+        for (; nn>0; nn--)
+        {
+            transpose_u8_8x8(src0 + 7*srcstride, -srcstride, dst0, stride);
+
+            src0 += 8;
+            src1 += 8;
+
+            dst0 += 4*dst_step;
+            dst1 += 4*dst_step;
+        }
+#endif // __ARM_NEON
         for (; remain>0; remain--)
         {
             dst0[0] = src1[0 + 3*src_step];
@@ -2974,7 +3510,7 @@ static void kanna_rotate_6_c1(const unsigned char* src, int srcw, int srch, int
 
         src0 += srcwgap + 7*srcstride;
     }
-#endif // __ARM_NEON
+#endif // __ARM_NEON || __SSE2__
     for (; y<srch; y++)
     {
         unsigned char* dst0 = dstend - y - 1;
@@ -3002,7 +3538,7 @@ static void kanna_rotate_6_c2(const unsigned char* src, int srcw, int srch, int
     const unsigned char* src0 = src;
 
     int y = 0;
-#if __ARM_NEON
+#if __ARM_NEON || __SSE2__
     for (; y+7<srch; y+=8)
     {
         const unsigned char* src1 = src0 + srcstride;
@@ -3016,6 +3552,7 @@ static void kanna_rotate_6_c2(const unsigned char* src, int srcw, int srch, int
         int nn = srcw >> 3;
         int remain = srcw - (nn << 3);
 
+#if __ARM_NEON
 #if __aarch64__
         for (; nn>0; nn--)
         {
@@ -3192,6 +3729,18 @@ static void kanna_rotate_6_c2(const unsigned char* src, int srcw, int srch, int
         );
         }
 #endif // __aarch64__
+#else
+        for (; nn>0; nn--)
+        {
+            transpose_u16_8x8(src0 + 7*srcstride, -srcstride, dst0, stride);
+
+            src0 += 2*8;
+            src1 += 2*8;
+
+            dst0 += 4*dst_step;
+            dst1 += 4*dst_step;
+        }
+#endif // __ARM_NEON
         for (; remain>0; remain--)
         {
             dst0[0] = src1[0 + 3*src_step];
@@ -3219,7 +3768,7 @@ static void kanna_rotate_6_c2(const unsigned char* src, int srcw, int srch, int
 
         src0 += srcwgap + 7*srcstride;
     }
-#endif // __ARM_NEON
+#endif // __ARM_NEON || __SSE2__
     for (; y<srch; y++)
     {
         unsigned char* dst0 = dstend - y*2 - 2;
@@ -3539,7 +4088,7 @@ static void kanna_rotate_6_c4(const unsigned char* src, int srcw, int srch, int
     const unsigned char* src0 = src;
 
     int y = 0;
-#if __ARM_NEON
+#if __ARM_NEON || __SSE2__
     for (; y+7<srch; y+=8)
     {
         const unsigned char* src1 = src0 + srcstride;
@@ -3553,6 +4102,7 @@ static void kanna_rotate_6_c4(const unsigned char* src, int srcw, int srch, int
         int nn = srcw >> 3;
         int remain = srcw - (nn << 3);
 
+#if __ARM_NEON
 #if __aarch64__
         for (; nn>0; nn--)
         {
@@ -3789,6 +4339,18 @@ static void kanna_rotate_6_c4(const unsigned char* src, int srcw, int srch, int
         );
         }
 #endif // __aarch64__
+#else
+        for (; nn>0; nn--)
+        {
+            transpose_u32_8x8(src0 + 7*srcstride, -srcstride, dst0, stride);
+
+            src0 += 4*8;
+            src1 += 4*8;
+
+            dst0 += 4*dst_step;
+            dst1 += 4*dst_step;
+        }
+#endif // __ARM_NEON
         for (; remain>0; remain--)
         {
             dst0[0] = src1[0 + 3*src_step];
@@ -3832,7 +4394,7 @@ static void kanna_rotate_6_c4(const unsigned char* src, int srcw, int srch, int
 
         src0 += srcwgap + 7*srcstride;
     }
-#endif // __ARM_NEON
+#endif // __ARM_NEON || __SSE2__
     for (; y<srch; y++)
     {
         unsigned char* dst0 = dstend - y*4 - 4;
@@ -3863,7 +4425,7 @@ static void kanna_rotate_7_c1(const unsigned char* src, int srcw, int srch, int
     const unsigned char* src0 = src;
 
     int y = 0;
-#if __ARM_NEON
+#if __ARM_NEON || __SSE2__
     for (; y+7<srch; y+=8)
     {
         const unsigned char* src1 = src0 + srcstride;
@@ -3877,6 +4439,7 @@ static void kanna_rotate_7_c1(const unsigned char* src, int srcw, int srch, int
         int nn = srcw >> 3;
         int remain = srcw - (nn << 3);
 
+#if __ARM_NEON
 #if __aarch64__
         for (; nn>0; nn--)
         {
@@ -4012,6 +4575,18 @@ static void kanna_rotate_7_c1(const unsigned char* src, int srcw, int srch, int
         );
         }
 #endif // __aarch64__
+#else
+        for (; nn>0; nn--)
+        {
+            transpose_u8_8x8(src0 + 7*srcstride, -srcstride, dst7, -stride);
+
+            src0 += 8;
+            src1 += 8;
+
+            dst7 += 4*dst_step;
+            dst6 += 4*dst_step;
+        }
+#endif // __ARM_NEON
         for (; remain>0; remain--)
         {
             dst7[0] = src1[0 + 3*src_step];
@@ -4031,7 +4606,7 @@ static void kanna_rotate_7_c1(const unsigned char* src, int srcw, int srch, int
 
         src0 += srcwgap + 7*srcstride;
     }
-#endif // __ARM_NEON
+#endif // __ARM_NEON || __SSE2__
     for (; y<srch; y++)
     {
         unsigned char* dst0 = dstend - y - 1;
@@ -4059,7 +4634,7 @@ static void kanna_rotate_7_c2(const unsigned char* src, int srcw, int srch, int
     const unsigned char* src0 = src;
 
     int y = 0;
-#if __ARM_NEON
+#if __ARM_NEON || __SSE2__
     for (; y+7<srch; y+=8)
     {
         const unsigned char* src1 = src0 + srcstride;
@@ -4073,6 +4648,7 @@ static void kanna_rotate_7_c2(const unsigned char* src, int srcw, int srch, int
         int nn = srcw >> 3;
         int remain = srcw - (nn << 3);
 
+#if __ARM_NEON
 #if __aarch64__
         for (; nn>0; nn--)
         {
@@ -4249,6 +4825,18 @@ static void kanna_rotate_7_c2(const unsigned char* src, int srcw, int srch, int
         );
         }
 #endif // __aarch64__
+#else
+        for (; nn>0; nn--)
+        {
+            transpose_u16_8x8(src0 + 7*srcstride, -srcstride, dst7, -stride);
+
+            src0 += 2*8;
+            src1 += 2*8;
+
+            dst7 += 4*dst_step;
+            dst6 += 4*dst_step;
+        }
+#endif // __ARM_NEON
         for (; remain>0; remain--)
         {
             dst7[0] = src1[0 + 3*src_step];
@@ -4276,7 +4864,7 @@ static void kanna_rotate_7_c2(const unsigned char* src, int srcw, int srch, int
 
         src0 += srcwgap + 7*srcstride;
     }
-#endif // __ARM_NEON
+#endif // __ARM_NEON || __SSE2__
     for (; y<srch; y++)
     {
         unsigned char* dst0 = dstend - y*2 - 2;
@@ -4596,7 +5184,7 @@ static void kanna_rotate_7_c4(const unsigned char* src, int srcw, int srch, int
     const unsigned char* src0 = src;
 
     int y = 0;
-#if __ARM_NEON
+#if __ARM_NEON || __SSE2__
     for (; y+7<srch; y+=8)
     {
         const unsigned char* src1 = src0 + srcstride;
@@ -4610,6 +5198,7 @@ static void kanna_rotate_7_c4(const unsigned char* src, int srcw, int srch, int
         int nn = srcw >> 3;
         int remain = srcw - (nn << 3);
 
+#if __ARM_NEON
 #if __aarch64__
         for (; nn>0; nn--)
         {
@@ -4846,6 +5435,18 @@ static void kanna_rotate_7_c4(const unsigned char* src, int srcw, int srch, int
         );
         }
 #endif // __aarch64__
+#else
+        for (; nn>0; nn--)
+        {
+            transpose_u32_8x8(src0 + 7*srcstride, -srcstride, dst7, -stride);
+
+            src0 += 4*8;
+            src1 += 4*8;
+
+            dst7 += 4*dst_step;
+            dst6 += 4*dst_step;
+        }
+#endif // __ARM_NEON
         for (; remain>0; remain--)
         {
             dst7[0] = src1[0 + 3*src_step];
@@ -4889,7 +5490,7 @@ static void kanna_rotate_7_c4(const unsigned char* src, int srcw, int srch, int
 
         src0 += srcwgap + 7*srcstride;
     }
-#endif // __ARM_NEON
+#endif // __ARM_NEON || __SSE2__
     for (; y<srch; y++)
     {
         unsigned char* dst0 = dstend - y*4 - 4;
@@ -4920,7 +5521,7 @@ static void kanna_rotate_8_c1(const unsigned char* src, int srcw, int srch, int
     const unsigned char* src0 = src;
 
     int y = 0;
-#if __ARM_NEON
+#if __ARM_NEON || __SSE2__
     for (; y+7<srch; y+=8)
     {
         const unsigned char* src1 = src0 + srcstride;
@@ -4934,6 +5535,7 @@ static void kanna_rotate_8_c1(const unsigned char* src, int srcw, int srch, int
         int nn = srcw >> 3;
         int remain = srcw - (nn << 3);
 
+#if __ARM_NEON
 #if __aarch64__
         for (; nn>0; nn--)
         {
@@ -5069,6 +5671,18 @@ static void kanna_rotate_8_c1(const unsigned char* src, int srcw, int srch, int
         );
         }
 #endif // __aarch64__
+#else
+        for (; nn>0; nn--)
+        {
+            transpose_u8_8x8(src0, srcstride, dst7, -stride);
+
+            src0 += 8;
+            src1 += 8;
+
+            dst7 += 4*dst_step;
+            dst6 += 4*dst_step;
+        }
+#endif // __ARM_NEON
         for (; remain>0; remain--)
         {
             dst7[0] = src0[0];
@@ -5088,7 +5702,7 @@ static void kanna_rotate_8_c1(const unsigned char* src, int srcw, int srch, int
 
         src0 += srcwgap + 7*srcstride;
     }
-#endif // __ARM_NEON
+#endif // __ARM_NEON || __SSE2__
     for (; y<srch; y++)
     {
         unsigned char* dst0 = dstend + y;
@@ -5116,7 +5730,7 @@ static void kanna_rotate_8_c2(const unsigned char* src, int srcw, int srch, int
     const unsigned char* src0 = src;
 
     int y = 0;
-#if __ARM_NEON
+#if __ARM_NEON || __SSE2__
     for (; y+7<srch; y+=8)
     {
         const unsigned char* src1 = src0 + srcstride;
@@ -5130,6 +5744,7 @@ static void kanna_rotate_8_c2(const unsigned char* src, int srcw, int srch, int
         int nn = srcw >> 3;
         int remain = srcw - (nn << 3);
 
+#if __ARM_NEON
 #if __aarch64__
         for (; nn>0; nn--)
         {
@@ -5306,6 +5921,18 @@ static void kanna_rotate_8_c2(const unsigned char* src, int srcw, int srch, int
         );
         }
 #endif // __aarch64__
+#else
+        for (; nn>0; nn--)
+        {
+            transpose_u16_8x8(src0, srcstride, dst7, -stride);
+
+            src0 += 2*8;
+            src1 += 2*8;
+
+            dst7 += 4*dst_step;
+            dst6 += 4*dst_step;
+        }
+#endif // __ARM_NEON
         for (; remain>0; remain--)
         {
             dst7[0] = src0[0];
@@ -5333,7 +5960,7 @@ static void kanna_rotate_8_c2(const unsigned char* src, int srcw, int srch, int
 
         src0 += srcwgap + 7*srcstride;
     }
-#endif // __ARM_NEON
+#endif // __ARM_NEON || __SSE2__
     for (; y<srch; y++)
     {
         unsigned char* dst0 = dstend + y*2;
@@ -5653,7 +6280,7 @@ static void kanna_rotate_8_c4(const unsigned char* src, int srcw, int srch, int
     const unsigned char* src0 = src;
 
     int y = 0;
-#if __ARM_NEON
+#if __ARM_NEON || __SSE2__
     for (; y+7<srch; y+=8)
     {
         const unsigned char* src1 = src0 + srcstride;
@@ -5667,6 +6294,7 @@ static void kanna_rotate_8_c4(const unsigned char* src, int srcw, int srch, int
         int nn = srcw >> 3;
         int remain = srcw - (nn << 3);
 
+#if __ARM_NEON
 #if __aarch64__
         for (; nn>0; nn--)
         {
@@ -5903,6 +6531,18 @@ static void kanna_rotate_8_c4(const unsigned char* src, int srcw, int srch, int
         );
         }
 #endif // __aarch64__
+#else
+        for (; nn>0; nn--)
+        {
+            transpose_u32_8x8(src0, srcstride, dst7, -stride);
+
+            src0 += 4*8;
+            src1 += 4*8;
+
+            dst7 += 4*dst_step;
+            dst6 += 4*dst_step;
+        }
+#endif // __ARM_NEON
         for (; remain>0; remain--)
         {
             dst7[0] = src0[0];
@@ -5946,7 +6586,7 @@ static void kanna_rotate_8_c4(const unsigned char* src, int srcw, int srch, int
 
         src0 += srcwgap + 7*srcstride;
     }
-#endif // __ARM_NEON
+#endif // __ARM_NEON || __SSE2__
     for (; y<srch; y++)
     {
         unsigned char* dst0 = dstend + y*4;
@@ -45,6 +45,63 @@ ModelBinFromDataReader::ModelBinFromDataReader(const DataReader& _dr) : dr(_dr)
 {
 }
 
+// raw elements stored as is, padded to 4 bytes
+// referenced in place when the reader allows it, otherwise read into a new mat
+static Mat load_raw(const DataReader& dr, int w, size_t elemsize)
+{
+    const size_t data_size = w * elemsize;
+    const size_t align_data_size = alignSize(data_size, 4);
+
+    const void* ref = 0;
+    if (dr.reference(&dr, align_data_size, &ref) == align_data_size)
+    {
+        // the format keeps every chunk 4 byte aligned
+        return Mat(w, (void*)ref, elemsize);
+    }
+
+    Mat m(w, elemsize);
+    if (m.empty())
+        return m;
+
+    size_t nread = dr.read(&dr, m.data, data_size);
+    if (nread != data_size)
+    {
+        fprintf(stderr, "ModelBin read weight_data failed %zd\n", nread);
+        return Mat();
+    }
+
+    if (align_data_size != data_size)
+    {
+        unsigned char padding[4];
+        nread = dr.read(&dr, padding, align_data_size - data_size);
+        if (nread != align_data_size - data_size)
+        {
+            fprintf(stderr, "ModelBin read weight_data padding failed %zd\n", nread);
+            return Mat();
+        }
+    }
+
+    return m;
+}
+
+// read size bytes, in place when the reader allows it, otherwise through buf
+static const void* reference_or_read(const DataReader& dr, size_t size, std::vector<unsigned char>& buf)
+{
+    const void* ref = 0;
+    if (dr.reference(&dr, size, &ref) == size)
+        return ref;
+
+    buf.resize(size);
+    size_t nread = dr.read(&dr, buf.data(), size);
+    if (nread != size)
+    {
+        fprintf(stderr, "ModelBin read failed %zd\n", nread);
+        return 0;
+    }
+
+    return buf.data();
+}
+
 Mat ModelBinFromDataReader::load(int w, int type) const
 {
     if (type == 0)
@@ -76,114 +133,62 @@ Mat ModelBinFromDataReader::load(int w, int type) const
         {
             // half-precision data
             size_t align_data_size = alignSize(w * sizeof(unsigned short), 4);
-            std::vector<unsigned short> float16_weights;
-            float16_weights.resize(align_data_size);
-            nread = dr.read(&dr, float16_weights.data(), align_data_size);
-            if (nread != align_data_size)
-            {
-                fprintf(stderr, "ModelBin read float16_weights failed %zd\n", nread);
+            std::vector<unsigned char> buf;
+            const void* float16_weights = reference_or_read(dr, align_data_size, buf);
+            if (!float16_weights)
                 return Mat();
-            }
 
-            return Mat::from_float16(float16_weights.data(), w);
+            return Mat::from_float16((const unsigned short*)float16_weights, w);
         }
         else if (flag_struct.tag == 0x000D4B38)
         {
             // int8 data
-            size_t align_data_size = alignSize(w, 4);
-            std::vector<signed char> int8_weights;
-            int8_weights.resize(align_data_size);
-            nread = dr.read(&dr, int8_weights.data(), align_data_size);
-            if (nread != align_data_size)
-            {
-                fprintf(stderr, "ModelBin read int8_weights failed %zd\n", nread);
-                return Mat();
-            }
-
-            Mat m(w, (size_t)1u);
-            if (m.empty())
-                return m;
-
-            memcpy(m.data, int8_weights.data(), w);
-
-            return m;
+            return load_raw(dr, w, (size_t)1u);
         }
         else if (flag_struct.tag == 0x0002C056)
         {
-            Mat m(w);
-            if (m.empty())
-                return m;
-
             // raw data with extra scaling
-            nread = dr.read(&dr, m, w * sizeof(float));
-            if (nread != w * sizeof(float))
-            {
-                fprintf(stderr, "ModelBin read weight_data failed %zd\n", nread);
-                return Mat();
-            }
-
-            return m;
+            return load_raw(dr, w, (size_t)4u);
         }
 
-        Mat m(w);
-        if (m.empty())
-            return m;
-
         if (flag != 0)
         {
+            Mat m(w);
+            if (m.empty())
+                return m;
+
             // quantized data
-            float quantization_value[256];
-            nread = dr.read(&dr, quantization_value, 256 * sizeof(float));
-            if (nread != 256 * sizeof(float))
-            {
-                fprintf(stderr, "ModelBin read quantization_value failed %zd\n", nread);
+            std::vector<unsigned char> quantization_buf;
+            const float* quantization_value = (const float*)reference_or_read(dr, 256 * sizeof(float), quantization_buf);
+            if (!quantization_value)
                 return Mat();
-            }
 
             size_t align_weight_data_size = alignSize(w * sizeof(unsigned char), 4);
-            std::vector<unsigned char> index_array;
-            index_array.resize(align_weight_data_size);
-            nread = dr.read(&dr, index_array.data(), align_weight_data_size);
-            if (nread != align_weight_data_size)
-            {
-                fprintf(stderr, "ModelBin read index_array failed %zd\n", nread);
+            std::vector<unsigned char> index_buf;
+            const unsigned char* index_array = (const unsigned char*)reference_or_read(dr, align_weight_data_size, index_buf);
+            if (!index_array)
                 return Mat();
-            }
 
             float* ptr = m;
             for (int i = 0; i < w; i++)
             {
                 ptr[i] = quantization_value[ index_array[i] ];
             }
+
+            return m;
         }
         else if (flag_struct.f0 == 0)
         {
             // raw data
-            nread = dr.read(&dr, m, w * sizeof(float));
-            if (nread != w * sizeof(float))
-            {
-                fprintf(stderr, "ModelBin read weight_data failed %zd\n", nread);
-                return Mat();
-            }
+            return load_raw(dr, w, (size_t)4u);
         }
 
-        return m;
+        return Mat(w);
     }
     else if (type == 1)
     {
-        Mat m(w);
-        if (m.empty())
-            return m;
-
         // raw data
-        size_t nread = dr.read(&dr, m, w * sizeof(float));
-        if (nread != w * sizeof(float))
-        {
-            fprintf(stderr, "ModelBin read weight_data failed %zd\n", nread);
-            return Mat();
-        }
-
-        return m;
+        return load_raw(dr, w, (size_t)4u);
     }
     else
     {
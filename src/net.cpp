@@ -17,14 +17,30 @@
 #include "datareader.h"
 #include "modelbin.h"
 #include "paramdict.h"
+#include "profiler.h"
 #include "convolution.h"
 #include "convolutiondepthwise.h"
+#include "innerproduct.h"
+#include "batchnorm.h"
+#include "scale.h"
+#include "bias.h"
+#include "binaryop.h"
+#include "dropout.h"
 #include "relu.h"
+#include "clip.h"
+#include "hardswish.h"
+#include "reshape.h"
+#include "concat.h"
+#include "threadpool.h"
 
 #include <stdarg.h>
 #include <stdio.h>
 #include <string.h>
 #include <stdint.h>
+#include <algorithm>
+#include <functional>
+#include <queue>
+#include <utility>
 
 #include "cstl/strings.h"
 
@@ -32,11 +48,103 @@
 #include "benchmark.h"
 #endif // NCNN_BENCHMARK
 
+#if NCNN_STRING
+typedef const char* (*name_at_func)(const Net* net, int index);
+
+static const char* blob_name_at(const Net* net, int index)
+{
+    return vector_get(net->blobs, index).name;
+}
+
+static const char* layer_name_at(const Net* net, int index)
+{
+    return vector_get(net->layers, index)->name;
+}
+
+// fnv-1a
+static unsigned int name_hash(const char* name)
+{
+    unsigned int hash = 2166136261u;
+    for (const unsigned char* p = (const unsigned char*)name; *p; p++)
+    {
+        hash = (hash ^ *p) * 16777619u;
+    }
+
+    return hash;
+}
+
+// room for count names, the table stays at most half full
+static void name_index_reset(NameIndex& ni, size_t count)
+{
+    size_t capacity = 16;
+    while (capacity < count * 2)
+        capacity <<= 1;
+
+    ni.slots.assign(capacity, -1);
+    ni.hashes.assign(capacity, 0);
+}
+
+// the slot holding name, or the empty slot it would go to
+static size_t name_index_probe(const NameIndex& ni, const Net* net, name_at_func name_at, const char* name, unsigned int hash)
+{
+    const size_t mask = ni.slots.size() - 1;
+
+    size_t i = hash & mask;
+    while (ni.slots[i] != -1)
+    {
+        if (ni.hashes[i] == hash && strcmp(name_at(net, ni.slots[i]), name) == 0)
+            break;
+
+        i = (i + 1) & mask;
+    }
+
+    return i;
+}
+
+// a name seen before keeps its first index, as a linear search would find
+static void name_index_insert(NameIndex& ni, const Net* net, name_at_func name_at, int index)
+{
+    const char* name = name_at(net, index);
+    const unsigned int hash = name_hash(name);
+
+    size_t i = name_index_probe(ni, net, name_at, name, hash);
+    if (ni.slots[i] != -1)
+        return;
+
+    ni.slots[i] = index;
+    ni.hashes[i] = hash;
+}
+
+// return -1 if not found
+static int name_index_find(const NameIndex& ni, const Net* net, name_at_func name_at, const char* name)
+{
+    size_t i = name_index_probe(ni, net, name_at, name, name_hash(name));
+    return ni.slots[i];
+}
+
+static void build_layer_name_index(Net* net)
+{
+    name_index_reset(net->layer_name_index, vector_size(net->layers));
+    for (size_t i=0; i<vector_size(net->layers); i++)
+    {
+        name_index_insert(net->layer_name_index, net, layer_name_at, (int)i);
+    }
+}
+#endif // NCNN_STRING
+
 Net::Net()
 {
     vector_init_ctor_dtor(blobs, Blob_ctor, Blob_dtor);
     vector_init(layers);
     vector_init(custom_layer_registry);
+
+    arena_plan_users = 0;
+    arena_cache = 0;
+    arena_cache_size = 0;
+    pthread_mutex_init(&arena_lock, 0);
+
+    mapped_model = 0;
+    mapped_model_size = 0;
 }
 
 Net::~Net()
@@ -45,6 +153,9 @@ Net::~Net()
     vector_destroy(blobs);
     vector_destroy(layers);
     vector_destroy(custom_layer_registry);
+
+    fastFree(arena_cache);
+    pthread_mutex_destroy(&arena_lock);
 }
 
 #if NCNN_STRING
@@ -134,6 +245,9 @@ int Net::load_param(const DataReader& dr)
     vector_resize(layers, layer_count);
     vector_resize(blobs, blob_count);
 
+    name_index_reset(blob_name_index, blob_count);
+    name_index_reset(layer_name_index, layer_count);
+
     ParamDict pd;
 
     int blob_index = 0;
@@ -181,6 +295,8 @@ int Net::load_param(const DataReader& dr)
                 strcpy_s(blob.name, 256, bottom_name);
 //                 fprintf(stderr, "new blob %s\n", bottom_name);
 
+                name_index_insert(blob_name_index, this, blob_name_at, bottom_blob_index);
+
                 blob_index++;
             }
 
@@ -202,6 +318,8 @@ int Net::load_param(const DataReader& dr)
             strcpy_s(blob.name, 256, blob_name);
 //             fprintf(stderr, "new blob %s\n", blob_name);
 
+            name_index_insert(blob_name_index, this, blob_name_at, blob_index);
+
             blob.producer = i;
 
             layer->tops[j] = blob_index;
@@ -265,6 +383,8 @@ int Net::load_param(const DataReader& dr)
         }
 
         vector_get(layers, i) = layer;
+
+        name_index_insert(layer_name_index, this, layer_name_at, i);
     }
 
 #undef SCAN_VALUE
@@ -302,6 +422,12 @@ int Net::load_param_bin(const DataReader& dr)
     vector_resize(layers, layer_count);
     vector_resize(blobs, blob_count);
 
+#if NCNN_STRING
+    // binary params carry no names
+    blob_name_index = NameIndex();
+    layer_name_index = NameIndex();
+#endif // NCNN_STRING
+
     ParamDict pd;
 
     for (int i=0; i<layer_count; i++)
@@ -456,6 +582,12 @@ int Net::load_model(const DataReader& dr)
 
     fuse_network(this);
 
+    if (ret == 0 && build_forward_plan(this) != 0)
+        ret = -1;
+
+    if (ret == 0)
+        infer_network_shapes(this);
+
     for (size_t i=0; i<vector_size(layers); i++)
     {
         Layer* layer = vector_get(layers, i);
@@ -504,9 +636,20 @@ int Net::load_param(const char* protopath)
         return -1;
     }
 
-    int ret = load_param(fp);
+    // read the whole text and parse it from memory, the memory scan is
+    // hand written while the stdio one goes through fscanf for every token
+    std::vector<char> text;
+    char buf[4096];
+    size_t nread;
+    while ((nread = fread(buf, 1, sizeof(buf), fp)) > 0)
+    {
+        text.insert(text.end(), buf, buf + nread);
+    }
     fclose(fp);
-    return ret;
+
+    text.push_back('\0');
+
+    return load_param_mem(&text[0]);
 }
 #endif // NCNN_STRING
 
@@ -538,6 +681,30 @@ int Net::load_model(FILE* fp)
 
 int Net::load_model(const char* modelpath)
 {
+    size_t mapped_size = 0;
+    const unsigned char* mapped = DataReaderFromMmap_map(modelpath, &mapped_size);
+    if (mapped)
+    {
+        // fp32 and int8 weights reference the mapped pages directly
+        const unsigned char* mem = mapped;
+        DataReader dr = createDataReaderFromMmap(&mem);
+        int ret = load_model(dr);
+        if (ret != 0)
+        {
+            // keep the mapping the weights of a previous load_model live in,
+            // the net has to be loaded again before use like after any failed load
+            DataReaderFromMmap_unmap(mapped, mapped_size);
+            return ret;
+        }
+
+        // the weights of a previous load_model are gone now
+        DataReaderFromMmap_unmap(mapped_model, mapped_model_size);
+        mapped_model = mapped;
+        mapped_model_size = mapped_size;
+
+        return ret;
+    }
+
     FILE* fp = fopen(modelpath, "rb");
     if (!fp)
     {
@@ -723,214 +890,1376 @@ int fuse_network(Net *net)
     return 0;
 }
 
-void Net::clear()
+int build_forward_plan(Net *net)
 {
-    vector_clear(blobs);
-    for (size_t i=0; i<vector_size(layers); i++)
+    const int layer_count = (int)vector_size(net->layers);
+
+    // producer to consumer edges, one per bottom reference
+    std::vector<int> indegree(layer_count, 0);
+    std::vector< std::vector<int> > consumers(layer_count);
+    for (int i=0; i<layer_count; i++)
     {
-        int dret = vector_get(layers, i)->destroy_pipeline(vector_get(layers, i), opt);
-        if (dret != 0)
+        const Layer* layer = vector_get(net->layers, i);
+        for (size_t j=0; j<layer->bottoms.size(); j++)
         {
-            fprintf(stderr, "layer destroy_pipeline failed\n");
-            // ignore anyway
+            int producer = vector_get(net->blobs, layer->bottoms[j]).producer;
+            if (producer < 0 || producer == i)
+                continue;
+
+            consumers[producer].push_back(i);
+            indegree[i]++;
         }
+    }
 
-        cdelete(vector_get(layers, i));
+    // kahn sort, always taking the lowest ready index
+    // so that a param file already in topological order keeps its order
+    std::priority_queue<int, std::vector<int>, std::greater<int> > ready;
+    for (int i=0; i<layer_count; i++)
+    {
+        if (indegree[i] == 0)
+            ready.push(i);
     }
-    vector_clear(layers);
+
+    net->forward_plan.clear();
+    net->forward_plan.reserve(layer_count);
+    while (!ready.empty())
+    {
+        int i = ready.top();
+        ready.pop();
+
+        net->forward_plan.push_back(i);
+
+        for (size_t j=0; j<consumers[i].size(); j++)
+        {
+            int consumer = consumers[i][j];
+            if (--indegree[consumer] == 0)
+                ready.push(consumer);
+        }
+    }
+
+    if ((int)net->forward_plan.size() != layer_count)
+    {
+        fprintf(stderr, "network graph has a cycle\n");
+        net->forward_plan.clear();
+        return -1;
+    }
+
+    return 0;
 }
 
-// construct an Extractor from network
-Extractor create_extractor(Net *net)
+// the blob whose producer writes a given blob, looking through Split,
+// whose tops are the bottom itself
+static int concat_slot_blob(const Net* net, int blob_index)
 {
-    return Extractor(net, vector_size(net->blobs));
+    for (;;)
+    {
+        int producer = vector_get(net->blobs, blob_index).producer;
+        if (producer < 0)
+            return blob_index;
+
+        const Layer* layer = vector_get(net->layers, producer);
+        if (layer->typeindex != LayerSplit)
+            return blob_index;
+
+        blob_index = layer->bottoms[0];
+    }
 }
 
-#if NCNN_STRING
-int find_blob_index_by_name(const Net *net, const char* name)
+// give every input of a channel axis Concat with known 3d shapes the channel
+// range it takes in the concat output, so its producer can write there directly
+// a blob gets at most one slot, a blob bound twice or set by the caller none
+static void plan_concat_slots(Net* net)
 {
-    for (size_t i=0; i<vector_size(net->blobs); i++)
+    const int blob_count = (int)vector_size(net->blobs);
+
+    net->concat_slots.resize(blob_count);
+    for (int i=0; i<blob_count; i++)
+    {
+        net->concat_slots[i].layer_index = -1;
+        net->concat_slots[i].step = -1;
+        net->concat_slots[i].channel_offset = 0;
+    }
+
+    for (size_t i=0; i<net->forward_plan.size(); i++)
     {
-        const Blob& blob = vector_get(net->blobs, i);
-        if (strcmp(blob.name, name) == 0)
+        const int layer_index = net->forward_plan[i];
+        const Layer* layer = vector_get(net->layers, layer_index);
+        if (layer->typeindex != LayerConcat || ((const Concat*)layer)->axis != 0 || layer->tops.size() != 1)
+            continue;
+
+        const Mat& top_shape = vector_get(net->blobs, layer->tops[0]).shape;
+        if (top_shape.dims != 3)
+            continue;
+
+        const size_t bottom_count = layer->bottoms.size();
+
+        std::vector<int> slot_blobs(bottom_count);
+        for (size_t j=0; j<bottom_count; j++)
         {
-            return static_cast<int>(i);
+            slot_blobs[j] = concat_slot_blob(net, layer->bottoms[j]);
         }
-    }
 
-    fprintf(stderr, "find_blob_index_by_name %s failed\n", name);
-    return -1;
-}
+        bool plannable = true;
+        int channels = 0;
+        for (size_t j=0; j<bottom_count && plannable; j++)
+        {
+            const int bottom_blob_index = slot_blobs[j];
+            const Blob& blob = vector_get(net->blobs, bottom_blob_index);
+
+            if (blob.shape.dims != 3 || blob.shape.w != top_shape.w || blob.shape.h != top_shape.h)
+                plannable = false;
+            else if (blob.producer < 0 || net->concat_slots[bottom_blob_index].layer_index != -1)
+                plannable = false;
+            else
+            {
+                const Layer* producer = vector_get(net->layers, blob.producer);
+                if (producer->typeindex == LayerInput || producer->tops.size() != 1)
+                    plannable = false;
+            }
 
-int find_layer_index_by_name(Net *net, const char* name)
-{
-    for (size_t i=0; i<vector_size(net->layers); i++)
-    {
-        const Layer* layer = vector_get(net->layers, i);
-        if (layer->name == name)
+            for (size_t k=0; k<j; k++)
+            {
+                if (slot_blobs[k] == bottom_blob_index)
+                    plannable = false;
+            }
+
+            channels += blob.shape.c;
+        }
+
+        if (!plannable || channels != top_shape.c)
+            continue;
+
+        int channel_offset = 0;
+        for (size_t j=0; j<bottom_count; j++)
         {
-            return static_cast<int>(i);
+            ConcatSlot& slot = net->concat_slots[slot_blobs[j]];
+            slot.layer_index = layer_index;
+            slot.step = (int)i;
+            slot.channel_offset = channel_offset;
+
+            channel_offset += vector_get(net->blobs, slot_blobs[j]).shape.c;
         }
     }
-
-    fprintf(stderr, "find_layer_index_by_name %s failed\n", name);
-    return -1;
 }
 
-int custom_layer_to_index(Net *net, const char* type)
+// the bytes Mat::create asks the allocator for, for a fp32 blob of this shape
+static size_t blob_alloc_size(const Mat& shape)
 {
-    const size_t custom_layer_registry_entry_count = vector_size(net->custom_layer_registry);
-    for (size_t i=0; i<custom_layer_registry_entry_count; i++)
-    {
-        if (strcmp(type, vector_get(net->custom_layer_registry, i).name) == 0)
-            return static_cast<int>(i);
-    }
+    const size_t cstep = shape.dims == 3 ? alignSize((size_t)shape.w * shape.h * 4u, 16) / 4u : (size_t)shape.w * shape.h;
+    const size_t totalsize = alignSize(cstep * shape.c * 4u, 4);
 
-    return -1;
+    return mat_data_alloc_size(totalsize);
 }
 
-Layer* create_custom_layer_by_type(Net *net, const char* type)
+// the arena blocks of a full forward simulated from the shape hints
+struct ArenaSim
 {
-    int index = custom_layer_to_index(net, type);
-    if (index == -1)
-        return 0;
+    const Net* net;
+    ArenaPlan plan;
+
+    // block holding every blob, -1 for the ones set by the caller
+    std::vector<int> blob_block;
+    // blobs and pending concat outputs referencing every block
+    std::vector<int> block_refs;
+    // block of every concat output handed out to its slots, -1 before
+    std::vector<int> concat_block;
+};
+
+static int arena_sim_alloc(ArenaSim& sim, size_t size)
+{
+    const int b = (int)sim.plan.sizes.size();
+    sim.plan.sizes.push_back(size);
+    sim.plan.events.push_back(b);
+    sim.block_refs.push_back(0);
+    return b;
+}
 
-    return create_custom_layer_by_index(net, index);
+static void arena_sim_release(ArenaSim& sim, int b)
+{
+    if (b != -1 && --sim.block_refs[b] == 0)
+        sim.plan.events.push_back(~b);
 }
-#endif // NCNN_STRING
 
-Layer* create_custom_layer_by_index(Net *net, int index)
+// the block of a concat output, created with its first slot like concat_slot_view does,
+// inside the block of an outer concat when it feeds one itself
+static int arena_sim_concat_block(ArenaSim& sim, int concat_top_blob_index)
 {
-    const size_t custom_layer_registry_entry_count = vector_size(net->custom_layer_registry);
-    if (index < 0 || static_cast<unsigned int>(index) >= custom_layer_registry_entry_count)
-        return 0;
+    int& b = sim.concat_block[concat_top_blob_index];
+    if (b == -1)
+    {
+        const ConcatSlot& slot = sim.net->concat_slots[concat_top_blob_index];
+        if (slot.layer_index != -1)
+            b = arena_sim_concat_block(sim, vector_get(sim.net->layers, slot.layer_index)->tops[0]);
+        else
+            b = arena_sim_alloc(sim, blob_alloc_size(vector_get(sim.net->blobs, concat_top_blob_index).shape));
 
-    layer_creator_func layer_creator = vector_get(net->custom_layer_registry, index).creator;
-    if (!layer_creator)
-        return 0;
+        // held by the extractor until the concat step
+        sim.block_refs[b]++;
+    }
 
-    return layer_creator();
+    return b;
 }
 
-int Net::forward_layer(int layer_index, std::vector<Mat>& blob_mats, Option& opt) const
+// plan the blob arena of a full forward along the forward plan from the shape hints,
+// every top allocated at its step and, in light mode, released after its last consumer
+// leaves the plan empty to be learned from a run when some blob shape is data dependent
+// Split tops, in place forward and concat slots share their block as forward_layer does,
+// other views are planned as blocks of their own, which only costs arena space
+static void plan_network_arena(Net* net)
 {
-    Layer* layer = vector_get(layers, layer_index);
+    const Option& opt = net->opt;
+    const int blob_count = (int)vector_size(net->blobs);
+    const int step_count = (int)net->forward_plan.size();
 
-//     fprintf(stderr, "forward_layer %d %s\n", layer_index, layer->name.c_str());
+    // the shape hints hold no element size
+    bool known = !opt.use_bf16_storage && !opt.use_packing_layout;
 
-    if (layer->one_blob_only)
-    {
-        // load bottom blob
-        int bottom_blob_index = layer->bottoms[0];
-        int top_blob_index = layer->tops[0];
+    ArenaSim sim;
+    sim.net = net;
+    sim.blob_block.resize(blob_count, -1);
+    sim.concat_block.resize(blob_count, -1);
 
-        if (blob_mats[bottom_blob_index].dims == 0)
+    // last consumer step of every blob, -1 for the net outputs
+    std::vector<int> last_use(blob_count, -1);
+    for (int i=0; i<step_count; i++)
+    {
+        const Layer* layer = vector_get(net->layers, net->forward_plan[i]);
+        for (size_t j=0; j<layer->bottoms.size(); j++)
         {
-            int ret = forward_layer(vector_get(blobs, bottom_blob_index).producer, blob_mats, opt);
-            if (ret != 0)
-                return ret;
+            last_use[layer->bottoms[j]] = i;
         }
+    }
 
-        Mat bottom_blob = blob_mats[bottom_blob_index];
+    const bool views = opt.use_blob_views && !net->concat_slots.empty();
 
-        if (opt.lightmode)
+    for (int i=0; known && i<step_count; i++)
+    {
+        const Layer* layer = vector_get(net->layers, net->forward_plan[i]);
+        if (layer->typeindex == LayerInput)
+            continue;
+
+        const bool inplace = opt.lightmode && layer->support_inplace;
+
+        for (size_t j=0; j<layer->tops.size(); j++)
         {
-            // delete after taken in light mode
-            blob_mats[bottom_blob_index].release();
-            // deep copy for inplace forward if data is shared
-            if (layer->support_inplace && *bottom_blob.refcount != 1)
+            const int top_blob_index = layer->tops[j];
+            const Mat& shape = vector_get(net->blobs, top_blob_index).shape;
+            if (shape.dims == 0)
             {
-                bottom_blob = bottom_blob.clone();
+                known = false;
+                break;
             }
-        }
 
-        if (opt.use_bf16_storage)
-        {
-            if (bottom_blob.elemsize / bottom_blob.elempack == 4u && layer->support_bf16_storage)
+            int b = -1;
+            if (layer->typeindex == LayerSplit)
             {
-                Mat bottom_blob_bf16;
-                cast_float32_to_bfloat16(bottom_blob, bottom_blob_bf16, opt);
-                bottom_blob = bottom_blob_bf16;
+                b = sim.blob_block[layer->bottoms[0]];
             }
-            if (bottom_blob.elemsize / bottom_blob.elempack == 2u && !layer->support_bf16_storage)
+            else if (inplace && j < layer->bottoms.size())
             {
-                Mat bottom_blob_fp32;
-                cast_bfloat16_to_float32(bottom_blob, bottom_blob_fp32, opt);
-                bottom_blob = bottom_blob_fp32;
+                // forward in place on the bottom if this step holds its only reference, on a copy otherwise
+                const int bottom_blob_index = layer->bottoms[j];
+                b = sim.blob_block[bottom_blob_index];
+                if (b == -1 || last_use[bottom_blob_index] != i || sim.block_refs[b] != 1)
+                    b = arena_sim_alloc(sim, blob_alloc_size(shape));
+            }
+            else if (views && net->concat_slots[top_blob_index].layer_index != -1)
+            {
+                b = arena_sim_concat_block(sim, vector_get(net->layers, net->concat_slots[top_blob_index].layer_index)->tops[0]);
+            }
+            else if (views && sim.concat_block[top_blob_index] != -1)
+            {
+                // the bottoms already fill the concat output
+                b = sim.concat_block[top_blob_index];
+            }
+            else
+            {
+                b = arena_sim_alloc(sim, blob_alloc_size(shape));
             }
-        }
-
-        if (opt.use_packing_layout)
-        {
-            int elempack = layer->support_packing ? 4 : 1;
 
-            Mat bottom_blob_packed;
-            convert_packing(bottom_blob, bottom_blob_packed, elempack, opt);
-            bottom_blob = bottom_blob_packed;
+            sim.blob_block[top_blob_index] = b;
+            if (b != -1)
+                sim.block_refs[b]++;
         }
 
-        // forward
-        if (opt.lightmode && layer->support_inplace)
-        {
-            Mat& bottom_top_blob = bottom_blob;
-#if NCNN_BENCHMARK
-            double start = get_current_time();
-            int ret = layer->forward_inplace(layer, bottom_top_blob, opt);
-            double end = get_current_time();
-            benchmark(layer, bottom_top_blob, bottom_top_blob, start, end);
-#else
-            int ret = layer->forward_inplace(layer, bottom_top_blob, opt);
-#endif // NCNN_BENCHMARK
-            if (ret != 0)
-                return ret;
+        if (!known)
+            break;
 
-            // store top blob
-            blob_mats[top_blob_index] = bottom_top_blob;
-        }
-        else
+        // the extractor drops its concat output once the concat step has run
+        if (views && layer->tops.size() == 1 && sim.concat_block[layer->tops[0]] != -1)
+            arena_sim_release(sim, sim.concat_block[layer->tops[0]]);
+
+        if (opt.lightmode)
         {
-            Mat top_blob;
-#if NCNN_BENCHMARK
-            double start = get_current_time();
-            int ret = layer->forward(layer, bottom_blob, top_blob, opt);
-            double end = get_current_time();
-            benchmark(layer, bottom_blob, top_blob, start, end);
-#else
-            int ret = layer->forward(layer, bottom_blob, top_blob, opt);
-#endif // NCNN_BENCHMARK
-            if (ret != 0)
-                return ret;
+            for (size_t j=0; j<layer->bottoms.size(); j++)
+            {
+                const int bottom_blob_index = layer->bottoms[j];
+                if (last_use[bottom_blob_index] != i)
+                    continue;
 
-            // store top blob
-            blob_mats[top_blob_index] = top_blob;
+                arena_sim_release(sim, sim.blob_block[bottom_blob_index]);
+                sim.blob_block[bottom_blob_index] = -1;
+            }
         }
-
     }
+
+    if (!known || sim.plan.sizes.empty())
+        sim.plan = ArenaPlan();
     else
     {
-        // load bottom blobs
-        std::vector<Mat> bottom_blobs(layer->bottoms.size());
-        for (size_t i=0; i<layer->bottoms.size(); i++)
-        {
-            int bottom_blob_index = layer->bottoms[i];
-
-            if (blob_mats[bottom_blob_index].dims == 0)
-            {
-                int ret = forward_layer(vector_get(blobs, bottom_blob_index).producer, blob_mats, opt);
-                if (ret != 0)
-                    return ret;
-            }
+        sim.plan.from_shapes = true;
+        pack_arena_plan(sim.plan);
+    }
 
-            bottom_blobs[i] = blob_mats[bottom_blob_index];
+    // extractors replaying the current plan keep it, they learn nothing from a plan of shapes either
+    pthread_mutex_lock(&net->arena_lock);
+    if (net->arena_plan_users == 0)
+    {
+        net->arena_plan = sim.plan;
+    }
+    pthread_mutex_unlock(&net->arena_lock);
+}
 
+int infer_network_shapes(Net *net)
+{
+    if (net->forward_plan.empty() && build_forward_plan(net) != 0)
+        return -1;
+
+    std::vector<Mat> bottom_shapes;
+    std::vector<Mat> top_shapes;
+    for (size_t i=0; i<net->forward_plan.size(); i++)
+    {
+        Layer* layer = vector_get(net->layers, net->forward_plan[i]);
+
+        const size_t bottom_count = layer->bottoms.size();
+        const size_t top_count = layer->tops.size();
+
+        bool bottoms_known = true;
+        bottom_shapes.resize(bottom_count);
+        for (size_t j=0; j<bottom_count; j++)
+        {
+            bottom_shapes[j] = vector_get(net->blobs, layer->bottoms[j]).shape;
+            if (bottom_shapes[j].dims == 0)
+                bottoms_known = false;
+        }
+
+        // source layers keep the shapes given by Net::reshape
+        bool tops_known = true;
+        for (size_t j=0; j<top_count; j++)
+        {
+            if (vector_get(net->blobs, layer->tops[j]).shape.dims == 0)
+                tops_known = false;
+        }
+
+        if (bottoms_known && !(bottom_count == 0 && tops_known))
+        {
+            top_shapes.clear();
+            top_shapes.resize(top_count);
+
+            if (layer->infer_shape(layer, bottom_shapes, top_shapes) == 0)
+            {
+                for (size_t j=0; j<top_count; j++)
+                {
+                    vector_get(net->blobs, layer->tops[j]).shape = top_shapes[j];
+                }
+            }
+        }
+
+        layer->bottom_shapes = bottom_shapes;
+        layer->top_shapes.resize(top_count);
+        for (size_t j=0; j<top_count; j++)
+        {
+            layer->top_shapes[j] = vector_get(net->blobs, layer->tops[j]).shape;
+        }
+    }
+
+    plan_concat_slots(net);
+
+    plan_network_arena(net);
+
+    return 0;
+}
+
+// the weight and activation fields shared by the layers that can absorb
+// a following per channel affine op or activation
+struct FoldTarget
+{
+    int num_output;
+    int weight_data_size;
+    int* bias_term;
+    int* activation_type;
+    Mat* activation_params;
+    Mat* weight_data;
+    Mat* bias_data;
+    // output is a 3d feature map rather than a 1d vector
+    bool spatial;
+};
+
+static bool get_fold_target(Layer* layer, FoldTarget& t)
+{
+    if (layer->typeindex == LayerConvolution)
+    {
+        Convolution* conv = (Convolution*)layer;
+        if (conv->int8_scale_term || conv->weight_data.elemsize != (size_t)4u)
+            return false;
+
+        t.num_output = conv->num_output;
+        t.weight_data_size = conv->weight_data_size;
+        t.bias_term = &conv->bias_term;
+        t.activation_type = &conv->activation_type;
+        t.activation_params = &conv->activation_params;
+        t.weight_data = &conv->weight_data;
+        t.bias_data = &conv->bias_data;
+        t.spatial = true;
+        return true;
+    }
+
+    if (layer->typeindex == LayerConvolutionDepthWise)
+    {
+        ConvolutionDepthWise* convdw = (ConvolutionDepthWise*)layer;
+        if (convdw->int8_scale_term || convdw->weight_data.elemsize != (size_t)4u)
+            return false;
+
+        t.num_output = convdw->num_output;
+        t.weight_data_size = convdw->weight_data_size;
+        t.bias_term = &convdw->bias_term;
+        t.activation_type = &convdw->activation_type;
+        t.activation_params = &convdw->activation_params;
+        t.weight_data = &convdw->weight_data;
+        t.bias_data = &convdw->bias_data;
+        t.spatial = true;
+        return true;
+    }
+
+    if (layer->typeindex == LayerInnerProduct)
+    {
+        InnerProduct* innerproduct = (InnerProduct*)layer;
+        if (innerproduct->int8_scale_term || innerproduct->weight_data.elemsize != (size_t)4u)
+            return false;
+
+        t.num_output = innerproduct->num_output;
+        t.weight_data_size = innerproduct->weight_data_size;
+        t.bias_term = &innerproduct->bias_term;
+        t.activation_type = &innerproduct->activation_type;
+        t.activation_params = &innerproduct->activation_params;
+        t.weight_data = &innerproduct->weight_data;
+        t.bias_data = &innerproduct->bias_data;
+        t.spatial = false;
+        return true;
+    }
+
+    return false;
+}
+
+// express layer as y = x * scale[p] + shift[p] over the output channels
+// a null array stands for all ones or all zeros, scalars fill the arrays
+// return false if layer is not such an op for this output
+static bool get_channel_affine(const Layer* layer, const FoldTarget& t, const float*& scale, const float*& shift, float& scalar_scale, float& scalar_shift)
+{
+    scale = 0;
+    shift = 0;
+    scalar_scale = 1.f;
+    scalar_shift = 0.f;
+
+    if (layer->typeindex == LayerBatchNorm)
+    {
+        const BatchNorm* batchnorm = (const BatchNorm*)layer;
+        if (batchnorm->channels != t.num_output)
+            return false;
+
+        scale = batchnorm->b_data;
+        shift = batchnorm->a_data;
+        return true;
+    }
+
+    if (layer->typeindex == LayerScale)
+    {
+        const Scale* s = (const Scale*)layer;
+        if (s->scale_data_size != t.num_output)
+            return false;
+
+        scale = s->scale_data;
+        if (s->bias_term)
+            shift = s->bias_data;
+        return true;
+    }
+
+    if (layer->typeindex == LayerBias)
+    {
+        // Bias walks channels, on a 1d blob it would only add the first value
+        const Bias* bias = (const Bias*)layer;
+        if (!t.spatial || bias->bias_data_size != t.num_output)
+            return false;
+
+        shift = bias->bias_data;
+        return true;
+    }
+
+    if (layer->typeindex == LayerBinaryOp)
+    {
+        const BinaryOp* binaryop = (const BinaryOp*)layer;
+        if (!binaryop->with_scalar)
+            return false;
+
+        // 0=add 1=sub 2=mul 3=div 7=rsub
+        switch (binaryop->op_type)
+        {
+        case 0: scalar_shift = binaryop->b; return true;
+        case 1: scalar_shift = -binaryop->b; return true;
+        case 2: scalar_scale = binaryop->b; return true;
+        case 3:
+            if (binaryop->b == 0.f)
+                return false;
+            scalar_scale = 1.f / binaryop->b;
+            return true;
+        case 7: scalar_scale = -1.f; scalar_shift = binaryop->b; return true;
+        default: return false;
+        }
+    }
+
+    if (layer->typeindex == LayerDropout)
+    {
+        scalar_scale = ((const Dropout*)layer)->scale;
+        return true;
+    }
+
+    return false;
+}
+
+static bool fold_channel_affine(FoldTarget& t, const Layer* layer)
+{
+    // the affine op would have to run before the activation
+    if (*t.activation_type != 0)
+        return false;
+
+    const float* scale;
+    const float* shift;
+    float scalar_scale;
+    float scalar_shift;
+    if (!get_channel_affine(layer, t, scale, shift, scalar_scale, scalar_shift))
+        return false;
+
+    // the weights may reference external model memory, fold into private copies
+    Mat weight_data = t.weight_data->clone();
+    Mat bias_data(t.num_output);
+    if (weight_data.empty() || bias_data.empty())
+        return false;
+
+    for (int p=0; p<t.num_output; p++)
+    {
+        bias_data[p] = *t.bias_term ? (*t.bias_data)[p] : 0.f;
+    }
+
+    const int weight_data_size_output = t.weight_data_size / t.num_output;
+    for (int p=0; p<t.num_output; p++)
+    {
+        const float s = scale ? scale[p] : scalar_scale;
+        const float b = shift ? shift[p] : scalar_shift;
+
+        float* w = (float*)weight_data + weight_data_size_output * p;
+        for (int k=0; k<weight_data_size_output; k++)
+        {
+            w[k] *= s;
+        }
+
+        bias_data[p] = bias_data[p] * s + b;
+    }
+
+    *t.weight_data = weight_data;
+    *t.bias_data = bias_data;
+    *t.bias_term = 1;
+
+    return true;
+}
+
+static bool fold_activation(FoldTarget& t, const Layer* layer)
+{
+    if (*t.activation_type != 0)
+        return false;
+
+    // 0=none 1=relu 2=leakyrelu 3=clip 4=sigmoid 6=hardswish
+    int activation_type = 0;
+    Mat activation_params;
+    if (layer->typeindex == LayerReLU)
+    {
+        float slope = ((const ReLU*)layer)->slope;
+        if (slope == 0.f)
+        {
+            activation_type = 1;
+        }
+        else
+        {
+            activation_type = 2;
+            activation_params.create(1);
+            activation_params[0] = slope;
+        }
+    }
+    else if (layer->typeindex == LayerClip)
+    {
+        activation_type = 3;
+        activation_params.create(2);
+        activation_params[0] = ((const Clip*)layer)->min;
+        activation_params[1] = ((const Clip*)layer)->max;
+    }
+    else if (layer->typeindex == LayerSigmoid)
+    {
+        activation_type = 4;
+    }
+    else if (layer->typeindex == LayerHardSwish)
+    {
+        activation_type = 6;
+        activation_params.create(2);
+        activation_params[0] = ((const HardSwish*)layer)->alpha;
+        activation_params[1] = ((const HardSwish*)layer)->beta;
+    }
+    else
+    {
+        return false;
+    }
+
+    *t.activation_type = activation_type;
+    *t.activation_params = activation_params;
+
+    return true;
+}
+
+// the consumer of blob if it is the only one, -1 otherwise
+static int single_consumer(const Net *net, int blob_index)
+{
+    const Blob& blob = vector_get(net->blobs, blob_index);
+    if (vector_size(blob.consumers) != 1)
+        return -1;
+
+    return vector_get(blob.consumers, 0);
+}
+
+// a layer with one bottom and one top, which is the only consumer of its bottom
+static bool is_chain_layer(const Net *net, int layer_index)
+{
+    const Layer* layer = vector_get(net->layers, layer_index);
+    if (layer->bottoms.size() != 1 || layer->tops.size() != 1)
+        return false;
+
+    return single_consumer(net, layer->bottoms[0]) == layer_index;
+}
+
+// drop layer from the graph by letting its producer write its top blob directly
+// the bottom blob of layer is left without producer and consumer
+static void bypass_into_producer(Net *net, int layer_index)
+{
+    Layer* layer = vector_get(net->layers, layer_index);
+    const int bottom_blob_index = layer->bottoms[0];
+    const int top_blob_index = layer->tops[0];
+
+    Blob& bottom_blob = vector_get(net->blobs, bottom_blob_index);
+    const int producer = bottom_blob.producer;
+
+    Layer* producer_layer = vector_get(net->layers, producer);
+    for (size_t j=0; j<producer_layer->tops.size(); j++)
+    {
+        if (producer_layer->tops[j] == bottom_blob_index)
+            producer_layer->tops[j] = top_blob_index;
+    }
+
+    vector_get(net->blobs, top_blob_index).producer = producer;
+
+    bottom_blob.producer = -1;
+    vector_clear(bottom_blob.consumers);
+}
+
+// drop layer from the graph by letting its consumer read its bottom blob directly
+// the top blob of layer is left without producer and consumer
+static void bypass_into_consumer(Net *net, int layer_index)
+{
+    Layer* layer = vector_get(net->layers, layer_index);
+    const int bottom_blob_index = layer->bottoms[0];
+    const int top_blob_index = layer->tops[0];
+
+    Blob& top_blob = vector_get(net->blobs, top_blob_index);
+    const int consumer = vector_get(top_blob.consumers, 0);
+
+    Layer* consumer_layer = vector_get(net->layers, consumer);
+    for (size_t j=0; j<consumer_layer->bottoms.size(); j++)
+    {
+        if (consumer_layer->bottoms[j] == top_blob_index)
+            consumer_layer->bottoms[j] = bottom_blob_index;
+    }
+
+    vector_get(vector_get(net->blobs, bottom_blob_index).consumers, 0) = consumer;
+
+    top_blob.producer = -1;
+    vector_clear(top_blob.consumers);
+}
+
+static bool is_passthrough_layer(const Layer* layer)
+{
+    if (layer->typeindex == LayerNoop || layer->typeindex == LayerSplit)
+        return true;
+
+    if (layer->typeindex == LayerDropout)
+        return ((const Dropout*)layer)->scale == 1.f;
+
+    return false;
+}
+
+// a reshape whose result is fully overridden by the next reshape
+static bool is_reshape_chain(const Net *net, const Layer* layer)
+{
+    if (layer->typeindex != LayerReshape || ((const Reshape*)layer)->permute)
+        return false;
+
+    int next = single_consumer(net, layer->tops[0]);
+    if (next == -1)
+        return false;
+
+    const Layer* next_layer = vector_get(net->layers, next);
+    if (next_layer->typeindex != LayerReshape)
+        return false;
+
+    // 0 copies a dim from the bottom, which would see another shape
+    const Reshape* reshape = (const Reshape*)next_layer;
+    return !reshape->permute && reshape->w != 0 && reshape->h != 0 && reshape->c != 0;
+}
+
+int optimize_network(Net *net)
+{
+    const int layer_count = (int)vector_size(net->layers);
+
+    std::vector<char> removed(layer_count, 0);
+
+    // strip layers that only forward their bottom
+    for (int i=0; i<layer_count; i++)
+    {
+        const Layer* layer = vector_get(net->layers, i);
+        if (!is_chain_layer(net, i))
+            continue;
+
+        if (is_reshape_chain(net, layer))
+        {
+            bypass_into_consumer(net, i);
+            removed[i] = 1;
+            continue;
+        }
+
+        if (!is_passthrough_layer(layer))
+            continue;
+
+        // the input layer must keep producing the blob the user feeds
+        int producer = vector_get(net->blobs, layer->bottoms[0]).producer;
+        if (producer < 0 || vector_get(net->layers, producer)->typeindex == LayerInput)
+            continue;
+
+        bypass_into_producer(net, i);
+        removed[i] = 1;
+    }
+
+    // fold the affine ops and activations that follow a weighted layer
+    for (int i=0; i<layer_count; i++)
+    {
+        Layer* layer = vector_get(net->layers, i);
+        if (removed[i] || layer->tops.size() != 1)
+            continue;
+
+        FoldTarget t;
+        if (!get_fold_target(layer, t))
+            continue;
+
+        for (;;)
+        {
+            int next = single_consumer(net, layer->tops[0]);
+            if (next == -1 || !is_chain_layer(net, next))
+                break;
+
+            const Layer* next_layer = vector_get(net->layers, next);
+            if (!fold_channel_affine(t, next_layer) && !fold_activation(t, next_layer))
+                break;
+
+            bypass_into_producer(net, next);
+            removed[next] = 1;
+        }
+    }
+
+    // compact the layer list and renumber the blob links
+    std::vector<int> new_index(layer_count, -1);
+    std::vector<Layer*> kept;
+    for (int i=0; i<layer_count; i++)
+    {
+        Layer* layer = vector_get(net->layers, i);
+        if (removed[i])
+        {
+            cdelete(layer);
+            continue;
+        }
+
+        new_index[i] = (int)kept.size();
+        kept.push_back(layer);
+    }
+
+    if (kept.size() == (size_t)layer_count)
+        return 0;
+
+    vector_clear(net->layers);
+    for (size_t i=0; i<kept.size(); i++)
+    {
+        vector_pushback(net->layers, kept[i]);
+    }
+
+    std::vector<int> consumers;
+    for (size_t i=0; i<vector_size(net->blobs); i++)
+    {
+        Blob& blob = vector_get(net->blobs, i);
+        if (blob.producer >= 0)
+            blob.producer = new_index[blob.producer];
+
+        consumers.clear();
+        for (size_t j=0; j<vector_size(blob.consumers); j++)
+        {
+            int consumer = new_index[vector_get(blob.consumers, j)];
+            if (consumer != -1)
+                consumers.push_back(consumer);
+        }
+
+        vector_clear(blob.consumers);
+        for (size_t j=0; j<consumers.size(); j++)
+        {
+            vector_pushback(blob.consumers, consumers[j]);
+        }
+    }
+
+#if NCNN_STRING
+    if (!net->layer_name_index.slots.empty())
+        build_layer_name_index(net);
+#endif // NCNN_STRING
+
+    return 0;
+}
+
+int Net::reshape(const std::vector<int>& input_indexes, const std::vector<Mat>& input_shapes)
+{
+    if (vector_empty(layers) || input_indexes.size() != input_shapes.size())
+    {
+        fprintf(stderr, "reshape on an empty network or with mismatched shape count\n");
+        return -1;
+    }
+
+    // forget every shape hint, the inputs are the new ground truth
+    for (size_t i=0; i<vector_size(blobs); i++)
+    {
+        vector_get(blobs, i).shape = Mat();
+    }
+
+    for (size_t i=0; i<input_indexes.size(); i++)
+    {
+        int blob_index = input_indexes[i];
+        if (blob_index < 0 || blob_index >= (int)vector_size(blobs))
+        {
+            fprintf(stderr, "reshape blob index %d out of range\n", blob_index);
+            return -1;
+        }
+
+        vector_get(blobs, blob_index).shape = input_shapes[i].shape();
+    }
+
+    return infer_network_shapes(this);
+}
+
+#if NCNN_STRING
+int Net::reshape(const char* blob_name, const Mat& shape)
+{
+    int blob_index = find_blob_index_by_name(this, blob_name);
+    if (blob_index == -1)
+        return -1;
+
+    return reshape(blob_index, shape);
+}
+#endif // NCNN_STRING
+
+int Net::reshape(int blob_index, const Mat& shape)
+{
+    return reshape(std::vector<int>(1, blob_index), std::vector<Mat>(1, shape));
+}
+
+int Net::optimize()
+{
+    if (vector_empty(layers))
+    {
+        fprintf(stderr, "network graph not ready\n");
+        return -1;
+    }
+
+    // folding and the recreated pipelines start from the loaded weights
+    for (size_t i=0; i<vector_size(layers); i++)
+    {
+        Layer* layer = vector_get(layers, i);
+        if (layer->typeindex == LayerConvolution && ((Convolution*)layer)->weight_data.empty())
+        {
+            fprintf(stderr, "layer %d weights were released in lightweight mode, optimize needs them\n", (int)i);
+            return -1;
+        }
+    }
+
+    // the packed and transformed weights are derived from the ones being folded
+    for (size_t i=0; i<vector_size(layers); i++)
+    {
+        Layer* layer = vector_get(layers, i);
+        int dret = layer->destroy_pipeline(layer, opt);
+        if (dret != 0)
+        {
+            fprintf(stderr, "layer destroy_pipeline %d failed\n", (int)i);
+            return -1;
+        }
+    }
+
+    optimize_network(this);
+
+    // the graph changes, so does the blob sequence
+    pthread_mutex_lock(&arena_lock);
+    if (arena_plan_users == 0)
+    {
+        arena_plan = ArenaPlan();
+    }
+    pthread_mutex_unlock(&arena_lock);
+
+    if (build_forward_plan(this) != 0)
+        return -1;
+
+    infer_network_shapes(this);
+
+    for (size_t i=0; i<vector_size(layers); i++)
+    {
+        Layer* layer = vector_get(layers, i);
+        int cret = layer->create_pipeline(layer, opt);
+        if (cret != 0)
+        {
+            fprintf(stderr, "layer create_pipeline %d failed\n", (int)i);
+            return -1;
+        }
+    }
+
+    return 0;
+}
+
+// distinct buffers behind the weight mats of one layer
+static void collect_weight_buffers(const Layer* layer, std::vector<std::pair<const void*, size_t> >& buffers)
+{
+    for (size_t i=0; i<layer->weight_mats.size(); i++)
+    {
+        const Mat* m = layer->weight_mats[i];
+        if (m->empty())
+            continue;
+
+        buffers.push_back(std::make_pair((const void*)m->data, m->total() * m->elemsize));
+    }
+}
+
+static size_t sum_distinct_buffers(std::vector<std::pair<const void*, size_t> >& buffers)
+{
+    std::sort(buffers.begin(), buffers.end());
+
+    size_t bytes = 0;
+    for (size_t i=0; i<buffers.size(); i++)
+    {
+        if (i > 0 && buffers[i].first == buffers[i - 1].first)
+            continue;
+
+        bytes += buffers[i].second;
+    }
+
+    return bytes;
+}
+
+size_t Net::layer_weight_bytes(int layer_index) const
+{
+    if (layer_index < 0 || layer_index >= (int)vector_size(layers))
+        return 0;
+
+    std::vector<std::pair<const void*, size_t> > buffers;
+    collect_weight_buffers(vector_get(layers, layer_index), buffers);
+
+    return sum_distinct_buffers(buffers);
+}
+
+size_t Net::weight_bytes() const
+{
+    std::vector<std::pair<const void*, size_t> > buffers;
+    for (size_t i=0; i<vector_size(layers); i++)
+    {
+        collect_weight_buffers(vector_get(layers, i), buffers);
+    }
+
+    return sum_distinct_buffers(buffers);
+}
+
+void Net::clear()
+{
+    forward_plan.clear();
+    concat_slots.clear();
+
+    // the graph changes, so does the blob sequence
+    pthread_mutex_lock(&arena_lock);
+    if (arena_plan_users == 0)
+    {
+        arena_plan = ArenaPlan();
+    }
+    pthread_mutex_unlock(&arena_lock);
+
+    vector_clear(blobs);
+    for (size_t i=0; i<vector_size(layers); i++)
+    {
+        int dret = vector_get(layers, i)->destroy_pipeline(vector_get(layers, i), opt);
+        if (dret != 0)
+        {
+            fprintf(stderr, "layer destroy_pipeline failed\n");
+            // ignore anyway
+        }
+
+        cdelete(vector_get(layers, i));
+    }
+    vector_clear(layers);
+
+#if NCNN_STRING
+    blob_name_index = NameIndex();
+    layer_name_index = NameIndex();
+#endif // NCNN_STRING
+
+#if NCNN_STDIO
+    DataReaderFromMmap_unmap(mapped_model, mapped_model_size);
+#endif // NCNN_STDIO
+    mapped_model = 0;
+    mapped_model_size = 0;
+}
+
+// construct an Extractor from network
+Extractor create_extractor(const Net *net)
+{
+    return Extractor(net, vector_size(net->blobs));
+}
+
+int forward_request(const Net *net, const std::vector<int>& input_indexes, const std::vector<Mat>& inputs,
+                    const std::vector<int>& output_indexes, std::vector<Mat>& outputs, const Option& opt)
+{
+    if (input_indexes.size() != inputs.size())
+    {
+        fprintf(stderr, "forward_request got %d input blobs for %d mats\n", (int)input_indexes.size(), (int)inputs.size());
+        return -1;
+    }
+
+    Extractor ex = create_extractor(net);
+    ex.opt = opt;
+
+    for (size_t i=0; i<inputs.size(); i++)
+    {
+        int ret = ex.input(input_indexes[i], inputs[i]);
+        if (ret != 0)
+            return ret;
+    }
+
+    outputs.resize(output_indexes.size());
+    for (size_t i=0; i<output_indexes.size(); i++)
+    {
+        int ret = ex.extract(output_indexes[i], outputs[i]);
+        if (ret != 0)
+            return ret;
+    }
+
+    return 0;
+}
+
+#if NCNN_STRING
+int forward_request(const Net *net, const std::vector<const char*>& input_names, const std::vector<Mat>& inputs,
+                    const std::vector<const char*>& output_names, std::vector<Mat>& outputs, const Option& opt)
+{
+    std::vector<int> input_indexes(input_names.size());
+    for (size_t i=0; i<input_names.size(); i++)
+    {
+        input_indexes[i] = find_blob_index_by_name(net, input_names[i]);
+        if (input_indexes[i] == -1)
+            return -1;
+    }
+
+    std::vector<int> output_indexes(output_names.size());
+    for (size_t i=0; i<output_names.size(); i++)
+    {
+        output_indexes[i] = find_blob_index_by_name(net, output_names[i]);
+        if (output_indexes[i] == -1)
+            return -1;
+    }
+
+    return forward_request(net, input_indexes, inputs, output_indexes, outputs, opt);
+}
+#endif // NCNN_STRING
+
+#if NCNN_STRING
+int find_blob_index_by_name(const Net *net, const char* name)
+{
+    if (!net->blob_name_index.slots.empty())
+    {
+        int index = name_index_find(net->blob_name_index, net, blob_name_at, name);
+        if (index != -1)
+            return index;
+    }
+    else
+    {
+        for (size_t i=0; i<vector_size(net->blobs); i++)
+        {
+            const Blob& blob = vector_get(net->blobs, i);
+            if (strcmp(blob.name, name) == 0)
+            {
+                return static_cast<int>(i);
+            }
+        }
+    }
+
+    fprintf(stderr, "find_blob_index_by_name %s failed\n", name);
+    return -1;
+}
+
+int find_layer_index_by_name(Net *net, const char* name)
+{
+    if (!net->layer_name_index.slots.empty())
+    {
+        int index = name_index_find(net->layer_name_index, net, layer_name_at, name);
+        if (index != -1)
+            return index;
+    }
+    else
+    {
+        for (size_t i=0; i<vector_size(net->layers); i++)
+        {
+            const Layer* layer = vector_get(net->layers, i);
+            if (layer && strcmp(layer->name, name) == 0)
+            {
+                return static_cast<int>(i);
+            }
+        }
+    }
+
+    fprintf(stderr, "find_layer_index_by_name %s failed\n", name);
+    return -1;
+}
+
+int custom_layer_to_index(Net *net, const char* type)
+{
+    const size_t custom_layer_registry_entry_count = vector_size(net->custom_layer_registry);
+    for (size_t i=0; i<custom_layer_registry_entry_count; i++)
+    {
+        if (strcmp(type, vector_get(net->custom_layer_registry, i).name) == 0)
+            return static_cast<int>(i);
+    }
+
+    return -1;
+}
+
+Layer* create_custom_layer_by_type(Net *net, const char* type)
+{
+    int index = custom_layer_to_index(net, type);
+    if (index == -1)
+        return 0;
+
+    return create_custom_layer_by_index(net, index);
+}
+#endif // NCNN_STRING
+
+Layer* create_custom_layer_by_index(Net *net, int index)
+{
+    const size_t custom_layer_registry_entry_count = vector_size(net->custom_layer_registry);
+    if (index < 0 || static_cast<unsigned int>(index) >= custom_layer_registry_entry_count)
+        return 0;
+
+    layer_creator_func layer_creator = vector_get(net->custom_layer_registry, index).creator;
+    if (!layer_creator)
+        return 0;
+
+    Layer* layer = layer_creator();
+    layer->typeindex = index | CustomBit;
+    return layer;
+}
+
+// whether the consumer at step is the last user of a bottom blob and drops it
+// concurrent branches finish in any order, so there the consumers count down instead
+// and the last one to have taken its reference releases the blob
+static inline bool release_after_use(Extractor& ex, int bottom_blob_index, int step)
+{
+    if (ex.blob_pending_uses.empty())
+        return ex.blob_release_step[bottom_blob_index] == step;
+
+    return ex.blob_release_step[bottom_blob_index] != -1 && NCNN_XADD(&ex.blob_pending_uses[bottom_blob_index], -1) == 1;
+}
+
+// the channel range of the concat output planned for a top blob, empty if there is none
+// the concat output is created when its first slot is handed out,
+// inside the slot of an outer concat when it feeds one itself
+static Mat concat_slot_view(const Net* net, Extractor& ex, int blob_index, const Option& opt)
+{
+    // the slots are filled in plan order, which concurrent branches do not keep
+    if (!opt.use_blob_views || !ex.blob_pending_uses.empty() || net->concat_slots.empty())
+        return Mat();
+
+    const ConcatSlot& slot = net->concat_slots[blob_index];
+    if (slot.layer_index == -1 || !ex.step_needed[slot.step])
+        return Mat();
+
+    const int concat_top_blob_index = vector_get(net->layers, slot.layer_index)->tops[0];
+
+    if (ex.concat_outputs.empty())
+        ex.concat_outputs.resize(ex.blob_mats.size());
+
+    Mat& concat_output = ex.concat_outputs[concat_top_blob_index];
+    if (concat_output.empty())
+    {
+        concat_output = concat_slot_view(net, ex, concat_top_blob_index, opt);
+        if (concat_output.empty())
+        {
+            const Mat& shape = vector_get(net->blobs, concat_top_blob_index).shape;
+            concat_output.create(shape.w, shape.h, shape.c, 4u, opt.blob_allocator);
+            if (concat_output.empty())
+                return Mat();
+        }
+    }
+
+    return concat_output.shared_channel_range(slot.channel_offset, vector_get(net->blobs, blob_index).shape.c);
+}
+
+int Net::forward_layer(int layer_index, Extractor& ex, int step) const
+{
+    return forward_layer(layer_index, ex, step, ex.opt, ex.bottom_blobs, ex.top_blobs);
+}
+
+int Net::forward_layer(int layer_index, Extractor& ex, int step, const Option& opt, std::vector<Mat>& bottom_blobs, std::vector<Mat>& top_blobs) const
+{
+    Layer* layer = vector_get(layers, layer_index);
+
+    std::vector<Mat>& blob_mats = ex.blob_mats;
+
+//     fprintf(stderr, "forward_layer %d %s\n", layer_index, layer->name);
+
+    if (layer->one_blob_only)
+    {
+        // load bottom blob
+        int bottom_blob_index = layer->bottoms[0];
+        int top_blob_index = layer->tops[0];
+
+        Mat bottom_blob = blob_mats[bottom_blob_index];
+
+        if (opt.lightmode)
+        {
+            // delete after the last use in light mode
+            if (release_after_use(ex, bottom_blob_index, step))
+            {
+                blob_mats[bottom_blob_index].release();
+            }
+            // deep copy for inplace forward if data is shared or external
+            if (layer->support_inplace && (!bottom_blob.refcount || *bottom_blob.refcount != 1))
+            {
+                bottom_blob = bottom_blob.clone(opt.blob_allocator);
+            }
+        }
+
+        if (opt.use_bf16_storage)
+        {
+            if (bottom_blob.elemsize / bottom_blob.elempack == 4u && layer->support_bf16_storage)
+            {
+                Mat bottom_blob_bf16;
+                cast_float32_to_bfloat16(bottom_blob, bottom_blob_bf16, opt);
+                bottom_blob = bottom_blob_bf16;
+            }
+            if (bottom_blob.elemsize / bottom_blob.elempack == 2u && !layer->support_bf16_storage)
+            {
+                Mat bottom_blob_fp32;
+                cast_bfloat16_to_float32(bottom_blob, bottom_blob_fp32, opt);
+                bottom_blob = bottom_blob_fp32;
+            }
+        }
+
+        if (opt.use_packing_layout)
+        {
+            int elempack = layer->support_packing ? 4 : 1;
+
+            Mat bottom_blob_packed;
+            convert_packing(bottom_blob, bottom_blob_packed, elempack, opt);
+            bottom_blob = bottom_blob_packed;
+        }
+
+        // forward
+        if (opt.lightmode && layer->support_inplace)
+        {
+            Mat& bottom_top_blob = bottom_blob;
+            LayerProfile profile;
+            if (opt.profiler)
+                profile_begin(profile, layer_index, layer, bottom_top_blob);
+#if NCNN_BENCHMARK
+            double start = get_current_time();
+            int ret = layer->forward_inplace(layer, bottom_top_blob, opt);
+            double end = get_current_time();
+            benchmark(layer, bottom_top_blob, bottom_top_blob, start, end);
+#else
+            int ret = layer->forward_inplace(layer, bottom_top_blob, opt);
+#endif // NCNN_BENCHMARK
+            if (opt.profiler)
+                profile_end(opt.profiler, profile, bottom_top_blob);
+            if (ret != 0)
+                return ret;
+
+            // store top blob
+            blob_mats[top_blob_index] = bottom_top_blob;
+        }
+        else
+        {
+            // a layer creating its top with the planned shape writes into the concat output
+            Mat top_blob = concat_slot_view(this, ex, top_blob_index, opt);
+            LayerProfile profile;
+            if (opt.profiler)
+                profile_begin(profile, layer_index, layer, bottom_blob);
+#if NCNN_BENCHMARK
+            double start = get_current_time();
+            int ret = layer->forward(layer, bottom_blob, top_blob, opt);
+            double end = get_current_time();
+            benchmark(layer, bottom_blob, top_blob, start, end);
+#else
+            int ret = layer->forward(layer, bottom_blob, top_blob, opt);
+#endif // NCNN_BENCHMARK
+            if (opt.profiler)
+                profile_end(opt.profiler, profile, top_blob);
+            if (ret != 0)
+                return ret;
+
+            // store top blob
+            blob_mats[top_blob_index] = top_blob;
+        }
+
+    }
+    else
+    {
+        // load bottom blobs
+        bottom_blobs.clear();
+        bottom_blobs.resize(layer->bottoms.size());
+        for (size_t i=0; i<layer->bottoms.size(); i++)
+        {
+            bottom_blobs[i] = blob_mats[layer->bottoms[i]];
+        }
+
+        // delete after the last use in light mode
+        // only once all bottoms are taken, a blob may be bound twice
+        if (opt.lightmode)
+        {
+            for (size_t i=0; i<layer->bottoms.size(); i++)
+            {
+                int bottom_blob_index = layer->bottoms[i];
+                if (release_after_use(ex, bottom_blob_index, step))
+                {
+                    blob_mats[bottom_blob_index].release();
+                }
+            }
+        }
+
+        for (size_t i=0; i<layer->bottoms.size(); i++)
+        {
             if (opt.lightmode)
             {
-                // delete after taken in light mode
-                blob_mats[bottom_blob_index].release();
-                // deep copy for inplace forward if data is shared
-                if (layer->support_inplace && *bottom_blobs[i].refcount != 1)
+                // deep copy for inplace forward if data is shared or external
+                if (layer->support_inplace && (!bottom_blobs[i].refcount || *bottom_blobs[i].refcount != 1))
                 {
-                    bottom_blobs[i] = bottom_blobs[i].clone();
+                    bottom_blobs[i] = bottom_blobs[i].clone(opt.blob_allocator);
                 }
             }
 
@@ -964,6 +2293,9 @@ int Net::forward_layer(int layer_index, std::vector<Mat>& blob_mats, Option& opt
         if (opt.lightmode && layer->support_inplace)
         {
             std::vector<Mat>& bottom_top_blobs = bottom_blobs;
+            LayerProfile profile;
+            if (opt.profiler)
+                profile_begin(profile, layer_index, layer, bottom_top_blobs);
 #if NCNN_BENCHMARK
             double start = get_current_time();
             int ret = layer->forward_inplace_multi(layer, bottom_top_blobs, opt);
@@ -972,6 +2304,8 @@ int Net::forward_layer(int layer_index, std::vector<Mat>& blob_mats, Option& opt
 #else
             int ret = layer->forward_inplace_multi(layer, bottom_top_blobs, opt);
 #endif // NCNN_BENCHMARK
+            if (opt.profiler)
+                profile_end(opt.profiler, profile, bottom_top_blobs);
             if (ret != 0)
                 return ret;
 
@@ -985,7 +2319,13 @@ int Net::forward_layer(int layer_index, std::vector<Mat>& blob_mats, Option& opt
         }
         else
         {
-            std::vector<Mat> top_blobs(layer->tops.size());
+            top_blobs.clear();
+            top_blobs.resize(layer->tops.size());
+            if (layer->tops.size() == 1)
+                top_blobs[0] = concat_slot_view(this, ex, layer->tops[0], opt);
+            LayerProfile profile;
+            if (opt.profiler)
+                profile_begin(profile, layer_index, layer, bottom_blobs);
 #if NCNN_BENCHMARK
             double start = get_current_time();
             int ret = layer->forward_multi(layer, bottom_blobs, top_blobs, opt);
@@ -994,6 +2334,8 @@ int Net::forward_layer(int layer_index, std::vector<Mat>& blob_mats, Option& opt
 #else
             int ret = layer->forward_multi(layer, bottom_blobs, top_blobs, opt);
 #endif // NCNN_BENCHMARK
+            if (opt.profiler)
+                profile_end(opt.profiler, profile, top_blobs);
             if (ret != 0)
                 return ret;
 
@@ -1004,12 +2346,82 @@ int Net::forward_layer(int layer_index, std::vector<Mat>& blob_mats, Option& opt
 
                 blob_mats[top_blob_index] = top_blobs[i];
             }
+
+            top_blobs.clear();
         }
+
+        // drop the references so light mode can recycle them
+        bottom_blobs.clear();
+
+        // the planned concat output is complete, the top blob holds it now
+        if (!ex.concat_outputs.empty() && layer->tops.size() == 1)
+            ex.concat_outputs[layer->tops[0]].release();
     }
 
-//     fprintf(stderr, "forward_layer %d %s done\n", layer_index, layer->name.c_str());
+//     fprintf(stderr, "forward_layer %d %s done\n", layer_index, layer->name);
 //     const Mat& blob = blob_mats[layer->tops[0]];
-//     fprintf(stderr, "[%-2d %-16s %-16s]  %d    blobs count = %-3d   size = %-3d x %-3d\n", layer_index, layer->type.c_str(), layer->name.c_str(), layer->tops[0], blob.c, blob.h, blob.w);
+//     fprintf(stderr, "[%-2d %-16s %-16s]  %d    blobs count = %-3d   size = %-3d x %-3d\n", layer_index, layer->type, layer->name, layer->tops[0], blob.c, blob.h, blob.w);
+
+    return 0;
+}
+
+int Net::forward_layer_batch(int layer_index, const std::vector<Extractor*>& exs, int step) const
+{
+    Layer* layer = vector_get(layers, layer_index);
+
+    const Option& opt = exs[0]->opt;
+
+    // storage conversions are done per sample in forward_layer
+    if (exs.size() == 1 || !layer->forward_batch || !layer->one_blob_only || opt.use_bf16_storage || opt.use_packing_layout)
+    {
+        for (size_t b=0; b<exs.size(); b++)
+        {
+            int ret = forward_layer(layer_index, *exs[b], step);
+            if (ret != 0)
+                return ret;
+        }
+
+        return 0;
+    }
+
+    const int bottom_blob_index = layer->bottoms[0];
+    const int top_blob_index = layer->tops[0];
+
+    std::vector<Mat> bottom_blobs(exs.size());
+    for (size_t b=0; b<exs.size(); b++)
+    {
+        bottom_blobs[b] = exs[b]->blob_mats[bottom_blob_index];
+
+        // delete after the last use in light mode
+        if (opt.lightmode && exs[b]->blob_release_step[bottom_blob_index] == step)
+        {
+            exs[b]->blob_mats[bottom_blob_index].release();
+        }
+    }
+
+    std::vector<Mat> top_blobs(exs.size());
+    // one record for the whole batch
+    LayerProfile profile;
+    if (opt.profiler)
+        profile_begin(profile, layer_index, layer, bottom_blobs);
+#if NCNN_BENCHMARK
+    double start = get_current_time();
+    int ret = layer->forward_batch(layer, bottom_blobs, top_blobs, opt);
+    double end = get_current_time();
+    benchmark(layer, start, end);
+#else
+    int ret = layer->forward_batch(layer, bottom_blobs, top_blobs, opt);
+#endif // NCNN_BENCHMARK
+    if (opt.profiler)
+        profile_end(opt.profiler, profile, top_blobs);
+    if (ret != 0)
+        return ret;
+
+    // store top blobs
+    for (size_t b=0; b<exs.size(); b++)
+    {
+        exs[b]->blob_mats[top_blob_index] = top_blobs[b];
+    }
 
     return 0;
 }
@@ -1018,11 +2430,362 @@ Extractor::Extractor(const Net* _net, size_t blob_count) : net(_net)
 {
     blob_mats.resize(blob_count);
     opt = net->opt;
+
+    step_needed.resize(net->forward_plan.size(), 0);
+    blob_needed.resize(blob_count, 0);
+    blob_release_step.resize(blob_count, -1);
+
+    arena_allocator = 0;
+    arena_plan_used = false;
+    arena = 0;
+    arena_size = 0;
+}
+
+Extractor::Extractor(Extractor&& other)
+    : net(other.net), blob_mats(std::move(other.blob_mats)), opt(other.opt),
+      step_needed(std::move(other.step_needed)), blob_needed(std::move(other.blob_needed)),
+      blob_release_step(std::move(other.blob_release_step)), blob_pending_uses(std::move(other.blob_pending_uses)),
+      concat_outputs(std::move(other.concat_outputs)),
+      bottom_blobs(std::move(other.bottom_blobs)), top_blobs(std::move(other.top_blobs)),
+      arena_allocator(other.arena_allocator), arena_plan_used(other.arena_plan_used),
+      arena(other.arena), arena_size(other.arena_size)
+{
+    // the source gives up the arena, its destructor must not release it again
+    other.arena_allocator = 0;
+    other.arena_plan_used = false;
+    other.arena = 0;
+    other.arena_size = 0;
 }
 
 Extractor::~Extractor()
 {
     blob_mats.clear();
+    concat_outputs.clear();
+    bottom_blobs.clear();
+    top_blobs.clear();
+
+    if (arena_allocator)
+    {
+        pthread_mutex_lock(&net->arena_lock);
+
+        if (arena_plan_used)
+            net->arena_plan_users--;
+
+        // learn the blob sequence of this run unless it replayed the plan already,
+        // a plan from the shape hints is kept, the shapes are only known by running otherwise
+        if (!net->arena_plan.from_shapes && !arena_allocator->replayed() && net->arena_plan_users == 0)
+        {
+            arena_allocator->build_plan(net->arena_plan);
+        }
+
+        // keep the larger arena for the next extractor
+        if (arena_size > net->arena_cache_size)
+        {
+            fastFree(net->arena_cache);
+            net->arena_cache = arena;
+            net->arena_cache_size = arena_size;
+            arena = 0;
+        }
+
+        pthread_mutex_unlock(&net->arena_lock);
+
+        fastFree(arena);
+        delete arena_allocator;
+    }
+}
+
+static void setup_arena_allocator(Extractor* ex)
+{
+    const Net* net = ex->net;
+
+    ex->arena_allocator = new ArenaAllocator;
+
+    pthread_mutex_lock(&net->arena_lock);
+
+    // the options a plan from the shape hints was made for
+    const bool from_shapes = net->arena_plan.from_shapes;
+    const bool plan_fits = !from_shapes || (ex->opt.lightmode == net->opt.lightmode
+                           && ex->opt.use_blob_views == net->opt.use_blob_views
+                           && ex->opt.use_bf16_storage == net->opt.use_bf16_storage
+                           && ex->opt.use_packing_layout == net->opt.use_packing_layout);
+
+    const ArenaPlan* plan = 0;
+    if (net->arena_plan.peak_size != 0 && plan_fits)
+    {
+        plan = &net->arena_plan;
+        net->arena_plan_users++;
+        ex->arena_plan_used = true;
+
+        if (net->arena_cache_size >= plan->peak_size)
+        {
+            ex->arena = net->arena_cache;
+            ex->arena_size = net->arena_cache_size;
+            net->arena_cache = 0;
+            net->arena_cache_size = 0;
+        }
+    }
+
+    pthread_mutex_unlock(&net->arena_lock);
+
+    if (plan && !ex->arena)
+    {
+        ex->arena = fastMalloc(plan->peak_size);
+        ex->arena_size = ex->arena ? plan->peak_size : 0;
+    }
+
+    ex->arena_allocator->reset(plan, ex->arena);
+
+    ex->opt.blob_allocator = ex->arena_allocator;
+    // a plan from the shape hints covers the blobs only, the layer workspace is not known up front
+    if (!ex->opt.workspace_allocator && !from_shapes)
+        ex->opt.workspace_allocator = ex->arena_allocator;
+}
+
+// schedule the steps of ex->net->forward_plan needed for blob_index
+// and the step after which each input blob is dead
+// return 0 if success
+static int plan_extract(Extractor* ex, int blob_index)
+{
+    const Net* net = ex->net;
+    const std::vector<int>& plan = net->forward_plan;
+    const int step_count = (int)plan.size();
+
+    // walk the plan backwards from the requested blob and keep the steps producing missing blobs,
+    // the first consumer met of a blob this way is its last use
+    std::fill(ex->blob_needed.begin(), ex->blob_needed.end(), 0);
+    ex->blob_needed[blob_index] = 1;
+    ex->blob_release_step[blob_index] = -1;
+
+    for (int i=step_count-1; i>=0; i--)
+    {
+        const Layer* layer = vector_get(net->layers, plan[i]);
+
+        bool needed = false;
+        for (size_t j=0; j<layer->tops.size(); j++)
+        {
+            int top_blob_index = layer->tops[j];
+            if (ex->blob_needed[top_blob_index] && ex->blob_mats[top_blob_index].dims == 0)
+            {
+                needed = true;
+                break;
+            }
+        }
+
+        ex->step_needed[i] = needed;
+        if (!needed)
+            continue;
+
+        if (layer->one_blob_only && layer->bottoms.empty())
+        {
+            fprintf(stderr, "input of layer %d is not set\n", plan[i]);
+            return -1;
+        }
+
+        for (size_t j=0; j<layer->bottoms.size(); j++)
+        {
+            int bottom_blob_index = layer->bottoms[j];
+            if (ex->blob_needed[bottom_blob_index])
+                continue;
+
+            if (ex->blob_mats[bottom_blob_index].dims == 0 && vector_get(net->blobs, bottom_blob_index).producer < 0)
+            {
+                fprintf(stderr, "blob %d is not set\n", bottom_blob_index);
+                return -1;
+            }
+
+            ex->blob_needed[bottom_blob_index] = 1;
+            ex->blob_release_step[bottom_blob_index] = i;
+        }
+    }
+
+    return 0;
+}
+
+// the needed steps of one extract as a dependency graph,
+// drained by a few thread pool participants that each take whatever step is ready
+struct BranchSchedule
+{
+    const Net* net;
+    Extractor* ex;
+
+    // producer steps still running or waiting, per step
+    std::vector<int> pending;
+    // needed steps reading a top of the step
+    std::vector< std::vector<int> > successors;
+
+    // steps whose bottoms are all done, lowest step first
+    std::priority_queue<int, std::vector<int>, std::greater<int> > ready;
+
+    int remaining;
+    int ret;
+
+    // threads of ex->opt.num_threads not lent to a running step,
+    // taken and given back under the lock so the running steps never exceed the budget
+    int free_threads;
+    // participants inside branch_worker not running a step
+    int idle;
+
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+};
+
+static void branch_worker(int /*participant*/, void* args)
+{
+    BranchSchedule* s = (BranchSchedule*)args;
+
+    Option opt = s->ex->opt;
+    std::vector<Mat> bottom_blobs;
+    std::vector<Mat> top_blobs;
+
+    pthread_mutex_lock(&s->lock);
+    s->idle++;
+    for (;;)
+    {
+        while ((s->ready.empty() || s->free_threads == 0) && s->remaining > 0 && s->ret == 0)
+            pthread_cond_wait(&s->cond, &s->lock);
+
+        if (s->remaining == 0 || s->ret != 0)
+            break;
+
+        // share the free threads among the ready steps that can start now
+        const int starting = std::min((int)s->ready.size(), s->idle);
+        const int num_threads = std::max(s->free_threads / starting, 1);
+
+        int step = s->ready.top();
+        s->ready.pop();
+
+        s->free_threads -= num_threads;
+        s->idle--;
+        opt.num_threads = num_threads;
+
+        pthread_mutex_unlock(&s->lock);
+
+        int ret = s->net->forward_layer(s->net->forward_plan[step], *s->ex, step, opt, bottom_blobs, top_blobs);
+
+        pthread_mutex_lock(&s->lock);
+
+        s->free_threads += num_threads;
+        s->idle++;
+        s->remaining--;
+
+        if (ret != 0)
+            s->ret = ret;
+
+        for (size_t j=0; j<s->successors[step].size(); j++)
+        {
+            int successor = s->successors[step][j];
+            if (--s->pending[successor] == 0)
+                s->ready.push(successor);
+        }
+
+        pthread_cond_broadcast(&s->cond);
+    }
+    s->idle--;
+    pthread_mutex_unlock(&s->lock);
+}
+
+// run the steps selected by plan_extract with independent branches in parallel
+// falls back to one step at a time when the needed steps form a single chain
+static int forward_branches(Extractor* ex)
+{
+    const Net* net = ex->net;
+    const std::vector<int>& plan = net->forward_plan;
+    const int step_count = (int)plan.size();
+    const int layer_count = (int)vector_size(net->layers);
+
+    BranchSchedule s;
+    s.net = net;
+    s.ex = ex;
+    s.pending.resize(step_count, 0);
+    s.successors.resize(step_count);
+    s.remaining = 0;
+    s.ret = 0;
+
+    std::vector<int> layer_step(layer_count, -1);
+    for (int i=0; i<step_count; i++)
+    {
+        layer_step[plan[i]] = i;
+    }
+
+    ex->blob_pending_uses.assign(ex->blob_mats.size(), 0);
+
+    int max_ready = 0;
+    for (int i=0; i<step_count; i++)
+    {
+        if (!ex->step_needed[i])
+            continue;
+
+        const Layer* layer = vector_get(net->layers, plan[i]);
+        for (size_t j=0; j<layer->bottoms.size(); j++)
+        {
+            int bottom_blob_index = layer->bottoms[j];
+
+            ex->blob_pending_uses[bottom_blob_index]++;
+
+            // a blob set before this extract has no running producer
+            if (ex->blob_mats[bottom_blob_index].dims != 0)
+                continue;
+
+            int producer = vector_get(net->blobs, bottom_blob_index).producer;
+            int producer_step = producer < 0 ? -1 : layer_step[producer];
+            if (producer_step < 0 || !ex->step_needed[producer_step])
+                continue;
+
+            s.successors[producer_step].push_back(i);
+            s.pending[i]++;
+        }
+
+        if (s.pending[i] == 0)
+            s.ready.push(i);
+
+        s.remaining++;
+    }
+
+    for (int i=0; i<step_count; i++)
+    {
+        max_ready = std::max(max_ready, (int)s.successors[i].size());
+    }
+    max_ready = std::max(max_ready, (int)s.ready.size());
+
+    int ret = 0;
+    if (max_ready < 2)
+    {
+        // a single chain, nothing to overlap
+        ex->blob_pending_uses.clear();
+
+        for (int i=0; i<step_count; i++)
+        {
+            if (!ex->step_needed[i])
+                continue;
+
+            ret = net->forward_layer(plan[i], *ex, i);
+            if (ret != 0)
+                break;
+        }
+
+        return ret;
+    }
+
+    pthread_mutex_init(&s.lock, 0);
+    pthread_cond_init(&s.cond, 0);
+
+    s.free_threads = std::max(ex->opt.num_threads, 1);
+    s.idle = 0;
+
+    // the branches run on the persistent thread pool, the calling thread takes part as well
+    // a participant the pool cannot staff is run after the others and finds nothing left
+    Option opt_branches = ex->opt;
+    opt_branches.use_thread_pool = true;
+    opt_branches.num_threads = std::min(std::min(ex->opt.num_branch_threads, s.free_threads), s.remaining);
+
+    parallel_for(opt_branches.num_threads, branch_worker, &s, opt_branches);
+
+    pthread_cond_destroy(&s.cond);
+    pthread_mutex_destroy(&s.lock);
+
+    ex->blob_pending_uses.clear();
+
+    return s.ret;
 }
 
 void Extractor::set_light_mode(bool enable)
@@ -1045,6 +2808,11 @@ void Extractor::set_workspace_allocator(Allocator* allocator)
     opt.workspace_allocator = allocator;
 }
 
+void Extractor::set_profiler(Profiler* profiler)
+{
+    opt.profiler = profiler;
+}
+
 #if NCNN_STRING
 int Extractor::input(const char* blob_name, const Mat& in)
 {
@@ -1082,9 +2850,39 @@ int Extractor::extract(int blob_index, Mat& feat)
 
     int ret = 0;
 
+    if (opt.use_arena_allocator && !opt.blob_allocator && !arena_allocator)
+    {
+        setup_arena_allocator(this);
+    }
+
     if (blob_mats[blob_index].dims == 0)
     {
-        int layer_index = vector_get(net->blobs, blob_index).producer;
+        const std::vector<int>& plan = net->forward_plan;
+        const int step_count = (int)plan.size();
+
+        ret = plan_extract(this, blob_index);
+        if (ret != 0)
+            return ret;
+
+        // the arena replays a fixed allocation order, which concurrent branches do not keep
+        if (opt.num_branch_threads > 1 && !arena_allocator)
+        {
+            ret = forward_branches(this);
+            if (ret != 0)
+                return ret;
+        }
+        else
+        {
+            for (int i=0; i<step_count; i++)
+            {
+                if (!step_needed[i])
+                    continue;
+
+                ret = net->forward_layer(plan[i], *this, i);
+                if (ret != 0)
+                    return ret;
+            }
+        }
     }
 
     feat = blob_mats[blob_index];
@@ -1096,5 +2894,111 @@ int Extractor::extract(int blob_index, Mat& feat)
         feat = bottom_blob_unpacked;
     }
 
+    // the arena is reused by the next run, hand out a copy
+    if (arena_allocator && feat.allocator == arena_allocator)
+    {
+        feat = feat.clone();
+    }
+
+    return ret;
+}
+
+int forward_batch(const Net *net, const std::vector<int>& input_indexes, const std::vector<std::vector<Mat> >& inputs,
+                  const std::vector<int>& output_indexes, std::vector<std::vector<Mat> >& outputs, const Option& opt)
+{
+    const int batch = (int)inputs.size();
+    for (int b=0; b<batch; b++)
+    {
+        if (input_indexes.size() != inputs[b].size())
+        {
+            fprintf(stderr, "forward_batch got %d input blobs for %d mats of sample %d\n", (int)input_indexes.size(), (int)inputs[b].size(), b);
+            return -1;
+        }
+    }
+
+    outputs.resize(batch);
+    if (batch == 0)
+        return 0;
+
+    std::vector<Extractor*> exs(batch);
+    for (int b=0; b<batch; b++)
+    {
+        exs[b] = new Extractor(net, vector_size(net->blobs));
+        exs[b]->opt = opt;
+        exs[b]->opt.use_arena_allocator = false;
+    }
+
+    int ret = 0;
+    for (int b=0; b<batch && ret == 0; b++)
+    {
+        for (size_t i=0; i<input_indexes.size() && ret == 0; i++)
+        {
+            ret = exs[b]->input(input_indexes[i], inputs[b][i]);
+        }
+    }
+
+    const std::vector<int>& plan = net->forward_plan;
+    for (size_t k=0; k<output_indexes.size() && ret == 0; k++)
+    {
+        const int blob_index = output_indexes[k];
+        if (blob_index < 0 || blob_index >= (int)vector_size(net->blobs))
+        {
+            ret = -1;
+            break;
+        }
+
+        // the samples share one graph and one set of inputs, so they share the schedule too
+        if (exs[0]->blob_mats[blob_index].dims == 0)
+        {
+            for (int b=0; b<batch && ret == 0; b++)
+            {
+                ret = plan_extract(exs[b], blob_index);
+            }
+
+            for (size_t i=0; i<plan.size() && ret == 0; i++)
+            {
+                if (!exs[0]->step_needed[i])
+                    continue;
+
+                ret = net->forward_layer_batch(plan[i], exs, (int)i);
+            }
+        }
+
+        for (int b=0; b<batch && ret == 0; b++)
+        {
+            outputs[b].resize(output_indexes.size());
+            ret = exs[b]->extract(blob_index, outputs[b][k]);
+        }
+    }
+
+    for (int b=0; b<batch; b++)
+    {
+        delete exs[b];
+    }
+
     return ret;
 }
+
+#if NCNN_STRING
+int forward_batch(const Net *net, const std::vector<const char*>& input_names, const std::vector<std::vector<Mat> >& inputs,
+                  const std::vector<const char*>& output_names, std::vector<std::vector<Mat> >& outputs, const Option& opt)
+{
+    std::vector<int> input_indexes(input_names.size());
+    for (size_t i=0; i<input_names.size(); i++)
+    {
+        input_indexes[i] = find_blob_index_by_name(net, input_names[i]);
+        if (input_indexes[i] == -1)
+            return -1;
+    }
+
+    std::vector<int> output_indexes(output_names.size());
+    for (size_t i=0; i<output_names.size(); i++)
+    {
+        output_indexes[i] = find_blob_index_by_name(net, output_names[i]);
+        if (output_indexes[i] == -1)
+            return -1;
+    }
+
+    return forward_batch(net, input_indexes, inputs, output_indexes, outputs, opt);
+}
+#endif // NCNN_STRING
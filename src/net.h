@@ -27,6 +27,36 @@
 
 struct DataReader;
 struct Extractor;
+
+#if NCNN_STRING
+// open addressing hash table from names to blob or layer indexes
+// the names stay in the blobs and layers, a slot only holds the index
+struct NameIndex
+{
+    // index of the named blob or layer, -1 for an empty slot
+    std::vector<int> slots;
+    // name hash of each occupied slot
+    std::vector<unsigned int> hashes;
+};
+#endif // NCNN_STRING
+
+// where a blob sits inside the output of the channel axis Concat consuming it
+struct ConcatSlot
+{
+    // the concat layer and its forward plan step, -1 if the blob has no slot
+    int layer_index;
+    int step;
+    // first channel of the blob in the concat output
+    int channel_offset;
+};
+
+// a loaded net is immutable during inference
+// layers keep no per request state in forward, so any number of threads
+// may run their own Extractor on one const Net at the same time,
+// sharing a single copy of the weights and transformed kernels
+// loading, reshape, clear and custom layer registration are not thread safe
+// allocators shared by concurrent extractors must be thread safe,
+// PoolAllocator and BucketPoolAllocator are, UnlockedPoolAllocator is not
 struct Net
 {
     // empty init
@@ -68,6 +98,9 @@ struct Net
     int load_param_bin(const char* protopath);
 
     // load network weight data from model file
+    // the path variant maps the file read only where mmap is available,
+    // fp32 and int8 weights then reference the mapped pages without a copy
+    // and the file must not be truncated or rewritten until clear
     // return 0 if success
     int load_model(FILE* fp);
     int load_model(const char* modelpath);
@@ -100,22 +133,109 @@ struct Net
     int load_model(AAssetManager* mgr, const char* assetpath);
 #endif // __ANDROID_API__ >= 9
 
+    // set concrete input blob shapes and propagate them through the graph
+    // into every blob shape and layer shape hint
+    // call it after load_param and before load_model, so that
+    // create_pipeline selects kernels for the final shapes
+    // return 0 if success
+    int reshape(const std::vector<int>& input_indexes, const std::vector<Mat>& input_shapes);
+#if NCNN_STRING
+    int reshape(const char* blob_name, const Mat& shape);
+#endif // NCNN_STRING
+    int reshape(int blob_index, const Mat& shape);
+
+    // rewrite the loaded graph into a cheaper equivalent one
+    // BatchNorm, Scale, Bias, scalar BinaryOp and Dropout are folded into the
+    // weights of the Convolution, ConvolutionDepthWise or InnerProduct before them,
+    // a following ReLU, Clip, Sigmoid or HardSwish becomes their activation_type,
+    // and Noop, single output Split and overridden Reshape layers are dropped
+    // call it after load_model, the pipelines are recreated for the new weights
+    // blobs in the middle of a folded chain can no longer be extracted
+    // return 0 if success
+    int optimize();
+
+    // bytes of weight memory held by one layer, the loaded weights
+    // and the copies packed by create_pipeline, a shared buffer counted once
+    // use it to check what opt.lightweight releases
+    size_t layer_weight_bytes(int layer_index) const;
+
+    // bytes of weight memory held by all layers, a shared buffer counted once
+    size_t weight_bytes() const;
+
     // unload network structure and weight data
     void clear();
 
-    int forward_layer(int layer_index, std::vector<Mat>& blob_mats, Option& opt) const;
+    // run one step of the forward plan on the extractor blobs
+    int forward_layer(int layer_index, Extractor& ex, int step) const;
+    // same with a step private option and bottom and top lists, for steps running concurrently
+    int forward_layer(int layer_index, Extractor& ex, int step, const Option& opt, std::vector<Mat>& bottom_blobs, std::vector<Mat>& top_blobs) const;
+
+    // run one step of the forward plan on the blobs of every extractor in a batch
+    int forward_layer_batch(int layer_index, const std::vector<Extractor*>& exs, int step) const;
 
     vector_def(Blob) blobs;
     vector_def(Layer*) layers;
 
+    // layer indexes in topological order, compiled in load_model
+    std::vector<int> forward_plan;
+
+    // concat slot of every blob, planned from the shape hints with the forward plan
+    // see Option::use_blob_views
+    std::vector<ConcatSlot> concat_slots;
+
+    // blob arena plan made from the shape hints, or learned from the last extractor run
+    // when a shape is data dependent, and a spare arena shared by the extractors under arena_lock
+    mutable ArenaPlan arena_plan;
+    mutable int arena_plan_users;
+    mutable void* arena_cache;
+    mutable size_t arena_cache_size;
+    mutable pthread_mutex_t arena_lock;
+
     vector_def(layer_registry_entry) custom_layer_registry;
+
+#if NCNN_STRING
+    // name lookup for find_blob_index_by_name and find_layer_index_by_name
+    // filled while parsing the plain param, empty for the binary one
+    NameIndex blob_name_index;
+    NameIndex layer_name_index;
+#endif // NCNN_STRING
+
+    // read only mapping of the model file, referenced by the weights until clear
+    const unsigned char* mapped_model;
+    size_t mapped_model_size;
 };
 
 // construct an Extractor from network
-extern Extractor create_extractor(Net *net);
+extern Extractor create_extractor(const Net *net);
+
+// run one whole request on a private extractor configured by opt
+// safe to call from many threads at once on one loaded net
+// outputs are resized to the output count
+// return 0 if success
+extern int forward_request(const Net *net, const std::vector<int>& input_indexes, const std::vector<Mat>& inputs,
+                           const std::vector<int>& output_indexes, std::vector<Mat>& outputs, const Option& opt);
+#if NCNN_STRING
+extern int forward_request(const Net *net, const std::vector<const char*>& input_names, const std::vector<Mat>& inputs,
+                           const std::vector<const char*>& output_names, std::vector<Mat>& outputs, const Option& opt);
+#endif // NCNN_STRING
 
+// run a batch of requests together, inputs[i] and outputs[i] belong to sample i
+// each layer runs for all samples before the next layer starts, so its weights are
+// streamed from memory once per batch and stay in cache for the other samples,
+// layers with forward_batch take the whole batch in a single weight pass
+// opt.use_arena_allocator is ignored
+// return 0 if success
+extern int forward_batch(const Net *net, const std::vector<int>& input_indexes, const std::vector<std::vector<Mat> >& inputs,
+                         const std::vector<int>& output_indexes, std::vector<std::vector<Mat> >& outputs, const Option& opt);
 #if NCNN_STRING
+extern int forward_batch(const Net *net, const std::vector<const char*>& input_names, const std::vector<std::vector<Mat> >& inputs,
+                         const std::vector<const char*>& output_names, std::vector<std::vector<Mat> >& outputs, const Option& opt);
+#endif // NCNN_STRING
 
+#if NCNN_STRING
+
+// hashed lookup when the net came from a plain param, linear search otherwise
+// return -1 if not found
 extern int find_blob_index_by_name(const Net *net, const char* name);
 extern int find_layer_index_by_name(Net *net, const char* name);
 extern int custom_layer_to_index(Net *net, const char* type);
@@ -129,6 +249,22 @@ extern Layer* create_custom_layer_by_index(Net *net, int index);
 // fuse int8 op dequantize and quantize by requantize
 int fuse_network(Net *net);
 
+// fold layers and strip passthrough layers as described in Net::optimize
+// layer indexes change, blob indexes stay
+// return 0 if success
+int optimize_network(Net *net);
+
+// sort the layers topologically into net->forward_plan
+// return 0 if success, -1 if the graph has a cycle
+int build_forward_plan(Net *net);
+
+// propagate blob shapes along net->forward_plan with the layer infer_shape
+// layers with unknown input shapes or data dependent output shapes
+// keep the shape hints they already have
+// the concat slots and the blob arena plan are made from the resulting hints
+// return 0 if success
+int infer_network_shapes(Net *net);
+
 struct Extractor
 {
     ~Extractor();
@@ -149,6 +285,9 @@ struct Extractor
     // set workspace memory allocator
     void set_workspace_allocator(Allocator* allocator);
 
+    // set profiler recording every layer forward, null to stop
+    void set_profiler(Profiler* profiler);
+
 #if NCNN_STRING
     // set input by blob name
     // return 0 if success
@@ -169,9 +308,37 @@ struct Extractor
 
     Extractor(const Net* net, size_t blob_count);
 
+    // move only, an extractor owns its blob arena and counts as a user of the net arena plan
+    Extractor(Extractor&& other);
+    Extractor(const Extractor&) = delete;
+    Extractor& operator=(const Extractor&) = delete;
+
     const Net* net;
     std::vector<Mat> blob_mats;
     Option opt;
+
+    // schedule of the current extract, restricted to the ancestors of the requested blob
+    // step_needed[i] tells whether forward_plan[i] runs
+    // blob_release_step[i] is the step after which blob i is dead, -1 if it is kept
+    std::vector<char> step_needed;
+    std::vector<char> blob_needed;
+    std::vector<int> blob_release_step;
+    // consumers yet to take blob i when branches run concurrently, empty otherwise
+    std::vector<int> blob_pending_uses;
+
+    // output of a planned concat while its producers fill their slots,
+    // indexed by the concat top blob, empty until the first slot is handed out
+    std::vector<Mat> concat_outputs;
+
+    // reused bottom and top lists for multi blob layers
+    std::vector<Mat> bottom_blobs;
+    std::vector<Mat> top_blobs;
+
+    // blob arena when opt.use_arena_allocator is enabled, set up on first extract
+    ArenaAllocator* arena_allocator;
+    bool arena_plan_used;
+    void* arena;
+    size_t arena_size;
 };
 
 #endif // NCNN_NET_H
@@ -19,6 +19,8 @@ Option::Option()
 {
     lightmode = true;
     num_threads = get_cpu_count();
+    num_branch_threads = 1;
+    use_thread_pool = false;
     blob_allocator = 0;
     workspace_allocator = 0;
 
@@ -35,4 +37,14 @@ Option::Option()
     use_packing_layout = false;
 
     use_bf16_storage = false;
+
+    use_arena_allocator = false;
+
+    use_blob_views = false;
+
+    lightweight = false;
+
+    pipeline_cache = 0;
+
+    profiler = 0;
 }
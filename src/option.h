@@ -18,6 +18,8 @@
 #include "platform.h"
 
 struct Allocator;
+struct PipelineCache;
+struct Profiler;
 struct Option
 {
     // default option
@@ -32,6 +34,19 @@ struct Option
     // default value is the one returned by get_cpu_count()
     int num_threads;
 
+    // run independent branches of the graph on up to this many thread pool threads at once
+    // the num_threads budget is split among the layers running at the same time,
+    // a layer starts with its share of the threads left and gives them back when done
+    // the allocators must be thread safe and use_arena_allocator is ignored then
+    // default value is 1, one layer at a time
+    int num_branch_threads;
+
+    // run the ported parallel loops on the ncnn thread pool instead of openmp
+    // the pool keeps one set of threads per process for all extractors,
+    // see threadpool.h, always on when built without openmp
+    // disabled by default
+    bool use_thread_pool;
+
     // blob memory allocator
     Allocator* blob_allocator;
 
@@ -68,6 +83,41 @@ struct Option
 
     // enable options for cpu inference
     bool use_bf16_storage;
+
+    // serve intermediate blobs from one arena per extractor
+    // offsets are planned from the blob shape hints when load_model or reshape can infer them all,
+    // from the previous run of the same net otherwise, which also serves workspace then
+    // ignored when blob_allocator is set, workspace is only served if workspace_allocator is not set
+    // disabled by default
+    bool use_arena_allocator;
+
+    // let the producers of a channel axis Concat write straight into their
+    // channel range of the concat output, planned from the blob shape hints,
+    // and let Slice return ranges of its input where the slices are contiguous
+    // a producer writing elsewhere, or shapes differing from the hints, fall back to a copy
+    // ignored for the producers when branches run concurrently
+    // disabled by default
+    bool use_blob_views;
+
+    // release the loaded weights of a layer once create_pipeline has packed
+    // the copy its kernel reads, so only one copy of the weights stays resident
+    // Net::optimize needs the loaded weights and fails after they are released,
+    // and the kernel selecting options can no longer be changed per extractor
+    // changes should be applied before loading network weight
+    // disabled by default
+    bool lightweight;
+
+    // look up and store the weights transformed in create_pipeline here
+    // so that a later start can load them instead of transforming again
+    // changes should be applied before loading network weight
+    // null by default
+    PipelineCache* pipeline_cache;
+
+    // record the time, shapes and allocations of every layer forward here
+    // cheap enough to leave on in production builds, see profiler.h
+    // the profiler must outlive the extracts using it
+    // null by default
+    Profiler* profiler;
 };
 
 #endif // NCNN_OPTION_H
@@ -13,6 +13,7 @@
 // specific language governing permissions and limitations under the License.
 
 #include <ctype.h>
+#include <stdlib.h>
 #include "paramdict.h"
 #include "datareader.h"
 #include "platform.h"
@@ -81,6 +82,22 @@ static bool vstr_is_float(const char vstr[16])
     return false;
 }
 
+// strtof and strtol instead of sscanf, the values are already split out
+// return 1 if a number was parsed, like sscanf
+static int parse_vstr(const char* vstr, float* f)
+{
+    char* end = 0;
+    *f = strtof(vstr, &end);
+    return end != vstr ? 1 : 0;
+}
+
+static int parse_vstr(const char* vstr, int* i)
+{
+    char* end = 0;
+    *i = (int)strtol(vstr, &end, 10);
+    return end != vstr ? 1 : 0;
+}
+
 int ParamDict::load_param(const DataReader& dr)
 {
     clear();
@@ -124,12 +141,12 @@ int ParamDict::load_param(const DataReader& dr)
                 if (is_float)
                 {
                     float* ptr = params[id].v;
-                    nscan = sscanf(vstr, "%f", &ptr[j]);
+                    nscan = parse_vstr(vstr, &ptr[j]);
                 }
                 else
                 {
                     int* ptr = params[id].v;
-                    nscan = sscanf(vstr, "%d", &ptr[j]);
+                    nscan = parse_vstr(vstr, &ptr[j]);
                 }
                 if (nscan != 1)
                 {
@@ -153,9 +170,9 @@ int ParamDict::load_param(const DataReader& dr)
             bool is_float = vstr_is_float(vstr);
 
             if (is_float)
-                nscan = sscanf(vstr, "%f", &params[id].f);
+                nscan = parse_vstr(vstr, &params[id].f);
             else
-                nscan = sscanf(vstr, "%d", &params[id].i);
+                nscan = parse_vstr(vstr, &params[id].i);
             if (nscan != 1)
             {
                 fprintf(stderr, "ParamDict parse value failed\n");
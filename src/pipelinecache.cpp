@@ -0,0 +1,344 @@
+// Tencent is pleased to support the open source community by making ncnn available.
+//
+// Copyright (C) 2020 THL A29 Limited, a Tencent company. All rights reserved.
+//
+// Licensed under the BSD 3-Clause License (the "License"); you may not use this file except
+// in compliance with the License. You may obtain a copy of the License at
+//
+// https://opensource.org/licenses/BSD-3-Clause
+//
+// Unless required by applicable law or agreed to in writing, software distributed
+// under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+// CONDITIONS OF ANY KIND, either express or implied. See the License for the
+// specific language governing permissions and limitations under the License.
+
+
+#include "pipelinecache.h"
+
+#include <stdio.h>
+#include <string.h>
+#include "option.h"
+
+// file layout, all little endian
+// header  uint32 magic, uint32 version, uint32 entry count
+// entry   uint64 key, uint64 source size, uint64 source checksum,
+//         int32 dims w h c elempack, uint32 elemsize, then c planes of w*h*elemsize bytes
+static const unsigned int PIPELINE_CACHE_MAGIC = 0x4350434e;
+static const unsigned int PIPELINE_CACHE_VERSION = 2;
+
+PipelineCache::PipelineCache()
+{
+}
+
+PipelineCache::~PipelineCache()
+{
+    clear();
+}
+
+#if NCNN_STDIO
+// a shape the transforms can produce and the file has the bytes for
+static bool valid_entry_shape(const int* shape, unsigned int elemsize, long remaining)
+{
+    const int dims = shape[0];
+    const int w = shape[1];
+    const int h = shape[2];
+    const int c = shape[3];
+    const int elempack = shape[4];
+
+    if (dims < 1 || dims > 3 || w <= 0 || h <= 0 || c <= 0)
+        return false;
+
+    if ((dims < 2 && h != 1) || (dims < 3 && c != 1))
+        return false;
+
+    if (elemsize != 1 && elemsize != 2 && elemsize != 4 && elemsize != 8 && elemsize != 16 && elemsize != 32 && elemsize != 64)
+        return false;
+
+    if (elempack <= 0 || elemsize % elempack != 0 || elemsize / elempack > 4)
+        return false;
+
+    // the planes must fit in the rest of the file, which bounds w h c too
+    const unsigned long long size = (unsigned long long)w * h * c * elemsize;
+    return size <= (unsigned long long)remaining;
+}
+
+int PipelineCache::load(const char* path)
+{
+    FILE* fp = fopen(path, "rb");
+    if (!fp)
+    {
+        fprintf(stderr, "fopen %s failed\n", path);
+        return -1;
+    }
+
+    clear();
+
+    long file_size = -1;
+    if (fseek(fp, 0, SEEK_END) == 0)
+    {
+        file_size = ftell(fp);
+        fseek(fp, 0, SEEK_SET);
+    }
+
+    unsigned int header[3];
+    if (file_size < 0 || fread(header, sizeof(header), 1, fp) != 1 || header[0] != PIPELINE_CACHE_MAGIC || header[1] != PIPELINE_CACHE_VERSION)
+    {
+        fprintf(stderr, "pipeline cache %s has no valid header\n", path);
+        fclose(fp);
+        return -1;
+    }
+
+    for (unsigned int i=0; i<header[2]; i++)
+    {
+        PipelineCacheKey key;
+        int shape[5];
+        unsigned int elemsize;
+        if (fread(&key.key, sizeof(key.key), 1, fp) != 1 || fread(&key.source_size, sizeof(key.source_size), 1, fp) != 1
+            || fread(&key.source_checksum, sizeof(key.source_checksum), 1, fp) != 1
+            || fread(shape, sizeof(shape), 1, fp) != 1 || fread(&elemsize, sizeof(elemsize), 1, fp) != 1)
+            break;
+
+        if (!valid_entry_shape(shape, elemsize, file_size - ftell(fp)))
+        {
+            fprintf(stderr, "pipeline cache %s entry %d has an invalid shape dims=%d w=%d h=%d c=%d elempack=%d elemsize=%u\n",
+                    path, i, shape[0], shape[1], shape[2], shape[3], shape[4], elemsize);
+            clear();
+            fclose(fp);
+            return -1;
+        }
+
+        const int dims = shape[0];
+        Mat m;
+        if (dims == 1)
+            m.create(shape[1], (size_t)elemsize, shape[4]);
+        else if (dims == 2)
+            m.create(shape[1], shape[2], (size_t)elemsize, shape[4]);
+        else
+            m.create(shape[1], shape[2], shape[3], (size_t)elemsize, shape[4]);
+        if (m.empty())
+            break;
+
+        const size_t plane_size = (size_t)m.w * m.h * m.elemsize;
+        bool ok = true;
+        for (int q=0; q<m.c; q++)
+        {
+            if (fread(m.channel(q).data, 1, plane_size, fp) != plane_size)
+                ok = false;
+        }
+        if (!ok)
+            break;
+
+        insert(key, m);
+    }
+
+    fclose(fp);
+
+    if (entries.size() != header[2])
+    {
+        // a truncated file still serves the entries read so far
+        fprintf(stderr, "pipeline cache %s truncated after %d entries\n", path, (int)entries.size());
+    }
+
+    return 0;
+}
+
+int PipelineCache::save(const char* path) const
+{
+    FILE* fp = fopen(path, "wb");
+    if (!fp)
+    {
+        fprintf(stderr, "fopen %s failed\n", path);
+        return -1;
+    }
+
+    unsigned int header[3] = { PIPELINE_CACHE_MAGIC, PIPELINE_CACHE_VERSION, (unsigned int)entries.size() };
+    bool ok = fwrite(header, sizeof(header), 1, fp) == 1;
+
+    for (size_t i=0; ok && i<entries.size(); i++)
+    {
+        const Mat& m = entries[i].m;
+        int shape[5] = { m.dims, m.w, m.h, m.c, m.elempack };
+        unsigned int elemsize = (unsigned int)m.elemsize;
+
+        const PipelineCacheKey& key = entries[i].key;
+        ok = fwrite(&key.key, sizeof(key.key), 1, fp) == 1
+             && fwrite(&key.source_size, sizeof(key.source_size), 1, fp) == 1
+             && fwrite(&key.source_checksum, sizeof(key.source_checksum), 1, fp) == 1
+             && fwrite(shape, sizeof(shape), 1, fp) == 1
+             && fwrite(&elemsize, sizeof(elemsize), 1, fp) == 1;
+
+        const size_t plane_size = (size_t)m.w * m.h * m.elemsize;
+        for (int q=0; ok && q<m.c; q++)
+        {
+            ok = fwrite(m.channel(q).data, 1, plane_size, fp) == plane_size;
+        }
+    }
+
+    if (fclose(fp) != 0)
+        ok = false;
+
+    if (!ok)
+    {
+        fprintf(stderr, "pipeline cache %s write failed\n", path);
+        return -1;
+    }
+
+    return 0;
+}
+#endif // NCNN_STDIO
+
+// index of the first entry whose key is not less than key
+static size_t lower_bound_key(const std::vector<PipelineCache::Entry>& entries, uint64_t key)
+{
+    size_t lo = 0;
+    size_t hi = entries.size();
+    while (lo < hi)
+    {
+        size_t mid = lo + (hi - lo) / 2;
+        if (entries[mid].key.key < key)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+
+    return lo;
+}
+
+Mat PipelineCache::find(const PipelineCacheKey& key) const
+{
+    size_t i = lower_bound_key(entries, key.key);
+    if (i == entries.size() || entries[i].key.key != key.key)
+        return Mat();
+
+    const PipelineCacheKey& stored = entries[i].key;
+    if (stored.source_size != key.source_size || stored.source_checksum != key.source_checksum)
+    {
+        fprintf(stderr, "pipeline cache entry %016llx was made from other source weights, ignored\n", (unsigned long long)key.key);
+        return Mat();
+    }
+
+    return entries[i].m;
+}
+
+void PipelineCache::insert(const PipelineCacheKey& key, const Mat& m)
+{
+    if (m.empty())
+        return;
+
+    size_t i = lower_bound_key(entries, key.key);
+    if (i < entries.size() && entries[i].key.key == key.key)
+    {
+        entries[i].key = key;
+        entries[i].m = m;
+        return;
+    }
+
+    Entry e;
+    e.key = key;
+    e.m = m;
+    entries.insert(entries.begin() + i, e);
+}
+
+void PipelineCache::clear()
+{
+    entries.clear();
+}
+
+// fnv-1a over whole 64 bit words, with a shift to carry the high input bits down
+// weights can be large, a byte at a time would cost more than some transforms
+static uint64_t hash_bytes(uint64_t hash, const void* data, size_t size)
+{
+    const uint64_t prime = 0x100000001b3ULL;
+
+    const unsigned char* p = (const unsigned char*)data;
+    for (; size >= 8; size -= 8, p += 8)
+    {
+        uint64_t v;
+        memcpy(&v, p, 8);
+        hash = (hash ^ v) * prime;
+        hash ^= hash >> 29;
+    }
+    for (; size > 0; size--, p++)
+    {
+        hash = (hash ^ *p) * prime;
+    }
+
+    return hash;
+}
+
+// the same walk with the key hash and an independent checksum side by side,
+// so the source weights are read once for both
+static void hash_source_bytes(uint64_t& hash, uint64_t& checksum, const void* data, size_t size)
+{
+    const uint64_t prime = 0x100000001b3ULL;
+    const uint64_t checksum_prime = 0x9e3779b97f4a7c15ULL;
+
+    const unsigned char* p = (const unsigned char*)data;
+    for (; size >= 8; size -= 8, p += 8)
+    {
+        uint64_t v;
+        memcpy(&v, p, 8);
+        hash = (hash ^ v) * prime;
+        hash ^= hash >> 29;
+        checksum = (checksum + v) * checksum_prime;
+        checksum ^= checksum >> 31;
+    }
+    for (; size > 0; size--, p++)
+    {
+        hash = (hash ^ *p) * prime;
+        checksum = (checksum + *p) * checksum_prime;
+    }
+}
+
+PipelineCacheKey pipeline_cache_key(const char* tag, const int* params, int param_count, const Mat& source)
+{
+    uint64_t hash = 0xcbf29ce484222325ULL;
+
+    hash = hash_bytes(hash, tag, strlen(tag) + 1);
+    hash = hash_bytes(hash, params, param_count * sizeof(int));
+
+    int shape[5] = { source.dims, source.w, source.h, source.c, source.elempack };
+    hash = hash_bytes(hash, shape, sizeof(shape));
+    hash = hash_bytes(hash, &source.elemsize, sizeof(source.elemsize));
+
+    uint64_t checksum = 0;
+
+    const size_t plane_size = (size_t)source.w * source.h * source.elemsize;
+    for (int q=0; q<source.c; q++)
+    {
+        hash_source_bytes(hash, checksum, source.channel(q).data, plane_size);
+    }
+
+    PipelineCacheKey key;
+    key.key = hash;
+    key.source_size = (uint64_t)plane_size * source.c;
+    key.source_checksum = checksum;
+
+    return key;
+}
+
+bool pipeline_cache_lookup(const Option& opt, const char* tag, const int* params, int param_count, const Mat& source, PipelineCacheKey& key, Mat& m)
+{
+    key.key = 0;
+    key.source_size = 0;
+    key.source_checksum = 0;
+    if (!opt.pipeline_cache)
+        return false;
+
+    key = pipeline_cache_key(tag, params, param_count, source);
+
+    Mat cached = opt.pipeline_cache->find(key);
+    if (cached.empty())
+        return false;
+
+    m = cached;
+    return true;
+}
+
+void pipeline_cache_store(const Option& opt, const PipelineCacheKey& key, const Mat& m)
+{
+    if (!opt.pipeline_cache)
+        return;
+
+    opt.pipeline_cache->insert(key, m);
+}
@@ -0,0 +1,89 @@
+// Tencent is pleased to support the open source community by making ncnn available.
+//
+// Copyright (C) 2020 THL A29 Limited, a Tencent company. All rights reserved.
+//
+// Licensed under the BSD 3-Clause License (the "License"); you may not use this file except
+// in compliance with the License. You may obtain a copy of the License at
+//
+// https://opensource.org/licenses/BSD-3-Clause
+//
+// Unless required by applicable law or agreed to in writing, software distributed
+// under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+// CONDITIONS OF ANY KIND, either express or implied. See the License for the
+// specific language governing permissions and limitations under the License.
+
+
+#ifndef NCNN_PIPELINECACHE_H
+#define NCNN_PIPELINECACHE_H
+
+#include <stdint.h>
+#include <vector>
+#include "platform.h"
+#include "mat.h"
+
+struct Option;
+
+// weights transformed in create_pipeline, keyed by the transform and its input
+// point Option::pipeline_cache at it before load_model to collect the transforms,
+// save it once loaded, and load it on the next start to skip the identical work
+// a key covers the source weight bytes, the layer geometry and the transform,
+// whose tag differs per kernel layout and instruction set variant,
+// so entries of another model, option set or cpu are simply never hit
+// not thread safe, fill it from one load_model at a time
+
+// where a transformed weight is stored, and the source weights it came from
+// the size and a second independent checksum of the source catch a key collision
+struct PipelineCacheKey
+{
+    uint64_t key;
+    uint64_t source_size;
+    uint64_t source_checksum;
+};
+
+struct PipelineCache
+{
+    PipelineCache();
+    ~PipelineCache();
+
+#if NCNN_STDIO
+    // replace the entries with the ones in the cache file
+    // a file with an invalid entry header is rejected as a whole
+    // return 0 if success
+    int load(const char* path);
+
+    // write all entries into the cache file
+    // return 0 if success
+    int save(const char* path) const;
+#endif // NCNN_STDIO
+
+    // transformed weight stored under key, empty if none
+    // or if it was made from source weights of another size or checksum
+    Mat find(const PipelineCacheKey& key) const;
+
+    // store a transformed weight under key
+    void insert(const PipelineCacheKey& key, const Mat& m);
+
+    void clear();
+
+    struct Entry
+    {
+        PipelineCacheKey key;
+        Mat m;
+    };
+
+    // sorted by key.key
+    std::vector<Entry> entries;
+};
+
+// key of one transform applied to source
+// tag names the transform and its output layout, params hold the geometry it depends on
+PipelineCacheKey pipeline_cache_key(const char* tag, const int* params, int param_count, const Mat& source);
+
+// look the transform up in opt.pipeline_cache
+// return true with the cached weight in m on a hit, otherwise key is set for the store
+bool pipeline_cache_lookup(const Option& opt, const char* tag, const int* params, int param_count, const Mat& source, PipelineCacheKey& key, Mat& m);
+
+// remember a freshly transformed weight in opt.pipeline_cache, if any
+void pipeline_cache_store(const Option& opt, const PipelineCacheKey& key, const Mat& m);
+
+#endif // NCNN_PIPELINECACHE_H
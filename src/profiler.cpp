@@ -0,0 +1,462 @@
+// Tencent is pleased to support the open source community by making ncnn available.
+//
+// Copyright (C) 2020 THL A29 Limited, a Tencent company. All rights reserved.
+//
+// Licensed under the BSD 3-Clause License (the "License"); you may not use this file except
+// in compliance with the License. You may obtain a copy of the License at
+//
+// https://opensource.org/licenses/BSD-3-Clause
+//
+// Unless required by applicable law or agreed to in writing, software distributed
+// under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+// CONDITIONS OF ANY KIND, either express or implied. See the License for the
+// specific language governing permissions and limitations under the License.
+
+#include "profiler.h"
+
+#include <string.h>
+#include <atomic>
+
+#include "benchmark.h"
+#include "layer.h"
+#include "layer_type.h"
+#include "layer/convolution.h"
+#include "layer/convolutiondepthwise.h"
+#include "layer/deconvolution.h"
+#include "layer/deconvolutiondepthwise.h"
+#include "layer/innerproduct.h"
+
+static std::atomic<int> g_profile_thread_count(0);
+static thread_local int g_profile_thread_id = 0;
+
+static Mat shape_of(const Mat& m)
+{
+    Mat shape;
+    shape.dims = m.dims;
+    shape.w = m.w;
+    shape.h = m.h;
+    shape.c = m.c;
+    shape.elemsize = m.elemsize;
+    shape.elempack = m.elempack;
+    return shape;
+}
+
+static int64_t shape_elements(const Mat& m)
+{
+    return (int64_t)m.w * m.h * m.c * m.elempack;
+}
+
+static int64_t shape_bytes(const Mat& m)
+{
+    return (int64_t)m.w * m.h * m.c * m.elemsize;
+}
+
+// the unpacked extents in w h c order, return the dims
+static int shape_extents(const Mat& m, int* extents)
+{
+    extents[0] = m.w;
+    extents[1] = m.h;
+    extents[2] = m.c;
+    if (m.dims > 0)
+        extents[m.dims - 1] *= m.elempack;
+
+    return m.dims;
+}
+
+// 224x224x3 with shapes separated by semicolons
+static void format_shapes(const std::vector<Mat>& shapes, char* buf, size_t size)
+{
+    buf[0] = '\0';
+
+    size_t len = 0;
+    for (size_t i=0; i<shapes.size(); i++)
+    {
+        int extents[3];
+        int dims = shape_extents(shapes[i], extents);
+
+        for (int j=0; j<dims && len < size; j++)
+        {
+            const char* sep = j > 0 ? "x" : (i > 0 ? ";" : "");
+            len += snprintf(buf + len, size - len, "%s%d", sep, extents[j]);
+        }
+    }
+}
+
+static int64_t estimate_flops(const LayerProfile& profile)
+{
+    const Layer* layer = profile.layer;
+
+    int64_t bottom_elements = 0;
+    for (size_t i=0; i<profile.bottom_shapes.size(); i++)
+    {
+        bottom_elements += shape_elements(profile.bottom_shapes[i]);
+    }
+
+    int64_t top_elements = 0;
+    for (size_t i=0; i<profile.top_shapes.size(); i++)
+    {
+        top_elements += shape_elements(profile.top_shapes[i]);
+    }
+
+    // every output gathers weight_data_size / num_output inputs
+    if (layer->typeindex == LayerConvolution)
+    {
+        const Convolution* op = (const Convolution*)layer;
+        return op->num_output ? top_elements * (op->weight_data_size / op->num_output) * 2 : 0;
+    }
+    if (layer->typeindex == LayerConvolutionDepthWise)
+    {
+        const ConvolutionDepthWise* op = (const ConvolutionDepthWise*)layer;
+        return op->num_output ? top_elements * (op->weight_data_size / op->num_output) * 2 : 0;
+    }
+    if (layer->typeindex == LayerInnerProduct)
+    {
+        const InnerProduct* op = (const InnerProduct*)layer;
+        return op->num_output ? top_elements * (op->weight_data_size / op->num_output) * 2 : 0;
+    }
+
+    // every input scatters into weight_data_size / channels outputs
+    if (layer->typeindex == LayerDeconvolution || layer->typeindex == LayerDeconvolutionDepthWise)
+    {
+        int extents[3];
+        int dims = profile.bottom_shapes.empty() ? 0 : shape_extents(profile.bottom_shapes[0], extents);
+        int channels = dims == 3 ? extents[2] : 0;
+
+        int weight_data_size = layer->typeindex == LayerDeconvolution
+                               ? ((const Deconvolution*)layer)->weight_data_size
+                               : ((const DeconvolutionDepthWise*)layer)->weight_data_size;
+
+        return channels ? bottom_elements * (weight_data_size / channels) * 2 : 0;
+    }
+
+    return top_elements;
+}
+
+static int64_t estimate_bytes(const LayerProfile& profile)
+{
+    int64_t bytes = 0;
+    for (size_t i=0; i<profile.bottom_shapes.size(); i++)
+    {
+        bytes += shape_bytes(profile.bottom_shapes[i]);
+    }
+    for (size_t i=0; i<profile.top_shapes.size(); i++)
+    {
+        bytes += shape_bytes(profile.top_shapes[i]);
+    }
+
+    // the source and the packed weights are both registered,
+    // the kernel reads the largest one
+    int64_t weight_bytes = 0;
+    const std::vector<Mat*>& weight_mats = profile.layer->weight_mats;
+    for (size_t i=0; i<weight_mats.size(); i++)
+    {
+        const Mat& m = *weight_mats[i];
+        int64_t size = (int64_t)m.total() * m.elemsize;
+        if (size > weight_bytes)
+            weight_bytes = size;
+    }
+
+    return bytes + weight_bytes;
+}
+
+static void start_profile(LayerProfile& profile, int layer_index, const Layer* layer)
+{
+    if (g_profile_thread_id == 0)
+        g_profile_thread_id = g_profile_thread_count.fetch_add(1) + 1;
+
+    profile.layer_index = layer_index;
+    profile.layer = layer;
+    profile.kernel_name = layer->kernel_name;
+    profile.thread_id = g_profile_thread_id;
+
+    memset(&profile.allocations, 0, sizeof(profile.allocations));
+    g_allocation_counter = &profile.allocations;
+
+    profile.start_ns = get_current_time_ns();
+}
+
+void profile_begin(LayerProfile& profile, int layer_index, const Layer* layer, const Mat& bottom_blob)
+{
+    profile.bottom_shapes.resize(1);
+    profile.bottom_shapes[0] = shape_of(bottom_blob);
+
+    start_profile(profile, layer_index, layer);
+}
+
+void profile_begin(LayerProfile& profile, int layer_index, const Layer* layer, const std::vector<Mat>& bottom_blobs)
+{
+    profile.bottom_shapes.resize(bottom_blobs.size());
+    for (size_t i=0; i<bottom_blobs.size(); i++)
+    {
+        profile.bottom_shapes[i] = shape_of(bottom_blobs[i]);
+    }
+
+    start_profile(profile, layer_index, layer);
+}
+
+static void finish_profile(Profiler* profiler, LayerProfile& profile)
+{
+    profile.flops = estimate_flops(profile);
+    profile.bytes = estimate_bytes(profile);
+
+    pthread_mutex_lock(&profiler->lock);
+    profiler->records.push_back(profile);
+    pthread_mutex_unlock(&profiler->lock);
+}
+
+void profile_end(Profiler* profiler, LayerProfile& profile, const Mat& top_blob)
+{
+    profile.end_ns = get_current_time_ns();
+    g_allocation_counter = 0;
+
+    profile.top_shapes.resize(1);
+    profile.top_shapes[0] = shape_of(top_blob);
+
+    finish_profile(profiler, profile);
+}
+
+void profile_end(Profiler* profiler, LayerProfile& profile, const std::vector<Mat>& top_blobs)
+{
+    profile.end_ns = get_current_time_ns();
+    g_allocation_counter = 0;
+
+    profile.top_shapes.resize(top_blobs.size());
+    for (size_t i=0; i<top_blobs.size(); i++)
+    {
+        profile.top_shapes[i] = shape_of(top_blobs[i]);
+    }
+
+    finish_profile(profiler, profile);
+}
+
+Profiler::Profiler()
+{
+    pthread_mutex_init(&lock, 0);
+}
+
+Profiler::~Profiler()
+{
+    pthread_mutex_destroy(&lock);
+}
+
+void Profiler::clear()
+{
+    pthread_mutex_lock(&lock);
+    records.clear();
+    pthread_mutex_unlock(&lock);
+}
+
+static const char* layer_type(const Layer* layer)
+{
+#if NCNN_STRING
+    return layer->type;
+#else
+    (void)layer;
+    return "";
+#endif // NCNN_STRING
+}
+
+static const char* layer_name(const Layer* layer)
+{
+#if NCNN_STRING
+    return layer->name;
+#else
+    (void)layer;
+    return "";
+#endif // NCNN_STRING
+}
+
+static void write_json_string(FILE* fp, const char* s)
+{
+    fputc('"', fp);
+    for (; s && *s; s++)
+    {
+        unsigned char c = (unsigned char)*s;
+        if (c == '"' || c == '\\')
+            fprintf(fp, "\\%c", c);
+        else if (c < 0x20)
+            fprintf(fp, "\\u%04x", c);
+        else
+            fputc(c, fp);
+    }
+    fputc('"', fp);
+}
+
+static void write_json_shapes(FILE* fp, const std::vector<Mat>& shapes)
+{
+    fputc('[', fp);
+    for (size_t i=0; i<shapes.size(); i++)
+    {
+        int extents[3];
+        int dims = shape_extents(shapes[i], extents);
+
+        fprintf(fp, i > 0 ? ",[" : "[");
+        for (int j=0; j<dims; j++)
+        {
+            fprintf(fp, j > 0 ? ",%d" : "%d", extents[j]);
+        }
+        fputc(']', fp);
+    }
+    fputc(']', fp);
+}
+
+// quote the field, doubling the quotes inside
+static void write_csv_string(FILE* fp, const char* s)
+{
+    fputc('"', fp);
+    for (; s && *s; s++)
+    {
+        if (*s == '"')
+            fputc('"', fp);
+        fputc(*s, fp);
+    }
+    fputc('"', fp);
+}
+
+// records times are written relative to the earliest start
+static int64_t earliest_start(const std::vector<LayerProfile>& records)
+{
+    int64_t t0 = records.empty() ? 0 : records[0].start_ns;
+    for (size_t i=1; i<records.size(); i++)
+    {
+        if (records[i].start_ns < t0)
+            t0 = records[i].start_ns;
+    }
+
+    return t0;
+}
+
+int Profiler::write_json(FILE* fp) const
+{
+    pthread_mutex_lock(&lock);
+
+    const int64_t t0 = earliest_start(records);
+
+    fprintf(fp, "[\n");
+    for (size_t i=0; i<records.size(); i++)
+    {
+        const LayerProfile& r = records[i];
+
+        fprintf(fp, "  {\"index\": %d, \"type\": ", r.layer_index);
+        write_json_string(fp, layer_type(r.layer));
+        fprintf(fp, ", \"name\": ");
+        write_json_string(fp, layer_name(r.layer));
+        fprintf(fp, ", \"kernel\": ");
+        if (r.kernel_name)
+            write_json_string(fp, r.kernel_name);
+        else
+            fprintf(fp, "null");
+        fprintf(fp, ", \"thread\": %d, \"start_ns\": %lld, \"duration_ns\": %lld, \"bottoms\": ",
+                r.thread_id, (long long)(r.start_ns - t0), (long long)(r.end_ns - r.start_ns));
+        write_json_shapes(fp, r.bottom_shapes);
+        fprintf(fp, ", \"tops\": ");
+        write_json_shapes(fp, r.top_shapes);
+        fprintf(fp, ", \"flops\": %lld, \"bytes\": %lld, \"malloc_bytes\": %lld, \"malloc_count\": %d, \"free_bytes\": %lld, \"free_count\": %d}%s\n",
+                (long long)r.flops, (long long)r.bytes,
+                (long long)r.allocations.malloc_bytes, r.allocations.malloc_count,
+                (long long)r.allocations.free_bytes, r.allocations.free_count,
+                i + 1 < records.size() ? "," : "");
+    }
+    fprintf(fp, "]\n");
+
+    pthread_mutex_unlock(&lock);
+
+    return ferror(fp) ? -1 : 0;
+}
+
+int Profiler::write_csv(FILE* fp) const
+{
+    pthread_mutex_lock(&lock);
+
+    const int64_t t0 = earliest_start(records);
+
+    fprintf(fp, "index,type,name,kernel,thread,start_ns,duration_ns,bottoms,tops,flops,bytes,malloc_bytes,malloc_count,free_bytes,free_count\n");
+    for (size_t i=0; i<records.size(); i++)
+    {
+        const LayerProfile& r = records[i];
+
+        char bottoms[256];
+        char tops[256];
+        format_shapes(r.bottom_shapes, bottoms, sizeof(bottoms));
+        format_shapes(r.top_shapes, tops, sizeof(tops));
+
+        fprintf(fp, "%d,", r.layer_index);
+        write_csv_string(fp, layer_type(r.layer));
+        fputc(',', fp);
+        write_csv_string(fp, layer_name(r.layer));
+        fputc(',', fp);
+        write_csv_string(fp, r.kernel_name);
+        fprintf(fp, ",%d,%lld,%lld,%s,%s,%lld,%lld,%lld,%d,%lld,%d\n",
+                r.thread_id, (long long)(r.start_ns - t0), (long long)(r.end_ns - r.start_ns), bottoms, tops,
+                (long long)r.flops, (long long)r.bytes,
+                (long long)r.allocations.malloc_bytes, r.allocations.malloc_count,
+                (long long)r.allocations.free_bytes, r.allocations.free_count);
+    }
+
+    pthread_mutex_unlock(&lock);
+
+    return ferror(fp) ? -1 : 0;
+}
+
+int Profiler::write_chrome_trace(FILE* fp) const
+{
+    pthread_mutex_lock(&lock);
+
+    const int64_t t0 = earliest_start(records);
+
+    // complete events, timestamps in microseconds
+    fprintf(fp, "{\"displayTimeUnit\": \"ns\", \"traceEvents\": [\n");
+    for (size_t i=0; i<records.size(); i++)
+    {
+        const LayerProfile& r = records[i];
+
+        char bottoms[256];
+        char tops[256];
+        format_shapes(r.bottom_shapes, bottoms, sizeof(bottoms));
+        format_shapes(r.top_shapes, tops, sizeof(tops));
+
+        fprintf(fp, "  {\"name\": ");
+        write_json_string(fp, layer_name(r.layer));
+        fprintf(fp, ", \"cat\": ");
+        write_json_string(fp, layer_type(r.layer));
+        fprintf(fp, ", \"ph\": \"X\", \"pid\": 0, \"tid\": %d, \"ts\": %.3f, \"dur\": %.3f, \"args\": {\"index\": %d, \"kernel\": ",
+                r.thread_id, (r.start_ns - t0) / 1000.0, (r.end_ns - r.start_ns) / 1000.0, r.layer_index);
+        write_json_string(fp, r.kernel_name);
+        fprintf(fp, ", \"bottoms\": \"%s\", \"tops\": \"%s\", \"flops\": %lld, \"bytes\": %lld, \"malloc_bytes\": %lld, \"malloc_count\": %d, \"free_bytes\": %lld, \"free_count\": %d}}%s\n",
+                bottoms, tops, (long long)r.flops, (long long)r.bytes,
+                (long long)r.allocations.malloc_bytes, r.allocations.malloc_count,
+                (long long)r.allocations.free_bytes, r.allocations.free_count,
+                i + 1 < records.size() ? "," : "");
+    }
+    fprintf(fp, "]}\n");
+
+    pthread_mutex_unlock(&lock);
+
+    return ferror(fp) ? -1 : 0;
+}
+
+#if NCNN_STDIO
+int Profiler::save(const char* path) const
+{
+    FILE* fp = fopen(path, "wb");
+    if (!fp)
+    {
+        fprintf(stderr, "fopen %s failed\n", path);
+        return -1;
+    }
+
+    const char* ext = strrchr(path, '.');
+
+    int ret;
+    if (ext && strcmp(ext, ".json") == 0)
+        ret = write_json(fp);
+    else if (ext && strcmp(ext, ".csv") == 0)
+        ret = write_csv(fp);
+    else
+        ret = write_chrome_trace(fp);
+
+    fclose(fp);
+
+    return ret;
+}
+#endif // NCNN_STDIO
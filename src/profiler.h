@@ -0,0 +1,104 @@
+// Tencent is pleased to support the open source community by making ncnn available.
+//
+// Copyright (C) 2020 THL A29 Limited, a Tencent company. All rights reserved.
+//
+// Licensed under the BSD 3-Clause License (the "License"); you may not use this file except
+// in compliance with the License. You may obtain a copy of the License at
+//
+// https://opensource.org/licenses/BSD-3-Clause
+//
+// Unless required by applicable law or agreed to in writing, software distributed
+// under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+// CONDITIONS OF ANY KIND, either express or implied. See the License for the
+// specific language governing permissions and limitations under the License.
+
+#ifndef NCNN_PROFILER_H
+#define NCNN_PROFILER_H
+
+#include <pthread.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <vector>
+#include "platform.h"
+#include "allocator.h"
+#include "mat.h"
+
+struct Layer;
+
+// one layer forward seen by the profiler
+struct LayerProfile
+{
+    int layer_index;
+    const Layer* layer;
+
+    // kernel the layer picked in create_pipeline, null if it has only one
+    const char* kernel_name;
+
+    // small id of the thread that ran the layer, branches running concurrently differ
+    int thread_id;
+
+    // monotonic clock
+    int64_t start_ns;
+    int64_t end_ns;
+
+    // dataless mats carrying dims, w, h, c, elemsize and elempack
+    // a batched forward lists the blobs of every sample
+    std::vector<Mat> bottom_shapes;
+    std::vector<Mat> top_shapes;
+
+    // estimated arithmetic, a multiply-add counts two
+    // convolution, deconvolution and innerproduct count their multiply-adds,
+    // the other layers one operation per output element
+    int64_t flops;
+
+    // bytes of the bottom and top blobs plus the weights the kernel reads
+    int64_t bytes;
+
+    // mats created and released on the layer thread during the forward,
+    // allocations made by the openmp or thread pool workers are not seen
+    AllocationCounter allocations;
+};
+
+// per layer records of the forwards run with Option::profiler or Extractor::set_profiler
+// the records pile up over extracts until clear
+// the writers put the start times relative to the earliest record
+// thread safe, one profiler may watch concurrent branches and several extractors
+struct Profiler
+{
+    Profiler();
+    ~Profiler();
+
+    void clear();
+
+    // write the records as a json array of layer objects
+    // return 0 if success
+    int write_json(FILE* fp) const;
+
+    // write the records as csv with a header line
+    // return 0 if success
+    int write_csv(FILE* fp) const;
+
+    // write the records as chrome trace events, load the file in chrome://tracing or perfetto
+    // return 0 if success
+    int write_chrome_trace(FILE* fp) const;
+
+#if NCNN_STDIO
+    // write into a file in the format given by the file extension,
+    // .json for json, .csv for csv, anything else for chrome trace
+    // return 0 if success
+    int save(const char* path) const;
+#endif // NCNN_STDIO
+
+    mutable pthread_mutex_t lock;
+    std::vector<LayerProfile> records;
+};
+
+// start timing one layer forward on the calling thread
+void profile_begin(LayerProfile& profile, int layer_index, const Layer* layer, const Mat& bottom_blob);
+void profile_begin(LayerProfile& profile, int layer_index, const Layer* layer, const std::vector<Mat>& bottom_blobs);
+
+// stop timing the layer forward and hand the record to profiler
+void profile_end(Profiler* profiler, LayerProfile& profile, const Mat& top_blob);
+void profile_end(Profiler* profiler, LayerProfile& profile, const std::vector<Mat>& top_blobs);
+
+#endif // NCNN_PROFILER_H
@@ -0,0 +1,364 @@
+// Tencent is pleased to support the open source community by making ncnn available.
+//
+// Copyright (C) 2020 THL A29 Limited, a Tencent company. All rights reserved.
+//
+// Licensed under the BSD 3-Clause License (the "License"); you may not use this file except
+// in compliance with the License. You may obtain a copy of the License at
+//
+// https://opensource.org/licenses/BSD-3-Clause
+//
+// Unless required by applicable law or agreed to in writing, software distributed
+// under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+// CONDITIONS OF ANY KIND, either express or implied. See the License for the
+// specific language governing permissions and limitations under the License.
+
+#include "threadpool.h"
+
+#include <pthread.h>
+#include <sched.h>
+#include <stdio.h>
+#include <time.h>
+#include <atomic>
+#include <vector>
+
+#include "cpu.h"
+
+// index range still to run by one participant of a loop
+// the owner claims begin without the lock, end only moves under the lock
+struct ParallelRange
+{
+    pthread_mutex_t lock;
+    std::atomic<int> begin;
+    std::atomic<int> end;
+};
+
+// one parallel_for call, lives on the stack of the calling thread
+struct ParallelJob
+{
+    parallel_for_func func;
+    void* args;
+
+    // one range per participant, the caller owns range 0
+    ParallelRange* ranges;
+    int range_count;
+
+    // participant slots handed out, guarded by the pool lock
+    int joined;
+
+    // indexes not finished yet
+    std::atomic<int> pending;
+    // pool workers that may still touch the job
+    std::atomic<int> workers_inside;
+};
+
+struct ThreadPool
+{
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+
+    // jobs with unclaimed participant slots
+    std::vector<ParallelJob*> jobs;
+    std::atomic<int> jobs_open;
+
+    int sleeping;
+    int worker_count;
+};
+
+static ThreadPool* g_thread_pool = 0;
+static pthread_once_t g_thread_pool_once = PTHREAD_ONCE_INIT;
+
+// microseconds a worker spins before it sleeps, long enough to cover the gap between two layers
+static const int g_worker_spin_us = 1000;
+// spins before a caller waiting for its helpers yields the core
+static const int g_caller_spin_count = 10000;
+
+static long long monotonic_us()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000000LL + ts.tv_nsec / 1000;
+}
+
+// the owner claims the front index with one fetch_add,
+// a claim at or past end is either the end of the range or a race with a steal
+static bool take_index(ParallelRange& range, int& i)
+{
+    i = range.begin.fetch_add(1);
+    if (i < range.end.load())
+        return true;
+
+    // a thief that saw the claim gives its half back before it unlocks
+    pthread_mutex_lock(&range.lock);
+    bool taken = i < range.end.load(std::memory_order_relaxed);
+    pthread_mutex_unlock(&range.lock);
+
+    return taken;
+}
+
+// move the back half of the largest other range into the empty range of slot
+static bool steal_range(ParallelJob* job, int slot)
+{
+    const int slot_count = job->range_count;
+
+    for (;;)
+    {
+        // an unlocked peek is enough to pick a victim
+        int victim = -1;
+        int victim_size = 0;
+        for (int k=0; k<slot_count; k++)
+        {
+            const ParallelRange& range = job->ranges[k];
+            int size = range.end.load(std::memory_order_relaxed) - range.begin.load(std::memory_order_relaxed);
+            if (k != slot && size > victim_size)
+            {
+                victim = k;
+                victim_size = size;
+            }
+        }
+
+        if (victim == -1)
+            return false;
+
+        ParallelRange& range = job->ranges[victim];
+
+        pthread_mutex_lock(&range.lock);
+
+        int end = range.end.load(std::memory_order_relaxed);
+        int size = end - range.begin.load(std::memory_order_relaxed);
+        int begin = end - (size + 1) / 2;
+        if (size > 0)
+        {
+            range.end.store(begin);
+
+            // the owner may have claimed into the back half meanwhile,
+            // hand it all back then, the owner waits on the lock to learn its claim holds
+            if (range.begin.load() > begin)
+            {
+                range.end.store(end);
+                size = 0;
+            }
+        }
+
+        pthread_mutex_unlock(&range.lock);
+
+        if (size <= 0)
+            continue;
+
+        // nobody steals from an empty range, so only we touch it now
+        ParallelRange& own = job->ranges[slot];
+        pthread_mutex_lock(&own.lock);
+        own.begin.store(begin, std::memory_order_relaxed);
+        own.end.store(end, std::memory_order_relaxed);
+        pthread_mutex_unlock(&own.lock);
+
+        return true;
+    }
+}
+
+static void run_job(ParallelJob* job, int slot)
+{
+    ParallelRange& own = job->ranges[slot];
+
+    for (;;)
+    {
+        int i;
+        while (take_index(own, i))
+        {
+            job->func(i, job->args);
+            job->pending.fetch_sub(1);
+        }
+
+        if (!steal_range(job, slot))
+            break;
+    }
+}
+
+// claim a participant slot of the oldest open job, pool lock held
+static ParallelJob* take_job(ThreadPool* pool, int& slot)
+{
+    if (pool->jobs.empty())
+        return 0;
+
+    ParallelJob* job = pool->jobs[0];
+
+    slot = job->joined++;
+    job->workers_inside.fetch_add(1);
+
+    if (job->joined == job->range_count)
+    {
+        pool->jobs.erase(pool->jobs.begin());
+        pool->jobs_open.fetch_sub(1);
+    }
+
+    return job;
+}
+
+static void* thread_pool_worker(void* args)
+{
+    ThreadPool* pool = (ThreadPool*)args;
+
+    int powersave = -1;
+
+    for (;;)
+    {
+        const long long spin_end = monotonic_us() + g_worker_spin_us;
+        for (int i=1; pool->jobs_open.load(std::memory_order_relaxed) == 0; i++)
+        {
+            // the clock is cheap but not free, look at it every few hundred spins
+            if (i % 256 == 0 && monotonic_us() >= spin_end)
+                break;
+        }
+
+        pthread_mutex_lock(&pool->lock);
+
+        int slot = 0;
+        ParallelJob* job = take_job(pool, slot);
+        while (!job)
+        {
+            pool->sleeping++;
+            pthread_cond_wait(&pool->cond, &pool->lock);
+            pool->sleeping--;
+
+            job = take_job(pool, slot);
+        }
+
+        pthread_mutex_unlock(&pool->lock);
+
+        // follow set_cpu_powersave like the openmp threads do
+        if (powersave != get_cpu_powersave())
+        {
+            powersave = get_cpu_powersave();
+            set_current_thread_affinity(get_cpu_thread_affinity_mask(powersave));
+        }
+
+        run_job(job, slot);
+
+        job->workers_inside.fetch_sub(1);
+    }
+
+    return 0;
+}
+
+static void create_thread_pool()
+{
+    ThreadPool* pool = new ThreadPool;
+    pthread_mutex_init(&pool->lock, 0);
+    pthread_cond_init(&pool->cond, 0);
+    pool->jobs_open.store(0);
+    pool->sleeping = 0;
+    pool->worker_count = 0;
+
+    const int worker_count = get_cpu_count() - 1;
+    for (int i=0; i<worker_count; i++)
+    {
+        pthread_t thread;
+        if (pthread_create(&thread, 0, thread_pool_worker, pool) != 0)
+        {
+            fprintf(stderr, "thread pool started %d of %d workers\n", pool->worker_count, worker_count);
+            break;
+        }
+
+        // the workers live as long as the process
+        pthread_detach(thread);
+        pool->worker_count++;
+    }
+
+    g_thread_pool = pool;
+}
+
+int get_thread_pool_size()
+{
+    pthread_once(&g_thread_pool_once, create_thread_pool);
+
+    return g_thread_pool->worker_count;
+}
+
+void parallel_for(int n, parallel_for_func func, void* args, const Option& opt)
+{
+    if (n <= 0)
+        return;
+
+#ifdef _OPENMP
+    if (!opt.use_thread_pool)
+    {
+        #pragma omp parallel for num_threads(opt.num_threads)
+        for (int i=0; i<n; i++)
+        {
+            func(i, args);
+        }
+
+        return;
+    }
+#endif // _OPENMP
+
+    int num_threads = opt.num_threads < n ? opt.num_threads : n;
+    if (num_threads > 1)
+    {
+        int pool_threads = get_thread_pool_size() + 1;
+        if (num_threads > pool_threads)
+            num_threads = pool_threads;
+    }
+
+    if (num_threads <= 1)
+    {
+        for (int i=0; i<n; i++)
+        {
+            func(i, args);
+        }
+
+        return;
+    }
+
+    ThreadPool* pool = g_thread_pool;
+
+    ParallelJob job;
+    job.func = func;
+    job.args = args;
+    job.ranges = new ParallelRange[num_threads];
+    job.range_count = num_threads;
+    for (int k=0; k<num_threads; k++)
+    {
+        ParallelRange& range = job.ranges[k];
+        pthread_mutex_init(&range.lock, 0);
+        range.begin.store((int)((long long)n * k / num_threads));
+        range.end.store((int)((long long)n * (k + 1) / num_threads));
+    }
+    job.joined = 1;
+    job.pending.store(n);
+    job.workers_inside.store(0);
+
+    pthread_mutex_lock(&pool->lock);
+    pool->jobs.push_back(&job);
+    pool->jobs_open.fetch_add(1);
+    if (pool->sleeping > 0)
+        pthread_cond_broadcast(&pool->cond);
+    pthread_mutex_unlock(&pool->lock);
+
+    run_job(&job, 0);
+
+    // no more helpers may join once the work is handed out
+    pthread_mutex_lock(&pool->lock);
+    for (size_t j=0; j<pool->jobs.size(); j++)
+    {
+        if (pool->jobs[j] == &job)
+        {
+            pool->jobs.erase(pool->jobs.begin() + j);
+            pool->jobs_open.fetch_sub(1);
+            break;
+        }
+    }
+    pthread_mutex_unlock(&pool->lock);
+
+    // the helpers finish the indexes they took
+    for (int spin=0; job.pending.load() > 0 || job.workers_inside.load() > 0; spin++)
+    {
+        if (spin >= g_caller_spin_count)
+            sched_yield();
+    }
+
+    for (int k=0; k<num_threads; k++)
+    {
+        pthread_mutex_destroy(&job.ranges[k].lock);
+    }
+    delete[] job.ranges;
+}
@@ -0,0 +1,37 @@
+// Tencent is pleased to support the open source community by making ncnn available.
+//
+// Copyright (C) 2020 THL A29 Limited, a Tencent company. All rights reserved.
+//
+// Licensed under the BSD 3-Clause License (the "License"); you may not use this file except
+// in compliance with the License. You may obtain a copy of the License at
+//
+// https://opensource.org/licenses/BSD-3-Clause
+//
+// Unless required by applicable law or agreed to in writing, software distributed
+// under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+// CONDITIONS OF ANY KIND, either express or implied. See the License for the
+// specific language governing permissions and limitations under the License.
+
+#ifndef NCNN_THREADPOOL_H
+#define NCNN_THREADPOOL_H
+
+#include "option.h"
+
+// body of a parallel loop, called once for every index
+typedef void (*parallel_for_func)(int i, void* args);
+
+// run func(i, args) for every i in [0, n) on up to opt.num_threads threads
+// the iterations must be independent and may run in any order
+// openmp runs the loop unless opt.use_thread_pool is set or openmp is not available,
+// the ncnn thread pool runs it otherwise
+void parallel_for(int n, parallel_for_func func, void* args, const Option& opt);
+
+// one process wide pool of get_cpu_count() - 1 worker threads, started on first use
+// the thread calling parallel_for always works on its own loop, so the pool is shared
+// by all extractors without ever running more threads than cores
+// each caller splits its loop into one index range per thread,
+// a thread that runs out of work steals half of the largest range left
+// the workers follow the cpu powersave affinity where set_cpu_thread_affinity works
+int get_thread_pool_size();
+
+#endif // NCNN_THREADPOOL_H